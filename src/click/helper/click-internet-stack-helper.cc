@@ -391,6 +391,14 @@ ClickInternetStackHelper::EnableAsciiIpv4Internal (
       return;
     }
 
+  //
+  // The Ipv4 trace sinks only write text.
+  //
+  if (AsciiTraceHelper::IsBinaryStream (stream))
+    {
+      NS_FATAL_ERROR ("ClickInternetStackHelper::EnableAsciiIpv4Internal(): binary trace streams are not supported");
+    }
+
   //
   // Our trace sinks are going to use packet printing, so we have to
   // make sure that is turned on.
@@ -484,7 +492,7 @@ ClickInternetStackHelper::EnableAsciiIpv4Internal (
       // functions that are always there waiting for just such a case.
       //
       oss << "/NodeList/" << node->GetId () << "/$ns3::ArpL3Protocol/Drop";
-      Config::Connect (oss.str (), MakeBoundCallback (&AsciiTraceHelper::DefaultDropSinkWithContext, stream));
+      Config::Connect (oss.str (), AsciiTraceHelper::MakeDefaultSinkWithContext ('d', stream));
 
       //
       // This has all kinds of parameters coming with, so we have to cook up our
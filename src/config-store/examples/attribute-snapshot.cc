@@ -0,0 +1,123 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Saves an attribute snapshot during a first run, then starts a second
+// run from it:
+//
+//   ./waf --run "attribute-snapshot --time=5 --stop=10"
+//   ./waf --run "attribute-snapshot --restore=1 --stop=10"
+//
+// The second run begins at the snapshot time with the attribute values
+// and random streams of the first one.  It is not the state of the first
+// run: the applications start again and the devices and sockets start
+// empty.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/config-store-module.h"
+
+#include <iostream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("AttributeSnapshotExample");
+
+static void
+ReportTime (std::string what)
+{
+  std::cout << what << " at " << Simulator::Now ().GetSeconds () << "s" << std::endl;
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::string filename = "snapshot.txt";
+  bool restore = false;
+  double time = 5.0;
+  double stop = 10.0;
+
+  CommandLine cmd;
+  cmd.AddValue ("filename", "Snapshot file", filename);
+  cmd.AddValue ("restore", "Start from the snapshot instead of saving one", restore);
+  cmd.AddValue ("time", "Time at which the snapshot is saved", time);
+  cmd.AddValue ("stop", "Simulation stop time in seconds", stop);
+  cmd.Parse (argc, argv);
+
+  AttributeSnapshot snapshot;
+  snapshot.SetFilename (filename);
+  if (restore)
+    {
+      snapshot.RestoreDefaults ();
+      time = snapshot.GetTime ().GetSeconds ();
+      ReportTime ("Restored snapshot");
+    }
+
+  NodeContainer nodes;
+  nodes.Create (2);
+
+  PointToPointHelper pointToPoint;
+  pointToPoint.SetDeviceAttribute ("DataRate", StringValue ("5Mbps"));
+  pointToPoint.SetChannelAttribute ("Delay", StringValue ("2ms"));
+  NetDeviceContainer devices = pointToPoint.Install (nodes);
+
+  InternetStackHelper stack;
+  stack.Install (nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = address.Assign (devices);
+
+  uint16_t port = 9;
+  PacketSinkHelper sinkHelper ("ns3::UdpSocketFactory",
+                               InetSocketAddress (Ipv4Address::GetAny (), port));
+  ApplicationContainer sinkApp = sinkHelper.Install (nodes.Get (1));
+  OnOffHelper onOff ("ns3::UdpSocketFactory", InetSocketAddress (interfaces.GetAddress (1), port));
+  // Fixed streams, so that the second run continues their draws
+  ExponentialVariable onTime (0.5);
+  onTime.SetStream (0);
+  ExponentialVariable offTime (0.5);
+  offTime.SetStream (1);
+  onOff.SetAttribute ("OnTime", RandomVariableValue (onTime));
+  onOff.SetAttribute ("OffTime", RandomVariableValue (offTime));
+  ApplicationContainer sourceApp = onOff.Install (nodes.Get (0));
+
+  // Start and stop times are relative to the restored clock
+  sinkApp.Start (Seconds (0.0));
+  sourceApp.Start (Seconds (1.0));
+
+  if (restore)
+    {
+      snapshot.RestoreAttributes ();
+      Simulator::Stop (Seconds (stop - time));
+    }
+  else
+    {
+      // A change made during the run, which the second run picks up
+      // from the snapshot
+      devices.Get (0)->SetAttribute ("DataRate", StringValue ("2Mbps"));
+      Simulator::Schedule (Seconds (time), &AttributeSnapshot::Save, &snapshot);
+      Simulator::Schedule (Seconds (time), &ReportTime, "Saved snapshot");
+      Simulator::Stop (Seconds (stop));
+    }
+
+  Simulator::Run ();
+  std::cout << "Stopped at " << Simulator::Now ().GetSeconds () << "s, sink received "
+            << DynamicCast<PacketSink> (sinkApp.Get (0))->GetTotalRx () << " bytes" << std::endl;
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,237 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "attribute-snapshot.h"
+#include "raw-text-config.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/simulator.h"
+#include "ns3/rng-stream.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include <fstream>
+#include <sstream>
+
+NS_LOG_COMPONENT_DEFINE ("AttributeSnapshot");
+
+namespace ns3 {
+
+static void
+AttributeSnapshotClockReached (void)
+{
+}
+
+AttributeSnapshot::AttributeSnapshot ()
+  : m_filename (""),
+    m_time (Seconds (0))
+{
+}
+
+void
+AttributeSnapshot::SetFilename (std::string filename)
+{
+  m_filename = filename;
+}
+
+void
+AttributeSnapshot::Save (void)
+{
+  NS_LOG_FUNCTION (this << m_filename);
+  {
+    RawTextConfigSave config;
+    config.SetFilename (m_filename);
+    config.Default ();
+    config.Global ();
+    config.Attributes ();
+  }
+  std::ofstream os (m_filename.c_str (), std::ios::out | std::ios::app);
+  NS_ABORT_MSG_UNLESS (os.good (), "Could not write snapshot to " << m_filename);
+
+  uint32_t seed[6];
+  RngStream::GetNextSeed (seed);
+  // Same "type name value" layout as the rest of the file, so that
+  // RawTextConfigLoad skips these lines
+  os << "time now \"" << Simulator::Now () << "\"" << std::endl;
+  os << "rng nextSeed \"" << seed[0];
+  for (uint32_t i = 1; i < 6; ++i)
+    {
+      os << ":" << seed[i];
+    }
+  os << "\"" << std::endl;
+  std::vector<int64_t> streams = RngStream::GetStreams ();
+  for (std::vector<int64_t>::const_iterator i = streams.begin (); i != streams.end (); ++i)
+    {
+      RngStream::GetStreamState (*i, seed);
+      os << "stream " << *i << " \"" << seed[0];
+      for (uint32_t j = 1; j < 6; ++j)
+        {
+          os << ":" << seed[j];
+        }
+      os << "\"" << std::endl;
+    }
+}
+
+bool
+AttributeSnapshot::ParseState (std::string value, uint32_t state[6])
+{
+  std::istringstream iss (value);
+  char separator;
+  iss >> state[0];
+  for (uint32_t j = 1; j < 6; ++j)
+    {
+      iss >> separator >> state[j];
+    }
+  return !iss.fail ();
+}
+
+void
+AttributeSnapshot::Read (std::vector<Line> &lines) const
+{
+  std::ifstream is (m_filename.c_str (), std::ios::in);
+  NS_ABORT_MSG_UNLESS (is.good (), "Could not read snapshot from " << m_filename);
+  std::string text;
+  while (std::getline (is, text))
+    {
+      // The value is the rest of the line, which may hold spaces
+      Line line;
+      std::istringstream iss (text);
+      iss >> line.type >> line.name;
+      if (iss.fail ())
+        {
+          continue;
+        }
+      std::getline (iss, line.value);
+      std::string::size_type start = line.value.find ("\"");
+      std::string::size_type end = line.value.rfind ("\"");
+      if (start != std::string::npos && end > start)
+        {
+          line.value = line.value.substr (start + 1, end - start - 1);
+        }
+      else
+        {
+          std::string::size_type first = line.value.find_first_not_of (" \t");
+          line.value = first == std::string::npos ? "" : line.value.substr (first);
+        }
+      lines.push_back (line);
+    }
+}
+
+void
+AttributeSnapshot::RestoreDefaults (void)
+{
+  NS_LOG_FUNCTION (this << m_filename);
+  std::vector<Line> lines;
+  Read (lines);
+
+  bool haveTime = false;
+  bool haveSeed = false;
+  uint32_t seed[6];
+  // Global values first: they hold the seed, the run number and the
+  // simulator implementation, which the check below instantiates
+  for (std::vector<Line>::const_iterator i = lines.begin (); i != lines.end (); ++i)
+    {
+      if (i->type == "global" && !Config::SetGlobalFailSafe (i->name, StringValue (i->value)))
+        {
+          NS_LOG_WARN ("could not restore global " << i->name << "=" << i->value);
+        }
+    }
+  NS_ABORT_MSG_UNLESS (Simulator::Now ().IsZero () && Simulator::IsFinished (),
+                       "A snapshot must be restored before anything is scheduled");
+  for (std::vector<Line>::const_iterator i = lines.begin (); i != lines.end (); ++i)
+    {
+      if (i->type == "default")
+        {
+          if (!Config::SetDefaultFailSafe (i->name, StringValue (i->value)))
+            {
+              NS_LOG_WARN ("could not restore default " << i->name << "=" << i->value);
+            }
+        }
+      else if (i->type == "time")
+        {
+          m_time = Time (i->value);
+          haveTime = true;
+        }
+      else if (i->type == "rng")
+        {
+          haveSeed = ParseState (i->value, seed);
+        }
+      else if (i->type == "stream")
+        {
+          uint32_t state[6];
+          std::istringstream iss (i->name);
+          int64_t stream;
+          iss >> stream;
+          NS_ABORT_MSG_UNLESS (!iss.fail () && ParseState (i->value, state)
+                               && RngStream::SetStreamState (stream, state),
+                               "Invalid state of stream " << i->name);
+        }
+    }
+  NS_ABORT_MSG_UNLESS (haveTime && haveSeed, m_filename << " is not a snapshot");
+  NS_ABORT_MSG_UNLESS (RngStream::SetNextSeed (seed), "Invalid random number generator state");
+
+  // The simulator has no way to set its clock, but running an event at
+  // the snapshot time on the empty event list checked above moves it
+  // there with any implementation.  The real-time implementation waits
+  // for that time before returning, though.
+  if (!m_time.IsZero ())
+    {
+      Simulator::Schedule (m_time, &AttributeSnapshotClockReached);
+      Simulator::Run ();
+    }
+  NS_LOG_LOGIC ("restored time " << Simulator::Now ());
+}
+
+void
+AttributeSnapshot::RestoreAttributes (void)
+{
+  NS_LOG_FUNCTION (this << m_filename);
+  std::vector<Line> lines;
+  Read (lines);
+  for (std::vector<Line>::const_iterator i = lines.begin (); i != lines.end (); ++i)
+    {
+      if (i->type != "value")
+        {
+          continue;
+        }
+      // Values which do not serialize (e.g. some random variables) are
+      // saved empty: keep whatever the scenario configured instead.
+      std::string::size_type slash = i->name.rfind ("/");
+      NS_ASSERT (slash != std::string::npos);
+      std::string attribute = i->name.substr (slash + 1);
+      Config::MatchContainer objects = Config::LookupMatches (i->name.substr (0, slash));
+      for (Config::MatchContainer::Iterator j = objects.Begin (); j != objects.End (); ++j)
+        {
+          // Only set the values which differ from what the scenario
+          // configured, so that e.g. a random variable keeps its stream
+          StringValue current;
+          if ((*j)->GetAttributeFailSafe (attribute, current) && current.Get () == i->value)
+            {
+              continue;
+            }
+          if (!(*j)->SetAttributeFailSafe (attribute, StringValue (i->value)))
+            {
+              NS_LOG_WARN ("could not restore " << i->name << "=" << i->value);
+            }
+        }
+    }
+}
+
+Time
+AttributeSnapshot::GetTime (void) const
+{
+  return m_time;
+}
+
+} // namespace ns3
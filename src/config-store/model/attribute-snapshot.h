@@ -0,0 +1,110 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef ATTRIBUTE_SNAPSHOT_H
+#define ATTRIBUTE_SNAPSHOT_H
+
+#include "ns3/nstime.h"
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup configstore
+ *
+ * \brief Save the attribute values and random streams of a running
+ *        simulation and start a new one from them
+ *
+ * A snapshot is a RawText ConfigStore file (default values, global
+ * values and the value of every attribute reachable from the
+ * configuration namespace) extended with the simulation time and the
+ * state of the random number generator package.
+ *
+ * A snapshot is not a checkpoint of the simulation.  Pending events,
+ * packets in flight (propagating on a channel or waiting in a queue)
+ * and the protocol state which is not held in attributes (TCP
+ * connections, ARP caches, routing tables learnt at run time, ...) are
+ * not saved.  A run started from a snapshot therefore does not resume
+ * the saved one: it is a new run which begins at the snapshot time with
+ * the same configuration and random streams.
+ *
+ * A snapshot is restored in a fresh process which builds the same
+ * scenario:
+ *
+ * \code
+ *   AttributeSnapshot snapshot;
+ *   snapshot.SetFilename ("snapshot.txt");
+ *   snapshot.RestoreDefaults ();   // before any object is created
+ *   ... build the topology ...
+ *   snapshot.RestoreAttributes ();
+ *   Simulator::Run ();
+ * \endcode
+ *
+ * The random variables which must draw the same values as in the saved
+ * run are put on a stream of their own, e.g. with
+ * RandomVariable::SetStream, when the scenario is built: the snapshot
+ * holds the state of these streams, and restores it when the scenario
+ * creates them again.  The other variables draw from the streams
+ * following the ones handed out in the saved run.
+ *
+ * Since the clock is restored before the topology is built, the events
+ * the scenario schedules are relative to the snapshot time.
+ */
+class AttributeSnapshot
+{
+public:
+  AttributeSnapshot ();
+
+  void SetFilename (std::string filename);
+  /**
+   * Write the snapshot file.  Typically scheduled at the time the
+   * snapshot is to be taken.
+   */
+  void Save (void);
+  /**
+   * Restore default values, global values, the random number generator
+   * state and the simulation time.  Must be called before anything is
+   * scheduled, and before the random variables get their streams.
+   */
+  void RestoreDefaults (void);
+  /**
+   * Restore the attribute values of the objects of the scenario which
+   * differ from the saved ones.  Must be called once the topology is
+   * built.
+   */
+  void RestoreAttributes (void);
+  /**
+   * \returns the simulation time the snapshot was taken at
+   */
+  Time GetTime (void) const;
+
+private:
+  struct Line
+  {
+    std::string type;
+    std::string name;
+    std::string value;
+  };
+  void Read (std::vector<Line> &lines) const;
+  static bool ParseState (std::string value, uint32_t state[6]);
+
+  std::string m_filename;
+  Time m_time;
+};
+
+} // namespace ns3
+
+#endif /* ATTRIBUTE_SNAPSHOT_H */
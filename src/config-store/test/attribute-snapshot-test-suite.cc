@@ -0,0 +1,195 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/attribute-snapshot.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/random-variable.h"
+#include "ns3/object.h"
+#include "ns3/string.h"
+#include "ns3/config.h"
+#include <vector>
+
+namespace ns3 {
+
+// Draws from two variables every second
+class AttributeSnapshotDraws
+{
+public:
+  AttributeSnapshotDraws ();
+  void Start (Time first);
+  void Draw (void);
+
+  UniformVariable m_uniform;
+  ExponentialVariable m_exponential;
+  std::vector<Time> m_times;
+  std::vector<double> m_values;
+};
+
+AttributeSnapshotDraws::AttributeSnapshotDraws ()
+  : m_exponential (2.0)
+{
+  m_uniform.SetStream (3);
+  m_exponential.SetStream (4);
+}
+
+void
+AttributeSnapshotDraws::Start (Time first)
+{
+  Simulator::Schedule (first, &AttributeSnapshotDraws::Draw, this);
+}
+
+void
+AttributeSnapshotDraws::Draw (void)
+{
+  m_times.push_back (Simulator::Now ());
+  m_values.push_back (m_uniform.GetValue ());
+  m_values.push_back (m_exponential.GetValue ());
+  Simulator::Schedule (Seconds (1), &AttributeSnapshotDraws::Draw, this);
+}
+
+class AttributeSnapshotRestoreTestCase : public TestCase
+{
+public:
+  AttributeSnapshotRestoreTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+AttributeSnapshotRestoreTestCase::AttributeSnapshotRestoreTestCase ()
+  : TestCase ("Check that a restored run draws the same random values as an uninterrupted one")
+{
+}
+
+void
+AttributeSnapshotRestoreTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("snapshot.txt");
+
+  // Uninterrupted run, which saves a snapshot half way
+  std::vector<Time> times;
+  std::vector<double> values;
+  {
+    AttributeSnapshotDraws draws;
+    draws.Start (Seconds (1));
+    AttributeSnapshot snapshot;
+    snapshot.SetFilename (filename);
+    Simulator::Schedule (Seconds (4.5), &AttributeSnapshot::Save, &snapshot);
+    Simulator::Stop (Seconds (10));
+    Simulator::Run ();
+    Simulator::Destroy ();
+    times = draws.m_times;
+    values = draws.m_values;
+  }
+  NS_TEST_ASSERT_MSG_EQ (times.size (), 9, "Unexpected number of draws");
+
+  // A variable on a default stream in between, which must not matter
+  UniformVariable other;
+  other.GetValue ();
+
+  // Restored run
+  AttributeSnapshot snapshot;
+  snapshot.SetFilename (filename);
+  snapshot.RestoreDefaults ();
+  NS_TEST_ASSERT_MSG_EQ (Simulator::Now (), Seconds (4.5), "Clock not restored");
+  AttributeSnapshotDraws draws;
+  draws.Start (Seconds (0.5));
+  snapshot.RestoreAttributes ();
+  Simulator::Stop (Seconds (10) - snapshot.GetTime ());
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  // The draws at 5s to 9s
+  NS_TEST_ASSERT_MSG_EQ (draws.m_times.size (), 5, "Unexpected number of restored draws");
+  for (uint32_t i = 0; i < draws.m_times.size (); ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (draws.m_times[i], times[i + 4], "Draw " << i << " at another time");
+      NS_TEST_EXPECT_MSG_EQ (draws.m_values[2 * i], values[2 * (i + 4)], "Uniform draw " << i << " differs");
+      NS_TEST_EXPECT_MSG_EQ (draws.m_values[2 * i + 1], values[2 * (i + 4) + 1], "Exponential draw " << i << " differs");
+    }
+}
+
+class AttributeSnapshotObject : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+  std::string m_label;
+};
+
+TypeId
+AttributeSnapshotObject::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::AttributeSnapshotObject")
+    .SetParent<Object> ()
+    .AddConstructor<AttributeSnapshotObject> ()
+    .AddAttribute ("Label", "A string attribute",
+                   StringValue ("none"),
+                   MakeStringAccessor (&AttributeSnapshotObject::m_label),
+                   MakeStringChecker ())
+  ;
+  return tid;
+}
+
+NS_OBJECT_ENSURE_REGISTERED (AttributeSnapshotObject);
+
+class AttributeSnapshotSpacesTestCase : public TestCase
+{
+public:
+  AttributeSnapshotSpacesTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+AttributeSnapshotSpacesTestCase::AttributeSnapshotSpacesTestCase ()
+  : TestCase ("Check that values holding spaces are restored whole")
+{
+}
+
+void
+AttributeSnapshotSpacesTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("spaces.txt");
+
+  Config::SetDefault ("ns3::AttributeSnapshotObject::Label", StringValue ("a label with spaces"));
+  AttributeSnapshot snapshot;
+  snapshot.SetFilename (filename);
+  snapshot.Save ();
+  Simulator::Destroy ();
+
+  Config::SetDefault ("ns3::AttributeSnapshotObject::Label", StringValue ("none"));
+  snapshot.RestoreDefaults ();
+  Ptr<AttributeSnapshotObject> object = CreateObject<AttributeSnapshotObject> ();
+  NS_TEST_EXPECT_MSG_EQ (object->m_label, "a label with spaces", "Value cut at the first space");
+  Simulator::Destroy ();
+}
+
+class AttributeSnapshotTestSuite : public TestSuite
+{
+public:
+  AttributeSnapshotTestSuite ();
+};
+
+AttributeSnapshotTestSuite::AttributeSnapshotTestSuite ()
+  : TestSuite ("attribute-snapshot", UNIT)
+{
+  AddTestCase (new AttributeSnapshotRestoreTestCase);
+  AddTestCase (new AttributeSnapshotSpacesTestCase);
+}
+
+static AttributeSnapshotTestSuite g_attributeSnapshotTestSuite;
+
+} // namespace ns3
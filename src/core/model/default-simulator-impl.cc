@@ -22,13 +22,16 @@
 #include "default-simulator-impl.h"
 #include "scheduler.h"
 #include "event-impl.h"
+#include "event-profiler.h"
 
 #include "ptr.h"
 #include "pointer.h"
+#include "string.h"
 #include "assert.h"
 #include "log.h"
 
 #include <math.h>
+#include <fstream>
 
 NS_LOG_COMPONENT_DEFINE ("DefaultSimulatorImpl");
 
@@ -42,11 +45,20 @@ DefaultSimulatorImpl::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::DefaultSimulatorImpl")
     .SetParent<SimulatorImpl> ()
     .AddConstructor<DefaultSimulatorImpl> ()
+    .AddAttribute ("EventProfile",
+                   "If not empty, measure the wall-clock time and allocations of every "
+                   "event, per target and context.  When the simulator is destroyed, a "
+                   "report is written to <EventProfile>.txt and folded stacks (in "
+                   "nanoseconds) for flamegraph.pl to <EventProfile>.folded.",
+                   StringValue (""),
+                   MakeStringAccessor (&DefaultSimulatorImpl::SetEventProfile),
+                   MakeStringChecker ())
   ;
   return tid;
 }
 
 DefaultSimulatorImpl::DefaultSimulatorImpl ()
+  : m_profiler (0)
 {
   m_stop = false;
   // uids are allocated from 4.
@@ -65,6 +77,19 @@ DefaultSimulatorImpl::DefaultSimulatorImpl ()
 
 DefaultSimulatorImpl::~DefaultSimulatorImpl ()
 {
+  delete m_profiler;
+}
+
+void
+DefaultSimulatorImpl::SetEventProfile (std::string prefix)
+{
+  m_eventProfile = prefix;
+  delete m_profiler;
+  m_profiler = 0;
+  if (!prefix.empty ())
+    {
+      m_profiler = new EventProfiler ();
+    }
 }
 
 void
@@ -91,6 +116,14 @@ DefaultSimulatorImpl::Destroy ()
           ev->Invoke ();
         }
     }
+  if (m_profiler != 0)
+    {
+      std::ofstream report ((m_eventProfile + ".txt").c_str ());
+      m_profiler->PrintReport (report);
+      std::ofstream folded ((m_eventProfile + ".folded").c_str ());
+      m_profiler->PrintFolded (folded);
+      NS_LOG_LOGIC ("wrote event profile to " << m_eventProfile << ".txt");
+    }
 }
 
 void
@@ -128,7 +161,18 @@ DefaultSimulatorImpl::ProcessOneEvent (void)
   m_currentTs = next.key.m_ts;
   m_currentContext = next.key.m_context;
   m_currentUid = next.key.m_uid;
-  next.impl->Invoke ();
+  // The object of a cancelled event may be gone: its target is not
+  // looked up
+  if (m_profiler != 0 && !next.impl->IsCancelled ())
+    {
+      m_profiler->Start (next.impl, m_currentContext);
+      next.impl->Invoke ();
+      m_profiler->Stop ();
+    }
+  else
+    {
+      next.impl->Invoke ();
+    }
   next.impl->Unref ();
 
   ProcessEventsWithContext ();
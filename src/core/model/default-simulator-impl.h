@@ -30,9 +30,12 @@
 #include "ptr.h"
 
 #include <list>
+#include <string>
 
 namespace ns3 {
 
+class EventProfiler;
+
 class DefaultSimulatorImpl : public SimulatorImpl
 {
 public:
@@ -64,6 +67,7 @@ private:
   virtual void DoDispose (void);
   void ProcessOneEvent (void);
   void ProcessEventsWithContext (void);
+  void SetEventProfile (std::string prefix);
  
   struct EventWithContext {
     uint32_t context;
@@ -89,6 +93,10 @@ private:
   int m_unscheduledEvents;
 
   SystemThread::ThreadId m_main;
+
+  // Opt-in, see the EventProfile attribute
+  std::string m_eventProfile;
+  EventProfiler *m_profiler;
 };
 
 } // namespace ns3
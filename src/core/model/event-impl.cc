@@ -52,4 +52,10 @@ EventImpl::IsCancelled (void)
   return m_cancel;
 }
 
+const void *
+EventImpl::GetTarget (void) const
+{
+  return 0;
+}
+
 } // namespace ns3
@@ -57,6 +57,15 @@ public:
    * Invoked by the simulation engine before calling Invoke.
    */
   bool IsCancelled (void);
+  /**
+   * \returns the address of the function the event calls, or 0 if
+   * unknown.
+   *
+   * The events built by MakeEvent return the function or, for a
+   * member function, the code it calls on the object.  Only used to
+   * profile the events, see EventProfiler.
+   */
+  virtual const void *GetTarget (void) const;
 
 protected:
   virtual void Notify (void) = 0;
@@ -0,0 +1,451 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "event-profiler.h"
+#include "event-impl.h"
+#include "ns3/core-config.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <new>
+#include <stdlib.h>
+
+#ifdef HAVE_RT
+#include <time.h>
+#else
+#include <sys/time.h>
+#endif
+
+#if (__GNUC__ >= 3)
+#include <cxxabi.h>
+#endif
+
+#ifdef HAVE_DLADDR
+#include <dlfcn.h>
+#endif
+
+#ifdef ENABLE_EVENT_PROFILER_ALLOC
+
+// The nothrow and delete operators must not throw; C++11 spells it
+// noexcept and later standards reject the dynamic specification.
+#if __cplusplus >= 201103L
+#define NS_NOTHROW noexcept
+#else
+#define NS_NOTHROW throw ()
+#endif
+
+// Only built with --enable-event-profiler-alloc: every operator new goes
+// through here, so that the profiler can tell how many allocations each
+// event made.  The profiler installs the counter of its thread while an
+// event runs; otherwise only the test of the null counter is added to the
+// default behavior.
+static __thread uint64_t *t_allocations = 0;
+
+static void *
+CountedAllocate (size_t size)
+{
+  if (t_allocations != 0)
+    {
+      (*t_allocations)++;
+    }
+  if (size == 0)
+    {
+      size = 1;
+    }
+  void *p;
+  while ((p = malloc (size)) == 0)
+    {
+      std::new_handler handler = std::set_new_handler (0);
+      std::set_new_handler (handler);
+      if (handler == 0)
+        {
+          throw std::bad_alloc ();
+        }
+      handler ();
+    }
+  return p;
+}
+
+void *
+operator new (size_t size)
+{
+  return CountedAllocate (size);
+}
+void *
+operator new[] (size_t size)
+{
+  return CountedAllocate (size);
+}
+void *
+operator new (size_t size, const std::nothrow_t &) NS_NOTHROW
+{
+  try
+    {
+      return CountedAllocate (size);
+    }
+  catch (...)
+    {
+      return 0;
+    }
+}
+void *
+operator new[] (size_t size, const std::nothrow_t &) NS_NOTHROW
+{
+  try
+    {
+      return CountedAllocate (size);
+    }
+  catch (...)
+    {
+      return 0;
+    }
+}
+void
+operator delete (void *p) NS_NOTHROW
+{
+  free (p);
+}
+void
+operator delete[] (void *p) NS_NOTHROW
+{
+  free (p);
+}
+void
+operator delete (void *p, const std::nothrow_t &) NS_NOTHROW
+{
+  free (p);
+}
+void
+operator delete[] (void *p, const std::nothrow_t &) NS_NOTHROW
+{
+  free (p);
+}
+
+#endif /* ENABLE_EVENT_PROFILER_ALLOC */
+
+namespace ns3 {
+
+EventProfiler::Stats::Stats ()
+  : count (0),
+    totalNs (0),
+    maxNs (0),
+    allocations (0)
+{
+}
+
+void
+EventProfiler::Stats::Add (const Stats &o)
+{
+  count += o.count;
+  totalNs += o.totalNs;
+  maxNs = std::max (maxNs, o.maxNs);
+  allocations += o.allocations;
+}
+
+EventProfiler::EventProfiler ()
+  : m_current (0, 0),
+    m_startNs (0),
+    m_allocations (0)
+{
+}
+
+uint64_t
+EventProfiler::GetWallClockNs (void)
+{
+#ifdef HAVE_RT
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t> (ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return static_cast<uint64_t> (tv.tv_sec) * 1000000000 + tv.tv_usec * 1000;
+#endif
+}
+
+void
+EventProfiler::Start (EventImpl *event, uint32_t context)
+{
+  // The function called by the event when known, its type otherwise
+  Target target (event->GetTarget (), 0);
+  if (target.first == 0)
+    {
+      target.second = &typeid (*event);
+    }
+  std::map<Target, uint32_t>::const_iterator i = m_targetIndex.find (target);
+  uint32_t index;
+  if (i == m_targetIndex.end ())
+    {
+      index = m_targets.size ();
+      m_targetIndex[target] = index;
+      m_targets.push_back (std::make_pair (target.first, &typeid (*event)));
+    }
+  else
+    {
+      index = i->second;
+    }
+  m_current = Key (index, context);
+#ifdef ENABLE_EVENT_PROFILER_ALLOC
+  m_allocations = 0;
+  t_allocations = &m_allocations;
+#endif /* ENABLE_EVENT_PROFILER_ALLOC */
+  // last, to leave the bookkeeping above out of the measurement
+  m_startNs = GetWallClockNs ();
+}
+
+void
+EventProfiler::Stop (void)
+{
+  uint64_t elapsed = GetWallClockNs () - m_startNs;
+#ifdef ENABLE_EVENT_PROFILER_ALLOC
+  t_allocations = 0;
+#endif /* ENABLE_EVENT_PROFILER_ALLOC */
+  Stats &stats = m_stats[m_current];
+  stats.count++;
+  stats.totalNs += elapsed;
+  stats.maxNs = std::max (stats.maxNs, elapsed);
+  stats.allocations += m_allocations;
+}
+
+std::string
+EventProfiler::GetTargetName (const void *function, const std::type_info &info)
+{
+#ifdef HAVE_DLADDR
+  Dl_info symbol;
+  if (function != 0 && dladdr (const_cast<void *> (function), &symbol) != 0)
+    {
+      if (symbol.dli_sname != 0 && symbol.dli_saddr == function)
+        {
+          return Demangle (symbol.dli_sname);
+        }
+      // Not exported: the type of the event tells the class and the
+      // arguments, and the offset in the library where to look for it
+      std::ostringstream oss;
+      std::string library = symbol.dli_fname != 0 ? symbol.dli_fname : "";
+      oss << GetTypeName (info) << " at " << library.substr (library.rfind ('/') + 1)
+          << "+0x" << std::hex
+          << static_cast<const char *> (function) - static_cast<const char *> (symbol.dli_fbase);
+      return oss.str ();
+    }
+#endif /* HAVE_DLADDR */
+  return GetTypeName (info);
+}
+
+std::string
+EventProfiler::Demangle (std::string name)
+{
+#if (__GNUC__ >= 3)
+  int status;
+  char *demangled = abi::__cxa_demangle (name.c_str (), NULL, NULL, &status);
+  if (status == 0)
+    {
+      name = demangled;
+    }
+  free (demangled);
+#endif
+  return name;
+}
+
+std::string
+EventProfiler::GetTypeName (const std::type_info &info)
+{
+  std::string name = Demangle (info.name ());
+  // MakeEvent builds local classes, named after the MakeEvent
+  // instantiation: keep its template arguments only.
+  std::string::size_type start = name.find ("MakeEvent<");
+  if (start == std::string::npos)
+    {
+      std::string::size_type paren = name.find ("MakeEvent(");
+      if (paren != std::string::npos)
+        {
+          // zero argument function, MakeEvent is not a template
+          return "void (*)()";
+        }
+      return name;
+    }
+  start += std::string ("MakeEvent<").size ();
+  std::vector<std::string> arguments;
+  std::string::size_type begin = start;
+  int depth = 0;
+  for (std::string::size_type i = start; i < name.size (); ++i)
+    {
+      char c = name[i];
+      if (c == '<' || c == '(')
+        {
+          depth++;
+        }
+      else if ((c == ')' || c == '>') && depth > 0)
+        {
+          depth--;
+        }
+      else if (c == ',' && depth == 0)
+        {
+          arguments.push_back (name.substr (begin, i - begin));
+          begin = i + 2;
+        }
+      else if (c == '>')
+        {
+          arguments.push_back (name.substr (begin, i - begin));
+          break;
+        }
+    }
+  if (arguments.empty ())
+    {
+      return name;
+    }
+  if (arguments[0].find ("::*") != std::string::npos)
+    {
+      // member function: the member function pointer type
+      return arguments[0];
+    }
+  // function: the first half of the arguments are its parameter types
+  std::ostringstream oss;
+  oss << "void (*)(";
+  for (uint32_t i = 0; i < arguments.size () / 2; ++i)
+    {
+      oss << (i == 0 ? "" : ", ") << arguments[i];
+    }
+  oss << ")";
+  return oss.str ();
+}
+
+std::string
+EventProfiler::GetContextName (uint32_t context)
+{
+  if (context == 0xffffffff)
+    {
+      return "no context";
+    }
+  std::ostringstream oss;
+  oss << "context " << context;
+  return oss.str ();
+}
+
+static bool
+CompareTotal (const std::pair<std::string, uint64_t> &a,
+              const std::pair<std::string, uint64_t> &b)
+{
+  return a.second > b.second;
+}
+
+void
+EventProfiler::GetTargetStats (std::vector<std::pair<std::string, Stats> > &targets) const
+{
+  std::vector<std::string> names;
+  GetTargetNames (names);
+  std::map<std::string, Stats> byName;
+  for (std::map<Key, Stats>::const_iterator i = m_stats.begin (); i != m_stats.end (); ++i)
+    {
+      byName[names[i->first.first]].Add (i->second);
+    }
+  std::vector<std::pair<std::string, uint64_t> > order;
+  for (std::map<std::string, Stats>::const_iterator i = byName.begin (); i != byName.end (); ++i)
+    {
+      order.push_back (std::make_pair (i->first, i->second.totalNs));
+    }
+  std::stable_sort (order.begin (), order.end (), CompareTotal);
+  for (std::vector<std::pair<std::string, uint64_t> >::const_iterator i = order.begin ();
+       i != order.end (); ++i)
+    {
+      targets.push_back (std::make_pair (i->first, byName[i->first]));
+    }
+}
+
+void
+EventProfiler::PrintReport (std::ostream &os, uint32_t contexts) const
+{
+  std::vector<std::pair<std::string, Stats> > targets;
+  GetTargetStats (targets);
+  Stats all;
+  for (std::vector<std::pair<std::string, Stats> >::const_iterator i = targets.begin ();
+       i != targets.end (); ++i)
+    {
+      all.Add (i->second);
+    }
+
+  os << std::setw (12) << "events"
+     << std::setw (12) << "total(ms)"
+     << std::setw (8) << "%"
+     << std::setw (12) << "mean(us)"
+     << std::setw (12) << "max(us)"
+     << std::setw (12) << "allocs"
+     << "  target" << std::endl;
+  for (std::vector<std::pair<std::string, Stats> >::const_iterator i = targets.begin ();
+       i != targets.end (); ++i)
+    {
+      const Stats &s = i->second;
+      os << std::setw (12) << s.count
+         << std::setw (12) << std::fixed << std::setprecision (3) << s.totalNs / 1e6
+         << std::setw (8) << std::setprecision (1) << (all.totalNs ? 100.0 * s.totalNs / all.totalNs : 0.0)
+         << std::setw (12) << std::setprecision (3) << s.totalNs / 1e3 / s.count
+         << std::setw (12) << s.maxNs / 1e3
+#ifdef ENABLE_EVENT_PROFILER_ALLOC
+         << std::setw (12) << s.allocations
+#else
+         << std::setw (12) << "-"
+#endif /* ENABLE_EVENT_PROFILER_ALLOC */
+         << "  " << i->first << std::endl;
+    }
+  os << std::setw (12) << all.count
+     << std::setw (12) << std::setprecision (3) << all.totalNs / 1e6
+     << "          total" << std::endl;
+
+  // Contexts which used the most time
+  std::map<uint32_t, Stats> byContext;
+  for (std::map<Key, Stats>::const_iterator i = m_stats.begin (); i != m_stats.end (); ++i)
+    {
+      byContext[i->first.second].Add (i->second);
+    }
+  std::vector<std::pair<std::string, uint64_t> > order;
+  for (std::map<uint32_t, Stats>::const_iterator i = byContext.begin (); i != byContext.end (); ++i)
+    {
+      order.push_back (std::make_pair (GetContextName (i->first), i->second.totalNs));
+    }
+  std::stable_sort (order.begin (), order.end (), CompareTotal);
+  os << std::endl << std::setw (12) << "total(ms)" << "  context" << std::endl;
+  for (uint32_t i = 0; i < order.size () && i < contexts; ++i)
+    {
+      os << std::setw (12) << std::setprecision (3) << order[i].second / 1e6
+         << "  " << order[i].first << std::endl;
+    }
+  os.unsetf (std::ios::floatfield);
+}
+
+void
+EventProfiler::GetTargetNames (std::vector<std::string> &names) const
+{
+  for (std::vector<Target>::const_iterator i = m_targets.begin (); i != m_targets.end (); ++i)
+    {
+      names.push_back (GetTargetName (i->first, *i->second));
+    }
+}
+
+void
+EventProfiler::PrintFolded (std::ostream &os) const
+{
+  std::vector<std::string> names;
+  GetTargetNames (names);
+  for (std::map<Key, Stats>::const_iterator i = m_stats.begin (); i != m_stats.end (); ++i)
+    {
+      // ';' separates the frames of a folded stack
+      std::string target = names[i->first.first];
+      std::replace (target.begin (), target.end (), ';', ',');
+      os << GetContextName (i->first.second) << ";" << target << " " << i->second.totalNs << std::endl;
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,120 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef EVENT_PROFILER_H
+#define EVENT_PROFILER_H
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <typeinfo>
+
+namespace ns3 {
+
+class EventImpl;
+
+/**
+ * \ingroup simulator
+ *
+ * \brief Attribute wall-clock time and memory allocations to events
+ *
+ * Every event is accounted to its target and to its context (the node
+ * id for events scheduled with Simulator::ScheduleWithContext).  The
+ * target is the function the event calls, as captured by MakeEvent (see
+ * EventImpl::GetTarget): for a virtual member function, the override of
+ * the object.  The report names it from the symbols of the libraries
+ * (with dladdr); a function which is not exported, or an event which
+ * does not tell its target, is named after the type of the event: the
+ * member function pointer type, or the argument types of a function.
+ *
+ * For each (target, context) pair, the number of events and the total
+ * and maximum wall-clock time are recorded.  When built with
+ * --enable-event-profiler-alloc, which replaces the global operator new
+ * of the core library, the calls to operator new made by the simulation
+ * thread while the events ran are counted too.
+ *
+ * See the DefaultSimulatorImpl::EventProfile attribute.
+ */
+class EventProfiler
+{
+public:
+  EventProfiler ();
+
+  /**
+   * \param event the event about to be invoked
+   * \param context the context of the event
+   */
+  void Start (EventImpl *event, uint32_t context);
+  /**
+   * Account the time since the last call to Start.
+   */
+  void Stop (void);
+
+  /**
+   * Print one line per target, sorted by decreasing total time, followed
+   * by the contexts which used the most time.
+   *
+   * \param os the output stream
+   * \param contexts the number of contexts to report
+   */
+  void PrintReport (std::ostream &os, uint32_t contexts = 20) const;
+  /**
+   * Print the "context;target nanoseconds" lines expected by
+   * flamegraph.pl and compatible tools.
+   *
+   * \param os the output stream
+   */
+  void PrintFolded (std::ostream &os) const;
+
+private:
+  struct Stats
+  {
+    Stats ();
+    void Add (const Stats &o);
+    uint64_t count;
+    uint64_t totalNs;
+    uint64_t maxNs;
+    uint64_t allocations;
+  };
+  typedef std::pair<uint32_t, uint32_t> Key; // target index, context
+
+  static uint64_t GetWallClockNs (void);
+  typedef std::pair<const void *, const std::type_info *> Target;
+
+  static std::string GetTargetName (const void *function, const std::type_info &info);
+  static std::string GetTypeName (const std::type_info &info);
+  static std::string Demangle (std::string name);
+  void GetTargetNames (std::vector<std::string> &names) const;
+  static std::string GetContextName (uint32_t context);
+  // Targets sharing the same name (types instantiated in different
+  // libraries may have distinct type_info objects) merged together
+  void GetTargetStats (std::vector<std::pair<std::string, Stats> > &targets) const;
+
+  // Function, or type of the events of unknown function
+  std::map<Target, uint32_t> m_targetIndex;
+  // Function and type of the first event of each target
+  std::vector<Target> m_targets;
+  std::map<Key, Stats> m_stats;
+
+  Key m_current;
+  uint64_t m_startNs;
+  uint64_t m_allocations;
+};
+
+} // namespace ns3
+
+#endif /* EVENT_PROFILER_H */
@@ -1,5 +1,8 @@
 #include "make-event.h"
 
+#include <cstddef>
+#include <cstring>
+
 namespace ns3 {
 
 EventImpl * MakeEvent (void (*f)(void))
@@ -14,6 +17,10 @@ public:
       : m_function (function)
     {
     }
+    virtual const void *GetTarget (void) const
+    {
+      return MakeEventFunctionTarget (&m_function, sizeof (m_function));
+    }
     virtual ~EventFunctionImpl0 ()
     {
     }
@@ -28,4 +35,51 @@ private:
   return ev;
 }
 
+const void *
+MakeEventMemberTarget (const void *object, const void *memPtr, uint32_t size)
+{
+#if defined (__GNUC__) && (defined (__i386__) || defined (__x86_64__) || defined (__arm__) || defined (__aarch64__))
+  // Itanium C++ ABI: the address of the function or, for a virtual
+  // function, its offset in the vtable, then the adjustment of this
+  if (size != 2 * sizeof (ptrdiff_t))
+    {
+      return 0;
+    }
+  ptrdiff_t words[2];
+  std::memcpy (words, memPtr, sizeof (words));
+  ptrdiff_t ptr = words[0];
+  ptrdiff_t adj = words[1];
+#if defined (__arm__) || defined (__aarch64__)
+  // the functions may be at odd addresses: the adjustment is doubled to
+  // flag the virtual functions
+  bool isVirtual = (adj & 1) != 0;
+  adj >>= 1;
+  ptrdiff_t offset = ptr;
+#else
+  bool isVirtual = (ptr & 1) != 0;
+  ptrdiff_t offset = ptr - 1;
+#endif
+  if (!isVirtual)
+    {
+      return reinterpret_cast<const void *> (ptr);
+    }
+  const char *vtable = *reinterpret_cast<const char * const *> (static_cast<const char *> (object) + adj);
+  return *reinterpret_cast<const void * const *> (vtable + offset);
+#else
+  return 0;
+#endif
+}
+
+const void *
+MakeEventFunctionTarget (const void *fnPtr, uint32_t size)
+{
+  // A function pointer does not convert to void * in C++98
+  const void *target = 0;
+  if (size == sizeof (target))
+    {
+      std::memcpy (&target, fnPtr, size);
+    }
+  return target;
+}
+
 } // namespace ns3
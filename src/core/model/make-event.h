@@ -73,6 +73,26 @@ struct EventMemberImplObjTraits<T *>
   }
 };
 
+/**
+ * \returns the address of the code called by the member function
+ * pointer of size bytes at memPtr on the object, or 0 if the layout of
+ * the member function pointers of the compiler is unknown
+ */
+const void *MakeEventMemberTarget (const void *object, const void *memPtr, uint32_t size);
+/**
+ * \returns the address of the function pointer of size bytes at fnPtr
+ */
+const void *MakeEventFunctionTarget (const void *fnPtr, uint32_t size);
+
+template <typename MEM, typename OBJ>
+const void *MakeEventMemberTarget (MEM mem_ptr, OBJ obj)
+{
+  // this as seen by the class of the member function
+  typedef typename TypeTraits<MEM>::PointerToMemberTraits::ObjectType Class;
+  const Class &object = EventMemberImplObjTraits<OBJ>::GetReference (obj);
+  return MakeEventMemberTarget (&object, &mem_ptr, sizeof (mem_ptr));
+}
+
 template <typename MEM, typename OBJ>
 EventImpl * MakeEvent (MEM mem_ptr, OBJ obj)
 {
@@ -85,6 +105,10 @@ public:
         m_function (function)
     {
     }
+    virtual const void *GetTarget (void) const
+    {
+      return MakeEventMemberTarget (m_function, m_obj);
+    }
     virtual ~EventMemberImpl0 ()
     {
     }
@@ -114,6 +138,10 @@ public:
         m_a1 (a1)
     {
     }
+    virtual const void *GetTarget (void) const
+    {
+      return MakeEventMemberTarget (m_function, m_obj);
+    }
 protected:
     virtual ~EventMemberImpl1 ()
     {
@@ -145,6 +173,10 @@ public:
         m_a2 (a2)
     {
     }
+    virtual const void *GetTarget (void) const
+    {
+      return MakeEventMemberTarget (m_function, m_obj);
+    }
 protected:
     virtual ~EventMemberImpl2 ()
     {
@@ -178,6 +210,10 @@ public:
         m_a3 (a3)
     {
     }
+    virtual const void *GetTarget (void) const
+    {
+      return MakeEventMemberTarget (m_function, m_obj);
+    }
 protected:
     virtual ~EventMemberImpl3 ()
     {
@@ -213,6 +249,10 @@ public:
         m_a4 (a4)
     {
     }
+    virtual const void *GetTarget (void) const
+    {
+      return MakeEventMemberTarget (m_function, m_obj);
+    }
 protected:
     virtual ~EventMemberImpl4 ()
     {
@@ -251,6 +291,10 @@ public:
         m_a5 (a5)
     {
     }
+    virtual const void *GetTarget (void) const
+    {
+      return MakeEventMemberTarget (m_function, m_obj);
+    }
 protected:
     virtual ~EventMemberImpl5 ()
     {
@@ -285,6 +329,10 @@ public:
         m_a1 (a1)
     {
     }
+    virtual const void *GetTarget (void) const
+    {
+      return MakeEventFunctionTarget (&m_function, sizeof (m_function));
+    }
 protected:
     virtual ~EventFunctionImpl1 ()
     {
@@ -315,6 +363,10 @@ public:
         m_a2 (a2)
     {
     }
+    virtual const void *GetTarget (void) const
+    {
+      return MakeEventFunctionTarget (&m_function, sizeof (m_function));
+    }
 protected:
     virtual ~EventFunctionImpl2 ()
     {
@@ -348,6 +400,10 @@ public:
         m_a3 (a3)
     {
     }
+    virtual const void *GetTarget (void) const
+    {
+      return MakeEventFunctionTarget (&m_function, sizeof (m_function));
+    }
 protected:
     virtual ~EventFunctionImpl3 ()
     {
@@ -383,6 +439,10 @@ public:
         m_a4 (a4)
     {
     }
+    virtual const void *GetTarget (void) const
+    {
+      return MakeEventFunctionTarget (&m_function, sizeof (m_function));
+    }
 protected:
     virtual ~EventFunctionImpl4 ()
     {
@@ -420,6 +480,10 @@ public:
         m_a5 (a5)
     {
     }
+    virtual const void *GetTarget (void) const
+    {
+      return MakeEventFunctionTarget (&m_function, sizeof (m_function));
+    }
 protected:
     virtual ~EventFunctionImpl5 ()
     {
@@ -387,6 +387,15 @@ public:
    */
   inline static Time FromDouble (double value, enum Unit timeUnit)
   {
+    struct Information *info = PeekInformation (timeUnit);
+    // Whole values scaled up to the resolution are exact in integer
+    // time steps: Seconds (1.0) needs no 128-bit multiplication.
+    // Negative values keep the int64x64_t rounding they always had.
+    if (info->fromMul && value >= 0 && value == floor (value)
+        && value < 9.2e18 / info->factor)
+      {
+        return Time (static_cast<int64_t> (value) * static_cast<int64_t> (info->factor));
+      }
     return From (int64x64_t (value), timeUnit);
   }
   /**
@@ -536,6 +545,43 @@ inline Time &operator -= (Time &lhs, const Time &rhs)
   return lhs;
 }
 
+/**
+ * \relates ns3::Time
+ *
+ * Scaling a Time by an integer stays in integer time steps: the result
+ * is exact, so there is no need to go through the 128-bit int64x64_t
+ * arithmetic the generic Time * int64x64_t path would use.  Scaling by
+ * a double keeps using int64x64_t so that fractional results are not
+ * truncated before they are converted back to a Time.
+ */
+#define TIME_INTEGER_SCALE_DEFINE(type)                                 \
+  inline Time operator * (const Time &lhs, type rhs)                    \
+  {                                                                     \
+    return Time (lhs.GetTimeStep () * static_cast<int64_t> (rhs));      \
+  }                                                                     \
+  inline Time operator * (type lhs, const Time &rhs)                    \
+  {                                                                     \
+    return Time (static_cast<int64_t> (lhs) * rhs.GetTimeStep ());      \
+  }
+
+TIME_INTEGER_SCALE_DEFINE (int)
+TIME_INTEGER_SCALE_DEFINE (unsigned int)
+TIME_INTEGER_SCALE_DEFINE (long int)
+TIME_INTEGER_SCALE_DEFINE (unsigned long int)
+TIME_INTEGER_SCALE_DEFINE (long long int)
+TIME_INTEGER_SCALE_DEFINE (unsigned long long int)
+
+#undef TIME_INTEGER_SCALE_DEFINE
+
+inline int64x64_t operator * (const Time &lhs, double rhs)
+{
+  return int64x64_t (lhs) * int64x64_t (rhs);
+}
+inline int64x64_t operator * (double lhs, const Time &rhs)
+{
+  return int64x64_t (lhs) * int64x64_t (rhs);
+}
+
 /**
  * \anchor ns3-Time-Abs
  * \relates ns3::TimeUnit
@@ -95,6 +95,7 @@ public:
   virtual double  GetValue () = 0;
   virtual uint32_t GetInteger ();
   virtual RandomVariableBase*   Copy (void) const = 0;
+  void SetStream (int64_t stream);
 
 protected:
   RngStream* m_generator;  // underlying generator being wrapped
@@ -124,6 +125,13 @@ uint32_t RandomVariableBase::GetInteger ()
   return (uint32_t)GetValue ();
 }
 
+void
+RandomVariableBase::SetStream (int64_t stream)
+{
+  delete m_generator;
+  m_generator = new RngStream (stream);
+}
+
 // -------------------------------------------------------
 
 RandomVariable::RandomVariable ()
@@ -165,6 +173,13 @@ RandomVariable::GetInteger (void) const
   return m_variable->GetInteger ();
 }
 
+void
+RandomVariable::SetStream (int64_t stream)
+{
+  NS_ASSERT (m_variable != 0);
+  m_variable->SetStream (stream);
+}
+
 RandomVariableBase *
 RandomVariable::Peek (void) const
 {
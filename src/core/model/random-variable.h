@@ -137,6 +137,17 @@ public:
    */
   uint32_t GetInteger (void) const;
 
+  /**
+   * \brief Draw the values from the stream of the given index
+   * \param stream the stream index, from 0 to 2^31-1
+   *
+   * By default, a random variable draws from the next free stream when
+   * it first needs a value, so that its values depend on what the other
+   * variables did before.  The stream of a given index only depends on
+   * the seed and the run number.
+   */
+  void SetStream (int64_t stream);
+
 private:
   friend std::ostream & operator << (std::ostream &os, const RandomVariable &var);
   friend std::istream & operator >> (std::istream &os, RandomVariable &var);
@@ -20,9 +20,12 @@
 
 #include <cstdlib>
 #include <iostream>
+#include <algorithm>
 #include "rng-stream.h"
 #include "global-value.h"
 #include "integer.h"
+#include "abort.h"
+#include "assert.h"
 using namespace std;
 
 namespace
@@ -343,12 +346,53 @@ RngStream::RngStream ()
 
   anti = false;
   incPrec = false;
+  index = -1;
   // Stream initialization moved to separate method.
   InitializeStream ();
   //move the state of this stream up
   ResetNthSubstream (run);
 }
 
+RngStream::RngStream (int64_t stream)
+{
+  NS_ABORT_MSG_UNLESS (stream >= 0 && stream < 0x80000000LL, "Invalid stream index " << stream);
+  uint32_t run = EnsureGlobalInitialized ();
+
+  anti = false;
+  incPrec = false;
+  // The indexed streams start 2^64 streams after the package seed, well
+  // past the streams handed out by the default constructor
+  uint32_t seed[6];
+  GetPackageSeed (seed);
+  double B1[3][3], C1[3][3], B2[3][3], C2[3][3];
+  MatTwoPowModM (A1p127, B1, m1, 64);
+  MatTwoPowModM (A2p127, B2, m2, 64);
+  MatPowModM (A1p127, C1, m1, static_cast<int32_t> (stream));
+  MatPowModM (A2p127, C2, m2, static_cast<int32_t> (stream));
+  MatMatModM (B1, C1, C1, m1);
+  MatMatModM (B2, C2, C2, m2);
+  for (int i = 0; i < 6; ++i) {
+      Ig[i] = seed[i];
+    }
+  MatVecModM (C1, Ig, Ig, m1);
+  MatVecModM (C2, &Ig[3], &Ig[3], m2);
+  for (int i = 0; i < 6; ++i) {
+      Bg[i] = Cg[i] = Ig[i];
+    }
+  ResetNthSubstream (run);
+
+  index = stream;
+  Register ();
+  StateMap::iterator state = GetPendingStates ().find (index);
+  if (state != GetPendingStates ().end ())
+    {
+      for (int i = 0; i < 6; ++i) {
+          Cg[i] = state->second[i];
+        }
+      GetPendingStates ().erase (state);
+    }
+}
+
 RngStream::RngStream(const RngStream& r)
 {
   anti = r.anti;
@@ -358,6 +402,63 @@ RngStream::RngStream(const RngStream& r)
       Bg[i] = r.Bg[i];
       Ig[i] = r.Ig[i];
     }
+  // A copy carries on with the draws of the original, e.g. when a
+  // random variable is set as an attribute
+  index = r.index;
+  Register ();
+}
+
+RngStream &
+RngStream::operator= (const RngStream &r)
+{
+  if (this == &r)
+    {
+      return *this;
+    }
+  anti = r.anti;
+  incPrec = r.incPrec;
+  for (int i = 0; i < 6; ++i) {
+      Cg[i] = r.Cg[i];
+      Bg[i] = r.Bg[i];
+      Ig[i] = r.Ig[i];
+    }
+  if (index != r.index)
+    {
+      Unregister ();
+      index = r.index;
+      Register ();
+    }
+  return *this;
+}
+
+RngStream::~RngStream ()
+{
+  Unregister ();
+}
+
+void
+RngStream::Register (void)
+{
+  if (index >= 0)
+    {
+      GetIndexedStreams ()[index].push_back (this);
+    }
+}
+
+void
+RngStream::Unregister (void)
+{
+  if (index < 0)
+    {
+      return;
+    }
+  StreamMap::iterator streams = GetIndexedStreams ().find (index);
+  NS_ASSERT (streams != GetIndexedStreams ().end ());
+  streams->second.erase (std::find (streams->second.begin (), streams->second.end (), this));
+  if (streams->second.empty ())
+    {
+      GetIndexedStreams ().erase (streams);
+    }
 }
 
 
@@ -453,6 +554,65 @@ RngStream::GetPackageSeed (uint32_t seed[6])
       seed[i] = static_cast<uint32_t> (theSeed);
     }
 }
+// The seed the next stream will be initialized from.  Together with
+// the seed and run number, it is all that is needed to hand out the
+// same sequence of streams again, e.g. after restoring a snapshot.
+void
+RngStream::GetNextSeed (uint32_t seed[6])
+{
+  EnsureGlobalInitialized ();
+  for (int i = 0; i < 6; i++)
+    {
+      seed[i] = static_cast<uint32_t> (nextSeed[i]);
+    }
+}
+std::vector<int64_t>
+RngStream::GetStreams (void)
+{
+  std::vector<int64_t> streams;
+  for (StreamMap::const_iterator i = GetIndexedStreams ().begin (); i != GetIndexedStreams ().end (); ++i)
+    {
+      streams.push_back (i->first);
+    }
+  return streams;
+}
+void
+RngStream::GetStreamState (int64_t stream, uint32_t state[6])
+{
+  StreamMap::const_iterator i = GetIndexedStreams ().find (stream);
+  NS_ABORT_MSG_UNLESS (i != GetIndexedStreams ().end (), "No stream of index " << stream);
+  // The most recent copy is the one which is drawn from
+  i->second.back ()->GetState (state);
+}
+bool
+RngStream::SetStreamState (int64_t stream, const uint32_t state[6])
+{
+  if (!CheckSeed (state))
+    {
+      return false;
+    }
+  GetPendingStates ()[stream] = std::vector<uint32_t> (state, state + 6);
+  return true;
+}
+RngStream::StreamMap &
+RngStream::GetIndexedStreams (void)
+{
+  static StreamMap streams;
+  return streams;
+}
+RngStream::StateMap &
+RngStream::GetPendingStates (void)
+{
+  static StateMap states;
+  return states;
+}
+bool
+RngStream::SetNextSeed (const uint32_t seed[6])
+{
+  // Make sure the package seed does not overwrite it later on
+  EnsureGlobalInitialized ();
+  return SetPackageSeed (seed);
+}
 void 
 RngStream::SetPackageRun (uint32_t run)
 {
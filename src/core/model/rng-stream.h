@@ -20,6 +20,8 @@
 #ifndef RNGSTREAM_H
 #define RNGSTREAM_H
 #include <string>
+#include <map>
+#include <vector>
 #include <stdint.h>
 
 namespace ns3 {
@@ -39,7 +41,19 @@ namespace ns3 {
 class RngStream {
 public:  //public api
   RngStream ();
+  /**
+   * Create the stream of the given index.  Unlike the streams of the
+   * default constructor, which are handed out in creation order, it
+   * only depends on the seed, the run number and the index.
+   */
+  explicit RngStream (int64_t stream);
   RngStream (const RngStream&);
+  /**
+   * Copy the state of another stream.  This stream is moved to the
+   * index of the other one, so that it is saved and restored with it.
+   */
+  RngStream & operator= (const RngStream &r);
+  ~RngStream ();
   void InitializeStream (); // Separate initialization
   void ResetStartStream ();
   void ResetStartSubstream ();
@@ -56,13 +70,37 @@ public: //public static api
   static bool SetPackageSeed (uint32_t seed);
   static bool SetPackageSeed (const uint32_t seed[6]);
   static void GetPackageSeed (uint32_t seed[6]);
+  static void GetNextSeed (uint32_t seed[6]);
+  static bool SetNextSeed (const uint32_t seed[6]);
+  /**
+   * \returns the indices of the streams in use
+   */
+  static std::vector<int64_t> GetStreams (void);
+  /**
+   * \param stream the index of a stream in use
+   * \param state the current state of the stream, as by GetState
+   */
+  static void GetStreamState (int64_t stream, uint32_t state[6]);
+  /**
+   * The next stream created with the given index starts from the given
+   * state instead of the beginning of its substream, e.g. to continue
+   * the draws of a saved run.
+   */
+  static bool SetStreamState (int64_t stream, const uint32_t state[6]);
   static void SetPackageRun (uint32_t run);
   static uint32_t GetPackageRun (void);
   static bool CheckSeed (const uint32_t seed[6]);
   static bool CheckSeed (uint32_t seed);
 private: //members
+  typedef std::map<int64_t, std::vector<RngStream *> > StreamMap;
+  typedef std::map<int64_t, std::vector<uint32_t> > StateMap;
   double Cg[6], Bg[6], Ig[6];
   bool anti, incPrec;
+  int64_t index; // -1 unless created with a stream index
+  static StreamMap & GetIndexedStreams (void);
+  static StateMap & GetPendingStates (void);
+  void Register (void);
+  void Unregister (void);
   double U01 ();
   double U01d ();
   static uint32_t EnsureGlobalInitialized (void);
@@ -122,6 +122,7 @@ private:
   struct PtrToMemberTraits <U (V::*) (void)>
   {
     enum { IsPointerToMember = 1};
+    typedef V ObjectType;
     enum { nArgs = 0};
     typedef U ReturnType;
   };
@@ -129,6 +130,7 @@ private:
   struct PtrToMemberTraits <U (V::*) (void) const>
   {
     enum { IsPointerToMember = 1};
+    typedef V ObjectType;
     enum { nArgs = 0};
     typedef U ReturnType;
   };
@@ -136,6 +138,7 @@ private:
   struct PtrToMemberTraits <U (V::*) (W1)>
   {
     enum { IsPointerToMember = 1};
+    typedef V ObjectType;
     enum { nArgs = 1};
     typedef U ReturnType;
     typedef W1 Arg1Type;
@@ -144,6 +147,7 @@ private:
   struct PtrToMemberTraits <U (V::*) (W1) const>
   {
     enum { IsPointerToMember = 1};
+    typedef V ObjectType;
     enum { nArgs = 1};
     typedef U ReturnType;
     typedef W1 Arg1Type;
@@ -152,6 +156,7 @@ private:
   struct PtrToMemberTraits <U (V::*) (W1,W2)>
   {
     enum { IsPointerToMember = 1};
+    typedef V ObjectType;
     enum { nArgs = 2};
     typedef U ReturnType;
     typedef W1 Arg1Type;
@@ -161,6 +166,7 @@ private:
   struct PtrToMemberTraits <U (V::*) (W1,W2) const>
   {
     enum { IsPointerToMember = 1};
+    typedef V ObjectType;
     enum { nArgs = 2};
     typedef U ReturnType;
     typedef W1 Arg1Type;
@@ -172,6 +178,7 @@ private:
   struct PtrToMemberTraits <U (V::*) (W1,W2,W3)>
   {
     enum { IsPointerToMember = 1};
+    typedef V ObjectType;
     enum { nArgs = 3};
     typedef U ReturnType;
     typedef W1 Arg1Type;
@@ -184,6 +191,7 @@ private:
   struct PtrToMemberTraits <U (V::*) (W1,W2,W3) const>
   {
     enum { IsPointerToMember = 1};
+    typedef V ObjectType;
     enum { nArgs = 3};
     typedef U ReturnType;
     typedef W1 Arg1Type;
@@ -196,6 +204,7 @@ private:
   struct PtrToMemberTraits <U (V::*) (W1,W2,W3,W4)>
   {
     enum { IsPointerToMember = 1};
+    typedef V ObjectType;
     enum { nArgs = 4};
     typedef U ReturnType;
     typedef W1 Arg1Type;
@@ -209,6 +218,7 @@ private:
   struct PtrToMemberTraits <U (V::*) (W1,W2,W3,W4) const>
   {
     enum { IsPointerToMember = 1};
+    typedef V ObjectType;
     enum { nArgs = 4};
     typedef U ReturnType;
     typedef W1 Arg1Type;
@@ -223,6 +233,7 @@ private:
   struct PtrToMemberTraits <U (V::*) (W1,W2,W3,W4,W5)>
   {
     enum { IsPointerToMember = 1};
+    typedef V ObjectType;
     enum { nArgs = 5};
     typedef U ReturnType;
     typedef W1 Arg1Type;
@@ -238,6 +249,7 @@ private:
   struct PtrToMemberTraits <U (V::*) (W1,W2,W3,W4,W5) const>
   {
     enum { IsPointerToMember = 1};
+    typedef V ObjectType;
     enum { nArgs = 5};
     typedef U ReturnType;
     typedef W1 Arg1Type;
@@ -253,6 +265,7 @@ private:
   struct PtrToMemberTraits <U (V::*) (W1,W2,W3,W4,W5,W6)>
   {
     enum { IsPointerToMember = 1};
+    typedef V ObjectType;
     enum { nArgs = 6};
     typedef U ReturnType;
     typedef W1 Arg1Type;
@@ -269,6 +282,7 @@ private:
   struct PtrToMemberTraits <U (V::*) (W1,W2,W3,W4,W5,W6) const>
   {
     enum { IsPointerToMember = 1};
+    typedef V ObjectType;
     enum { nArgs = 6};
     typedef U ReturnType;
     typedef W1 Arg1Type;
@@ -20,12 +20,14 @@
 //
 
 #include <iostream>
+#include <algorithm>
 #include <math.h>
 
 #include "ns3/test.h"
 #include "ns3/assert.h"
 #include "ns3/integer.h"
 #include "ns3/random-variable.h"
+#include "ns3/rng-stream.h"
 
 using namespace std;
 
@@ -129,6 +131,98 @@ RandomNumberSerializationTestCase::DoRun (void)
                          "Deserialize and Serialize \"Normal:0.1:0.2:0.15\" mismatch");
 }
 
+class RandomNumberStreamTestCase : public TestCase
+{
+public:
+  RandomNumberStreamTestCase ();
+  virtual ~RandomNumberStreamTestCase ()
+  {
+  }
+
+private:
+  virtual void DoRun (void);
+};
+
+RandomNumberStreamTestCase::RandomNumberStreamTestCase ()
+  : TestCase ("Check that the values of a stream do not depend on the other variables")
+{
+}
+
+void
+RandomNumberStreamTestCase::DoRun (void)
+{
+  UniformVariable first;
+  first.SetStream (5);
+  vector<double> values;
+  for (int n = 0; n < 10; ++n)
+    {
+      values.push_back (first.GetValue ());
+    }
+
+  // Draw from other variables in between: with the default streams,
+  // this would change the values of the next variable
+  UniformVariable other;
+  other.GetValue ();
+  UniformVariable second;
+  second.SetStream (5);
+  UniformVariable third;
+  third.SetStream (6);
+  bool differ = false;
+  for (int n = 0; n < 10; ++n)
+    {
+      double value = second.GetValue ();
+      NS_TEST_EXPECT_MSG_EQ (value, values[n], "Stream 5 gave another value");
+      differ = differ || (third.GetValue () != value);
+    }
+  NS_TEST_EXPECT_MSG_EQ (differ, true, "Streams 5 and 6 gave the same values");
+}
+
+class RngStreamAssignTestCase : public TestCase
+{
+public:
+  RngStreamAssignTestCase ();
+  virtual ~RngStreamAssignTestCase ()
+  {
+  }
+
+private:
+  virtual void DoRun (void);
+};
+
+RngStreamAssignTestCase::RngStreamAssignTestCase ()
+  : TestCase ("Check that an assigned stream is registered under its new index")
+{
+}
+
+void
+RngStreamAssignTestCase::DoRun (void)
+{
+  RngStream *seven = new RngStream (7);
+  RngStream *eight = new RngStream (8);
+  seven->RandU01 ();
+  *eight = *seven;
+  // Stream 8 must be gone, and stream 7 must still be there once the
+  // original is destroyed
+  delete seven;
+  vector<int64_t> streams = RngStream::GetStreams ();
+  NS_TEST_EXPECT_MSG_EQ ((std::find (streams.begin (), streams.end (), 7) != streams.end ()), true,
+                         "Stream 7 not registered");
+  NS_TEST_EXPECT_MSG_EQ ((std::find (streams.begin (), streams.end (), 8) == streams.end ()), true,
+                         "Stream 8 still registered");
+  uint32_t state[6];
+  uint32_t expected[6];
+  RngStream::GetStreamState (7, state);
+  eight->GetState (expected);
+  for (int i = 0; i < 6; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (state[i], expected[i], "Stream 7 reports the state of another stream");
+    }
+  delete eight;
+  streams = RngStream::GetStreams ();
+  NS_TEST_EXPECT_MSG_EQ ((std::find (streams.begin (), streams.end (), 7) == streams.end ()), true,
+                         "Stream 7 still registered");
+}
+
 class BasicRandomNumberTestSuite : public TestSuite
 {
 public:
@@ -140,6 +234,8 @@ BasicRandomNumberTestSuite::BasicRandomNumberTestSuite ()
 {
   AddTestCase (new BasicRandomNumberTestCase);
   AddTestCase (new RandomNumberSerializationTestCase);
+  AddTestCase (new RandomNumberStreamTestCase);
+  AddTestCase (new RngStreamAssignTestCase);
 }
 
 static BasicRandomNumberTestSuite BasicRandomNumberTestSuite;
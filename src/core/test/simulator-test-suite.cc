@@ -23,6 +23,12 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/simulator-impl.h"
+#include "ns3/string.h"
+#include "ns3/core-config.h"
+#include <fstream>
+#include <sstream>
+#include <vector>
 
 namespace ns3 {
 
@@ -168,6 +174,72 @@ SimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_destroy, true, "Event should have run");
 }
 
+class SimulatorRemoveTestCase : public TestCase
+{
+public:
+  SimulatorRemoveTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  void Event (uint32_t i);
+  std::vector<bool> m_run;
+  Time m_last;
+  bool m_inOrder;
+  ObjectFactory m_schedulerFactory;
+};
+
+SimulatorRemoveTestCase::SimulatorRemoveTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check that removing events keeps the events in order with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+
+void
+SimulatorRemoveTestCase::Event (uint32_t i)
+{
+  m_run[i] = true;
+  if (Simulator::Now () < m_last)
+    {
+      m_inOrder = false;
+    }
+  m_last = Simulator::Now ();
+}
+
+void
+SimulatorRemoveTestCase::DoRun (void)
+{
+  const uint32_t n = 500;
+  m_run.assign (n, false);
+  m_last = Seconds (0);
+  m_inOrder = true;
+  Simulator::SetScheduler (m_schedulerFactory);
+
+  std::vector<EventId> ids;
+  uint32_t delay = 1;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      delay = (delay * 7919 + 13) % 1009;
+      ids.push_back (Simulator::Schedule (MicroSeconds (delay), &SimulatorRemoveTestCase::Event, this, i));
+    }
+  // Remove events from all over the event list
+  for (uint32_t i = 0; i < n; i += 3)
+    {
+      Simulator::Remove (ids[(i * 37) % n]);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_inOrder, true, "Events did not run in time order");
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      bool removed = false;
+      for (uint32_t j = 0; j < n; j += 3)
+        {
+          removed = removed || (j * 37) % n == i;
+        }
+      NS_TEST_EXPECT_MSG_EQ (m_run[i], !removed, "Event " << i << " removed=" << removed);
+    }
+}
+
 class SimulatorTemplateTestCase : public TestCase
 {
 public:
@@ -459,6 +531,156 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class ProfiledBase
+{
+public:
+  virtual ~ProfiledBase ();
+  virtual void Run (void);
+};
+
+class ProfiledDerived : public ProfiledBase
+{
+public:
+  virtual void Run (void);
+};
+
+ProfiledBase::~ProfiledBase ()
+{
+}
+
+void
+ProfiledBase::Run (void)
+{
+}
+
+void
+ProfiledDerived::Run (void)
+{
+}
+
+class SimulatorEventProfilerTestCase : public TestCase
+{
+public:
+  SimulatorEventProfilerTestCase ();
+private:
+  virtual void DoRun (void);
+  void Allocate (uint32_t n);
+  void Nothing (void);
+  void Other (void);
+  bool FindLine (std::string filename, std::string text, std::string &line);
+  // the number of events of the line of the report about the target
+  uint32_t GetCount (std::string filename, std::string target);
+};
+
+SimulatorEventProfilerTestCase::SimulatorEventProfilerTestCase ()
+  : TestCase ("Check that the event profiler accounts events to their target and context")
+{
+}
+
+void
+SimulatorEventProfilerTestCase::Allocate (uint32_t n)
+{
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      delete new uint32_t (i);
+    }
+}
+
+void
+SimulatorEventProfilerTestCase::Nothing (void)
+{
+}
+
+void
+SimulatorEventProfilerTestCase::Other (void)
+{
+}
+
+bool
+SimulatorEventProfilerTestCase::FindLine (std::string filename, std::string text, std::string &line)
+{
+  std::ifstream is (filename.c_str ());
+  while (std::getline (is, line))
+    {
+      if (line.find (text) != std::string::npos)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+uint32_t
+SimulatorEventProfilerTestCase::GetCount (std::string filename, std::string target)
+{
+  std::string line;
+  uint32_t count = 0;
+  if (FindLine (filename, target, line))
+    {
+      std::istringstream iss (line);
+      iss >> count;
+    }
+  return count;
+}
+
+void
+SimulatorEventProfilerTestCase::DoRun (void)
+{
+  std::string prefix = CreateTempDirFilename ("event-profile");
+  ObjectFactory factory;
+  factory.SetTypeId ("ns3::DefaultSimulatorImpl");
+  factory.Set ("EventProfile", StringValue (prefix));
+  Simulator::SetImplementation (factory.Create<SimulatorImpl> ());
+
+  for (uint32_t i = 0; i < 10; ++i)
+    {
+      Simulator::ScheduleWithContext (3, MicroSeconds (i), &SimulatorEventProfilerTestCase::Allocate, this, 5);
+    }
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      Simulator::Schedule (MicroSeconds (i), &SimulatorEventProfilerTestCase::Nothing, this);
+    }
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      Simulator::Schedule (MicroSeconds (i), &SimulatorEventProfilerTestCase::Other, this);
+    }
+  ProfiledDerived derived;
+  Simulator::Schedule (MicroSeconds (1), &ProfiledBase::Run, &derived);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  std::string report = prefix + ".txt";
+#ifdef HAVE_DLADDR
+  // Every function has its own line, named after it
+  std::string allocate = "SimulatorEventProfilerTestCase::Allocate(unsigned int)";
+  NS_TEST_EXPECT_MSG_EQ (GetCount (report, "SimulatorEventProfilerTestCase::Nothing()"), 4,
+                         "Wrong number of Nothing events");
+  NS_TEST_EXPECT_MSG_EQ (GetCount (report, "SimulatorEventProfilerTestCase::Other()"), 2,
+                         "Wrong number of Other events");
+  // The override called through the pointer to the base member function
+  NS_TEST_EXPECT_MSG_EQ (GetCount (report, "ProfiledDerived::Run()"), 1,
+                         "Virtual function not resolved");
+#else
+  std::string allocate = "SimulatorEventProfilerTestCase::*)(unsigned int)";
+#endif /* HAVE_DLADDR */
+
+  std::string line;
+  NS_TEST_ASSERT_MSG_EQ (FindLine (report, allocate, line), true, "Allocate events are not in the report");
+  std::istringstream iss (line);
+  uint32_t count;
+  iss >> count;
+  NS_TEST_ASSERT_MSG_EQ (count, 10, "Wrong number of Allocate events");
+#ifdef ENABLE_EVENT_PROFILER_ALLOC
+  double total, percent, mean, max;
+  uint64_t allocations;
+  iss >> total >> percent >> mean >> max >> allocations;
+  NS_TEST_ASSERT_MSG_EQ (allocations, 50, "Wrong number of allocations");
+#endif /* ENABLE_EVENT_PROFILER_ALLOC */
+
+  NS_TEST_ASSERT_MSG_EQ (FindLine (report, "context 3", line), true,
+                         "Context of the Allocate events is not in the report");
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -475,6 +697,16 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory));
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory));
+    AddTestCase (new SimulatorEventProfilerTestCase ());
+
+    factory.SetTypeId (ListScheduler::GetTypeId ());
+    AddTestCase (new SimulatorRemoveTestCase (factory));
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorRemoveTestCase (factory));
+    factory.SetTypeId (HeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorRemoveTestCase (factory));
+    factory.SetTypeId (CalendarScheduler::GetTypeId ());
+    AddTestCase (new SimulatorRemoveTestCase (factory));
   }
 } g_simulatorTestSuite;
 
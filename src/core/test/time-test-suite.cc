@@ -133,6 +133,57 @@ TimesWithSignsTestCase::DoTeardown (void)
 {
 }
 
+class TimeIntegerFastPathTestCase : public TestCase
+{
+public:
+  TimeIntegerFastPathTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TimeIntegerFastPathTestCase::TimeIntegerFastPathTestCase ()
+  : TestCase ("Checks that integer time arithmetic matches the int64x64_t path")
+{
+}
+
+void
+TimeIntegerFastPathTestCase::DoRun (void)
+{
+  Time t = NanoSeconds (1234567);
+  Time negative = NanoSeconds (-7654321);
+
+  NS_TEST_ASSERT_MSG_EQ (t * 3, Time (int64x64_t (t) * int64x64_t (3)),
+                         "Time * int differs from the 128-bit result");
+  NS_TEST_ASSERT_MSG_EQ (3 * t, Time (int64x64_t (3) * int64x64_t (t)),
+                         "int * Time differs from the 128-bit result");
+  NS_TEST_ASSERT_MSG_EQ (t * 1000U, Time (int64x64_t (t) * int64x64_t (1000)),
+                         "Time * unsigned differs from the 128-bit result");
+  NS_TEST_ASSERT_MSG_EQ (negative * 5, Time (int64x64_t (negative) * int64x64_t (5)),
+                         "negative Time * int differs from the 128-bit result");
+  NS_TEST_ASSERT_MSG_EQ (t * -5, Time (int64x64_t (t) * int64x64_t (-5)),
+                         "Time * negative int differs from the 128-bit result");
+  NS_TEST_ASSERT_MSG_EQ (t * 0, Seconds (0),
+                         "Time * 0 is not zero");
+
+  // Scaling by a double keeps its fractional precision
+  NS_TEST_ASSERT_MSG_EQ (Time (t * 0.5), NanoSeconds (617283),
+                         "Time * double lost precision");
+  NS_TEST_ASSERT_MSG_EQ (Time (2.5 * t), Time (int64x64_t (2.5) * int64x64_t (t)),
+                         "double * Time differs from the 128-bit result");
+
+  // Whole values take the integer path, the others the 128-bit one
+  NS_TEST_ASSERT_MSG_EQ (Seconds (3.0), Time::From (int64x64_t (3.0), Time::S),
+                         "whole Seconds differ from the 128-bit result");
+  NS_TEST_ASSERT_MSG_EQ (Time::FromDouble (42.0, Time::MS), Time::From (int64x64_t (42.0), Time::MS),
+                         "whole MilliSeconds differ from the 128-bit result");
+  NS_TEST_ASSERT_MSG_EQ (Seconds (-42.0), Time::From (int64x64_t (-42.0), Time::S),
+                         "negative whole Seconds differ from the 128-bit result");
+  NS_TEST_ASSERT_MSG_EQ (Seconds (0.3), Time::From (int64x64_t (0.3), Time::S),
+                         "fractional Seconds differ from the 128-bit result");
+  NS_TEST_ASSERT_MSG_EQ (Seconds (1e9), Time::From (int64x64_t (1e9), Time::S),
+                         "large whole Seconds differ from the 128-bit result");
+}
+
 static class TimeTestSuite : public TestSuite
 {
 public:
@@ -141,6 +192,7 @@ public:
   {
     AddTestCase (new TimeSimpleTestCase (Time::US));
     AddTestCase (new TimesWithSignsTestCase ());
+    AddTestCase (new TimeIntegerFastPathTestCase ());
   }
 } g_timeTestSuite;
 
@@ -146,6 +146,10 @@ def register_types(module):
     module.add_class('Item', import_from_module='ns.network', outer_class=root_module['ns3::PacketTagIterator'])
     ## packet-tag-list.h (module 'network'): ns3::PacketTagList [class]
     module.add_class('PacketTagList', import_from_module='ns.network')
+    ## packet-tag-list.h (module 'network'): ns3::PacketTagList::Iterator [class]
+    module.add_class('Iterator', import_from_module='ns.network', outer_class=root_module['ns3::PacketTagList'])
+    ## packet-tag-list.h (module 'network'): ns3::PacketTagList::Iterator::Item [struct]
+    module.add_class('Item', import_from_module='ns.network', outer_class=root_module['ns3::PacketTagList::Iterator'])
     ## packet-tag-list.h (module 'network'): ns3::PacketTagList::TagData [struct]
     module.add_class('TagData', import_from_module='ns.network', outer_class=root_module['ns3::PacketTagList'])
     ## pcap-file.h (module 'network'): ns3::PcapFile [class]
@@ -410,6 +414,8 @@ def register_methods(root_module):
     register_Ns3PacketTagIterator_methods(root_module, root_module['ns3::PacketTagIterator'])
     register_Ns3PacketTagIteratorItem_methods(root_module, root_module['ns3::PacketTagIterator::Item'])
     register_Ns3PacketTagList_methods(root_module, root_module['ns3::PacketTagList'])
+    register_Ns3PacketTagListIterator_methods(root_module, root_module['ns3::PacketTagList::Iterator'])
+    register_Ns3PacketTagListIteratorItem_methods(root_module, root_module['ns3::PacketTagList::Iterator::Item'])
     register_Ns3PacketTagListTagData_methods(root_module, root_module['ns3::PacketTagList::TagData'])
     register_Ns3PcapFile_methods(root_module, root_module['ns3::PcapFile'])
     register_Ns3PcapHelper_methods(root_module, root_module['ns3::PcapHelper'])
@@ -2514,9 +2520,9 @@ def register_Ns3PacketTagList_methods(root_module, cls):
                    'void', 
                    [param('ns3::Tag const &', 'tag')], 
                    is_const=True)
-    ## packet-tag-list.h (module 'network'): ns3::PacketTagList::TagData const * ns3::PacketTagList::Head() const [member function]
-    cls.add_method('Head', 
-                   'ns3::PacketTagList::TagData const *', 
+    ## packet-tag-list.h (module 'network'): ns3::PacketTagList::Iterator ns3::PacketTagList::Begin() const [member function]
+    cls.add_method('Begin', 
+                   'ns3::PacketTagList::Iterator', 
                    [], 
                    is_const=True)
     ## packet-tag-list.h (module 'network'): bool ns3::PacketTagList::Peek(ns3::Tag & tag) const [member function]
@@ -2534,6 +2540,29 @@ def register_Ns3PacketTagList_methods(root_module, cls):
                    [])
     return
 
+def register_Ns3PacketTagListIterator_methods(root_module, cls):
+    ## packet-tag-list.h (module 'network'): ns3::PacketTagList::Iterator::Iterator(ns3::PacketTagList::Iterator const & arg0) [copy constructor]
+    cls.add_constructor([param('ns3::PacketTagList::Iterator const &', 'arg0')])
+    ## packet-tag-list.h (module 'network'): bool ns3::PacketTagList::Iterator::HasNext() const [member function]
+    cls.add_method('HasNext', 
+                   'bool', 
+                   [], 
+                   is_const=True)
+    ## packet-tag-list.h (module 'network'): ns3::PacketTagList::Iterator::Item ns3::PacketTagList::Iterator::Next() [member function]
+    cls.add_method('Next', 
+                   'ns3::PacketTagList::Iterator::Item', 
+                   [])
+    return
+
+def register_Ns3PacketTagListIteratorItem_methods(root_module, cls):
+    ## packet-tag-list.h (module 'network'): ns3::PacketTagList::Iterator::Item::Item() [constructor]
+    cls.add_constructor([])
+    ## packet-tag-list.h (module 'network'): ns3::PacketTagList::Iterator::Item::Item(ns3::PacketTagList::Iterator::Item const & arg0) [copy constructor]
+    cls.add_constructor([param('ns3::PacketTagList::Iterator::Item const &', 'arg0')])
+    ## packet-tag-list.h (module 'network'): ns3::PacketTagList::Iterator::Item::tid [variable]
+    cls.add_instance_attribute('tid', 'ns3::TypeId', is_const=False)
+    return
+
 def register_Ns3PacketTagListTagData_methods(root_module, cls):
     ## packet-tag-list.h (module 'network'): ns3::PacketTagList::TagData::TagData() [constructor]
     cls.add_constructor([])
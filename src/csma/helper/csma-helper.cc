@@ -196,19 +196,19 @@ CsmaHelper::EnableAsciiInternal (
   std::ostringstream oss;
 
   oss << "/NodeList/" << nd->GetNode ()->GetId () << "/DeviceList/" << deviceid << "/$ns3::CsmaNetDevice/MacRx";
-  Config::Connect (oss.str (), MakeBoundCallback (&AsciiTraceHelper::DefaultReceiveSinkWithContext, stream));
+  Config::Connect (oss.str (), AsciiTraceHelper::MakeDefaultSinkWithContext ('r', stream));
 
   oss.str ("");
   oss << "/NodeList/" << nodeid << "/DeviceList/" << deviceid << "/$ns3::CsmaNetDevice/TxQueue/Enqueue";
-  Config::Connect (oss.str (), MakeBoundCallback (&AsciiTraceHelper::DefaultEnqueueSinkWithContext, stream));
+  Config::Connect (oss.str (), AsciiTraceHelper::MakeDefaultSinkWithContext ('+', stream));
 
   oss.str ("");
   oss << "/NodeList/" << nodeid << "/DeviceList/" << deviceid << "/$ns3::CsmaNetDevice/TxQueue/Dequeue";
-  Config::Connect (oss.str (), MakeBoundCallback (&AsciiTraceHelper::DefaultDequeueSinkWithContext, stream));
+  Config::Connect (oss.str (), AsciiTraceHelper::MakeDefaultSinkWithContext ('-', stream));
 
   oss.str ("");
   oss << "/NodeList/" << nodeid << "/DeviceList/" << deviceid << "/$ns3::CsmaNetDevice/TxQueue/Drop";
-  Config::Connect (oss.str (), MakeBoundCallback (&AsciiTraceHelper::DefaultDropSinkWithContext, stream));
+  Config::Connect (oss.str (), AsciiTraceHelper::MakeDefaultSinkWithContext ('d', stream));
 }
 
 NetDeviceContainer
@@ -188,19 +188,19 @@ EmuHelper::EnableAsciiInternal (
   std::ostringstream oss;
 
   oss << "/NodeList/" << nd->GetNode ()->GetId () << "/DeviceList/" << deviceid << "/$ns3::EmuNetDevice/MacRx";
-  Config::Connect (oss.str (), MakeBoundCallback (&AsciiTraceHelper::DefaultReceiveSinkWithContext, stream));
+  Config::Connect (oss.str (), AsciiTraceHelper::MakeDefaultSinkWithContext ('r', stream));
 
   oss.str ("");
   oss << "/NodeList/" << nodeid << "/DeviceList/" << deviceid << "/$ns3::EmuNetDevice/TxQueue/Enqueue";
-  Config::Connect (oss.str (), MakeBoundCallback (&AsciiTraceHelper::DefaultEnqueueSinkWithContext, stream));
+  Config::Connect (oss.str (), AsciiTraceHelper::MakeDefaultSinkWithContext ('+', stream));
 
   oss.str ("");
   oss << "/NodeList/" << nodeid << "/DeviceList/" << deviceid << "/$ns3::EmuNetDevice/TxQueue/Dequeue";
-  Config::Connect (oss.str (), MakeBoundCallback (&AsciiTraceHelper::DefaultDequeueSinkWithContext, stream));
+  Config::Connect (oss.str (), AsciiTraceHelper::MakeDefaultSinkWithContext ('-', stream));
 
   oss.str ("");
   oss << "/NodeList/" << nodeid << "/DeviceList/" << deviceid << "/$ns3::EmuNetDevice/TxQueue/Drop";
-  Config::Connect (oss.str (), MakeBoundCallback (&AsciiTraceHelper::DefaultDropSinkWithContext, stream));
+  Config::Connect (oss.str (), AsciiTraceHelper::MakeDefaultSinkWithContext ('d', stream));
 }
 
 NetDeviceContainer
@@ -81,6 +81,10 @@ public:
    * Users must first call PopulateRoutingTables() and then may subsequently
    * call RecomputeRoutingTables() at any later time in the simulation.
    *
+   * If the global value IncrementalRouteRecomputation is true, only the
+   * routers whose shortest path tree may have changed since the previous
+   * computation recompute their routes.
+   *
    */
   static void RecomputeRoutingTables (void);
 private:
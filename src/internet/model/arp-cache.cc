@@ -180,9 +180,9 @@ ArpCache::HandleWaitReplyTimeout (void)
   NS_LOG_FUNCTION (this);
   ArpCache::Entry* entry;
   bool restartWaitReplyTimer = false;
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++) 
+  for (uint32_t i = 0; i < m_arpCache.GetNPositions (); i++)
     {
-      entry = (*i).second;
+      entry = m_arpCache.GetPosition (i);
       if (entry != 0 && entry->IsWaitReply ())
         {
           if (entry->GetRetries () < m_maxRetries)
@@ -225,11 +225,8 @@ void
 ArpCache::Flush (void)
 {
   NS_LOG_FUNCTION (this);
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++) 
-    {
-      delete (*i).second;
-    }
-  m_arpCache.erase (m_arpCache.begin (), m_arpCache.end ());
+  m_arpCache.Clear ();
+  m_pendingPool.clear ();
   if (m_waitReplyTimer.IsRunning ())
     {
       NS_LOG_LOGIC ("Stopping WaitReplyTimer at " << Simulator::Now ().GetSeconds () << " due to ArpCache flush");
@@ -240,26 +237,42 @@ ArpCache::Flush (void)
 ArpCache::Entry *
 ArpCache::Lookup (Ipv4Address to)
 {
-  if (m_arpCache.find (to) != m_arpCache.end ()) 
-    {
-      ArpCache::Entry *entry = m_arpCache[to];
-      return entry;
-    }
-  return 0;
+  return m_arpCache.Find (to);
 }
 
 ArpCache::Entry *
 ArpCache::Add (Ipv4Address to)
 {
   NS_LOG_FUNCTION (this << to);
-  NS_ASSERT (m_arpCache.find (to) == m_arpCache.end ());
 
-  ArpCache::Entry *entry = new ArpCache::Entry (this);
-  m_arpCache[to] = entry;
+  ArpCache::Entry *entry = m_arpCache.Insert (to, ArpCache::Entry (this));
   entry->SetIpv4Address (to);
   return entry;
 }
 
+void
+ArpCache::EnqueuePending (std::list<Ptr<Packet> > &pending, Ptr<Packet> p)
+{
+  if (m_pendingPool.empty ())
+    {
+      pending.push_back (p);
+    }
+  else
+    {
+      pending.splice (pending.end (), m_pendingPool, m_pendingPool.begin ());
+      pending.back () = p;
+    }
+}
+
+Ptr<Packet>
+ArpCache::DequeuePending (std::list<Ptr<Packet> > &pending)
+{
+  Ptr<Packet> p = pending.front ();
+  pending.front () = 0;
+  m_pendingPool.splice (m_pendingPool.end (), pending, pending.begin ());
+  return p;
+}
+
 ArpCache::Entry::Entry (ArpCache *arp)
   : m_arp (arp),
     m_state (ALIVE),
@@ -318,7 +331,7 @@ ArpCache::Entry::UpdateWaitReply (Ptr<Packet> waiting)
     {
       return false;
     }
-  m_pending.push_back (waiting);
+  m_arp->EnqueuePending (m_pending, waiting);
   return true;
 }
 void 
@@ -328,7 +341,7 @@ ArpCache::Entry::MarkWaitReply (Ptr<Packet> waiting)
   NS_ASSERT (m_state == ALIVE || m_state == DEAD);
   NS_ASSERT (m_pending.empty ());
   m_state = WAIT_REPLY;
-  m_pending.push_back (waiting);
+  m_arp->EnqueuePending (m_pending, waiting);
   UpdateSeen ();
   m_arp->StartWaitReplyTimer ();
 }
@@ -388,9 +401,7 @@ ArpCache::Entry::DequeuePending (void)
     }
   else
     {
-      Ptr<Packet> p = m_pending.front ();
-      m_pending.pop_front ();
-      return p;
+      return m_arp->DequeuePending (m_pending);
     }
 }
 void 
@@ -32,7 +32,7 @@
 #include "ns3/ptr.h"
 #include "ns3/object.h"
 #include "ns3/traced-callback.h"
-#include "ns3/sgi-hashmap.h"
+#include "ns3/neighbor-cache-table.h"
 
 namespace ns3 {
 
@@ -45,6 +45,11 @@ class Ipv4Interface;
  *
  * A cached lookup table for translating layer 3 addresses to layer 2.
  * This implementation does lookups from IPv4 to a MAC address
+ *
+ * The entries are kept inline in an open addressing table, and a single
+ * timer per cache retries the requests of all the entries waiting for a
+ * reply.  The queues of the packets waiting for a reply take their nodes
+ * from a pool shared by the entries.
  */
 class ArpCache : public Object
 {
@@ -119,7 +124,7 @@ public:
      * \brief Constructor
      * \param arp The ArpCache this entry belongs to
      */
-    Entry (ArpCache *arp);
+    Entry (ArpCache *arp = 0);
 
     /**
      * \brief Changes the state of this entry to dead
@@ -208,8 +213,7 @@ private:
   };
 
 private:
-  typedef sgi::hash_map<Ipv4Address, ArpCache::Entry *, Ipv4AddressHash> Cache;
-  typedef sgi::hash_map<Ipv4Address, ArpCache::Entry *, Ipv4AddressHash>::iterator CacheI;
+  typedef NeighborCacheTable<Ipv4Address, ArpCache::Entry, Ipv4AddressHash> Cache;
 
   virtual void DoDispose (void);
 
@@ -227,7 +231,16 @@ private:
    * If there are no Arp requests pending, this event is not scheduled.
    */
   void HandleWaitReplyTimeout (void);
+  /**
+   * Append a packet to a pending queue, with a node of the pool if any.
+   */
+  void EnqueuePending (std::list<Ptr<Packet> > &pending, Ptr<Packet> p);
+  /**
+   * Remove the head of a pending queue, and return its node to the pool.
+   */
+  Ptr<Packet> DequeuePending (std::list<Ptr<Packet> > &pending);
   uint32_t m_pendingQueueSize;
+  std::list<Ptr<Packet> > m_pendingPool;  // Spare nodes of the pending queues
   Cache m_arpCache;
   TracedCallback<Ptr<const Packet> > m_dropTrace;
 };
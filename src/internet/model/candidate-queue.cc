@@ -44,7 +44,9 @@ operator<< (std::ostream& os, const CandidateQueue& q)
 {
   typedef CandidateQueue::CandidateList_t List_t;
   typedef List_t::const_iterator CIter_t;
-  const CandidateQueue::CandidateList_t& list = q.m_candidates;
+  // the heap is only partially ordered
+  List_t list = q.m_candidates;
+  std::sort (list.begin (), list.end (), &CandidateQueue::CompareCandidates);
 
   os << "*** CandidateQueue Begin (<id, distance, LSA-type>) ***" << std::endl;
   for (CIter_t iter = list.begin (); iter != list.end (); iter++)
@@ -59,7 +61,9 @@ operator<< (std::ostream& os, const CandidateQueue& q)
 }
 
 CandidateQueue::CandidateQueue()
-  : m_candidates ()
+  : m_candidates (),
+    m_index (),
+    m_sequence (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -82,16 +86,65 @@ CandidateQueue::Clear (void)
     }
 }
 
+void
+CandidateQueue::Place (SPFVertex *v, uint32_t position)
+{
+  m_candidates[position] = v;
+  v->m_candidatePosition = position;
+}
+
+void
+CandidateQueue::SiftUp (uint32_t position)
+{
+  SPFVertex *v = m_candidates[position];
+  while (position > 0)
+    {
+      uint32_t parent = (position - 1) / 2;
+      if (!CompareCandidates (v, m_candidates[parent]))
+        {
+          break;
+        }
+      Place (m_candidates[parent], position);
+      position = parent;
+    }
+  Place (v, position);
+}
+
+void
+CandidateQueue::SiftDown (uint32_t position)
+{
+  SPFVertex *v = m_candidates[position];
+  uint32_t size = m_candidates.size ();
+  for (;;)
+    {
+      uint32_t child = 2 * position + 1;
+      if (child >= size)
+        {
+          break;
+        }
+      if (child + 1 < size && CompareCandidates (m_candidates[child + 1], m_candidates[child]))
+        {
+          child++;
+        }
+      if (!CompareCandidates (m_candidates[child], v))
+        {
+          break;
+        }
+      Place (m_candidates[child], position);
+      position = child;
+    }
+  Place (v, position);
+}
+
 void
 CandidateQueue::Push (SPFVertex *vNew)
 {
   NS_LOG_FUNCTION (this << vNew);
 
-  CandidateList_t::iterator i = std::upper_bound (
-      m_candidates.begin (), m_candidates.end (), vNew,
-      &CandidateQueue::CompareSPFVertex
-      );
-  m_candidates.insert (i, vNew);
+  vNew->m_candidateSequence = m_sequence++;
+  m_candidates.push_back (vNew);
+  SiftUp (m_candidates.size () - 1);
+  m_index.insert (std::make_pair (vNew->GetVertexId (), vNew));
 }
 
 SPFVertex *
@@ -104,7 +157,23 @@ CandidateQueue::Pop (void)
     }
 
   SPFVertex *v = m_candidates.front ();
-  m_candidates.pop_front ();
+  SPFVertex *last = m_candidates.back ();
+  m_candidates.pop_back ();
+  if (!m_candidates.empty ())
+    {
+      Place (last, 0);
+      SiftDown (0);
+    }
+  std::pair<CandidateIndex_t::iterator, CandidateIndex_t::iterator> range = 
+    m_index.equal_range (v->GetVertexId ());
+  for (CandidateIndex_t::iterator i = range.first; i != range.second; i++)
+    {
+      if (i->second == v)
+        {
+          m_index.erase (i);
+          break;
+        }
+    }
   return v;
 }
 
@@ -138,18 +207,18 @@ SPFVertex *
 CandidateQueue::Find (const Ipv4Address addr) const
 {
   NS_LOG_FUNCTION_NOARGS ();
-  CandidateList_t::const_iterator i = m_candidates.begin ();
-
-  for (; i != m_candidates.end (); i++)
+  std::pair<CandidateIndex_t::const_iterator, CandidateIndex_t::const_iterator> range = 
+    m_index.equal_range (addr);
+  SPFVertex *found = 0;
+  // the one which would be popped first
+  for (CandidateIndex_t::const_iterator i = range.first; i != range.second; i++)
     {
-      SPFVertex *v = *i;
-      if (v->GetVertexId () == addr)
+      if (found == 0 || CompareCandidates (i->second, found))
         {
-          return v;
+          found = i->second;
         }
     }
-
-  return 0;
+  return found;
 }
 
 void
@@ -157,11 +226,39 @@ CandidateQueue::Reorder (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  m_candidates.sort (&CandidateQueue::CompareSPFVertex);
+  for (uint32_t i = m_candidates.size () / 2; i > 0; i--)
+    {
+      SiftDown (i - 1);
+    }
   NS_LOG_LOGIC ("After reordering the CandidateQueue");
   NS_LOG_LOGIC (*this);
 }
 
+void
+CandidateQueue::Update (SPFVertex *v)
+{
+  NS_LOG_FUNCTION (this << v);
+
+  uint32_t position = v->m_candidatePosition;
+  NS_ASSERT (position < m_candidates.size () && m_candidates[position] == v);
+  SiftUp (position);
+  SiftDown (v->m_candidatePosition);
+}
+
+bool
+CandidateQueue::CompareCandidates (const SPFVertex* v1, const SPFVertex* v2)
+{
+  if (CompareSPFVertex (v1, v2))
+    {
+      return true;
+    }
+  if (CompareSPFVertex (v2, v1))
+    {
+      return false;
+    }
+  return v1->m_candidateSequence < v2->m_candidateSequence;
+}
+
 /*
  * In this implementation, SPFVertex follows the ordering where
  * a vertex is ranked first if its GetDistanceFromRoot () is smaller;
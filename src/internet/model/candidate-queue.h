@@ -22,7 +22,8 @@
 #define CANDIDATE_QUEUE_H
 
 #include <stdint.h>
-#include <list>
+#include <vector>
+#include <map>
 #include "ns3/ipv4-address.h"
 
 namespace ns3 {
@@ -45,6 +46,12 @@ class SPFVertex;
  * for a Find () operation, the dynamic nature of the data and the derived
  * requirement for a Reorder () operation led us to implement this simple 
  * enhanced priority queue.
+ *
+ * The vertices are kept in a binary heap, each vertex knowing its position
+ * in it, and indexed by their IP addresses, so that Push (), Pop () and
+ * Update () take a logarithmic time and Find () does not scan the queue.
+ * The vertices of equal distance and type are popped in the order in
+ * which they were pushed.
  */
 class CandidateQueue
 {
@@ -162,6 +169,19 @@ public:
  */
   void Reorder (void);
 
+/**
+ * @brief Restores the priority of a Shortest Path First Vertex pointer of
+ * the queue after the value of its field m_distanceFromRoot changed.
+ * @internal
+ *
+ * This is the decrease-key operation of the queue: it moves only the given
+ * vertex, where Reorder () sorts the whole queue.
+ *
+ * @see SPFVertex
+ * @param v The Shortest Path First Vertex whose distance changed.
+ */
+  void Update (SPFVertex *v);
+
 private:
 /**
  * Candidate Queue copy construction is disallowed (not implemented) to 
@@ -188,9 +208,24 @@ private:
  * \return True if v1 should be popped before v2; false otherwise
  */
   static bool CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2);
+/**
+ * \brief return true if v1 should be popped before v2, the vertices of
+ * equal priority being popped in the order in which they were pushed
+ */
+  static bool CompareCandidates (const SPFVertex* v1, const SPFVertex* v2);
+/**
+ * \brief Move the vertex at the given position of the heap towards the top
+ * or the bottom of the heap, until the heap is ordered.
+ */
+  void SiftUp (uint32_t position);
+  void SiftDown (uint32_t position);
+  void Place (SPFVertex *v, uint32_t position);
 
-  typedef std::list<SPFVertex*> CandidateList_t;
+  typedef std::vector<SPFVertex*> CandidateList_t;
   CandidateList_t m_candidates;
+  typedef std::multimap<Ipv4Address, SPFVertex*> CandidateIndex_t;
+  CandidateIndex_t m_index;
+  uint32_t m_sequence;
 
   friend std::ostream& operator<< (std::ostream& os, const CandidateQueue& q);
 };
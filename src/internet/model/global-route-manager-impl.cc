@@ -35,6 +35,8 @@
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4-list-routing.h"
 #include "ns3/mpi-interface.h"
+#include "ns3/global-value.h"
+#include "ns3/boolean.h"
 #include "global-router-interface.h"
 #include "global-route-manager-impl.h"
 #include "candidate-queue.h"
@@ -44,6 +46,107 @@ NS_LOG_COMPONENT_DEFINE ("GlobalRouteManager");
 
 namespace ns3 {
 
+GlobalValue g_incrementalRouteRecomputation = GlobalValue ("IncrementalRouteRecomputation",
+                                                           "When the global routes are recomputed, only run the SPF calculation "
+                                                           "of the routers which may be affected by the changes of the topology",
+                                                           BooleanValue (false),
+                                                           MakeBooleanChecker ());
+
+namespace {
+
+//
+// What the SPF calculation reads from an LSA, to compare the LSAs of two
+// successive link state databases.  The first description is the header of
+// the LSA and the others its link records and attached routers, sorted, with
+// the metrics of the links to other vertices left out: these links are the
+// edges, keyed by the vertex they lead to and their address.
+//
+struct LinkDescription
+{
+  uint32_t type;
+  Ipv4Address id;
+  Ipv4Address data;
+  uint32_t metric;
+};
+
+bool
+operator< (LinkDescription const &a, LinkDescription const &b)
+{
+  if (a.type != b.type)
+    {
+      return a.type < b.type;
+    }
+  if (a.id != b.id)
+    {
+      return a.id < b.id;
+    }
+  if (a.data != b.data)
+    {
+      return a.data < b.data;
+    }
+  return a.metric < b.metric;
+}
+
+bool
+operator== (LinkDescription const &a, LinkDescription const &b)
+{
+  return a.type == b.type && a.id == b.id && a.data == b.data && a.metric == b.metric;
+}
+
+typedef std::map<std::pair<Ipv4Address, Ipv4Address>, uint32_t> EdgeMap_t;
+
+void
+DescribeLSA (GlobalRouteManagerLSDB *lsdb, GlobalRoutingLSA *lsa,
+             std::vector<LinkDescription> &links, EdgeMap_t &edges)
+{
+  LinkDescription d;
+  d.type = lsa->GetLSType ();
+  d.id = lsa->GetLinkStateId ();
+  d.data = lsa->GetAdvertisingRouter ();
+  d.metric = lsa->GetNetworkLSANetworkMask ().Get ();
+  links.push_back (d);
+  for (uint32_t i = 0; i < lsa->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (i);
+      d.type = GlobalRoutingLSA::ASExternalLSAs + 1 + l->GetLinkType ();
+      d.id = l->GetLinkId ();
+      d.data = l->GetLinkData ();
+      d.metric = l->GetMetric ();
+      if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint
+          || l->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+        {
+          edges[std::make_pair (l->GetLinkId (), l->GetLinkData ())] = d.metric;
+          d.metric = 0;
+        }
+      links.push_back (d);
+    }
+  for (uint32_t i = 0; i < lsa->GetNAttachedRouters (); i++)
+    {
+      d.type = GlobalRoutingLSA::ASExternalLSAs + 1 + GlobalRoutingLinkRecord::VirtualLink + 1;
+      d.id = lsa->GetAttachedRouter (i);
+      d.data = Ipv4Address ();
+      d.metric = 0;
+      links.push_back (d);
+      // the network vertex is at distance 0 of its routers
+      GlobalRoutingLSA *w = lsdb->GetLSAByLinkData (d.id);
+      if (w != 0)
+        {
+          edges[std::make_pair (w->GetLinkStateId (), d.id)] = 0;
+        }
+    }
+  std::sort (links.begin (), links.end ());
+}
+
+struct MetricChange
+{
+  uint32_t from;
+  uint32_t to;
+  uint32_t oldMetric;
+  uint32_t newMetric;
+};
+
+} // anonymous namespace
+
 std::ostream& 
 operator<< (std::ostream& os, const SPFVertex::NodeExit_t& exit)
 {
@@ -87,7 +190,9 @@ SPFVertex::SPFVertex () :
   m_nextHop ("0.0.0.0"),
   m_parents (),
   m_children (),
-  m_vertexProcessed (false)
+  m_vertexProcessed (false),
+  m_candidatePosition (0),
+  m_candidateSequence (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -100,7 +205,9 @@ SPFVertex::SPFVertex (GlobalRoutingLSA* lsa) :
   m_nextHop ("0.0.0.0"),
   m_parents (),
   m_children (),
-  m_vertexProcessed (false)
+  m_vertexProcessed (false),
+  m_candidatePosition (0),
+  m_candidateSequence (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
@@ -163,6 +270,7 @@ SPFVertex::~SPFVertex ()
   m_parents.clear ();
   // delete root exit direction
   m_ecmpRootExits.clear ();
+  m_ecmpRootExitWeights.clear ();
 
   NS_LOG_LOGIC ("Vertex-" << m_vertexId << " completed deleted");
 }
@@ -275,6 +383,8 @@ SPFVertex::SetRootExitDirection (Ipv4Address nextHop, int32_t id)
   // always maintain only one root's exit
   m_ecmpRootExits.clear ();
   m_ecmpRootExits.push_back (NodeExit_t (nextHop, id));
+  m_ecmpRootExitWeights.clear ();
+  m_ecmpRootExitWeights[NodeExit_t (nextHop, id)] = 1;
   // update the following in order to be backward compatitable with
   // GetNextHop and GetOutgoingInterface methods
   m_nextHop = nextHop;
@@ -323,6 +433,12 @@ SPFVertex::MergeRootExitDirections (const SPFVertex* vertex)
                           extList.begin (), extList.end ());
   m_ecmpRootExits.sort ();
   m_ecmpRootExits.unique ();
+  // the paths through the other vertex add up to the ones already found
+  for (RootExitWeights_t::const_iterator i = vertex->m_ecmpRootExitWeights.begin ();
+       i != vertex->m_ecmpRootExitWeights.end (); i++)
+    {
+      m_ecmpRootExitWeights[i->first] += i->second;
+    }
 }
 
 void 
@@ -339,6 +455,7 @@ SPFVertex::InheritAllRootExitDirections (const SPFVertex* vertex)
   m_ecmpRootExits.clear ();
   m_ecmpRootExits.insert (m_ecmpRootExits.end (), 
                           vertex->m_ecmpRootExits.begin (), vertex->m_ecmpRootExits.end ());
+  m_ecmpRootExitWeights = vertex->m_ecmpRootExitWeights;
 }
 
 uint32_t 
@@ -348,6 +465,18 @@ SPFVertex::GetNRootExitDirections () const
   return m_ecmpRootExits.size ();
 }
 
+uint32_t
+SPFVertex::GetRootExitWeight (uint32_t i) const
+{
+  NS_LOG_FUNCTION (i);
+  RootExitWeights_t::const_iterator weight = m_ecmpRootExitWeights.find (GetRootExitDirection (i));
+  if (weight == m_ecmpRootExitWeights.end ())
+    {
+      return 1;
+    }
+  return weight->second;
+}
+
 uint32_t 
 SPFVertex::GetNChildren (void) const
 {
@@ -527,7 +656,9 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 
 GlobalRouteManagerImpl::GlobalRouteManagerImpl () 
   :
-    m_spfroot (0)
+    m_spfroot (0),
+    m_spfrootNode (0),
+    m_incremental (false)
 {
   NS_LOG_FUNCTION_NOARGS ();
   m_lsdb = new GlobalRouteManagerLSDB ();
@@ -561,24 +692,11 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
   for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
     {
       Ptr<Node> node = *i;
-      Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-      if (router == 0)
-        {
-          continue;
-        }
-      Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-      uint32_t j = 0;
-      uint32_t nRoutes = gr->GetNRoutes ();
-      NS_LOG_LOGIC ("Deleting " << gr->GetNRoutes ()<< " routes from node " << node->GetId ());
-      // Each time we delete route 0, the route index shifts downward
-      // We can delete all routes if we delete the route numbered 0
-      // nRoutes times
-      for (j = 0; j < nRoutes; j++)
+      if (node->GetObject<GlobalRouter> () == 0)
         {
-          NS_LOG_LOGIC ("Deleting global route " << j << " from node " << node->GetId ());
-          gr->RemoveRoute (0);
+          return;
         }
-      NS_LOG_LOGIC ("Deleted " << j << " global routes from node "<< node->GetId ());
+      DeleteRoutes (node);
     }
   if (m_lsdb)
     {
@@ -586,6 +704,28 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
       delete m_lsdb;
       m_lsdb = new GlobalRouteManagerLSDB ();
     }
+  m_routerNodes.clear ();
+  m_distances.clear ();
+}
+
+void
+GlobalRouteManagerImpl::DeleteRoutes (Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (node);
+  Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+  uint32_t j = 0;
+  uint32_t nRoutes = gr->GetNRoutes ();
+  NS_LOG_LOGIC ("Deleting " << gr->GetNRoutes ()<< " routes from node " << node->GetId ());
+  // Each time we delete route 0, the route index shifts downward
+  // We can delete all routes if we delete the route numbered 0
+  // nRoutes times
+  for (j = 0; j < nRoutes; j++)
+    {
+      NS_LOG_LOGIC ("Deleting global route " << j << " from node " << node->GetId ());
+      gr->RemoveRoute (0);
+    }
+  NS_LOG_LOGIC ("Deleted " << j << " global routes from node "<< node->GetId ());
 }
 
 //
@@ -618,6 +758,7 @@ GlobalRouteManagerImpl::BuildGlobalRoutingDatabase ()
         {
           continue;
         }
+      m_routerNodes[rtr->GetRouterId ()] = node->GetId ();
 //
 // You must call DiscoverLSAs () before trying to use any routing info or to
 // update LSAs.  DiscoverLSAs () drives the process of discovering routes in
@@ -685,6 +826,24 @@ GlobalRouteManagerImpl::InitializeRoutes ()
 {
   NS_LOG_FUNCTION_NOARGS ();
 //
+// To recompute the routes incrementally, remember the distances from each
+// root to every vertex of the database.
+//
+  BooleanValue incremental;
+  g_incrementalRouteRecomputation.GetValue (incremental);
+  m_incremental = incremental.Get ();
+  m_vertexIndexes.clear ();
+  m_distances.clear ();
+  if (m_incremental)
+    {
+      GlobalRouteManagerLSDB::LSDBMap_t::const_iterator i;
+      for (i = m_lsdb->m_database.begin (); i != m_lsdb->m_database.end (); i++)
+        {
+          uint32_t index = m_vertexIndexes.size ();
+          m_vertexIndexes[i->first] = index;
+        }
+    }
+//
 // Walk the list of nodes in the system.
 //
   NS_LOG_INFO ("About to start SPF calculation");
@@ -717,6 +876,173 @@ GlobalRouteManagerImpl::InitializeRoutes ()
   NS_LOG_INFO ("Finished SPF calculation");
 }
 
+//
+// The routes computed by a root depend on its shortest path tree and on the
+// LSAs of the vertices of that tree.  So a root must compute its routes again
+// when the LSA of a vertex it reaches changes, other than for the metrics of
+// its links, or when the metric of a link changes such that the link joins or
+// leaves the shortest paths from the root: a link from x to y which decreased
+// to m joins them if d(x) + m <= d(y), and one which increased from m leaves
+// them if d(x) + m == d(y).  Any other change (a router or network appearing
+// or going away, a change of the AS external LSAs) recomputes everything.
+//
+void
+GlobalRouteManagerImpl::RecomputeRoutes ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  BooleanValue incremental;
+  g_incrementalRouteRecomputation.GetValue (incremental);
+  if (!incremental.Get () || !m_incremental)
+    {
+      DeleteGlobalRoutes ();
+      BuildGlobalRoutingDatabase ();
+      InitializeRoutes ();
+      return;
+    }
+
+  GlobalRouteManagerLSDB* oldLsdb = m_lsdb;
+  m_lsdb = new GlobalRouteManagerLSDB ();
+  BuildGlobalRoutingDatabase ();
+  std::set<Ipv4Address> roots;
+  bool found = FindAffectedRoots (oldLsdb, roots);
+  delete oldLsdb;
+
+  NodeList::Iterator listEnd = NodeList::End ();
+  if (!found)
+    {
+      NS_LOG_LOGIC ("Recomputing the routes of all the routers");
+      for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+        {
+          if ((*i)->GetObject<GlobalRouter> () != 0)
+            {
+              DeleteRoutes (*i);
+            }
+        }
+      InitializeRoutes ();
+      return;
+    }
+
+  NS_LOG_LOGIC ("Recomputing the routes of " << roots.size () << " routers and of the stub nodes");
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<Node> node = *i;
+      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
+      if (node->GetSystemId () != MpiInterface::GetSystemId () || !rtr || !rtr->GetNumLSAs ())
+        {
+          continue;
+        }
+      Ipv4Address root = rtr->GetRouterId ();
+      // the stub nodes keep no distances, as they skip the SPF calculation
+      if (roots.find (root) != roots.end () || m_distances.find (root) == m_distances.end ())
+        {
+          DeleteRoutes (node);
+          SPFCalculate (root);
+        }
+    }
+}
+
+bool
+GlobalRouteManagerImpl::FindAffectedRoots (GlobalRouteManagerLSDB* oldLsdb, std::set<Ipv4Address> &roots)
+{
+  NS_LOG_FUNCTION (oldLsdb);
+  if (oldLsdb->m_database.size () != m_lsdb->m_database.size ()
+      || oldLsdb->m_extdatabase.size () != m_lsdb->m_extdatabase.size ())
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < m_lsdb->m_extdatabase.size (); i++)
+    {
+      std::vector<LinkDescription> oldLinks, newLinks;
+      EdgeMap_t oldEdges, newEdges;
+      DescribeLSA (oldLsdb, oldLsdb->m_extdatabase[i], oldLinks, oldEdges);
+      DescribeLSA (m_lsdb, m_lsdb->m_extdatabase[i], newLinks, newEdges);
+      if (oldLinks != newLinks || oldEdges != newEdges)
+        {
+          return false;
+        }
+    }
+
+  std::vector<uint32_t> changed;
+  std::vector<MetricChange> changes;
+  GlobalRouteManagerLSDB::LSDBMap_t::const_iterator i = oldLsdb->m_database.begin ();
+  GlobalRouteManagerLSDB::LSDBMap_t::const_iterator j = m_lsdb->m_database.begin ();
+  for (; i != oldLsdb->m_database.end (); i++, j++)
+    {
+      std::map<Ipv4Address, uint32_t>::const_iterator from = m_vertexIndexes.find (i->first);
+      if (i->first != j->first || from == m_vertexIndexes.end ())
+        {
+          return false;
+        }
+      std::vector<LinkDescription> oldLinks, newLinks;
+      EdgeMap_t oldEdges, newEdges;
+      DescribeLSA (oldLsdb, i->second, oldLinks, oldEdges);
+      DescribeLSA (m_lsdb, j->second, newLinks, newEdges);
+      bool sameEdges = oldEdges.size () == newEdges.size ();
+      for (EdgeMap_t::const_iterator k = oldEdges.begin (), l = newEdges.begin ();
+           sameEdges && k != oldEdges.end (); k++, l++)
+        {
+          sameEdges = k->first == l->first;
+        }
+      if (oldLinks != newLinks || !sameEdges)
+        {
+          NS_LOG_LOGIC ("LSA " << i->first << " changed");
+          changed.push_back (from->second);
+          continue;
+        }
+      for (EdgeMap_t::const_iterator k = oldEdges.begin (), l = newEdges.begin ();
+           k != oldEdges.end (); k++, l++)
+        {
+          if (k->second == l->second)
+            {
+              continue;
+            }
+          std::map<Ipv4Address, uint32_t>::const_iterator to = m_vertexIndexes.find (k->first.first);
+          if (to == m_vertexIndexes.end ())
+            {
+              return false;
+            }
+          NS_LOG_LOGIC ("Metric of the link from " << i->first << " to " << k->first.first <<
+                        " changed from " << k->second << " to " << l->second);
+          MetricChange change;
+          change.from = from->second;
+          change.to = to->second;
+          change.oldMetric = k->second;
+          change.newMetric = l->second;
+          changes.push_back (change);
+        }
+    }
+
+  for (DistanceMap_t::const_iterator r = m_distances.begin (); r != m_distances.end (); r++)
+    {
+      std::vector<uint32_t> const &d = r->second;
+      bool affected = false;
+      for (std::vector<uint32_t>::const_iterator k = changed.begin (); !affected && k != changed.end (); k++)
+        {
+          affected = d[*k] != SPF_INFINITY;
+        }
+      for (std::vector<MetricChange>::const_iterator k = changes.begin (); !affected && k != changes.end (); k++)
+        {
+          if (d[k->from] == SPF_INFINITY)
+            {
+              continue;
+            }
+          if (k->newMetric < k->oldMetric)
+            {
+              affected = d[k->from] + k->newMetric <= d[k->to];
+            }
+          else
+            {
+              affected = d[k->from] + k->oldMetric == d[k->to];
+            }
+        }
+      if (affected)
+        {
+          roots.insert (r->first);
+        }
+    }
+  return true;
+}
+
 //
 // This method is derived from quagga ospf_spf_next ().  See RFC2328 Section 
 // 16.1 (2) for further details.
@@ -945,7 +1271,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 // If we've changed the cost to get to the vertex represented by <w>, we 
 // must reorder the priority queue keyed to that cost.
 //
-                  candidate.Reorder ();
+                  candidate.Update (cw);
                 }
             } // new lower cost path found
         } // end W is already on the candidate list
@@ -1109,7 +1435,7 @@ GlobalRouteManagerImpl::SPFNexthopCalculation (
         }
       else 
         {
-          w->SetRootExitDirection (v->GetRootExitDirection ());
+          w->InheritAllRootExitDirections (v);
         }
     }
   else 
@@ -1351,6 +1677,12 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // We also mark this vertex as being in the SPF tree.
 //
   m_spfroot= v;
+  m_spfrootNode = 0;
+  RouterNodeMap_t::const_iterator rootNode = m_routerNodes.find (root);
+  if (rootNode != m_routerNodes.end ())
+    {
+      m_spfrootNode = NodeList::GetNode (rootNode->second);
+    }
   v->SetDistanceFromRoot (0);
   v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
   NS_LOG_LOGIC ("Starting SPFCalculate for node " << root);
@@ -1366,9 +1698,20 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
     {
       NS_LOG_LOGIC ("SPFCalculate truncated for stub node " << root);
       delete m_spfroot;
+      m_spfroot = 0;
+      m_spfrootNode = 0;
+      m_distances.erase (root);
       return;
     }
 
+  std::vector<uint32_t> *distances = 0;
+  if (m_incremental)
+    {
+      distances = &m_distances[root];
+      distances->assign (m_vertexIndexes.size (), SPF_INFINITY);
+      (*distances)[m_vertexIndexes[root]] = 0;
+    }
+
   for (;;)
     {
 //
@@ -1409,6 +1752,10 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
       NS_LOG_LOGIC (candidate);
       v = candidate.Pop ();
       NS_LOG_LOGIC ("Popped vertex " << v->GetVertexId ());
+      if (distances != 0)
+        {
+          (*distances)[m_vertexIndexes[v->GetVertexId ()]] = v->GetDistanceFromRoot ();
+        }
 //
 // Update the status field of the vertex to indicate that it is in the SPF
 // tree.
@@ -1487,6 +1834,7 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
   delete m_spfroot;
   m_spfroot = 0;
+  m_spfrootNode = 0;
 }
 
 void
@@ -1545,58 +1893,35 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The node that has the router ID corresponding to the root vertex was
+// found by SPFCalculate ().  This is the one we're going to write the
+// routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = m_spfrootNode;
+  if (node != 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
+      NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
 //
 // Routing information is updated using the Ipv4 interface.  We need to QI
 // for that interface.  If the node is acting as an IP version 4 router, it
 // should absolutely have an Ipv4 interface.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
+      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+      NS_ASSERT_MSG (ipv4, 
+                     "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                     "QI for <Ipv4> interface failed");
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = extlsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
+      NS_ASSERT_MSG (v->GetLSA (), 
+                     "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                     "Expected valid LSA in SPFVertex* v");
+      Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
+      Ipv4Address tempip = extlsa->GetLinkStateId ();
+      tempip = tempip.CombineMask (tempmask);
 
 //
 // Here's why we did all of that work.  We're going to add a host route to the
@@ -1611,39 +1936,38 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
+      Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+      if (router == 0)
+        {
+          return;
+        }
+      Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+      NS_ASSERT (gr);
+      // walk through all next-hop-IPs and out-going-interfaces for reaching
+      // the stub network gateway 'v' from the root node
+      for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+        {
+          SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+          Ipv4Address nextHop = exit.first;
+          int32_t outIf = exit.second;
+          if (outIf >= 0)
             {
-              continue;
+              gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf, v->GetRootExitWeight (i));
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                            " add external network route to " << tempip <<
+                            " using next hop " << nextHop <<
+                            " via interface " << outIf);
             }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+          else
             {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add external network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                            " NOT able to add network route to " << tempip <<
+                            " using next hop " << nextHop <<
+                            " since outgoing interface id is negative");
             }
-          return;
-        } // if
-    } // for
+        }
+      return;
+    }
 }
 
 
@@ -1714,60 +2038,35 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The node that has the router ID corresponding to the root vertex was
+// found by SPFCalculate ().  This is the one we're going to write the
+// routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = m_spfrootNode;
+  if (node != 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
+      NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
 //
 // Routing information is updated using the Ipv4 interface.  We need to QI
 // for that interface.  If the node is acting as an IP version 4 router, it
 // should absolutely have an Ipv4 interface.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
+      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+      NS_ASSERT_MSG (ipv4, 
+                     "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                     "QI for <Ipv4> interface failed");
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask (l->GetLinkData ().Get ());
-          Ipv4Address tempip = l->GetLinkId ();
-          tempip = tempip.CombineMask (tempmask);
+      NS_ASSERT_MSG (v->GetLSA (), 
+                     "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                     "Expected valid LSA in SPFVertex* v");
+      Ipv4Mask tempmask (l->GetLinkData ().Get ());
+      Ipv4Address tempip = l->GetLinkId ();
+      tempip = tempip.CombineMask (tempmask);
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -1782,39 +2081,38 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 // which the packets should be send for forwarding.
 //
 
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
+      Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+      if (router == 0)
+        {
+          return;
+        }
+      Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+      NS_ASSERT (gr);
+      // walk through all next-hop-IPs and out-going-interfaces for reaching
+      // the stub network gateway 'v' from the root node
+      for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+        {
+          SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+          Ipv4Address nextHop = exit.first;
+          int32_t outIf = exit.second;
+          if (outIf >= 0)
             {
-              continue;
+              gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf, v->GetRootExitWeight (i));
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                            " add network route to " << tempip <<
+                            " using next hop " << nextHop <<
+                            " via interface " << outIf);
             }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+          else
             {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                            " NOT able to add network route to " << tempip <<
+                            " using next hop " << nextHop <<
+                            " since outgoing interface id is negative");
             }
-          return;
-        } // if
-    } // for
+        }
+      return;
+    }
 }
 
 //
@@ -1838,55 +2136,38 @@ GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
 //
   Ipv4Address routerId = m_spfroot->GetVertexId ();
 //
-// Walk the list of nodes in the system looking for the one corresponding to
-// the node at the root of the SPF tree.  This is the node for which we are
-// building the routing table.
+// The node corresponding to the root of the SPF tree was found by
+// SPFCalculate ().  This is the node for which we are building the routing
+// table.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = m_spfrootNode;
+  if (node != 0)
     {
-      Ptr<Node> node = *i;
-
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-//
-// If the node doesn't have a GlobalRouter interface it can't be the one
-// we're interested in.
-//
-      if (rtr == 0)
-        {
-          continue;
-        }
-
-      if (rtr->GetRouterId () == routerId)
-        {
 //
 // This is the node we're building the routing table for.  We're going to need
 // the Ipv4 interface to look for the ipv4 interface index.  Since this node
 // is participating in routing IP version 4 packets, it certainly must have 
 // an Ipv4 interface.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
-                         "GetObject for <Ipv4> interface failed");
+      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+      NS_ASSERT_MSG (ipv4, 
+                     "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
+                     "GetObject for <Ipv4> interface failed");
 //
 // Look through the interfaces on this node for one that has the IP address
 // we're looking for.  If we find one, return the corresponding interface
 // index, or -1 if not found.
 //
-          int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
+      int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
 
 #if 0
-          if (interface < 0)
-            {
-              NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
-                              "Expected an interface associated with address a:" << a);
-            }
-#endif 
-          return interface;
+      if (interface < 0)
+        {
+          NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
+                          "Expected an interface associated with address a:" << a);
         }
+#endif 
+      return interface;
     }
 //
 // Couldn't find it.
@@ -1929,60 +2210,35 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The node that has the router ID corresponding to the root vertex was
+// found by SPFCalculate ().  This is the one we're going to write the
+// routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = m_spfrootNode;
+  if (node != 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
+      NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
 //
 // Routing information is updated using the Ipv4 interface.  We need to 
 // GetObject for that interface.  If the node is acting as an IP version 4 
 // router, it should absolutely have an Ipv4 interface.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "GetObject for <Ipv4> interface failed");
+      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+      NS_ASSERT_MSG (ipv4, 
+                     "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                     "GetObject for <Ipv4> interface failed");
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
+      GlobalRoutingLSA *lsa = v->GetLSA ();
+      NS_ASSERT_MSG (lsa, 
+                     "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                     "Expected valid LSA in SPFVertex* v");
 
-          uint32_t nLinkRecords = lsa->GetNLinkRecords ();
+      uint32_t nLinkRecords = lsa->GetNLinkRecords ();
 //
 // Iterate through the link records on the vertex to which we're going to add
 // routes.  To make sure we're being clear, we're going to add routing table
@@ -1991,18 +2247,18 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // the local side of the point-to-point links found on the node described by
 // the vertex <v>.
 //
-          NS_LOG_LOGIC (" Node " << node->GetId () <<
-                        " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
-          for (uint32_t j = 0; j < nLinkRecords; ++j)
-            {
+      NS_LOG_LOGIC (" Node " << node->GetId () <<
+                    " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
+      for (uint32_t j = 0; j < nLinkRecords; ++j)
+        {
 //
 // We are only concerned about point-to-point links
 //
-              GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
-              if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
-                {
-                  continue;
-                }
+          GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+          if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+            {
+              continue;
+            }
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -2016,44 +2272,43 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-              Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-              if (router == 0)
+          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+          if (router == 0)
+            {
+              continue;
+            }
+          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+          NS_ASSERT (gr);
+          // walk through all available exit directions due to ECMP,
+          // and add host route for each of the exit direction toward
+          // the vertex 'v'
+          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+            {
+              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+              Ipv4Address nextHop = exit.first;
+              int32_t outIf = exit.second;
+              if (outIf >= 0)
                 {
-                  continue;
+                  gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
+                                      outIf, v->GetRootExitWeight (i));
+                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                                " adding host route to " << lr->GetLinkData () <<
+                                " using next hop " << nextHop <<
+                                " and outgoing interface " << outIf);
                 }
-              Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-              NS_ASSERT (gr);
-              // walk through all available exit directions due to ECMP,
-              // and add host route for each of the exit direction toward
-              // the vertex 'v'
-              for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+              else
                 {
-                  SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-                  Ipv4Address nextHop = exit.first;
-                  int32_t outIf = exit.second;
-                  if (outIf >= 0)
-                    {
-                      gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
-                                          outIf);
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " adding host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " and outgoing interface " << outIf);
-                    }
-                  else
-                    {
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " NOT able to add host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " since outgoing interface id is negative " << outIf);
-                    }
-                } // for all routes from the root the vertex 'v'
-            }
+                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                                " NOT able to add host route to " << lr->GetLinkData () <<
+                                " using next hop " << nextHop <<
+                                " since outgoing interface id is negative " << outIf);
+                }
+            } // for all routes from the root the vertex 'v'
+        }
 //
 // Done adding the routes for the selected node.
 //
-          return;
-        }
+      return;
     }
 }
 void
@@ -2074,95 +2329,69 @@ GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The node that has the router ID corresponding to the root vertex was
+// found by SPFCalculate ().  This is the one we're going to write the
+// routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = m_spfrootNode;
+  if (node != 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
+      NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
 //
 // Routing information is updated using the Ipv4 interface.  We need to 
 // GetObject for that interface.  If the node is acting as an IP version 4 
 // router, it should absolutely have an Ipv4 interface.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "GetObject for <Ipv4> interface failed");
+      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+      NS_ASSERT_MSG (ipv4, 
+                     "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                     "GetObject for <Ipv4> interface failed");
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = lsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
+      GlobalRoutingLSA *lsa = v->GetLSA ();
+      NS_ASSERT_MSG (lsa, 
+                     "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                     "Expected valid LSA in SPFVertex* v");
+      Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
+      Ipv4Address tempip = lsa->GetLinkStateId ();
+      tempip = tempip.CombineMask (tempmask);
+      Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+      if (router == 0)
+        {
+          return;
+        }
+      Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+      NS_ASSERT (gr);
+      // walk through all available exit directions due to ECMP,
+      // and add host route for each of the exit direction toward
+      // the vertex 'v'
+      for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+        {
+          SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+          Ipv4Address nextHop = exit.first;
+          int32_t outIf = exit.second;
+
+          if (outIf >= 0)
             {
-              continue;
+              gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf, v->GetRootExitWeight (i));
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                            " add network route to " << tempip <<
+                            " using next hop " << nextHop <<
+                            " via interface " << outIf);
             }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all available exit directions due to ECMP,
-          // and add host route for each of the exit direction toward
-          // the vertex 'v'
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+          else
             {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative " << outIf);
-                }
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                            " NOT able to add network route to " << tempip <<
+                            " using next hop " << nextHop <<
+                            " since outgoing interface id is negative " << outIf);
             }
         }
-    } 
+    }
 }
 
 // Derived from quagga ospf_vertex_add_parents ()
@@ -26,6 +26,7 @@
 #include <list>
 #include <queue>
 #include <map>
+#include <set>
 #include <vector>
 #include "ns3/object.h"
 #include "ns3/ptr.h"
@@ -384,6 +385,17 @@ public:
    * \return The number of exit directions from root
    */
   uint32_t GetNRootExitDirections () const;
+  /**
+   * \brief Get the number of shortest paths from the root to 'this' vertex
+   * through an exit direction
+   *
+   * The paths are counted as the exit directions are set, inherited and
+   * merged, and give the weight of the route through this exit.
+   *
+   * \param i An index to an exit direction
+   * \return The number of shortest paths through this exit direction
+   */
+  uint32_t GetRootExitWeight (uint32_t i) const;
 
 /**
  * @brief Get a pointer to the SPFVector that is the parent of "this" 
@@ -546,10 +558,17 @@ private:
   typedef std::list< NodeExit_t > ListOfNodeExit_t;
   /// store the multiple root's exits for supporting ECMP
   ListOfNodeExit_t m_ecmpRootExits;
+  typedef std::map<NodeExit_t, uint32_t> RootExitWeights_t;
+  /// number of shortest paths through each of the root's exits
+  RootExitWeights_t m_ecmpRootExitWeights;
   typedef std::list<SPFVertex*> ListOfSPFVertex_t;
   ListOfSPFVertex_t m_parents;
   ListOfSPFVertex_t m_children;
   bool m_vertexProcessed; 
+  /// the position of the vertex in the heap of its CandidateQueue
+  uint32_t m_candidatePosition;
+  /// the order in which the vertex was pushed in its CandidateQueue
+  uint32_t m_candidateSequence;
 
 /**
  * @brief The SPFVertex copy construction is disallowed.  There's no need for
@@ -566,6 +585,7 @@ private:
   //friend std::ostream& operator<< (std::ostream& os, const ListOfIf_t& ifs);
   //friend std::ostream& operator<< (std::ostream& os, const ListOfAddr_t& addrs);
   friend std::ostream& operator<< (std::ostream& os, const SPFVertex::ListOfSPFVertex_t& vs);
+  friend class CandidateQueue;
 };
 
 /**
@@ -669,6 +689,7 @@ public:
 
 
 private:
+  friend class GlobalRouteManagerImpl;
   typedef std::map<Ipv4Address, GlobalRoutingLSA*> LSDBMap_t;
   typedef std::pair<Ipv4Address, GlobalRoutingLSA*> LSDBPair_t;
 
@@ -729,6 +750,19 @@ public:
  */
   virtual void InitializeRoutes ();
 
+/**
+ * @brief Discover the Link State Advertisements again and update the
+ * per-node forwarding tables
+ * @internal
+ *
+ * Unless the global value IncrementalRouteRecomputation is true, this is
+ * DeleteGlobalRoutes (), BuildGlobalRoutingDatabase () and then
+ * InitializeRoutes ().  Otherwise the new database is compared with the
+ * one of the previous computation, and only the routers whose shortest
+ * path tree or routes may have changed run the SPF calculation again.
+ */
+  virtual void RecomputeRoutes ();
+
 /**
  * @brief Debugging routine; allow client code to supply a pre-built LSDB
  * @internal
@@ -756,8 +790,18 @@ private:
  */
   GlobalRouteManagerImpl& operator= (GlobalRouteManagerImpl& srmi);
 
+  typedef std::map<Ipv4Address, uint32_t> RouterNodeMap_t;
+  typedef std::map<Ipv4Address, std::vector<uint32_t> > DistanceMap_t;
+
   SPFVertex* m_spfroot;
+  Ptr<Node> m_spfrootNode;
   GlobalRouteManagerLSDB* m_lsdb;
+  RouterNodeMap_t m_routerNodes;  // the node id of each router id
+  bool m_incremental;
+  std::map<Ipv4Address, uint32_t> m_vertexIndexes;
+  DistanceMap_t m_distances;  // per root, indexed by m_vertexIndexes
+  void DeleteRoutes (Ptr<Node> node);
+  bool FindAffectedRoots (GlobalRouteManagerLSDB* oldLsdb, std::set<Ipv4Address> &roots);
   bool CheckForStubNode (Ipv4Address root);
   void SPFCalculate (Ipv4Address root);
   void SPFProcessStubs (SPFVertex* v);
@@ -53,6 +53,13 @@ GlobalRouteManager::InitializeRoutes (void)
   InitializeRoutes ();
 }
 
+void
+GlobalRouteManager::RecomputeRoutes (void)
+{
+  SimulationSingleton<GlobalRouteManagerImpl>::Get ()->
+  RecomputeRoutes ();
+}
+
 uint32_t
 GlobalRouteManager::AllocateRouterId (void)
 {
@@ -67,6 +67,17 @@ public:
  */
   static void InitializeRoutes ();
 
+/**
+ * @brief Discover the Link State Advertisements again and update the
+ * per-node forwarding tables
+ * @internal
+ *
+ * The SPF calculation runs again on every router, or only on those which
+ * may be affected by the changes of the topology if the global value
+ * IncrementalRouteRecomputation is true.
+ */
+  static void RecomputeRoutes ();
+
 private:
 /**
  * @brief Global Route Manager copy construction is disallowed.  There's no 
@@ -0,0 +1,354 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ip-reassembly.h"
+
+NS_LOG_COMPONENT_DEFINE ("IpReassembly");
+
+namespace ns3 {
+
+// End of the last hole until the length of the datagram is known
+static const uint32_t UNKNOWN_END = 0xffffffff;
+
+NS_OBJECT_ENSURE_REGISTERED (IpReassembly);
+
+TypeId
+IpReassembly::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::IpReassembly")
+    .SetParent<Object> ()
+    .AddConstructor<IpReassembly> ()
+  ;
+  return tid;
+}
+
+IpReassembly::IpReassembly ()
+  : m_timeout (Seconds (30)),
+    m_maxMemory (4194304),
+    m_memory (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+IpReassembly::~IpReassembly ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+IpReassembly::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_expiryEvent.Cancel ();
+  m_datagrams.clear ();
+  m_queue.clear ();
+  m_memory = 0;
+  m_dropCallback = MakeNullCallback<void, Ptr<Packet>, Ptr<Packet>, uint32_t, DropReason> ();
+  Object::DoDispose ();
+}
+
+bool
+IpReassembly::KeyLess::operator () (const Key &a, const Key &b) const
+{
+  if (a.identification != b.identification)
+    {
+      return a.identification < b.identification;
+    }
+  if (a.protocol != b.protocol)
+    {
+      return a.protocol < b.protocol;
+    }
+  if (a.source != b.source)
+    {
+      return a.source < b.source;
+    }
+  return a.destination < b.destination;
+}
+
+void
+IpReassembly::SetTimeout (Time timeout)
+{
+  m_timeout = timeout;
+}
+
+Time
+IpReassembly::GetTimeout (void) const
+{
+  return m_timeout;
+}
+
+void
+IpReassembly::SetMaxMemory (uint32_t bytes)
+{
+  m_maxMemory = bytes;
+}
+
+uint32_t
+IpReassembly::GetMaxMemory (void) const
+{
+  return m_maxMemory;
+}
+
+void
+IpReassembly::SetDropCallback (DropCallback cb)
+{
+  m_dropCallback = cb;
+}
+
+uint32_t
+IpReassembly::GetNDatagrams (void) const
+{
+  return m_datagrams.size ();
+}
+
+uint32_t
+IpReassembly::GetMemory (void) const
+{
+  return m_memory;
+}
+
+bool
+IpReassembly::AddFragment (const Key &key, Ptr<Packet> &packet, uint32_t offset, bool moreFragments,
+                           Ptr<Packet> &header, uint32_t iif)
+{
+  NS_LOG_FUNCTION (this << packet << offset << moreFragments << iif);
+
+  Datagrams_t::iterator it = m_datagrams.find (key);
+  if (it == m_datagrams.end ())
+    {
+      it = m_datagrams.insert (std::make_pair (key, Datagram ())).first;
+      Datagram &d = it->second;
+      d.holes[0] = UNKNOWN_END;
+      d.lastSeen = false;
+      d.length = 0;
+      d.header = header;
+      d.firstSeen = (offset == 0);
+      d.iif = iif;
+      d.size = header->GetSize ();
+      d.expires = Simulator::Now () + m_timeout;
+      d.age = m_queue.insert (m_queue.end (), key);
+      m_memory += d.size;
+      ScheduleExpiry ();
+    }
+  else if (offset == 0 && !it->second.firstSeen)
+    {
+      Datagram &d = it->second;
+      d.size -= d.header->GetSize ();
+      m_memory -= d.header->GetSize ();
+      d.header = header;
+      d.size += header->GetSize ();
+      m_memory += header->GetSize ();
+      d.firstSeen = true;
+    }
+
+  Datagram &d = it->second;
+  Insert (d, packet, offset, moreFragments);
+
+  if (d.lastSeen && d.holes.empty ())
+    {
+      Ptr<Packet> p = Create<Packet> ();
+      for (std::map<uint32_t, Ptr<Packet> >::const_iterator i = d.data.begin (); i != d.data.end (); ++i)
+        {
+          p->AddAtEnd (i->second);
+        }
+      NS_LOG_LOGIC ("Datagram complete, " << p->GetSize () << " bytes");
+      packet = p;
+      header = d.header;
+      Remove (it);
+      return true;
+    }
+
+  // Make room for the fragment by dropping the oldest datagrams, maybe its own
+  while (m_memory > m_maxMemory)
+    {
+      Datagrams_t::iterator oldest = m_datagrams.find (m_queue.front ());
+      bool own = (oldest == it);
+      NS_LOG_LOGIC ("Memory limit of " << m_maxMemory << " bytes hit, dropping the oldest datagram");
+      Drop (oldest, DROP_MEMORY);
+      if (own)
+        {
+          break;
+        }
+    }
+  return false;
+}
+
+void
+IpReassembly::Insert (Datagram &d, Ptr<Packet> fragment, uint32_t offset, bool moreFragments)
+{
+  uint32_t start = offset;
+  uint32_t end = offset + fragment->GetSize ();
+
+  if (!moreFragments && !d.lastSeen)
+    {
+      SetLength (d, end);
+    }
+  if (d.lastSeen)
+    {
+      end = std::min (end, d.length);
+    }
+
+  // First hole ending after the start of the fragment
+  std::map<uint32_t, uint32_t>::iterator hole = d.holes.upper_bound (start);
+  if (hole != d.holes.begin ())
+    {
+      std::map<uint32_t, uint32_t>::iterator prev = hole;
+      --prev;
+      if (prev->second > start)
+        {
+          hole = prev;
+        }
+    }
+
+  // Keep the bytes of the fragment falling into the holes
+  while (hole != d.holes.end () && hole->first < end)
+    {
+      uint32_t holeStart = hole->first;
+      uint32_t holeEnd = hole->second;
+      uint32_t s = std::max (start, holeStart);
+      uint32_t e = std::min (end, holeEnd);
+
+      d.data[s] = fragment->CreateFragment (s - offset, e - s);
+      d.size += e - s;
+      m_memory += e - s;
+
+      d.holes.erase (hole++);
+      if (holeStart < s)
+        {
+          d.holes[holeStart] = s;
+        }
+      if (e < holeEnd)
+        {
+          d.holes[e] = holeEnd;
+        }
+    }
+}
+
+void
+IpReassembly::SetLength (Datagram &d, uint32_t length)
+{
+  d.lastSeen = true;
+  d.length = length;
+
+  // No hole after the end
+  d.holes.erase (d.holes.lower_bound (length), d.holes.end ());
+  if (!d.holes.empty ())
+    {
+      std::map<uint32_t, uint32_t>::iterator last = d.holes.end ();
+      --last;
+      last->second = std::min (last->second, length);
+    }
+
+  // No data after the end either
+  std::map<uint32_t, Ptr<Packet> >::iterator i = d.data.lower_bound (length);
+  while (i != d.data.end ())
+    {
+      d.size -= i->second->GetSize ();
+      m_memory -= i->second->GetSize ();
+      d.data.erase (i++);
+    }
+  if (!d.data.empty ())
+    {
+      i = d.data.end ();
+      --i;
+      if (i->first + i->second->GetSize () > length)
+        {
+          uint32_t excess = i->first + i->second->GetSize () - length;
+          i->second = i->second->CreateFragment (0, length - i->first);
+          d.size -= excess;
+          m_memory -= excess;
+        }
+    }
+}
+
+Ptr<Packet>
+IpReassembly::GetPartialPacket (const Datagram &d) const
+{
+  Ptr<Packet> p = Create<Packet> ();
+  uint32_t next = 0;
+
+  for (std::map<uint32_t, Ptr<Packet> >::const_iterator i = d.data.begin (); i != d.data.end (); ++i)
+    {
+      if (i->first != next)
+        {
+          break;
+        }
+      p->AddAtEnd (i->second);
+      next += i->second->GetSize ();
+    }
+  return p;
+}
+
+void
+IpReassembly::Remove (Datagrams_t::iterator it)
+{
+  m_memory -= it->second.size;
+  m_queue.erase (it->second.age);
+  m_datagrams.erase (it);
+}
+
+void
+IpReassembly::Drop (Datagrams_t::iterator it, DropReason reason)
+{
+  NS_LOG_FUNCTION (this << reason);
+
+  Ptr<Packet> header = it->second.header;
+  Ptr<Packet> partial = GetPartialPacket (it->second);
+  uint32_t iif = it->second.iif;
+  Remove (it);
+
+  if (!m_dropCallback.IsNull ())
+    {
+      m_dropCallback (header, partial, iif, reason);
+    }
+}
+
+void
+IpReassembly::ScheduleExpiry (void)
+{
+  if (m_expiryEvent.IsRunning () || m_queue.empty ())
+    {
+      return;
+    }
+  Time expires = m_datagrams.find (m_queue.front ())->second.expires;
+  m_expiryEvent = Simulator::Schedule (expires - Simulator::Now (), &IpReassembly::Expire, this);
+}
+
+void
+IpReassembly::Expire (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // The head of the queue may have been reassembled since the event was
+  // scheduled: drop what is due and wait for the next oldest datagram.
+  while (!m_queue.empty ())
+    {
+      Datagrams_t::iterator oldest = m_datagrams.find (m_queue.front ());
+      if (oldest->second.expires > Simulator::Now ())
+        {
+          break;
+        }
+      NS_LOG_LOGIC ("Fragments of a datagram timed out");
+      Drop (oldest, DROP_TIMEOUT);
+    }
+  ScheduleExpiry ();
+}
+
+} // namespace ns3
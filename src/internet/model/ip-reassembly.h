@@ -0,0 +1,192 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IP_REASSEMBLY_H
+#define IP_REASSEMBLY_H
+
+#include <map>
+#include <list>
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/address.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/callback.h"
+
+namespace ns3 {
+
+class Packet;
+
+/**
+ * \ingroup internet
+ *
+ * \brief Reassembly of the fragmented datagrams, shared by IPv4 and IPv6.
+ *
+ * Each datagram keeps its data as disjoint blocks keyed by their offset, and
+ * the list of its holes (RFC 815) keyed by their start: a fragment is placed
+ * in logarithmic time, only the bytes falling into a hole are kept, so that
+ * the first copy of overlapping data wins, and the datagram is complete when
+ * its last fragment was received and no hole is left.
+ *
+ * The datagrams are queued by age, and a single event expires the oldest of
+ * them, whatever their number.  The bytes kept by all the datagrams are
+ * bounded: when a fragment exceeds the limit, the oldest datagrams are
+ * dropped until the buffer fits.
+ */
+class IpReassembly : public Object
+{
+public:
+  /**
+   * \enum DropReason
+   * \brief Reason why a datagram is dropped before its reassembly.
+   */
+  enum DropReason
+  {
+    DROP_TIMEOUT,   /**< Its fragments did not all arrive in time */
+    DROP_MEMORY     /**< It was the oldest one when the memory limit was hit */
+  };
+
+  /**
+   * \brief Identifies the fragments of a datagram.
+   */
+  struct Key
+  {
+    Address source;
+    Address destination;
+    uint32_t identification;
+    uint8_t protocol;
+  };
+
+  /**
+   * \brief Callback of a dropped datagram, with the header given with its
+   * fragments, the data received contiguously from its start, the interface
+   * of its first fragment and the reason of the drop.
+   */
+  typedef Callback<void, Ptr<Packet>, Ptr<Packet>, uint32_t, DropReason> DropCallback;
+
+  static TypeId GetTypeId (void);
+  IpReassembly ();
+  virtual ~IpReassembly ();
+
+  /**
+   * \brief Set the time given to the fragments of a datagram to arrive.
+   * \param timeout the timeout
+   */
+  void SetTimeout (Time timeout);
+
+  /**
+   * \brief Get the time given to the fragments of a datagram to arrive.
+   * \return the timeout
+   */
+  Time GetTimeout (void) const;
+
+  /**
+   * \brief Set the limit on the bytes kept by all the datagrams.
+   * \param bytes the limit
+   */
+  void SetMaxMemory (uint32_t bytes);
+
+  /**
+   * \brief Get the limit on the bytes kept by all the datagrams.
+   * \return the limit
+   */
+  uint32_t GetMaxMemory (void) const;
+
+  /**
+   * \brief Set the callback of the datagrams dropped before their reassembly.
+   * \param cb the callback
+   */
+  void SetDropCallback (DropCallback cb);
+
+  /**
+   * \brief Add a fragment.
+   *
+   * The header of the datagram is the one of its first fragment at offset
+   * zero, or the one of its first fragment received until then.
+   *
+   * \param key the datagram of the fragment
+   * \param packet the data of the fragment, replaced by the data of the
+   * datagram when complete
+   * \param offset the offset of the fragment, in bytes
+   * \param moreFragments the bit "More Fragments"
+   * \param header the header of the fragment, replaced by the one of the
+   * datagram when complete
+   * \param iif the input interface
+   * \return true if the fragment completed the datagram
+   */
+  bool AddFragment (const Key &key, Ptr<Packet> &packet, uint32_t offset, bool moreFragments,
+                    Ptr<Packet> &header, uint32_t iif);
+
+  /**
+   * \brief Get the number of datagrams waiting for fragments.
+   * \return the number of datagrams
+   */
+  uint32_t GetNDatagrams (void) const;
+
+  /**
+   * \brief Get the bytes kept by all the datagrams.
+   * \return the memory used
+   */
+  uint32_t GetMemory (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  struct KeyLess
+  {
+    bool operator () (const Key &a, const Key &b) const;
+  };
+
+  /**
+   * \brief The fragments of a datagram.
+   */
+  struct Datagram
+  {
+    std::map<uint32_t, Ptr<Packet> > data;  //< Disjoint blocks of data, by offset
+    std::map<uint32_t, uint32_t> holes;     //< Missing bytes, from start to end
+    bool lastSeen;                          //< The last fragment was received
+    uint32_t length;                        //< Length of the data, if lastSeen
+    Ptr<Packet> header;                     //< Header of the datagram
+    bool firstSeen;                         //< The header is the one at offset zero
+    uint32_t iif;                           //< Input interface of the first fragment
+    uint32_t size;                          //< Bytes kept by the datagram
+    Time expires;                           //< Expiration time
+    std::list<Key>::iterator age;           //< Position in the expiry queue
+  };
+
+  typedef std::map<Key, Datagram, KeyLess> Datagrams_t;
+
+  void Insert (Datagram &d, Ptr<Packet> fragment, uint32_t offset, bool moreFragments);
+  void SetLength (Datagram &d, uint32_t length);
+  Ptr<Packet> GetPartialPacket (const Datagram &d) const;
+  void Remove (Datagrams_t::iterator it);
+  void Drop (Datagrams_t::iterator it, DropReason reason);
+  void ScheduleExpiry (void);
+  void Expire (void);
+
+  Time m_timeout;           //< Time given to the fragments of a datagram
+  uint32_t m_maxMemory;     //< Limit on the bytes kept
+  uint32_t m_memory;        //< Bytes kept by all the datagrams
+  Datagrams_t m_datagrams;  //< Datagrams waiting for fragments
+  std::list<Key> m_queue;   //< Datagrams, oldest first
+  EventId m_expiryEvent;    //< Expiration of the oldest datagram
+  DropCallback m_dropCallback;
+};
+
+} // namespace ns3
+
+#endif /* IP_REASSEMBLY_H */
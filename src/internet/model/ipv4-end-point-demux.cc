@@ -26,6 +26,22 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv4EndPointDemux");
 
+namespace {
+
+bool
+IsConnected (Ipv4Address peerAddress, uint16_t peerPort)
+{
+  return peerAddress != Ipv4Address::GetAny () && peerPort != 0;
+}
+
+uint64_t
+GetConnectionKey (uint16_t localPort, Ipv4Address peerAddress, uint16_t peerPort)
+{
+  return (static_cast<uint64_t> (localPort) << 48) | (static_cast<uint64_t> (peerAddress.Get ()) << 16) | peerPort;
+}
+
+} // anonymous namespace
+
 Ipv4EndPointDemux::Ipv4EndPointDemux ()
   : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152)
 {
@@ -41,30 +57,30 @@ Ipv4EndPointDemux::~Ipv4EndPointDemux ()
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_connected.clear ();
+  m_unconnected.clear ();
+  m_ports.clear ();
 }
 
 bool
 Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
-    {
-      if ((*i)->GetLocalPort  () == port) 
-        {
-          return true;
-        }
-    }
-  return false;
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool
 Ipv4EndPointDemux::LookupLocal (Ipv4Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  PortEndPoints::iterator endPoints = m_ports.find (port);
+  if (endPoints == m_ports.end ())
     {
-      if ((*i)->GetLocalPort () == port &&
-          (*i)->GetLocalAddress () == addr) 
+      return false;
+    }
+  for (EndPointsI i = endPoints->second.begin (); i != endPoints->second.end (); i++) 
+    {
+      if ((*i)->GetLocalAddress () == addr)
         {
           return true;
         }
@@ -83,7 +99,7 @@ Ipv4EndPointDemux::Allocate (void)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -99,7 +115,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -122,7 +138,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address, uint16_t port)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -132,21 +148,40 @@ Ipv4EndPointDemux::Allocate (Ipv4Address localAddress, uint16_t localPort,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  EndPoints *index = 0;
+  if (IsConnected (peerAddress, peerPort))
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress) 
+      ConnectedEndPoints::iterator connected = m_connected.find (GetConnectionKey (localPort, peerAddress, peerPort));
+      if (connected != m_connected.end ())
         {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
+          index = &connected->second;
+        }
+    }
+  else
+    {
+      PortEndPoints::iterator unconnected = m_unconnected.find (localPort);
+      if (unconnected != m_unconnected.end ())
+        {
+          index = &unconnected->second;
+        }
+    }
+  if (index != 0)
+    {
+      for (EndPointsI i = index->begin (); i != index->end (); i++)
+        {
+          if ((*i)->GetLocalAddress () == localAddress &&
+              (*i)->GetPeerPort () == peerPort &&
+              (*i)->GetPeerAddress () == peerAddress)
+            {
+              NS_LOG_WARN ("No way we can allocate this end-point.");
+              /* no way we can allocate this end-point. */
+              return 0;
+            }
         }
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
 
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
 
@@ -157,13 +192,69 @@ void
 Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  NS_ASSERT (endPoint->m_demux == this);
+  Unindex (endPoint);
+  PortEndPoints::iterator port = m_ports.find (endPoint->GetLocalPort ());
+  NS_ASSERT (port != m_ports.end ());
+  port->second.erase (endPoint->m_portPosition);
+  if (port->second.empty ())
     {
-      if (*i == endPoint)
+      m_ports.erase (port);
+    }
+  m_endPoints.erase (endPoint->m_allPosition);
+  delete endPoint;
+}
+
+Ipv4EndPoint *
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
+{
+  endPoint->m_allPosition = m_endPoints.insert (m_endPoints.end (), endPoint);
+  EndPoints &port = m_ports[endPoint->GetLocalPort ()];
+  endPoint->m_portPosition = port.insert (port.end (), endPoint);
+  endPoint->m_demux = this;
+  Index (endPoint);
+  return endPoint;
+}
+
+void
+Ipv4EndPointDemux::Index (Ipv4EndPoint *endPoint)
+{
+  if (IsConnected (endPoint->GetPeerAddress (), endPoint->GetPeerPort ()))
+    {
+      EndPoints &index = m_connected[GetConnectionKey (endPoint->GetLocalPort (), endPoint->GetPeerAddress (),
+                                                       endPoint->GetPeerPort ())];
+      endPoint->m_indexPosition = index.insert (index.end (), endPoint);
+    }
+  else
+    {
+      EndPoints &index = m_unconnected[endPoint->GetLocalPort ()];
+      endPoint->m_indexPosition = index.insert (index.end (), endPoint);
+    }
+}
+
+void
+Ipv4EndPointDemux::Unindex (Ipv4EndPoint *endPoint)
+{
+  if (IsConnected (endPoint->GetPeerAddress (), endPoint->GetPeerPort ()))
+    {
+      ConnectedEndPoints::iterator i = m_connected.find (GetConnectionKey (endPoint->GetLocalPort (),
+                                                                           endPoint->GetPeerAddress (),
+                                                                           endPoint->GetPeerPort ()));
+      NS_ASSERT (i != m_connected.end ());
+      i->second.erase (endPoint->m_indexPosition);
+      if (i->second.empty ())
         {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
+          m_connected.erase (i);
+        }
+    }
+  else
+    {
+      PortEndPoints::iterator i = m_unconnected.find (endPoint->GetLocalPort ());
+      NS_ASSERT (i != m_unconnected.end ());
+      i->second.erase (endPoint->m_indexPosition);
+      if (i->second.empty ())
+        {
+          m_unconnected.erase (i);
         }
     }
 }
@@ -204,99 +295,123 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
 
   NS_LOG_FUNCTION (this << daddr << dport << saddr << sport << incomingInterface);
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  bool subnetDirected = false;
+  Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
+  for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
     {
-      Ipv4EndPoint* endP = *i;
-      NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
-                                                 << " daddr=" << endP->GetLocalAddress ()
-                                                 << " sport=" << endP->GetPeerPort ()
-                                                 << " saddr=" << endP->GetPeerAddress ());
-      if (endP->GetLocalPort () != dport) 
+      Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
+      if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
+          daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
+        {
+          subnetDirected = true;
+          incomingInterfaceAddr = addr.GetLocal ();
+        }
+    }
+  bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
+  NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
+
+  // only the endpoints connected to the source of the packet and those
+  // which accept any source on its destination port may match
+  EndPoints *indexes[2] = { 0, 0 };
+  if (IsConnected (saddr, sport))
+    {
+      ConnectedEndPoints::iterator connected = m_connected.find (GetConnectionKey (dport, saddr, sport));
+      if (connected != m_connected.end ())
+        {
+          indexes[0] = &connected->second;
+        }
+    }
+  PortEndPoints::iterator unconnected = m_unconnected.find (dport);
+  if (unconnected != m_unconnected.end ())
+    {
+      indexes[1] = &unconnected->second;
+    }
+  for (uint32_t k = 0; k < 2; k++)
+    {
+      if (indexes[k] == 0)
         {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
           continue;
         }
-      if (endP->GetBoundNetDevice ())
+      for (EndPointsI i = indexes[k]->begin (); i != indexes[k]->end (); i++)
         {
-          if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
+          Ipv4EndPoint* endP = *i;
+          NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
+                                                     << " daddr=" << endP->GetLocalAddress ()
+                                                     << " sport=" << endP->GetPeerPort ()
+                                                     << " saddr=" << endP->GetPeerAddress ());
+          if (endP->GetLocalPort () != dport) 
             {
               NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                                 << " because endpoint is bound to specific device and"
-                                                 << endP->GetBoundNetDevice ()
-                                                 << " does not match packet device " << incomingInterface->GetDevice ());
+                                                 << " because endpoint dport "
+                                                 << endP->GetLocalPort ()
+                                                 << " does not match packet dport " << dport);
               continue;
             }
-        }
-      bool subnetDirected = false;
-      Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
-      for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
-        {
-          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
-          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
-              daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
+          if (endP->GetBoundNetDevice ())
             {
-              subnetDirected = true;
-              incomingInterfaceAddr = addr.GetLocal ();
+              if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
+                {
+                  NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                                                     << " because endpoint is bound to specific device and"
+                                                     << endP->GetBoundNetDevice ()
+                                                     << " does not match packet device " << incomingInterface->GetDevice ());
+                  continue;
+                }
             }
-        }
-      bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
-      NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
-      bool localAddressMatchesWildCard = 
-        endP->GetLocalAddress () == Ipv4Address::GetAny ();
-      bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
+          bool localAddressMatchesWildCard = 
+            endP->GetLocalAddress () == Ipv4Address::GetAny ();
+          bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
 
-      if (isBroadcast)
-        {
-          NS_LOG_DEBUG ("Found bcast, localaddr " << endP->GetLocalAddress ());
-        }
+          if (isBroadcast)
+            {
+              NS_LOG_DEBUG ("Found bcast, localaddr " << endP->GetLocalAddress ());
+            }
 
-      if (isBroadcast && (endP->GetLocalAddress () != Ipv4Address::GetAny ()))
-        {
-          localAddressMatchesExact = (endP->GetLocalAddress () ==
-                                      incomingInterfaceAddr);
-        }
-      // if no match here, keep looking
-      if (!(localAddressMatchesExact || localAddressMatchesWildCard))
-        continue; 
-      bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
-      bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
-      bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
-      bool remoteAddressMatchesWildCard = endP->GetPeerAddress () ==
-        Ipv4Address::GetAny ();
-      // If remote does not match either with exact or wildcard,
-      // skip this one
-      if (!(remotePeerMatchesExact || remotePeerMatchesWildCard))
-        continue;
-      if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
-        continue;
-
-      // Now figure out which return list to add this one to
-      if (localAddressMatchesWildCard &&
-          remotePeerMatchesWildCard &&
-          remoteAddressMatchesWildCard)
-        { // Only local port matches exactly
-          retval1.push_back (endP);
-        }
-      if ((localAddressMatchesExact || (isBroadcast && localAddressMatchesWildCard))&&
-          remotePeerMatchesWildCard &&
-          remoteAddressMatchesWildCard)
-        { // Only local port and local address matches exactly
-          retval2.push_back (endP);
-        }
-      if (localAddressMatchesWildCard &&
-          remotePeerMatchesExact &&
-          remoteAddressMatchesExact)
-        { // All but local address
-          retval3.push_back (endP);
-        }
-      if (localAddressMatchesExact &&
-          remotePeerMatchesExact &&
-          remoteAddressMatchesExact)
-        { // All 4 match
-          retval4.push_back (endP);
+          if (isBroadcast && (endP->GetLocalAddress () != Ipv4Address::GetAny ()))
+            {
+              localAddressMatchesExact = (endP->GetLocalAddress () ==
+                                          incomingInterfaceAddr);
+            }
+          // if no match here, keep looking
+          if (!(localAddressMatchesExact || localAddressMatchesWildCard))
+            continue; 
+          bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
+          bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
+          bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
+          bool remoteAddressMatchesWildCard = endP->GetPeerAddress () ==
+            Ipv4Address::GetAny ();
+          // If remote does not match either with exact or wildcard,
+          // skip this one
+          if (!(remotePeerMatchesExact || remotePeerMatchesWildCard))
+            continue;
+          if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
+            continue;
+
+          // Now figure out which return list to add this one to
+          if (localAddressMatchesWildCard &&
+              remotePeerMatchesWildCard &&
+              remoteAddressMatchesWildCard)
+            { // Only local port matches exactly
+              retval1.push_back (endP);
+            }
+          if ((localAddressMatchesExact || (isBroadcast && localAddressMatchesWildCard))&&
+              remotePeerMatchesWildCard &&
+              remoteAddressMatchesWildCard)
+            { // Only local port and local address matches exactly
+              retval2.push_back (endP);
+            }
+          if (localAddressMatchesWildCard &&
+              remotePeerMatchesExact &&
+              remoteAddressMatchesExact)
+            { // All but local address
+              retval3.push_back (endP);
+            }
+          if (localAddressMatchesExact &&
+              remotePeerMatchesExact &&
+              remoteAddressMatchesExact)
+            { // All 4 match
+              retval4.push_back (endP);
+            }
         }
     }
 
@@ -23,6 +23,7 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
 #include "ns3/ipv4-address.h"
 #include "ipv4-interface.h"
 
@@ -38,6 +39,11 @@ class Ipv4EndPoint;
  * of endpoints, and has APIs to add and find endpoints in this demux.  This
  * code is shared in common to TCP and UDP protocols in ns3.  This demux
  * sits between ns3's layer four and the socket layer
+ *
+ * The endpoints are also indexed by their local port and peer, so that a
+ * lookup only examines the endpoints connected to the source of the packet
+ * and those which accept any source on the destination port, rather than
+ * every connection of the node.
  */
 
 class Ipv4EndPointDemux {
@@ -74,12 +80,27 @@ public:
   void DeAllocate (Ipv4EndPoint *endPoint);
 
 private:
+  friend class Ipv4EndPoint;
+  typedef std::map<uint64_t, EndPoints> ConnectedEndPoints;
+  typedef std::map<uint16_t, EndPoints> PortEndPoints;
+
   uint16_t AllocateEphemeralPort (void);
+  Ipv4EndPoint *Insert (Ipv4EndPoint *endPoint);
+  // called when the peer of an endpoint changes; the endpoints keep their
+  // positions in the lists, so that they are removed in logarithmic time
+  void Index (Ipv4EndPoint *endPoint);
+  void Unindex (Ipv4EndPoint *endPoint);
 
   uint16_t m_ephemeral;
   uint16_t m_portLast;
   uint16_t m_portFirst;
   EndPoints m_endPoints;
+  // the endpoints with a peer address and port, by local port and peer
+  ConnectedEndPoints m_connected;
+  // the other endpoints, by local port
+  PortEndPoints m_unconnected;
+  // all the endpoints, by local port
+  PortEndPoints m_ports;
 };
 
 } // namespace ns3
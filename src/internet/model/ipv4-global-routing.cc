@@ -27,6 +27,8 @@
 #include "ns3/ipv4-route.h"
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/node.h"
 #include "ipv4-global-routing.h"
 #include "global-route-manager.h"
 
@@ -46,6 +48,23 @@ Ipv4GlobalRouting::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&Ipv4GlobalRouting::m_randomEcmpRouting),
                    MakeBooleanChecker ())
+    .AddAttribute ("FlowEcmpRouting",
+                   "Set to true if flows are routed among ECMP by a hash of their addresses, protocol and ports, "
+                   "which keeps the packets of a flow on one route; takes precedence over RandomEcmpRouting",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Ipv4GlobalRouting::m_flowEcmpRouting),
+                   MakeBooleanChecker ())
+    .AddAttribute ("WeightedEcmpRouting",
+                   "Set to true if the random or flow ECMP routing chooses the routes in proportion to their weights, "
+                   "the number of shortest paths through their next hop",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Ipv4GlobalRouting::m_weightedEcmpRouting),
+                   MakeBooleanChecker ())
+    .AddAttribute ("EcmpHashSeed",
+                   "The seed of the flow hash of FlowEcmpRouting, mixed with the id of the node",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&Ipv4GlobalRouting::m_ecmpHashSeed),
+                   MakeUintegerChecker<uint32_t> ())
     .AddAttribute ("RespondToInterfaceEvents",
                    "Set to true if you want to dynamically recompute the global routes upon Interface notification events (up/down, or add/remove address)",
                    BooleanValue (false),
@@ -57,6 +76,10 @@ Ipv4GlobalRouting::GetTypeId (void)
 
 Ipv4GlobalRouting::Ipv4GlobalRouting () 
   : m_randomEcmpRouting (false),
+    m_flowEcmpRouting (false),
+    m_weightedEcmpRouting (false),
+    m_ecmpHashSeed (0),
+    m_nodeId (0),
     m_respondToInterfaceEvents (false)
 {
   NS_LOG_FUNCTION_NOARGS ();
@@ -70,12 +93,14 @@ Ipv4GlobalRouting::~Ipv4GlobalRouting ()
 void 
 Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest, 
                                    Ipv4Address nextHop, 
-                                   uint32_t interface)
+                                   uint32_t interface,
+                                   uint32_t weight)
 {
-  NS_LOG_FUNCTION (dest << nextHop << interface);
+  NS_LOG_FUNCTION (dest << nextHop << interface << weight);
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
   m_hostRoutes.push_back (route);
+  SetWeight (route, weight);
 }
 
 void 
@@ -92,15 +117,17 @@ void
 Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network, 
                                       Ipv4Mask networkMask, 
                                       Ipv4Address nextHop, 
-                                      uint32_t interface)
+                                      uint32_t interface,
+                                      uint32_t weight)
 {
-  NS_LOG_FUNCTION (network << networkMask << nextHop << interface);
+  NS_LOG_FUNCTION (network << networkMask << nextHop << interface << weight);
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateNetworkRouteTo (network,
                                                         networkMask,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (route);
+  SetWeight (route, weight);
 }
 
 void 
@@ -120,26 +147,129 @@ void
 Ipv4GlobalRouting::AddASExternalRouteTo (Ipv4Address network, 
                                          Ipv4Mask networkMask,
                                          Ipv4Address nextHop,
-                                         uint32_t interface)
+                                         uint32_t interface,
+                                         uint32_t weight)
 {
-  NS_LOG_FUNCTION (network << networkMask << nextHop);
+  NS_LOG_FUNCTION (network << networkMask << nextHop << weight);
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateNetworkRouteTo (network,
                                                         networkMask,
                                                         nextHop,
                                                         interface);
   m_ASexternalRoutes.push_back (route);
+  SetWeight (route, weight);
+}
+
+// Only the weights other than 1 are stored: the global routes of a large
+// topology are many, and most of them have a single path.
+void
+Ipv4GlobalRouting::SetWeight (const Ipv4RoutingTableEntry *route, uint32_t weight)
+{
+  NS_ASSERT (weight > 0);
+  if (weight != 1)
+    {
+      m_weights[route] = weight;
+    }
+}
+
+uint32_t
+Ipv4GlobalRouting::GetWeight (const Ipv4RoutingTableEntry *route) const
+{
+  RouteWeights_t::const_iterator i = m_weights.find (route);
+  if (i == m_weights.end ())
+    {
+      return 1;
+    }
+  return i->second;
+}
+
+// The finalizer of MurmurHash3
+static uint32_t
+FlowHashMix (uint32_t h, uint32_t k)
+{
+  h ^= k;
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+uint32_t
+Ipv4GlobalRouting::GetFlowHash (const Ipv4Header &header, Ptr<const Packet> p) const
+{
+  uint32_t ports = 0;
+  uint8_t protocol = header.GetProtocol ();
+  // The ports are the first 4 bytes of the TCP and UDP headers, which only
+  // the first fragment carries: a fragmented packet is hashed without them.
+  if (p != 0 && (protocol == 6 || protocol == 17)
+      && header.IsLastFragment () && header.GetFragmentOffset () == 0
+      && p->GetSize () >= 4)
+    {
+      uint8_t buffer[4];
+      p->CopyData (buffer, 4);
+      ports = (buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3];
+    }
+  uint32_t h = FlowHashMix (m_ecmpHashSeed, m_nodeId);
+  h = FlowHashMix (h, header.GetSource ().Get ());
+  h = FlowHashMix (h, header.GetDestination ().Get ());
+  h = FlowHashMix (h, protocol);
+  h = FlowHashMix (h, ports);
+  return h;
+}
+
+uint32_t
+Ipv4GlobalRouting::SelectRoute (const RouteVec_t &routes, const Ipv4Header &header, Ptr<const Packet> p)
+{
+  if (routes.size () == 1 || (!m_flowEcmpRouting && !m_randomEcmpRouting))
+    {
+      return 0;
+    }
+  uint32_t total = routes.size ();
+  if (m_weightedEcmpRouting)
+    {
+      total = 0;
+      for (RouteVec_t::const_iterator i = routes.begin (); i != routes.end (); i++)
+        {
+          total += GetWeight (*i);
+        }
+    }
+  uint32_t point;
+  if (m_flowEcmpRouting)
+    {
+      point = GetFlowHash (header, p) % total;
+    }
+  else
+    {
+      point = m_rand.GetInteger (0, total - 1);
+    }
+  if (!m_weightedEcmpRouting)
+    {
+      return point;
+    }
+  for (uint32_t i = 0; i < routes.size (); i++)
+    {
+      uint32_t weight = GetWeight (routes[i]);
+      if (point < weight)
+        {
+          return i;
+        }
+      point -= weight;
+    }
+  NS_ASSERT (false);
+  return 0;
 }
 
 
 Ptr<Ipv4Route>
-Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
+Ipv4GlobalRouting::LookupGlobal (const Ipv4Header &header, Ptr<const Packet> p, Ptr<NetDevice> oif)
 {
   NS_LOG_FUNCTION_NOARGS ();
+  Ipv4Address dest = header.GetDestination ();
   NS_LOG_LOGIC ("Looking for route for destination " << dest);
   Ptr<Ipv4Route> rtentry = 0;
   // store all available routes that bring packets to their destination
-  typedef std::vector<Ipv4RoutingTableEntry*> RouteVec_t;
   RouteVec_t allRoutes;
 
   NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
@@ -212,18 +342,10 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
     }
   if (allRoutes.size () > 0 ) // if route(s) is found
     {
-      // pick up one of the routes uniformly at random if random
+      // pick up one of the routes by the flow hash or at random if
       // ECMP routing is enabled, or always select the first route
-      // consistently if random ECMP routing is disabled
-      uint32_t selectIndex;
-      if (m_randomEcmpRouting)
-        {
-          selectIndex = m_rand.GetInteger (0, allRoutes.size ()-1);
-        }
-      else 
-        {
-          selectIndex = 0;
-        }
+      // consistently if ECMP routing is disabled
+      uint32_t selectIndex = SelectRoute (allRoutes, header, p);
       Ipv4RoutingTableEntry* route = allRoutes.at (selectIndex); 
       // create a Ipv4Route object from the selected routing table entry
       rtentry = Create<Ipv4Route> ();
@@ -301,10 +423,18 @@ Ipv4GlobalRouting::GetRoute (uint32_t index) const
   // quiet compiler.
   return 0;
 }
+uint32_t
+Ipv4GlobalRouting::GetRouteWeight (uint32_t index) const
+{
+  NS_LOG_FUNCTION (index);
+  return GetWeight (GetRoute (index));
+}
+
 void 
 Ipv4GlobalRouting::RemoveRoute (uint32_t index)
 {
   NS_LOG_FUNCTION (index);
+  m_weights.erase (GetRoute (index));
   if (index < m_hostRoutes.size ())
     {
       uint32_t tmp = 0;
@@ -380,6 +510,7 @@ Ipv4GlobalRouting::DoDispose (void)
     {
       delete (*l);
     }
+  m_weights.clear ();
 
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -448,7 +579,9 @@ Ipv4GlobalRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<Net
 // See if this is a unicast packet we have a route for.
 //
   NS_LOG_LOGIC ("Unicast destination- looking up");
-  Ptr<Ipv4Route> rtentry = LookupGlobal (header.GetDestination (), oif);
+  // The transport header is not on the packet yet for every protocol:
+  // the locally generated flows are hashed without their ports.
+  Ptr<Ipv4Route> rtentry = LookupGlobal (header, 0, oif);
   if (rtentry)
     {
       sockerr = Socket::ERROR_NOTERROR;
@@ -526,7 +659,7 @@ Ipv4GlobalRouting::RouteInput  (Ptr<const Packet> p, const Ipv4Header &header, P
     }
   // Next, try to find a route
   NS_LOG_LOGIC ("Unicast destination- looking up global route");
-  Ptr<Ipv4Route> rtentry = LookupGlobal (header.GetDestination ());
+  Ptr<Ipv4Route> rtentry = LookupGlobal (header, p);
   if (rtentry != 0)
     {
       NS_LOG_LOGIC ("Found unicast destination- calling unicast callback");
@@ -546,9 +679,7 @@ Ipv4GlobalRouting::NotifyInterfaceUp (uint32_t i)
   NS_LOG_FUNCTION (this << i);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeRoutes ();
     }
 }
 
@@ -558,9 +689,7 @@ Ipv4GlobalRouting::NotifyInterfaceDown (uint32_t i)
   NS_LOG_FUNCTION (this << i);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeRoutes ();
     }
 }
 
@@ -570,9 +699,7 @@ Ipv4GlobalRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress ad
   NS_LOG_FUNCTION (this << interface << address);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeRoutes ();
     }
 }
 
@@ -582,9 +709,7 @@ Ipv4GlobalRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress
   NS_LOG_FUNCTION (this << interface << address);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeRoutes ();
     }
 }
 
@@ -594,6 +719,11 @@ Ipv4GlobalRouting::SetIpv4 (Ptr<Ipv4> ipv4)
   NS_LOG_FUNCTION (this << ipv4);
   NS_ASSERT (m_ipv4 == 0 && ipv4 != 0);
   m_ipv4 = ipv4;
+  Ptr<Node> node = ipv4->GetObject<Node> ();
+  if (node != 0)
+    {
+      m_nodeId = node->GetId ();
+    }
 }
 
 
@@ -21,6 +21,8 @@
 #define IPV4_GLOBAL_ROUTING_H
 
 #include <list>
+#include <map>
+#include <vector>
 #include <stdint.h>
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv4-header.h"
@@ -63,6 +65,19 @@ class Node;
  *
  * This class deals with Ipv4 unicast routes only.
  *
+ * When several routes of equal cost lead to a destination, the first one
+ * is used, unless the attribute RandomEcmpRouting spreads the packets
+ * among them at random, or the attribute FlowEcmpRouting spreads the
+ * flows among them: a hash of the addresses, the protocol and the ports
+ * of a packet (the ports of the TCP and UDP packets which are not
+ * fragments, at forwarding) keeps the packets of a flow on one route and
+ * out of order delivery is avoided.  The hash is seeded by the attribute
+ * EcmpHashSeed and by the id of the node, so that the successive hops of
+ * a path do not split the flows the same way.  With WeightedEcmpRouting,
+ * each route is chosen in proportion to its weight, which the
+ * GlobalRouteManager sets to the number of shortest paths going through
+ * its next hop.
+ *
  * \see Ipv4RoutingProtocol
  * \see GlobalRouteManager
  */
@@ -101,12 +116,14 @@ public:
  * \param nextHop The Ipv4Address of the next hop in the route.
  * \param interface The network interface index used to send packets to the
  * destination.
+ * \param weight The weight of the route among the routes of equal cost.
  *
  * \see Ipv4Address
  */
   void AddHostRouteTo (Ipv4Address dest, 
                        Ipv4Address nextHop, 
-                       uint32_t interface);
+                       uint32_t interface,
+                       uint32_t weight = 1);
 /**
  * \brief Add a host route to the global routing table.
  *
@@ -127,13 +144,15 @@ public:
  * \param nextHop The next hop in the route to the destination network.
  * \param interface The network interface index used to send packets to the
  * destination.
+ * \param weight The weight of the route among the routes of equal cost.
  *
  * \see Ipv4Address
  */
   void AddNetworkRouteTo (Ipv4Address network, 
                           Ipv4Mask networkMask, 
                           Ipv4Address nextHop, 
-                          uint32_t interface);
+                          uint32_t interface,
+                          uint32_t weight = 1);
 
 /**
  * \brief Add a network route to the global routing table.
@@ -157,11 +176,13 @@ public:
  * \param nextHop The next hop Ipv4Address
  * \param interface The network interface index used to send packets to the
  * destination.
+ * \param weight The weight of the route among the routes of equal cost.
  */
   void AddASExternalRouteTo (Ipv4Address network,
                              Ipv4Mask networkMask,
                              Ipv4Address nextHop,
-                             uint32_t interface);
+                             uint32_t interface,
+                             uint32_t weight = 1);
 
 /**
  * \brief Get the number of individual unicast routes that have been added
@@ -211,12 +232,30 @@ public:
  */
   void RemoveRoute (uint32_t i);
 
+/**
+ * \brief Get the weight of a route from the global unicast routing table.
+ *
+ * \param i The index (into the routing table) of the route, as in GetRoute.
+ * \return The weight of the route among the routes of equal cost.
+ *
+ * \see Ipv4GlobalRouting::GetRoute
+ */
+  uint32_t GetRouteWeight (uint32_t i) const;
+
 protected:
   void DoDispose (void);
 
 private:
   /// Set to true if packets are randomly routed among ECMP; set to false for using only one route consistently
   bool m_randomEcmpRouting;
+  /// Set to true if the flows are routed among ECMP by a hash of their addresses, protocol and ports
+  bool m_flowEcmpRouting;
+  /// Set to true if the routes are chosen among ECMP in proportion to their weights
+  bool m_weightedEcmpRouting;
+  /// Seed of the flow hash, before the id of the node is mixed in
+  uint32_t m_ecmpHashSeed;
+  /// Id of the node, mixed in the flow hash
+  uint32_t m_nodeId;
   /// Set to true if this interface should respond to interface events by globallly recomputing routes 
   bool m_respondToInterfaceEvents;
   /// A uniform random number generator for randomly routing packets among ECMP 
@@ -232,11 +271,19 @@ private:
   typedef std::list<Ipv4RoutingTableEntry *>::const_iterator ASExternalRoutesCI;
   typedef std::list<Ipv4RoutingTableEntry *>::iterator ASExternalRoutesI;
 
-  Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0);
+  typedef std::vector<Ipv4RoutingTableEntry *> RouteVec_t;
+  typedef std::map<const Ipv4RoutingTableEntry *, uint32_t> RouteWeights_t;
+
+  Ptr<Ipv4Route> LookupGlobal (const Ipv4Header &header, Ptr<const Packet> p, Ptr<NetDevice> oif = 0);
+  uint32_t SelectRoute (const RouteVec_t &routes, const Ipv4Header &header, Ptr<const Packet> p);
+  uint32_t GetFlowHash (const Ipv4Header &header, Ptr<const Packet> p) const;
+  uint32_t GetWeight (const Ipv4RoutingTableEntry *route) const;
+  void SetWeight (const Ipv4RoutingTableEntry *route, uint32_t weight);
 
   HostRoutes m_hostRoutes;
   NetworkRoutes m_networkRoutes;
   ASExternalRoutes m_ASexternalRoutes; // External routes imported
+  RouteWeights_t m_weights; // Weights of the routes, if other than 1
 
   Ptr<Ipv4> m_ipv4;
 };
@@ -24,6 +24,7 @@
 #include "ipv4-l3-protocol.h"
 #include "arp-l3-protocol.h"
 #include "arp-cache.h"
+#include "ipv4-receive-offload.h"
 #include "ns3/net-device.h"
 #include "ns3/log.h"
 #include "ns3/packet.h"
@@ -47,6 +48,12 @@ Ipv4Interface::GetTypeId (void)
                    MakePointerAccessor (&Ipv4Interface::SetArpCache, 
                                         &Ipv4Interface::GetArpCache),
                    MakePointerChecker<ArpCache> ())
+    .AddAttribute ("ReceiveOffload",
+                   "The receive offload of the packets received on this interface, if any",
+                   PointerValue (0),
+                   MakePointerAccessor (&Ipv4Interface::SetReceiveOffload,
+                                        &Ipv4Interface::GetReceiveOffload),
+                   MakePointerChecker<Ipv4ReceiveOffload> ())
   ;
   ;
   return tid;
@@ -63,7 +70,8 @@ Ipv4Interface::Ipv4Interface ()
     m_metric (1),
     m_node (0), 
     m_device (0),
-    m_cache (0)
+    m_cache (0),
+    m_receiveOffload (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -79,6 +87,11 @@ Ipv4Interface::DoDispose (void)
   NS_LOG_FUNCTION_NOARGS ();
   m_node = 0;
   m_device = 0;
+  if (m_receiveOffload != 0)
+    {
+      m_receiveOffload->Dispose ();
+      m_receiveOffload = 0;
+    }
   Object::DoDispose ();
 }
 
@@ -143,6 +156,19 @@ Ipv4Interface::GetArpCache () const
   return m_cache;
 }
 
+void
+Ipv4Interface::SetReceiveOffload (Ptr<Ipv4ReceiveOffload> offload)
+{
+  NS_LOG_FUNCTION (this << offload);
+  m_receiveOffload = offload;
+}
+
+Ptr<Ipv4ReceiveOffload>
+Ipv4Interface::GetReceiveOffload (void) const
+{
+  return m_receiveOffload;
+}
+
 /**
  * These are IP interface states and may be distinct from 
  * NetDevice states, such as found in real implementations
@@ -34,6 +34,7 @@ class NetDevice;
 class Packet;
 class Node;
 class ArpCache;
+class Ipv4ReceiveOffload;
 
 /**
  * \brief The IPv4 representation of a network interface
@@ -66,6 +67,15 @@ public:
    * \return ARP cache used by this interface
    */
   Ptr<ArpCache> GetArpCache () const;
+  /**
+   * \param offload the receive offload of the packets received on this
+   * interface, 0 for none
+   */
+  void SetReceiveOffload (Ptr<Ipv4ReceiveOffload> offload);
+  /**
+   * \return the receive offload of this interface, or 0 if none
+   */
+  Ptr<Ipv4ReceiveOffload> GetReceiveOffload (void) const;
 
   /**
    * \param metric configured routing metric (cost) of this interface
@@ -167,6 +177,7 @@ private:
   Ptr<Node> m_node;
   Ptr<NetDevice> m_device;
   Ptr<ArpCache> m_cache; 
+  Ptr<Ipv4ReceiveOffload> m_receiveOffload;
 };
 
 } // namespace ns3
@@ -38,6 +38,7 @@
 #include "ipv4-l3-protocol.h"
 #include "icmpv4-l4-protocol.h"
 #include "ipv4-interface.h"
+#include "ipv4-receive-offload.h"
 #include "ipv4-raw-socket-impl.h"
 #include "ipv4-netfilter.h"
 
@@ -64,6 +65,11 @@ Ipv4L3Protocol::GetTypeId (void)
                    TimeValue (Seconds (30)),
                    MakeTimeAccessor (&Ipv4L3Protocol::m_fragmentExpirationTimeout),
                    MakeTimeChecker ())
+    .AddAttribute ("FragmentMemoryLimit",
+                   "The bytes of fragments kept for reassembly, beyond which the oldest packets are dropped.",
+                   UintegerValue (4194304),
+                   MakeUintegerAccessor (&Ipv4L3Protocol::m_fragmentMemoryLimit),
+                   MakeUintegerChecker<uint32_t> ())
     .AddTraceSource ("Tx", "Send ipv4 packet to outgoing interface.",
                      MakeTraceSourceAccessor (&Ipv4L3Protocol::m_txTrace))
     .AddTraceSource ("Rx", "Receive ipv4 packet from incoming interface.",
@@ -218,22 +224,12 @@ Ipv4L3Protocol::DoDispose (void)
   m_node = 0;
   m_routingProtocol = 0;
 
-  for (MapFragments_t::iterator it = m_fragments.begin (); it != m_fragments.end (); it++)
+  if (m_reassembly != 0)
     {
-      it->second = 0;
+      m_reassembly->Dispose ();
+      m_reassembly = 0;
     }
 
-  for (MapFragmentsTimers_t::iterator it = m_fragmentsTimers.begin (); it != m_fragmentsTimers.end (); it++)
-    {
-      if (it->second.IsRunning ())
-        {
-          it->second.Cancel ();
-        }
-    }
-
-  m_fragments.clear ();
-  m_fragmentsTimers.clear ();
-
   Object::DoDispose ();
 }
 
@@ -519,6 +515,27 @@ Ipv4L3Protocol::Receive ( Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t p
       socket->ForwardUp (packet, ipHeader, ipv4Interface);
     }
 
+  // The TCP segments for the node may be coalesced before the routing
+  Ptr<Ipv4ReceiveOffload> offload = ipv4Interface != 0 && ipv4Interface->GetDevice () == device ?
+    ipv4Interface->GetReceiveOffload () : 0;
+  if (offload != 0 && GetInterfaceForAddress (ipHeader.GetDestination ()) >= 0)
+    {
+      if (offload->GetDeliverCallback ().IsNull ())
+        {
+          offload->SetDeliverCallback (MakeCallback (&Ipv4L3Protocol::RouteReceived, this));
+        }
+      if (offload->Receive (packet, ipHeader, device))
+        {
+          return;
+        }
+    }
+  RouteReceived (packet, ipHeader, device);
+}
+
+void
+Ipv4L3Protocol::RouteReceived (Ptr<Packet> packet, const Ipv4Header &ipHeader, Ptr<NetDevice> device)
+{
+  NS_LOG_FUNCTION (this << packet << ipHeader << device);
   NS_ASSERT_MSG (m_routingProtocol != 0, "Need a routing protocol object to process packets");
   if (!m_routingProtocol->RouteInput (packet, ipHeader, device,
                                       MakeCallback (&Ipv4L3Protocol::IpForward, this),
@@ -528,10 +545,38 @@ Ipv4L3Protocol::Receive ( Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t p
                                       ))
     {
       NS_LOG_WARN ("No route found for forwarding packet.  Drop.");
+      int32_t interface = GetInterfaceForDevice (device);
+      Ptr<Ipv4ReceiveOffload> offload = GetDeliveringOffload (packet, interface);
+      if (offload != 0)
+        {
+          const Ipv4ReceiveOffload::SegmentList &segments = offload->GetDeliveredSegments ();
+          for (Ipv4ReceiveOffload::SegmentList::const_iterator i = segments.begin (); i != segments.end (); ++i)
+            {
+              m_dropTrace (i->ipHeader, i->packet, DROP_NO_ROUTE, m_node->GetObject<Ipv4> (), interface);
+            }
+          return;
+        }
       m_dropTrace (ipHeader, packet, DROP_NO_ROUTE, m_node->GetObject<Ipv4> (), interface);
     }
 }
 
+Ptr<Ipv4ReceiveOffload>
+Ipv4L3Protocol::GetDeliveringOffload (Ptr<const Packet> packet, int32_t interface) const
+{
+  if (interface < 0)
+    {
+      return 0;
+    }
+  Ptr<Ipv4ReceiveOffload> offload = GetInterface (interface)->GetReceiveOffload ();
+  ReceiveOffloadTag tag;
+  if (offload == 0 || !packet->PeekPacketTag (tag)
+      || offload->GetDeliveredSegments ().size () != tag.GetSegments ())
+    {
+      return 0;
+    }
+  return offload;
+}
+
 Ptr<Icmpv4L4Protocol>
 Ipv4L3Protocol::GetIcmp (void) const
 {
@@ -1017,7 +1062,21 @@ Ipv4L3Protocol::LocalDeliver (Ptr<const Packet> packet, Ipv4Header const&ip, uin
       NS_LOG_LOGIC ("Got last fragment, Packet is complete " << *p );
     }
 
-  m_localDeliverTrace (ip, packet, iif);
+  // The segments coalesced by the receive offload are traced one by one,
+  // with their own tags and UIDs
+  Ptr<Ipv4ReceiveOffload> offload = GetDeliveringOffload (packet, iif);
+  if (offload != 0)
+    {
+      const Ipv4ReceiveOffload::SegmentList &segments = offload->GetDeliveredSegments ();
+      for (Ipv4ReceiveOffload::SegmentList::const_iterator i = segments.begin (); i != segments.end (); ++i)
+        {
+          m_localDeliverTrace (i->ipHeader, i->packet, iif);
+        }
+    }
+  else
+    {
+      m_localDeliverTrace (ip, packet, iif);
+    }
 
   Ptr<IpL4Protocol> protocol = GetProtocol (ip.GetProtocol ());
   if (protocol != 0)
@@ -1369,192 +1428,48 @@ Ipv4L3Protocol::ProcessFragment (Ptr<Packet>& packet, Ipv4Header& ipHeader, uint
 {
   NS_LOG_FUNCTION (this << packet << " " << ipHeader << " " << iif);
 
-  uint64_t addressCombination = uint64_t (ipHeader.GetSource ().Get ()) << 32 & uint64_t (ipHeader.GetDestination ().Get ());
-  uint32_t idProto = uint32_t (ipHeader.GetIdentification ()) << 16 & uint32_t (ipHeader.GetProtocol ());
-  std::pair<uint64_t, uint32_t> key;
-  bool ret = false;
-  Ptr<Packet> p = packet->Copy ();
-
-  key.first = addressCombination;
-  key.second = idProto;
-
-  Ptr<Fragments> fragments;
-
-  MapFragments_t::iterator it = m_fragments.find (key);
-  if (it == m_fragments.end ())
-    {
-      fragments = Create<Fragments> ();
-      m_fragments.insert (std::make_pair (key, fragments));
-      m_fragmentsTimers[key] = Simulator::Schedule (m_fragmentExpirationTimeout,
-                                                    &Ipv4L3Protocol::HandleFragmentsTimeout, this,
-                                                    key, ipHeader, iif);
-    }
-  else
-    {
-      fragments = it->second;
-    }
-
-  NS_LOG_LOGIC ("Adding fragment - Size: " << packet->GetSize ( ) << " - Offset: " << (ipHeader.GetFragmentOffset ()) );
-
-  fragments->AddFragment (p, ipHeader.GetFragmentOffset (), !ipHeader.IsLastFragment () );
-
-  if ( fragments->IsEntire () )
-    {
-      packet = fragments->GetPacket ();
-      fragments = 0;
-      m_fragments.erase (key);
-      if (m_fragmentsTimers[key].IsRunning ())
-        {
-          NS_LOG_LOGIC ("Stopping WaitFragmentsTimer at " << Simulator::Now ().GetSeconds () << " due to complete packet");
-          m_fragmentsTimers[key].Cancel ();
-        }
-      m_fragmentsTimers.erase (key);
-      ret = true;
-    }
-
-  return ret;
-}
-
-Ipv4L3Protocol::Fragments::Fragments ()
-  : m_moreFragment (0)
-{
-}
-
-Ipv4L3Protocol::Fragments::~Fragments ()
-{
-}
-
-void
-Ipv4L3Protocol::Fragments::AddFragment (Ptr<Packet> fragment, uint16_t fragmentOffset, bool moreFragment)
-{
-  NS_LOG_FUNCTION (this << fragment << " " << fragmentOffset << " " << moreFragment);
-
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::iterator it;
-
-  for (it = m_fragments.begin (); it != m_fragments.end (); it++)
-    {
-      if (it->second > fragmentOffset)
-        {
-          break;
-        }
-    }
-
-  if (it == m_fragments.end ())
-    {
-      m_moreFragment = moreFragment;
-    }
-
-  m_fragments.insert (it, std::make_pair<Ptr<Packet>, uint16_t> (fragment, fragmentOffset));
-}
-
-bool
-Ipv4L3Protocol::Fragments::IsEntire () const
-{
-  NS_LOG_FUNCTION (this);
-
-  bool ret = !m_moreFragment && m_fragments.size () > 0;
-
-  if (ret)
+  if (m_reassembly == 0)
     {
-      uint16_t lastEndOffset = 0;
-
-      for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_fragments.begin (); it != m_fragments.end (); it++)
-        {
-          // overlapping fragments do exist
-          NS_LOG_LOGIC ("Checking overlaps " << lastEndOffset << " - " << it->second );
-
-          if (lastEndOffset < it->second)
-            {
-              ret = false;
-              break;
-            }
-          // fragments might overlap in strange ways
-          uint16_t fragmentEnd = it->first->GetSize () + it->second;
-          lastEndOffset = std::max ( lastEndOffset, fragmentEnd );
-        }
+      m_reassembly = CreateObject<IpReassembly> ();
+      m_reassembly->SetDropCallback (MakeCallback (&Ipv4L3Protocol::HandleFragmentsDrop, this));
     }
+  m_reassembly->SetTimeout (m_fragmentExpirationTimeout);
+  m_reassembly->SetMaxMemory (m_fragmentMemoryLimit);
 
-  return ret;
-}
-
-Ptr<Packet>
-Ipv4L3Protocol::Fragments::GetPacket () const
-{
-  NS_LOG_FUNCTION (this);
+  IpReassembly::Key key;
+  key.source = ipHeader.GetSource ();
+  key.destination = ipHeader.GetDestination ();
+  key.identification = ipHeader.GetIdentification ();
+  key.protocol = ipHeader.GetProtocol ();
 
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_fragments.begin ();
+  Ptr<Packet> p = packet->Copy ();
+  Ptr<Packet> header = Create<Packet> ();
+  header->AddHeader (ipHeader);
 
-  Ptr<Packet> p = Create<Packet> ();
-  uint16_t lastEndOffset = 0;
+  NS_LOG_LOGIC ("Adding fragment - Size: " << packet->GetSize ( ) << " - Offset: " << (ipHeader.GetFragmentOffset ()) );
 
-  for ( it = m_fragments.begin (); it != m_fragments.end (); it++)
+  if (m_reassembly->AddFragment (key, p, ipHeader.GetFragmentOffset (), !ipHeader.IsLastFragment (), header, iif))
     {
-      if ( lastEndOffset > it->second )
-        {
-          // The fragments are overlapping.
-          // We do not overwrite the "old" with the "new" because we do not know when each arrived.
-          // This is different from what Linux does.
-          // It is not possible to emulate a fragmentation attack.
-          uint32_t newStart = lastEndOffset - it->second;
-          if ( it->first->GetSize () > newStart )
-            {
-              uint32_t newSize = it->first->GetSize () - newStart;
-              Ptr<Packet> tempFragment = it->first->CreateFragment (newStart, newSize);
-              p->AddAtEnd (tempFragment);
-            }
-        }
-      else
-        {
-          NS_LOG_LOGIC ("Adding: " << *(it->first) );
-          p->AddAtEnd (it->first);
-        }
-      lastEndOffset = p->GetSize ();
+      packet = p;
+      return true;
     }
-
-  return p;
+  return false;
 }
 
-Ptr<Packet>
-Ipv4L3Protocol::Fragments::GetPartialPacket () const
+void
+Ipv4L3Protocol::HandleFragmentsDrop (Ptr<Packet> header, Ptr<Packet> packet, uint32_t iif, IpReassembly::DropReason reason)
 {
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_fragments.begin ();
-
-  Ptr<Packet> p = Create<Packet> ();
-  uint16_t lastEndOffset = 0;
+  NS_LOG_FUNCTION (this << header << packet << iif << reason);
 
-  if ( m_fragments.begin ()->second > 0 )
-    {
-      return p;
-    }
+  Ipv4Header ipHeader;
+  header->PeekHeader (ipHeader);
 
-  for ( it = m_fragments.begin (); it != m_fragments.end (); it++)
+  if (reason == IpReassembly::DROP_MEMORY)
     {
-      if ( lastEndOffset > it->second )
-        {
-          uint32_t newStart = lastEndOffset - it->second;
-          uint32_t newSize = it->first->GetSize () - newStart;
-          Ptr<Packet> tempFragment = it->first->CreateFragment (newStart, newSize);
-          p->AddAtEnd (tempFragment);
-        }
-      else if ( lastEndOffset == it->second )
-        {
-          NS_LOG_LOGIC ("Adding: " << *(it->first) );
-          p->AddAtEnd (it->first);
-        }
-      lastEndOffset = p->GetSize ();
+      m_dropTrace (ipHeader, packet, DROP_FRAGMENT_MEMORY, m_node->GetObject<Ipv4> (), iif);
+      return;
     }
 
-  return p;
-}
-
-void
-Ipv4L3Protocol::HandleFragmentsTimeout (std::pair<uint64_t, uint32_t> key, Ipv4Header & ipHeader, uint32_t iif)
-{
-  NS_LOG_FUNCTION (this);
-
-  MapFragments_t::iterator it = m_fragments.find (key);
-  Ptr<Packet> packet = it->second->GetPartialPacket ();
-
   // if we have at least 8 bytes, we can send an ICMP.
   if ( packet->GetSize () > 8 )
     {
@@ -1562,12 +1477,6 @@ Ipv4L3Protocol::HandleFragmentsTimeout (std::pair<uint64_t, uint32_t> key, Ipv4H
       icmp->SendTimeExceededTtl (ipHeader, packet);
     }
   m_dropTrace (ipHeader, packet, DROP_FRAGMENT_TIMEOUT, m_node->GetObject<Ipv4> (), iif);
-
-  // clear the buffers
-  it->second = 0;
-
-  m_fragments.erase (key);
-  m_fragmentsTimers.erase (key);
 }
 
 } // namespace ns3
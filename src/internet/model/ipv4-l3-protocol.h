@@ -34,6 +34,7 @@
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/nstime.h"
 #include "ns3/simulator.h"
+#include "ns3/ip-reassembly.h"
 
 namespace ns3 {
 
@@ -50,6 +51,7 @@ class Ipv4RawSocketImpl;
 class IpL4Protocol;
 class Icmpv4L4Protocol;
 class Ipv4Netfilter;
+class Ipv4ReceiveOffload;
 
 
 /**
@@ -95,7 +97,8 @@ public:
     DROP_BAD_CHECKSUM,   /**< Bad checksum */
     DROP_INTERFACE_DOWN,   /**< Interface is down so can not send packet */
     DROP_ROUTE_ERROR,   /**< Route error */
-    DROP_FRAGMENT_TIMEOUT /**< Fragment timeout exceeded */
+    DROP_FRAGMENT_TIMEOUT, /**< Fragment timeout exceeded */
+    DROP_FRAGMENT_MEMORY /**< Fragments evicted by the reassembly memory limit */
   };
 
   void SetNode (Ptr<Node> node);
@@ -257,6 +260,16 @@ private:
                       const Ipv4Header &header);
 
   void LocalDeliver (Ptr<const Packet> p, Ipv4Header const&ip, uint32_t iif);
+  /**
+   * \brief Route a packet received, after the receive offload of its
+   * interface if any.
+   */
+  void RouteReceived (Ptr<Packet> packet, const Ipv4Header &ipHeader, Ptr<NetDevice> device);
+  /**
+   * \returns the receive offload of the interface if it is delivering the
+   * packet, coalesced from several segments, or 0
+   */
+  Ptr<Ipv4ReceiveOffload> GetDeliveringOffload (Ptr<const Packet> packet, int32_t interface) const;
   void RouteInputError (Ptr<const Packet> p, const Ipv4Header & ipHeader, Socket::SocketErrno sockErrno);
 
   uint32_t AddIpv4Interface (Ptr<Ipv4Interface> interface);
@@ -287,12 +300,13 @@ private:
   bool ProcessFragment (Ptr<Packet>& packet, Ipv4Header & ipHeader, uint32_t iif);
 
   /**
-   * \brief Process the timeout for packet fragments
-   * \param key representing the packet fragments
-   * \param ipHeader the IP header of the original packet
+   * \brief Process the drop of a datagram before its reassembly
+   * \param header the packet holding the IP header of the datagram
+   * \param packet the data received from the start of the datagram
    * \param iif Input Interface
+   * \param reason timeout or memory limit
    */
-  void HandleFragmentsTimeout ( std::pair<uint64_t, uint32_t> key, Ipv4Header & ipHeader, uint32_t iif);
+  void HandleFragmentsDrop (Ptr<Packet> header, Ptr<Packet> packet, uint32_t iif, IpReassembly::DropReason reason);
 
   typedef std::vector<Ptr<Ipv4Interface> > Ipv4InterfaceList;
   typedef std::list<Ptr<Ipv4RawSocketImpl> > SocketList;
@@ -322,70 +336,11 @@ private:
   SocketList m_sockets;
 
   /**
-   * \class Fragments
-   * \brief A Set of Fragment belonging to the same packet (src, dst, identification and proto)
-   */
-  class Fragments : public SimpleRefCount<Fragments>
-  {
-public:
-    /**
-     * \brief Constructor.
-     */
-    Fragments ();
-
-    /**
-     * \brief Destructor.
-     */
-    ~Fragments ();
-
-    /**
-     * \brief Add a fragment.
-     * \param fragment the fragment
-     * \param fragmentOffset the offset of the fragment
-     * \param moreFragment the bit "More Fragment"
-     */
-    void AddFragment (Ptr<Packet> fragment, uint16_t fragmentOffset, bool moreFragment);
-
-    /**
-     * \brief If all fragments have been added.
-     * \returns true if the packet is entire
-     */
-    bool IsEntire () const;
-
-    /**
-     * \brief Get the entire packet.
-     * \return the entire packet
-     */
-    Ptr<Packet> GetPacket () const;
-
-    /**
-     * \brief Get the complete part of the packet.
-     * \return the part we have comeplete
-     */
-    Ptr<Packet> GetPartialPacket () const;
-
-private:
-    /**
-     * \brief True if other fragments will be sent.
-     */
-    bool m_moreFragment;
-
-    /**
-     * \brief The current fragments.
-     */
-    std::list<std::pair<Ptr<Packet>, uint16_t> > m_fragments;
-
-  };
-
-  typedef std::map< std::pair<uint64_t, uint32_t>, Ptr<Fragments> > MapFragments_t;
-  typedef std::map< std::pair<uint64_t, uint32_t>, EventId > MapFragmentsTimers_t;
-
-  /**
-   * \brief The hash of fragmented packets.
+   * \brief The fragmented packets waiting for reassembly.
    */
-  MapFragments_t       m_fragments;
+  Ptr<IpReassembly>    m_reassembly;
   Time                 m_fragmentExpirationTimeout;
-  MapFragmentsTimers_t m_fragmentsTimers;
+  uint32_t             m_fragmentMemoryLimit;
 
 };
 
@@ -0,0 +1,377 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/packet.h"
+#include "ns3/node.h"
+#include "ns3/net-device.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/log.h"
+#include "ipv4-receive-offload.h"
+#include "tcp-l4-protocol.h"
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4ReceiveOffload");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (ReceiveOffloadTag);
+
+ReceiveOffloadTag::ReceiveOffloadTag ()
+  : m_segments (0),
+    m_segmentSize (0)
+{
+}
+
+void
+ReceiveOffloadTag::SetSegments (uint16_t segments)
+{
+  m_segments = segments;
+}
+
+uint16_t
+ReceiveOffloadTag::GetSegments (void) const
+{
+  return m_segments;
+}
+
+void
+ReceiveOffloadTag::SetSegmentSize (uint16_t size)
+{
+  m_segmentSize = size;
+}
+
+uint16_t
+ReceiveOffloadTag::GetSegmentSize (void) const
+{
+  return m_segmentSize;
+}
+
+TypeId
+ReceiveOffloadTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ReceiveOffloadTag")
+    .SetParent<Tag> ()
+    .AddConstructor<ReceiveOffloadTag> ()
+  ;
+  return tid;
+}
+
+TypeId
+ReceiveOffloadTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+ReceiveOffloadTag::GetSerializedSize (void) const
+{
+  return 4;
+}
+
+void
+ReceiveOffloadTag::Serialize (TagBuffer i) const
+{
+  i.WriteU16 (m_segments);
+  i.WriteU16 (m_segmentSize);
+}
+
+void
+ReceiveOffloadTag::Deserialize (TagBuffer i)
+{
+  m_segments = i.ReadU16 ();
+  m_segmentSize = i.ReadU16 ();
+}
+
+void
+ReceiveOffloadTag::Print (std::ostream &os) const
+{
+  os << "segments=" << m_segments << " segmentSize=" << m_segmentSize;
+}
+
+NS_OBJECT_ENSURE_REGISTERED (Ipv4ReceiveOffload);
+
+TypeId
+Ipv4ReceiveOffload::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::Ipv4ReceiveOffload")
+    .SetParent<Object> ()
+    .AddConstructor<Ipv4ReceiveOffload> ()
+    .AddAttribute ("FlushTimeout",
+                   "The time the first segment of a flow may be held for others to be coalesced with it. "
+                   "Zero coalesces only the segments which arrive at the same simulated time, and "
+                   "delays none of them; a positive timeout delays the segments, and so the "
+                   "acknowledgments and the dynamics of TCP.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&Ipv4ReceiveOffload::m_flushTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxSize",
+                   "The maximum size of the data of a coalesced segment, in bytes.",
+                   UintegerValue (64000),
+                   MakeUintegerAccessor (&Ipv4ReceiveOffload::m_maxSize),
+                   MakeUintegerChecker<uint32_t> (0, 65455))
+    .AddAttribute ("MaxFlows",
+                   "The maximum number of flows held; the oldest one is flushed for a new one.",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&Ipv4ReceiveOffload::m_maxFlows),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+  return tid;
+}
+
+Ipv4ReceiveOffload::Ipv4ReceiveOffload ()
+  : m_lastArrival (Seconds (-1)),
+    m_nSegments (0),
+    m_nDelivered (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Ipv4ReceiveOffload::~Ipv4ReceiveOffload ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+Ipv4ReceiveOffload::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_flushEvent.Cancel ();
+  m_flows.clear ();
+  m_delivered.clear ();
+  m_deliver = MakeNullCallback<void, Ptr<Packet>, const Ipv4Header &, Ptr<NetDevice> > ();
+  Object::DoDispose ();
+}
+
+void
+Ipv4ReceiveOffload::SetDeliverCallback (DeliverCallback cb)
+{
+  m_deliver = cb;
+}
+
+Ipv4ReceiveOffload::DeliverCallback
+Ipv4ReceiveOffload::GetDeliverCallback (void) const
+{
+  return m_deliver;
+}
+
+const Ipv4ReceiveOffload::SegmentList &
+Ipv4ReceiveOffload::GetDeliveredSegments (void) const
+{
+  return m_delivered;
+}
+
+uint32_t
+Ipv4ReceiveOffload::GetNSegments (void) const
+{
+  return m_nSegments;
+}
+
+uint32_t
+Ipv4ReceiveOffload::GetNDelivered (void) const
+{
+  return m_nDelivered;
+}
+
+int32_t
+Ipv4ReceiveOffload::FindFlow (const Ipv4Header &ipHeader, const TcpHeader &tcpHeader) const
+{
+  for (uint32_t i = 0; i < m_flows.size (); i++)
+    {
+      const Flow &flow = m_flows[i];
+      if (flow.tcpHeader.GetSourcePort () == tcpHeader.GetSourcePort ()
+          && flow.tcpHeader.GetDestinationPort () == tcpHeader.GetDestinationPort ()
+          && flow.ipHeader.GetSource () == ipHeader.GetSource ()
+          && flow.ipHeader.GetDestination () == ipHeader.GetDestination ())
+        {
+          return i;
+        }
+    }
+  return -1;
+}
+
+// The segment follows the ones held and has the same headers but for the
+// lengths and the sequence number, so that the TCP socket can process the
+// segments one by one from the coalesced one.
+bool
+Ipv4ReceiveOffload::CanCoalesce (const Flow &flow, const Ipv4Header &ipHeader, const TcpHeader &tcpHeader,
+                                 uint32_t size) const
+{
+  return tcpHeader.GetSequenceNumber () == flow.nextSeq
+         && size <= flow.segmentSize
+         && flow.size + size <= m_maxSize
+         && tcpHeader.GetAckNumber () == flow.tcpHeader.GetAckNumber ()
+         && tcpHeader.GetWindowSize () == flow.tcpHeader.GetWindowSize ()
+         && tcpHeader.GetLength () == flow.tcpHeader.GetLength ()
+         && ipHeader.GetTos () == flow.ipHeader.GetTos ()
+         && ipHeader.GetTtl () == flow.ipHeader.GetTtl ();
+}
+
+bool
+Ipv4ReceiveOffload::Receive (Ptr<Packet> packet, const Ipv4Header &ipHeader, Ptr<NetDevice> device)
+{
+  NS_LOG_FUNCTION (this << packet << ipHeader);
+  NS_ASSERT (!m_deliver.IsNull ());
+
+  // Without timeout, only a burst of packets arriving at once can be
+  // coalesced: the first packet of an instant is not held, so that the
+  // links which deliver one packet at a time, as the serial links, do
+  // not pay for the offload.
+  bool burst = Simulator::Now () == m_lastArrival;
+  m_lastArrival = Simulator::Now ();
+  if (m_flushTimeout.IsZero () && !burst && m_flows.empty ())
+    {
+      return false;
+    }
+
+  if (ipHeader.GetProtocol () != TcpL4Protocol::PROT_NUMBER
+      || !ipHeader.IsLastFragment () || ipHeader.GetFragmentOffset () != 0)
+    {
+      return false;
+    }
+
+  // The data of a segment with a bad checksum must not be coalesced, the
+  // checksum of the coalesced segment would hide it.
+  TcpHeader tcpHeader;
+  if (Node::ChecksumEnabled ())
+    {
+      tcpHeader.EnableChecksums ();
+      tcpHeader.InitializeChecksum (ipHeader.GetSource (), ipHeader.GetDestination (), TcpL4Protocol::PROT_NUMBER);
+    }
+  packet->PeekHeader (tcpHeader);
+  uint32_t size = packet->GetSize () - tcpHeader.GetLength () * 4;
+  bool candidate = size > 0
+    && tcpHeader.IsChecksumOk ()
+    && tcpHeader.GetFlags () == TcpHeader::ACK
+    && tcpHeader.GetSackList ().empty ()
+    && !tcpHeader.HasWindowScale ()
+    && !tcpHeader.IsSackPermitted ();
+
+  Segment segment;
+  segment.packet = packet;
+  segment.ipHeader = ipHeader;
+  int32_t i = FindFlow (ipHeader, tcpHeader);
+  if (i >= 0)
+    {
+      Flow &flow = m_flows[i];
+      if (candidate && CanCoalesce (flow, ipHeader, tcpHeader, size))
+        {
+          flow.segments.push_back (segment);
+          flow.size += size;
+          flow.nextSeq += size;
+          m_nSegments++;
+          NS_LOG_LOGIC ("Segment " << tcpHeader.GetSequenceNumber () << " coalesced, " <<
+                        flow.segments.size () << " segments held");
+          // Nothing can follow a shorter segment, or go beyond the limit
+          if (size < flow.segmentSize || flow.size + flow.segmentSize > m_maxSize)
+            {
+              FlushFlow (i);
+            }
+          return true;
+        }
+      // Deliver the segments held first, to keep the flow in order
+      FlushFlow (i);
+    }
+  if (!candidate)
+    {
+      return false;
+    }
+
+  if (m_flows.size () >= m_maxFlows)
+    {
+      FlushFlow (0);
+    }
+  Flow flow;
+  flow.ipHeader = ipHeader;
+  flow.tcpHeader = tcpHeader;
+  flow.segments.push_back (segment);
+  flow.device = device;
+  flow.segmentSize = size;
+  flow.size = size;
+  flow.nextSeq = tcpHeader.GetSequenceNumber () + size;
+  m_flows.push_back (flow);
+  m_nSegments++;
+  if (!m_flushEvent.IsRunning ())
+    {
+      m_flushEvent = Simulator::Schedule (m_flushTimeout, &Ipv4ReceiveOffload::Flush, this);
+    }
+  return true;
+}
+
+void
+Ipv4ReceiveOffload::FlushFlow (uint32_t i)
+{
+  Flow flow = m_flows[i];
+  m_flows.erase (m_flows.begin () + i);
+  Deliver (flow);
+}
+
+void
+Ipv4ReceiveOffload::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_flushEvent.Cancel ();
+  // The delivery may bring new segments, they wait for the next flush
+  std::vector<Flow> flows;
+  flows.swap (m_flows);
+  for (std::vector<Flow>::iterator i = flows.begin (); i != flows.end (); ++i)
+    {
+      Deliver (*i);
+    }
+  if (!m_flows.empty () && !m_flushEvent.IsRunning ())
+    {
+      m_flushEvent = Simulator::Schedule (m_flushTimeout, &Ipv4ReceiveOffload::Flush, this);
+    }
+}
+
+void
+Ipv4ReceiveOffload::Deliver (Flow &flow)
+{
+  NS_LOG_FUNCTION (this << flow.segments.size ());
+  m_nDelivered++;
+  if (flow.segments.size () == 1)
+    {
+      m_deliver (flow.segments.front ().packet, flow.ipHeader, flow.device);
+      return;
+    }
+
+  // The first segment keeps its tags; the TCP header gets a new checksum,
+  // if enabled
+  Ptr<Packet> p = flow.segments.front ().packet->Copy ();
+  TcpHeader tcpHeader;
+  p->RemoveHeader (tcpHeader);
+  for (SegmentList::const_iterator i = flow.segments.begin () + 1; i != flow.segments.end (); ++i)
+    {
+      Ptr<Packet> data = i->packet->Copy ();
+      data->RemoveHeader (tcpHeader);
+      p->AddAtEnd (data);
+    }
+  p->AddHeader (flow.tcpHeader);
+  ReceiveOffloadTag tag;
+  tag.SetSegments (flow.segments.size ());
+  tag.SetSegmentSize (flow.segmentSize);
+  p->AddPacketTag (tag);
+  Ipv4Header ipHeader = flow.ipHeader;
+  ipHeader.SetPayloadSize (p->GetSize ());
+  // The segments are exposed to the traces of the delivery, which may
+  // bring new segments and deliver other flows in turn
+  SegmentList delivered;
+  delivered.swap (m_delivered);
+  m_delivered.swap (flow.segments);
+  m_deliver (p, ipHeader, flow.device);
+  m_delivered.swap (delivered);
+}
+
+} // namespace ns3
@@ -0,0 +1,224 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_RECEIVE_OFFLOAD_H
+#define IPV4_RECEIVE_OFFLOAD_H
+
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/tag.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/callback.h"
+#include "ns3/ipv4-header.h"
+#include "tcp-header.h"
+
+namespace ns3 {
+
+class Packet;
+class NetDevice;
+
+/**
+ * \ingroup internet
+ *
+ * \brief Marks a TCP segment coalesced by an Ipv4ReceiveOffload.
+ *
+ * The segments all had the size given here, except the last one which may
+ * be shorter, and the same header but for the sequence number.
+ */
+class ReceiveOffloadTag : public Tag
+{
+public:
+  ReceiveOffloadTag ();
+
+  /**
+   * \param segments the number of segments coalesced
+   */
+  void SetSegments (uint16_t segments);
+  /**
+   * \returns the number of segments coalesced
+   */
+  uint16_t GetSegments (void) const;
+  /**
+   * \param size the size of the data of the segments
+   */
+  void SetSegmentSize (uint16_t size);
+  /**
+   * \returns the size of the data of the segments, but the last one
+   */
+  uint16_t GetSegmentSize (void) const;
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer i) const;
+  virtual void Deserialize (TagBuffer i);
+  virtual void Print (std::ostream &os) const;
+
+private:
+  uint16_t m_segments;
+  uint16_t m_segmentSize;
+};
+
+/**
+ * \ingroup internet
+ *
+ * \brief Receive offload of an Ipv4Interface: coalesces the TCP segments
+ * received for the node (as the GRO of Linux).
+ *
+ * The in order segments of a flow, with the same IP and TCP headers but
+ * for the lengths and the sequence number, and only the ACK flag, are
+ * held and their data is put together into one segment, marked by a
+ * ReceiveOffloadTag.  A flow is flushed when a segment cannot be
+ * coalesced with it: a shorter segment (after being added), a segment out
+ * of order, without data or with other flags, or beyond MaxSize bytes.
+ * The other packets are not held.
+ *
+ * The layers above see the coalesced segment as one packet, which holds
+ * the packet tags and the UID of the first segment only.  Ipv4L3Protocol
+ * fires its LocalDeliver trace, and its Drop trace when the segment has
+ * no route, for each of the segments as received (GetDeliveredSegments),
+ * so that the probes which follow the packets by their tags or UIDs, as
+ * the FlowMonitor, account for all of them.  The netfilter LOCAL_IN hook
+ * and the demultiplexing see the coalesced segment only, and the packets
+ * which TcpSocketBase processes for the segments following the first one
+ * are fragments of it, without their packet tags.
+ *
+ * When FlushTimeout is zero (the default), only the packets which arrive
+ * at the same simulated time, as the windows sent through a SimpleChannel,
+ * are coalesced: the segments are flushed at the end of that time, and
+ * the first packet of an instant is never held.  The coalesced segment
+ * goes once through the routing, the local delivery and the
+ * demultiplexing of TCP, then TcpSocketBase processes the segments one by
+ * one, so that its acknowledgments are the ones it would have sent for
+ * the segments received separately.  On a link which delivers one packet
+ * at a time, as a point-to-point or CSMA link, nothing is coalesced and
+ * the offload has no effect.
+ *
+ * A positive FlushTimeout holds the first segment of a flow for up to
+ * that time, and coalesces the segments of a serial link too, but the
+ * segments are then processed late: the acknowledgments are sent later,
+ * the RTT samples of the sender grow, and the dynamics and goodput of TCP
+ * change.  It is only meant for simulations where the cost of the
+ * reception matters more than these changes.
+ *
+ * An Ipv4ReceiveOffload serves a single interface:
+ * \code
+ *   ipv4->GetInterface (1)->SetReceiveOffload (CreateObject<Ipv4ReceiveOffload> ());
+ * \endcode
+ */
+class Ipv4ReceiveOffload : public Object
+{
+public:
+  /**
+   * \brief Callback to go on with the processing of a packet, without its
+   * IP header, received on a device.
+   */
+  typedef Callback<void, Ptr<Packet>, const Ipv4Header &, Ptr<NetDevice> > DeliverCallback;
+
+  /**
+   * \brief A segment as received, with its TCP header.
+   */
+  struct Segment
+  {
+    Ptr<Packet> packet;          //< Segment, with its TCP header
+    Ipv4Header ipHeader;         //< IP header of the segment
+  };
+  typedef std::vector<Segment> SegmentList;
+
+  static TypeId GetTypeId (void);
+  Ipv4ReceiveOffload ();
+  virtual ~Ipv4ReceiveOffload ();
+
+  /**
+   * \param cb the callback of the packets flushed
+   */
+  void SetDeliverCallback (DeliverCallback cb);
+  /**
+   * \returns the callback of the packets flushed
+   */
+  DeliverCallback GetDeliverCallback (void) const;
+
+  /**
+   * \brief Receive a packet for the node.
+   *
+   * \param packet the packet, without its IP header
+   * \param ipHeader its IP header
+   * \param device the device which received it
+   * \returns false if the packet is to be processed now by the caller, true
+   * if it was taken
+   */
+  bool Receive (Ptr<Packet> packet, const Ipv4Header &ipHeader, Ptr<NetDevice> device);
+
+  /**
+   * \brief Deliver all the segments held.
+   */
+  void Flush (void);
+
+  /**
+   * \returns the segments of the coalesced packet being delivered.  Only
+   * valid while the deliver callback runs, empty otherwise.
+   */
+  const SegmentList & GetDeliveredSegments (void) const;
+
+  /**
+   * \returns the number of segments held by the offload
+   */
+  uint32_t GetNSegments (void) const;
+  /**
+   * \returns the number of packets delivered for them
+   */
+  uint32_t GetNDelivered (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief The segments held for a flow.
+   */
+  struct Flow
+  {
+    Ipv4Header ipHeader;         //< IP header of the first segment
+    TcpHeader tcpHeader;         //< TCP header of the first segment
+    SegmentList segments;        //< Segments as received, in order
+    Ptr<NetDevice> device;       //< Device which received them
+    uint16_t segmentSize;        //< Size of the data of the first segment
+    uint32_t size;               //< Size of the data of all the segments
+    SequenceNumber32 nextSeq;    //< Sequence number of the next segment
+  };
+
+  int32_t FindFlow (const Ipv4Header &ipHeader, const TcpHeader &tcpHeader) const;
+  bool CanCoalesce (const Flow &flow, const Ipv4Header &ipHeader, const TcpHeader &tcpHeader, uint32_t size) const;
+  void FlushFlow (uint32_t i);
+  void Deliver (Flow &flow);
+
+  Time m_flushTimeout;          //< Time the segments may be held
+  Time m_lastArrival;           //< Time of the last packet received
+  uint32_t m_maxSize;           //< Limit on the data of a coalesced segment
+  uint32_t m_maxFlows;          //< Limit on the flows held
+  std::vector<Flow> m_flows;    //< Flows held, oldest first
+  SegmentList m_delivered;      //< Segments of the packet being delivered
+  EventId m_flushEvent;         //< Flush of all the flows
+  DeliverCallback m_deliver;
+  uint32_t m_nSegments;
+  uint32_t m_nDelivered;
+};
+
+} // namespace ns3
+
+#endif /* IPV4_RECEIVE_OFFLOAD_H */
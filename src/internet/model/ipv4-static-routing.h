@@ -31,6 +31,7 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/lpm-trie.h"
 
 namespace ns3 {
 
@@ -62,6 +63,10 @@ class Node;
  * Ipv4RoutingProtocol that defines the interface methods that a routing 
  * protocol must support.
  *
+ * The network routes are indexed by a LpmTrie, so that the lookups of
+ * the routes without a requested output device take a time independent
+ * of the size of the table.
+ *
  * \see Ipv4RoutingProtocol
  * \see Ipv4ListRouting
  * \see Ipv4ListRouting::AddRoutingProtocol
@@ -383,6 +388,16 @@ private:
   typedef std::list<Ipv4MulticastRoutingTableEntry *>::const_iterator MulticastRoutesCI;
   typedef std::list<Ipv4MulticastRoutingTableEntry *>::iterator MulticastRoutesI;
 
+  /**
+   * Append a route to m_networkRoutes and insert it in m_lpm.
+   */
+  void AddNetworkRoute (Ipv4RoutingTableEntry *route, uint32_t metric);
+  /**
+   * Remove a route from m_lpm and m_networkRoutes, and delete it.
+   * \returns the iterator following i
+   */
+  NetworkRoutesI RemoveNetworkRoute (NetworkRoutesI i);
+
   Ptr<Ipv4Route> LookupStatic (Ipv4Address dest, Ptr<NetDevice> oif = 0);
   Ptr<Ipv4MulticastRoute> LookupStatic (Ipv4Address origin, Ipv4Address group,
                                         uint32_t interface);
@@ -390,6 +405,8 @@ private:
   Ipv4Address SourceAddressSelection (uint32_t interface, Ipv4Address dest);
 
   NetworkRoutes m_networkRoutes;
+  /// the routes of m_networkRoutes, indexed by their networks
+  LpmTrie<4, Ipv4RoutingTableEntry> m_lpm;
   MulticastRoutes m_multicastRoutes;
 
   Ptr<Ipv4> m_ipv4;
@@ -23,6 +23,7 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
 #include "ns3/ipv6-address.h"
 #include "ipv6-interface.h"
 
@@ -33,6 +34,10 @@ class Ipv6EndPoint;
 /**
  * \class Ipv6EndPointDemux
  * \brief Demultiplexor for end points.
+ *
+ * The end points are indexed by their local port and peer, so that a
+ * lookup only examines those connected to the source of the packet and
+ * those which accept any source on its destination port.
  */
 class Ipv6EndPointDemux
 {
@@ -137,12 +142,38 @@ public:
   EndPoints GetEndPoints () const;
 
 private:
+  friend class Ipv6EndPoint;
+  typedef std::map<std::pair<Ipv6Address, uint32_t>, EndPoints> ConnectedEndPoints;
+  typedef std::map<uint16_t, EndPoints> PortEndPoints;
+
   /**
    * \brief Allocate a ephemeral port.
    * \return a port
    */
   uint16_t AllocateEphemeralPort ();
 
+  /**
+   * \brief Add an end point to the list and to the indexes.
+   * \param endPoint the end point
+   * \return the end point
+   */
+  Ipv6EndPoint * Insert (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Index an end point by its local port and peer.  The end
+   * points keep their positions in the lists, so that they are removed
+   * in logarithmic time.
+   * \param endPoint the end point
+   */
+  void Index (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Remove an end point from the index of its local port and peer,
+   * before its peer changes or it is removed.
+   * \param endPoint the end point
+   */
+  void Unindex (Ipv6EndPoint *endPoint);
+
   /**
    * \brief The ephemeral port.
    */
@@ -162,6 +193,22 @@ private:
    * \brief A list of IPv6 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief The end points with a peer address and port, by peer address,
+   * local port and peer port.
+   */
+  ConnectedEndPoints m_connected;
+
+  /**
+   * \brief The other end points, by local port.
+   */
+  PortEndPoints m_unconnected;
+
+  /**
+   * \brief All the end points, by local port.
+   */
+  PortEndPoints m_ports;
 };
 
 } /* namespace ns3 */
@@ -22,6 +22,7 @@
 #define IPV6_END_POINT_H
 
 #include <stdint.h>
+#include <list>
 
 #include "ns3/ipv6-address.h"
 #include "ns3/callback.h"
@@ -31,6 +32,7 @@ namespace ns3
 
 class Header;
 class Packet;
+class Ipv6EndPointDemux;
 
 /**
  * \class Ipv6EndPoint
@@ -134,6 +136,8 @@ public:
                     uint8_t code, uint32_t info);
 
 private:
+  friend class Ipv6EndPointDemux;
+
   /**
    * \brief ForwardUp wrapper.
    * \param p packet
@@ -188,6 +192,20 @@ private:
    * \brief The destroy callback.
    */
   Callback<void> m_destroyCallback;
+
+  /**
+   * \brief The demultiplexor which indexes this end point by its peer.
+   */
+  Ipv6EndPointDemux *m_demux;
+
+  /**
+   * \brief The positions of this end point in the lists of its
+   * demultiplexor: all the end points, those of its local port, and its
+   * index by peer.
+   */
+  std::list<Ipv6EndPoint *>::iterator m_allPosition;
+  std::list<Ipv6EndPoint *>::iterator m_portPosition;
+  std::list<Ipv6EndPoint *>::iterator m_indexPosition;
 };
 
 } /* namespace ns3 */
@@ -280,6 +280,16 @@ TypeId Ipv6ExtensionFragment::GetTypeId ()
   static TypeId tid = TypeId ("ns3::Ipv6ExtensionFragment")
     .SetParent<Ipv6Extension> ()
     .AddConstructor<Ipv6ExtensionFragment> ()
+    .AddAttribute ("FragmentExpirationTimeout",
+                   "When this timeout expires, the fragments will be cleared from the buffer.",
+                   TimeValue (Seconds (60)),
+                   MakeTimeAccessor (&Ipv6ExtensionFragment::m_fragmentExpirationTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("FragmentMemoryLimit",
+                   "The bytes of fragments kept for reassembly, beyond which the oldest packets are dropped.",
+                   UintegerValue (4194304),
+                   MakeUintegerAccessor (&Ipv6ExtensionFragment::m_fragmentMemoryLimit),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 }
@@ -298,12 +308,11 @@ void Ipv6ExtensionFragment::DoDispose ()
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  for (MapFragments_t::iterator it = m_fragments.begin (); it != m_fragments.end (); it++)
+  if (m_reassembly != 0)
     {
-      it->second = 0;
+      m_reassembly->Dispose ();
+      m_reassembly = 0;
     }
-
-  m_fragments.clear ();
   Ipv6Extension::DoDispose ();
 }
 
@@ -334,41 +343,34 @@ uint8_t Ipv6ExtensionFragment::Process (Ptr<Packet>& packet, uint8_t offset, Ipv
   uint32_t identification = fragmentHeader.GetIdentification ();
   Ipv6Address src = ipv6Header.GetSourceAddress ();
 
-  std::pair<Ipv6Address, uint32_t> fragmentsId = std::make_pair<Ipv6Address, uint32_t> (src, identification);
-  Ptr<Fragments> fragments;
-
-  Ipv6Header ipHeader = ipv6Header;
-  ipHeader.SetNextHeader (fragmentHeader.GetNextHeader ());
-
-  MapFragments_t::iterator it = m_fragments.find (fragmentsId);
-  if (it == m_fragments.end ())
+  if (m_reassembly == 0)
     {
-      fragments = Create<Fragments> ();
-      m_fragments.insert (std::make_pair (fragmentsId, fragments));
-      EventId timeout = Simulator::Schedule (Seconds (60),
-                                             &Ipv6ExtensionFragment::HandleFragmentsTimeout, this,
-                                             fragmentsId, ipHeader);
-      fragments->SetTimeoutEventId (timeout);
-    }
-  else
-    {
-      fragments = it->second;
+      m_reassembly = CreateObject<IpReassembly> ();
+      m_reassembly->SetDropCallback (MakeCallback (&Ipv6ExtensionFragment::HandleFragmentsDrop, this));
     }
+  m_reassembly->SetTimeout (m_fragmentExpirationTimeout);
+  m_reassembly->SetMaxMemory (m_fragmentMemoryLimit);
 
-  if (fragmentOffset == 0)
-    {
-      Ptr<Packet> unfragmentablePart = packet->Copy ();
-      unfragmentablePart->RemoveAtEnd (packet->GetSize () - offset);
-      fragments->SetUnfragmentablePart (unfragmentablePart);
-    }
+  IpReassembly::Key key;
+  key.source = src;
+  key.destination = ipv6Header.GetDestinationAddress ();
+  key.identification = identification;
+  key.protocol = 0;
 
-  fragments->AddFragment (p, fragmentOffset, moreFragment);
+  Ipv6Header ipHeader = ipv6Header;
+  ipHeader.SetNextHeader (fragmentHeader.GetNextHeader ());
+
+  // The header kept with the fragments is the IPv6 header followed by the
+  // unfragmentable part, for the ICMPv6 error of a timeout.
+  Ptr<Packet> header = packet->Copy ();
+  header->RemoveAtEnd (packet->GetSize () - offset);
+  header->AddHeader (ipHeader);
 
-  if (fragments->IsEntire ())
+  if (m_reassembly->AddFragment (key, p, fragmentOffset, moreFragment, header, 0))
     {
-      packet = fragments->GetPacket ();
-      fragments->CancelTimeout ();
-      m_fragments.erase (fragmentsId);
+      header->RemoveHeader (ipHeader);
+      header->AddAtEnd (p);
+      packet = header;
       isDropped = false;
     }
   else
@@ -548,138 +550,24 @@ void Ipv6ExtensionFragment::GetFragments (Ptr<Packet> packet, uint32_t maxFragme
 }
 
 
-void Ipv6ExtensionFragment::HandleFragmentsTimeout (std::pair<Ipv6Address, uint32_t> fragmentsId,
-                                                    Ipv6Header & ipHeader)
+void Ipv6ExtensionFragment::HandleFragmentsDrop (Ptr<Packet> header, Ptr<Packet> packet,
+                                                 uint32_t iif, IpReassembly::DropReason reason)
 {
-  Ptr<Fragments> fragments;
+  NS_LOG_FUNCTION (this << header << packet << reason);
 
-  MapFragments_t::iterator it = m_fragments.find (fragmentsId);
-  NS_ASSERT_MSG(it != m_fragments.end (), "IPv6 Fragment timeout reached for non-existent fragment");
-  fragments = it->second;
+  Ipv6Header ipHeader;
+  header->PeekHeader (ipHeader);
 
-  Ptr<Packet> packet = fragments->GetPartialPacket ();
-
-  packet->AddHeader (ipHeader);
+  Ptr<Packet> p = header->Copy ();
+  p->AddAtEnd (packet);
 
   // if we have at least 8 bytes, we can send an ICMP.
-  if ( packet->GetSize () > 8 )
+  if (reason == IpReassembly::DROP_TIMEOUT && packet->GetSize () > 8)
     {
       Ptr<Icmpv6L4Protocol> icmp = GetNode ()->GetObject<Icmpv6L4Protocol> ();
-      icmp->SendErrorTimeExceeded (packet, ipHeader.GetSourceAddress (), Icmpv6Header::ICMPV6_FRAGTIME);
-    }
-  m_dropTrace (packet);
-
-  // clear the buffers
-  m_fragments.erase (fragmentsId);
-}
-
-Ipv6ExtensionFragment::Fragments::Fragments ()
-  : m_moreFragment (0)
-{
-}
-
-Ipv6ExtensionFragment::Fragments::~Fragments ()
-{
-}
-
-void Ipv6ExtensionFragment::Fragments::AddFragment (Ptr<Packet> fragment, uint16_t fragmentOffset, bool moreFragment)
-{
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::iterator it;
-
-  for (it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
-    {
-      if (it->second > fragmentOffset)
-        {
-          break;
-        }
-    }
-
-  if (it == m_packetFragments.end ())
-    {
-      m_moreFragment = moreFragment;
+      icmp->SendErrorTimeExceeded (p, ipHeader.GetSourceAddress (), Icmpv6Header::ICMPV6_FRAGTIME);
     }
-
-  m_packetFragments.insert (it, std::make_pair<Ptr<Packet>, uint16_t> (fragment, fragmentOffset));
-}
-
-void Ipv6ExtensionFragment::Fragments::SetUnfragmentablePart (Ptr<Packet> unfragmentablePart)
-{
-  m_unfragmentable = unfragmentablePart;
-}
-
-bool Ipv6ExtensionFragment::Fragments::IsEntire () const
-{
-  bool ret = !m_moreFragment && m_packetFragments.size () > 0;
-
-  if (ret)
-    {
-      uint16_t lastEndOffset = 0;
-
-      for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
-        {
-          if (lastEndOffset != it->second)
-            {
-              ret = false;
-              break;
-            }
-
-          lastEndOffset += it->first->GetSize ();
-        }
-    }
-
-  return ret;
-}
-
-Ptr<Packet> Ipv6ExtensionFragment::Fragments::GetPacket () const
-{
-  Ptr<Packet> p =  m_unfragmentable->Copy ();
-
-  for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
-    {
-      p->AddAtEnd (it->first);
-    }
-
-  return p;
-}
-
-Ptr<Packet> Ipv6ExtensionFragment::Fragments::GetPartialPacket () const
-{
-  Ptr<Packet> p;
-
-  if ( m_unfragmentable )
-    {
-      p = m_unfragmentable->Copy ();
-    }
-  else
-    {
-      return p;
-    }
-
-  uint16_t lastEndOffset = 0;
-
-  for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
-    {
-      if (lastEndOffset != it->second)
-        {
-          break;
-        }
-      p->AddAtEnd (it->first);
-      lastEndOffset += it->first->GetSize ();
-    }
-
-  return p;
-}
-
-void Ipv6ExtensionFragment::Fragments::SetTimeoutEventId (EventId event)
-{
-  m_timeoutEventId = event;
-  return;
-}
-
-void Ipv6ExtensionFragment::Fragments::CancelTimeout ()
-{
-  m_timeoutEventId.Cancel ();
-  return;
+  m_dropTrace (p);
 }
 
 
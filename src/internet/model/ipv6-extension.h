@@ -33,6 +33,8 @@
 #include "ns3/packet.h"
 #include "ns3/ipv6-address.h"
 #include "ns3/traced-callback.h"
+#include "ns3/nstime.h"
+#include "ip-reassembly.h"
 
 
 namespace ns3 {
@@ -276,116 +278,28 @@ protected:
 
 private:
   /**
-   * \class Fragments
-   * \brief A Set of Fragment
+   * \brief Process the drop of a datagram before its reassembly
+   * \param header the packet holding the IPv6 header and the unfragmentable part
+   * \param packet the data received from the start of the datagram
+   * \param iif Input Interface, unused
+   * \param reason timeout or memory limit
    */
-  class Fragments : public SimpleRefCount<Fragments>
-  {
-public:
-    /**
-     * \brief Constructor.
-     */
-    Fragments ();
-
-    /**
-     * \brief Destructor.
-     */
-    ~Fragments ();
-
-    /**
-     * \brief Add a fragment.
-     * \param fragment the fragment
-     * \param fragmentOffset the offset of the fragment
-     * \param moreFragment the bit "More Fragment"
-     */
-    void AddFragment (Ptr<Packet> fragment, uint16_t fragmentOffset, bool moreFragment);
-
-    /**
-     * \brief Set the unfragmentable part of the packet.
-     * \param unfragmentablePart the unfragmentable part
-     */
-    void SetUnfragmentablePart (Ptr<Packet> unfragmentablePart);
-
-    /**
-     * \brief If all fragments have been added.
-     * \returns true if the packet is entire
-     */
-    bool IsEntire () const;
-
-    /**
-     * \brief Get the entire packet.
-     * \return the entire packet
-     */
-    Ptr<Packet> GetPacket () const;
-
-    /**
-     * \brief Get the packet parts so far received.
-     * \return the partial packet
-     */
-    Ptr<Packet> GetPartialPacket () const;
-
-    /**
-     * \brief Set the Timeout EventId.
-     */
-    void SetTimeoutEventId (EventId event);
-
-    /**
-     * \brief Cancel the timeout event
-     */
-    void CancelTimeout ();
-
-private:
-    /**
-     * \brief If other fragments will be sent.
-     */
-    bool m_moreFragment;
-
-    /**
-     * \brief The current fragments.
-     */
-    std::list<std::pair<Ptr<Packet>, uint16_t> > m_packetFragments;
-
-    /**
-     * \brief The unfragmentable part.
-     */
-    Ptr<Packet> m_unfragmentable;
-
-    /**
-     * \brief Timeout handler event
-     */
-    EventId m_timeoutEventId;
-  };
+  void HandleFragmentsDrop (Ptr<Packet> header, Ptr<Packet> packet, uint32_t iif, IpReassembly::DropReason reason);
 
   /**
-   * \brief Process the timeout for packet fragments
-   * \param key representing the packet fragments
-   * \param ipHeader the IP header of the original packet
-   * \param iif Input Interface
+   * \brief The fragmented packets waiting for reassembly.
    */
-  void HandleFragmentsTimeout (std::pair<Ipv6Address, uint32_t> key, Ipv6Header & ipHeader);
+  Ptr<IpReassembly> m_reassembly;
 
   /**
-   * \brief Get the packet parts so far received.
-   * \return the partial packet
+   * \brief Time given to the fragments of a packet to arrive.
    */
-  Ptr<Packet> GetPartialPacket () const;
-
-  /**
-   * \brief Set the Timeout EventId.
-   */
-  void SetTimeoutEventId (EventId event);
-
-  /**
-   * \brief Cancel the timeout event
-   */
-  void CancelTimeout ();
-
-  typedef std::map<std::pair<Ipv6Address, uint32_t>, Ptr<Fragments> > MapFragments_t;
+  Time m_fragmentExpirationTimeout;
 
   /**
-   * \brief The hash of fragmented packets.
+   * \brief Bytes of fragments kept for reassembly.
    */
-  MapFragments_t m_fragments;
+  uint32_t m_fragmentMemoryLimit;
 };
 
 /**
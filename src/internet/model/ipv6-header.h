@@ -228,6 +228,12 @@ private:
   Ipv4Address m_destinationAddress1;
 };
 
+template <>
+struct FixedSerializedSize<Ipv6Header>
+{
+  static const uint32_t value = 40;
+};
+
 } /* namespace ns3 */
 
 #endif /* IPV6_HEADER_H */
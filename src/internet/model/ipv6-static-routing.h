@@ -30,6 +30,7 @@
 #include "ns3/ipv6.h"
 #include "ns3/ipv6-header.h"
 #include "ns3/ipv6-routing-protocol.h"
+#include "ns3/lpm-trie.h"
 
 namespace ns3 {
 
@@ -258,6 +259,20 @@ private:
   typedef std::list<Ipv6MulticastRoutingTableEntry *>::const_iterator MulticastRoutesCI;
   typedef std::list<Ipv6MulticastRoutingTableEntry *>::iterator MulticastRoutesI;
 
+  /**
+   * \brief Append a route to the forwarding table and index it.
+   * \param route the route
+   * \param metric metric of the route
+   */
+  void AddNetworkRoute (Ipv6RoutingTableEntry *route, uint32_t metric);
+
+  /**
+   * \brief Remove a route from the forwarding table and its index, and delete it.
+   * \param it the route
+   * \return the iterator following it
+   */
+  NetworkRoutesI RemoveNetworkRoute (NetworkRoutesI it);
+
   /**
    * \brief Lookup in the forwarding table for destination.
    * \param dest destination address
@@ -288,6 +303,11 @@ private:
    */
   NetworkRoutes m_networkRoutes;
 
+  /**
+   * \brief the routes of the forwarding table for network, indexed by their prefixes.
+   */
+  LpmTrie<16, Ipv6RoutingTableEntry> m_lpm;
+
   /**
    * \brief the forwarding table for multicast.
    */
@@ -0,0 +1,382 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef LPM_TRIE_H
+#define LPM_TRIE_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv4Routing
+ *
+ * \brief A longest prefix match index of the routes to networks
+ *
+ * The keys are addresses of N bytes in network order (4 for IPv4, 16
+ * for IPv6), and the values pointers to routes, which are not owned by
+ * the trie.  It is a multibit trie with a stride of 4 bits: each node
+ * has 16 slots, and the prefixes whose length ends in the stride of a
+ * node are expanded over the slots they cover, so that a lookup reads
+ * one slot per 4 bits of the address, at most 8 for IPv4 and 32 for
+ * IPv6, whatever the number of routes.
+ *
+ * Several routes may be stored for the same prefix: the one of lowest
+ * metric is returned and, among those of equal metric, the one
+ * inserted last, as the linear scans of the routing tables did.
+ */
+template <uint32_t N, typename T>
+class LpmTrie
+{
+public:
+  LpmTrie ();
+  ~LpmTrie ();
+
+  /**
+   * \param key the network address, whose bits after length are ignored
+   * \param length the length of the prefix, at most 8 * N
+   * \param route the route to this network
+   * \param metric the metric of the route
+   */
+  void Insert (uint8_t const *key, uint8_t length, T *route, uint32_t metric);
+  /**
+   * \param key the network address with which the route was inserted
+   * \param length the length of the prefix with which the route was inserted
+   * \param route the route to remove
+   */
+  void Remove (uint8_t const *key, uint8_t length, T *route);
+  /**
+   * \param key an address
+   * \returns the route of lowest metric to the longest prefix matching
+   *          key, or 0 if no prefix matches
+   */
+  T *Lookup (uint8_t const *key) const;
+  /**
+   * Remove all the routes.
+   */
+  void Clear (void);
+  /**
+   * \returns the number of routes in the trie
+   */
+  uint32_t GetNRoutes (void) const;
+
+private:
+  LpmTrie (const LpmTrie &o);
+  LpmTrie &operator = (const LpmTrie &o);
+
+  enum { STRIDE = 4, SLOTS = 1 << STRIDE, DEPTH = 8 * N / STRIDE };
+
+  struct Route
+  {
+    T *route;
+    uint32_t metric;
+  };
+  struct Prefix
+  {
+    uint8_t length;   //!< the length of the prefix in its node, 1 to STRIDE
+    uint8_t bits;     //!< the first slot covered by the prefix
+    std::vector<Route> routes; //!< in the order of insertion
+    T *best;
+  };
+  struct Node
+  {
+    Prefix *slots[SLOTS];
+    Node *children[SLOTS];
+    std::vector<Prefix *> prefixes;
+    uint32_t nChildren;
+  };
+
+  static uint8_t GetSlot (uint8_t const *key, uint32_t depth);
+  static void UpdateBest (Prefix *prefix);
+  static Node *CreateNode (void);
+  static void DeleteNode (Node *node);
+
+  Node *m_root;
+  Prefix m_default;
+  uint32_t m_nRoutes;
+};
+
+} // namespace ns3
+
+namespace ns3 {
+
+template <uint32_t N, typename T>
+LpmTrie<N,T>::LpmTrie ()
+  : m_root (CreateNode ()),
+    m_nRoutes (0)
+{
+  m_default.length = 0;
+  m_default.bits = 0;
+  m_default.best = 0;
+}
+
+template <uint32_t N, typename T>
+LpmTrie<N,T>::~LpmTrie ()
+{
+  DeleteNode (m_root);
+  m_root = 0;
+}
+
+template <uint32_t N, typename T>
+uint8_t
+LpmTrie<N,T>::GetSlot (uint8_t const *key, uint32_t depth)
+{
+  uint8_t byte = key[depth / 2];
+  return (depth % 2) ? (byte & 0x0f) : (byte >> 4);
+}
+
+template <uint32_t N, typename T>
+void
+LpmTrie<N,T>::UpdateBest (Prefix *prefix)
+{
+  prefix->best = 0;
+  uint32_t metric = 0;
+  for (typename std::vector<Route>::const_iterator i = prefix->routes.begin (); i != prefix->routes.end (); ++i)
+    {
+      // the last one of equal metric wins
+      if (prefix->best == 0 || i->metric <= metric)
+        {
+          prefix->best = i->route;
+          metric = i->metric;
+        }
+    }
+}
+
+template <uint32_t N, typename T>
+typename LpmTrie<N,T>::Node *
+LpmTrie<N,T>::CreateNode (void)
+{
+  Node *node = new Node ();
+  for (uint32_t i = 0; i < SLOTS; i++)
+    {
+      node->slots[i] = 0;
+      node->children[i] = 0;
+    }
+  node->nChildren = 0;
+  return node;
+}
+
+template <uint32_t N, typename T>
+void
+LpmTrie<N,T>::DeleteNode (Node *node)
+{
+  for (uint32_t i = 0; i < SLOTS; i++)
+    {
+      if (node->children[i] != 0)
+        {
+          DeleteNode (node->children[i]);
+        }
+    }
+  for (typename std::vector<Prefix *>::iterator i = node->prefixes.begin (); i != node->prefixes.end (); ++i)
+    {
+      delete *i;
+    }
+  delete node;
+}
+
+template <uint32_t N, typename T>
+void
+LpmTrie<N,T>::Insert (uint8_t const *key, uint8_t length, T *route, uint32_t metric)
+{
+  NS_ASSERT (length <= 8 * N);
+  Route r;
+  r.route = route;
+  r.metric = metric;
+  m_nRoutes++;
+  if (length == 0)
+    {
+      m_default.routes.push_back (r);
+      UpdateBest (&m_default);
+      return;
+    }
+  Node *node = m_root;
+  uint32_t depth = 0;
+  while (length > (depth + 1) * STRIDE)
+    {
+      uint8_t slot = GetSlot (key, depth);
+      if (node->children[slot] == 0)
+        {
+          node->children[slot] = CreateNode ();
+          node->nChildren++;
+        }
+      node = node->children[slot];
+      depth++;
+    }
+  uint8_t local = length - depth * STRIDE;
+  uint8_t bits = GetSlot (key, depth) & ~((1 << (STRIDE - local)) - 1);
+  Prefix *prefix = 0;
+  for (typename std::vector<Prefix *>::iterator i = node->prefixes.begin (); i != node->prefixes.end (); ++i)
+    {
+      if ((*i)->length == local && (*i)->bits == bits)
+        {
+          prefix = *i;
+          break;
+        }
+    }
+  if (prefix == 0)
+    {
+      prefix = new Prefix ();
+      prefix->length = local;
+      prefix->bits = bits;
+      node->prefixes.push_back (prefix);
+      // expand the prefix over the slots it covers, unless a longer
+      // prefix of this node covers them already
+      for (uint32_t slot = bits; slot < bits + (1U << (STRIDE - local)); slot++)
+        {
+          if (node->slots[slot] == 0 || node->slots[slot]->length < local)
+            {
+              node->slots[slot] = prefix;
+            }
+        }
+    }
+  prefix->routes.push_back (r);
+  UpdateBest (prefix);
+}
+
+template <uint32_t N, typename T>
+void
+LpmTrie<N,T>::Remove (uint8_t const *key, uint8_t length, T *route)
+{
+  NS_ASSERT (length <= 8 * N);
+  Prefix *prefix = &m_default;
+  Node *path[DEPTH];
+  uint32_t depth = 0;
+  Node *node = m_root;
+  if (length > 0)
+    {
+      while (length > (depth + 1) * STRIDE)
+        {
+          path[depth] = node;
+          node = node->children[GetSlot (key, depth)];
+          if (node == 0)
+            {
+              return;
+            }
+          depth++;
+        }
+      uint8_t local = length - depth * STRIDE;
+      uint8_t bits = GetSlot (key, depth) & ~((1 << (STRIDE - local)) - 1);
+      prefix = 0;
+      for (typename std::vector<Prefix *>::iterator i = node->prefixes.begin (); i != node->prefixes.end (); ++i)
+        {
+          if ((*i)->length == local && (*i)->bits == bits)
+            {
+              prefix = *i;
+              break;
+            }
+        }
+      if (prefix == 0)
+        {
+          return;
+        }
+    }
+  typename std::vector<Route>::iterator i;
+  for (i = prefix->routes.begin (); i != prefix->routes.end (); ++i)
+    {
+      if (i->route == route)
+        {
+          break;
+        }
+    }
+  if (i == prefix->routes.end ())
+    {
+      return;
+    }
+  prefix->routes.erase (i);
+  m_nRoutes--;
+  UpdateBest (prefix);
+  if (length == 0 || !prefix->routes.empty ())
+    {
+      return;
+    }
+
+  // the prefix is gone: give its slots back to the longest remaining
+  // prefix of the node which covers them
+  for (typename std::vector<Prefix *>::iterator j = node->prefixes.begin (); j != node->prefixes.end (); ++j)
+    {
+      if (*j == prefix)
+        {
+          node->prefixes.erase (j);
+          break;
+        }
+    }
+  for (uint32_t slot = prefix->bits; slot < prefix->bits + (1U << (STRIDE - prefix->length)); slot++)
+    {
+      node->slots[slot] = 0;
+      for (typename std::vector<Prefix *>::const_iterator j = node->prefixes.begin (); j != node->prefixes.end (); ++j)
+        {
+          uint32_t shift = STRIDE - (*j)->length;
+          if ((slot >> shift) == (static_cast<uint32_t> ((*j)->bits) >> shift)
+              && (node->slots[slot] == 0 || node->slots[slot]->length < (*j)->length))
+            {
+              node->slots[slot] = *j;
+            }
+        }
+    }
+  delete prefix;
+
+  // and prune the nodes left without any prefix
+  while (depth > 0 && node->prefixes.empty () && node->nChildren == 0)
+    {
+      depth--;
+      Node *parent = path[depth];
+      parent->children[GetSlot (key, depth)] = 0;
+      parent->nChildren--;
+      delete node;
+      node = parent;
+    }
+}
+
+template <uint32_t N, typename T>
+T *
+LpmTrie<N,T>::Lookup (uint8_t const *key) const
+{
+  Prefix const *found = m_default.best != 0 ? &m_default : 0;
+  Node const *node = m_root;
+  for (uint32_t depth = 0; node != 0 && depth < DEPTH; depth++)
+    {
+      uint8_t slot = GetSlot (key, depth);
+      if (node->slots[slot] != 0)
+        {
+          found = node->slots[slot];
+        }
+      node = node->children[slot];
+    }
+  return found != 0 ? found->best : 0;
+}
+
+template <uint32_t N, typename T>
+void
+LpmTrie<N,T>::Clear (void)
+{
+  DeleteNode (m_root);
+  m_root = CreateNode ();
+  m_default.routes.clear ();
+  m_default.best = 0;
+  m_nRoutes = 0;
+}
+
+template <uint32_t N, typename T>
+uint32_t
+LpmTrie<N,T>::GetNRoutes (void) const
+{
+  return m_nRoutes;
+}
+
+} // namespace ns3
+
+#endif /* LPM_TRIE_H */
@@ -18,9 +18,12 @@
  * Author: Sebastien Vincent <vincent@clarinet.u-strasbg.fr>
  */
 
+#include <cmath>
+#include <vector>
 #include "ns3/log.h"
 #include "ns3/uinteger.h"
 #include "ns3/node.h"
+#include "ns3/simulator.h"
 
 #include "ipv6-l3-protocol.h" 
 #include "icmpv6-l4-protocol.h"
@@ -48,6 +51,7 @@ TypeId NdiscCache::GetTypeId ()
 } 
 
 NdiscCache::NdiscCache ()
+  : m_aging (false)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -89,23 +93,15 @@ Ptr<NetDevice> NdiscCache::GetDevice () const
 NdiscCache::Entry* NdiscCache::Lookup (Ipv6Address dst)
 {
   NS_LOG_FUNCTION (this << dst);
-
-  if (m_ndCache.find (dst) != m_ndCache.end ())
-    {
-      NdiscCache::Entry* entry = m_ndCache[dst];
-      return entry;
-    }
-  return 0;
+  return m_ndCache.Find (dst);
 }
 
 NdiscCache::Entry* NdiscCache::Add (Ipv6Address to)
 {
   NS_LOG_FUNCTION (this << to);
-  NS_ASSERT (m_ndCache.find (to) == m_ndCache.end ());
 
-  NdiscCache::Entry* entry = new NdiscCache::Entry (this);
+  NdiscCache::Entry* entry = m_ndCache.Insert (to, NdiscCache::Entry (this));
   entry->SetIpv6Address (to);
-  m_ndCache[to] = entry;
   return entry;
 }
 
@@ -113,28 +109,111 @@ void NdiscCache::Remove (NdiscCache::Entry* entry)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  for (CacheI i = m_ndCache.begin (); i != m_ndCache.end (); i++)
+  entry->ClearWaitingPacket ();
+  m_ndCache.Erase (entry->GetIpv6Address ());
+}
+
+void NdiscCache::Flush ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  m_ndCache.Clear ();
+  m_waitingPool.clear ();
+  m_agingEvent.Cancel ();
+}
+
+void NdiscCache::ScheduleAging (Time expire)
+{
+  NS_LOG_FUNCTION (this << expire);
+
+  /* HandleAging schedules the next event itself */
+  if (m_aging)
     {
-      if ((*i).second == entry)
+      if (m_nextAging.IsZero () || expire < m_nextAging)
         {
-          m_ndCache.erase (i);
-          entry->ClearWaitingPacket ();
-          delete entry;
-          return;
+          m_nextAging = expire;
         }
+      return;
+    }
+  if (m_agingEvent.IsRunning () && Simulator::GetDelayLeft (m_agingEvent) <= expire - Simulator::Now ())
+    {
+      return;
     }
+  m_agingEvent.Cancel ();
+  m_agingEvent = Simulator::Schedule (expire - Simulator::Now (), &NdiscCache::HandleAging, this);
 }
 
-void NdiscCache::Flush ()
+void NdiscCache::HandleAging ()
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  for (CacheI i = m_ndCache.begin (); i != m_ndCache.end (); i++)
+  /* the handlers may add and remove entries: note the expired ones first */
+  std::vector<Ipv6Address> expired;
+  m_nextAging = Time ();
+  for (uint32_t i = 0; i < m_ndCache.GetNPositions (); i++)
+    {
+      NdiscCache::Entry* entry = m_ndCache.GetPosition (i);
+      if (entry == 0)
+        {
+          continue;
+        }
+      Time next = entry->GetNextTimer ();
+      if (next.IsZero ())
+        {
+          continue;
+        }
+      if (next <= Simulator::Now ())
+        {
+          expired.push_back (entry->GetIpv6Address ());
+        }
+      else if (m_nextAging.IsZero () || next < m_nextAging)
+        {
+          m_nextAging = next;
+        }
+    }
+
+  /* the timers started meanwhile lower m_nextAging */
+  m_aging = true;
+  for (std::vector<Ipv6Address>::const_iterator i = expired.begin (); i != expired.end (); i++)
+    {
+      NdiscCache::Entry* entry = Lookup (*i);
+      while (entry != 0 && entry->HandleTimer ())
+        {
+          entry = Lookup (*i);
+        }
+      if (entry != 0 && !entry->GetNextTimer ().IsZero ())
+        {
+          ScheduleAging (entry->GetNextTimer ());
+        }
+    }
+  m_aging = false;
+
+  if (!m_nextAging.IsZero ())
+    {
+      m_agingEvent = Simulator::Schedule (m_nextAging - Simulator::Now (), &NdiscCache::HandleAging, this);
+    }
+}
+
+void NdiscCache::EnqueueWaiting (std::list<Ptr<Packet> > &waiting, Ptr<Packet> p)
+{
+  if (m_waitingPool.empty ())
+    {
+      waiting.push_back (p);
+    }
+  else
     {
-      delete (*i).second; /* delete the pointer NdiscCache::Entry */
+      waiting.splice (waiting.end (), m_waitingPool, m_waitingPool.begin ());
+      waiting.back () = p;
     }
+}
 
-  m_ndCache.erase (m_ndCache.begin (), m_ndCache.end ());
+void NdiscCache::ReleaseWaiting (std::list<Ptr<Packet> > &waiting, uint32_t n)
+{
+  for (uint32_t i = 0; i < n && !waiting.empty (); i++)
+    {
+      waiting.front () = 0;
+      m_waitingPool.splice (m_waitingPool.end (), waiting, waiting.begin ());
+    }
 }
 
 void NdiscCache::SetUnresQlen (uint32_t unresQlen)
@@ -153,10 +232,6 @@ NdiscCache::Entry::Entry (NdiscCache* nd)
   : m_ndCache (nd),
     m_waiting (),
     m_router (false),
-    m_reachableTimer (Timer::CANCEL_ON_DESTROY),
-    m_retransTimer (Timer::CANCEL_ON_DESTROY),
-    m_probeTimer (Timer::CANCEL_ON_DESTROY),
-    m_delayTimer (Timer::CANCEL_ON_DESTROY),
     m_lastReachabilityConfirmation (Seconds (0.0)),
     m_nsRetransmit (0)
 {
@@ -183,16 +258,16 @@ void NdiscCache::Entry::AddWaitingPacket (Ptr<Packet> p)
     {
       /* we store only m_unresQlen packet => first packet in first packet remove */
       /* XXX report packet as 'dropped' */
-      m_waiting.remove (0);
+      m_ndCache->ReleaseWaiting (m_waiting, 1);
     }
-  m_waiting.push_back (p);
+  m_ndCache->EnqueueWaiting (m_waiting, p);
 }
 
 void NdiscCache::Entry::ClearWaitingPacket ()
 {
   NS_LOG_FUNCTION_NOARGS ();
   /* XXX report packets as 'dropped' */
-  m_waiting.clear ();
+  m_ndCache->ReleaseWaiting (m_waiting, m_waiting.size ());
 }
 
 void NdiscCache::Entry::FunctionReachableTimeout ()
@@ -335,6 +410,57 @@ void NdiscCache::Entry::SetIpv6Address (Ipv6Address ipv6Address)
   m_ipv6Address = ipv6Address;
 }
 
+Ipv6Address NdiscCache::Entry::GetIpv6Address () const
+{
+  return m_ipv6Address;
+}
+
+bool NdiscCache::Entry::HandleTimer ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  Time now = Simulator::Now ();
+
+  if (!m_reachableTimer.IsZero () && m_reachableTimer <= now)
+    {
+      m_reachableTimer = Time ();
+      FunctionReachableTimeout ();
+      return true;
+    }
+  if (!m_retransTimer.IsZero () && m_retransTimer <= now)
+    {
+      m_retransTimer = Time ();
+      FunctionRetransmitTimeout ();
+      return true;
+    }
+  if (!m_probeTimer.IsZero () && m_probeTimer <= now)
+    {
+      m_probeTimer = Time ();
+      FunctionProbeTimeout ();
+      return true;
+    }
+  if (!m_delayTimer.IsZero () && m_delayTimer <= now)
+    {
+      m_delayTimer = Time ();
+      FunctionDelayTimeout ();
+      return true;
+    }
+  return false;
+}
+
+Time NdiscCache::Entry::GetNextTimer () const
+{
+  Time next;
+  const Time *timers[4] = { &m_reachableTimer, &m_retransTimer, &m_probeTimer, &m_delayTimer };
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      if (!timers[i]->IsZero () && (next.IsZero () || *timers[i] < next))
+        {
+          next = *timers[i];
+        }
+    }
+  return next;
+}
+
 uint8_t NdiscCache::Entry::GetNSRetransmit () const
 {
   NS_LOG_FUNCTION_NOARGS ();
@@ -367,29 +493,29 @@ void NdiscCache::Entry::UpdateLastReachabilityconfirmation ()
 void NdiscCache::Entry::StartReachableTimer ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  m_reachableTimer.SetFunction (&NdiscCache::Entry::FunctionReachableTimeout, this);
-  m_reachableTimer.SetDelay (MilliSeconds (Icmpv6L4Protocol::REACHABLE_TIME));
-  m_reachableTimer.Schedule ();
+  /* rounded up to the second, to batch the aging of the entries */
+  Time expire = Simulator::Now () + MilliSeconds (Icmpv6L4Protocol::REACHABLE_TIME);
+  m_reachableTimer = Seconds (std::ceil (expire.GetSeconds ()));
+  m_ndCache->ScheduleAging (m_reachableTimer);
 }
 
 void NdiscCache::Entry::StopReachableTimer ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  m_reachableTimer.Cancel ();
+  m_reachableTimer = Time ();
 }
 
 void NdiscCache::Entry::StartProbeTimer ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  m_probeTimer.SetFunction (&NdiscCache::Entry::FunctionProbeTimeout, this);
-  m_probeTimer.SetDelay (MilliSeconds (Icmpv6L4Protocol::RETRANS_TIMER));
-  m_probeTimer.Schedule ();
+  m_probeTimer = Simulator::Now () + MilliSeconds (Icmpv6L4Protocol::RETRANS_TIMER);
+  m_ndCache->ScheduleAging (m_probeTimer);
 }
 
 void NdiscCache::Entry::StopProbeTimer ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  m_probeTimer.Cancel ();
+  m_probeTimer = Time ();
   ResetNSRetransmit ();
 }
 
@@ -397,30 +523,28 @@ void NdiscCache::Entry::StopProbeTimer ()
 void NdiscCache::Entry::StartDelayTimer ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  m_delayTimer.SetFunction (&NdiscCache::Entry::FunctionDelayTimeout, this);
-  m_delayTimer.SetDelay (Seconds (Icmpv6L4Protocol::DELAY_FIRST_PROBE_TIME));
-  m_delayTimer.Schedule ();
+  m_delayTimer = Simulator::Now () + Seconds (Icmpv6L4Protocol::DELAY_FIRST_PROBE_TIME);
+  m_ndCache->ScheduleAging (m_delayTimer);
 }
 
 void NdiscCache::Entry::StopDelayTimer ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  m_delayTimer.Cancel ();
+  m_delayTimer = Time ();
   ResetNSRetransmit ();
 }
 
 void NdiscCache::Entry::StartRetransmitTimer ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  m_retransTimer.SetFunction (&NdiscCache::Entry::FunctionRetransmitTimeout, this);
-  m_retransTimer.SetDelay (MilliSeconds (Icmpv6L4Protocol::RETRANS_TIMER));
-  m_retransTimer.Schedule ();
+  m_retransTimer = Simulator::Now () + MilliSeconds (Icmpv6L4Protocol::RETRANS_TIMER);
+  m_ndCache->ScheduleAging (m_retransTimer);
 }
 
 void NdiscCache::Entry::StopRetransmitTimer ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  m_retransTimer.Cancel ();
+  m_retransTimer = Time ();
   ResetNSRetransmit ();
 }
 
@@ -431,7 +555,7 @@ void NdiscCache::Entry::MarkIncomplete (Ptr<Packet> p)
 
   if (p)
     {
-      m_waiting.push_back (p);
+      m_ndCache->EnqueueWaiting (m_waiting, p);
     }
 }
 
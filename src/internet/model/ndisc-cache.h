@@ -30,8 +30,8 @@
 #include "ns3/net-device.h"
 #include "ns3/ipv6-address.h"
 #include "ns3/ptr.h"
-#include "ns3/timer.h"
-#include "ns3/sgi-hashmap.h"
+#include "ns3/event-id.h"
+#include "ns3/neighbor-cache-table.h"
 
 namespace ns3
 {
@@ -42,6 +42,11 @@ class Ipv6Interface;
 /**
  * \class NdiscCache
  * \brief IPv6 Neighbor Discovery cache.
+ *
+ * The entries are kept inline in an open addressing table.  Their timers
+ * are expiration times, which a single aging event per cache checks at the
+ * earliest of them; the reachable timers are rounded up to the second, so
+ * that one event handles all the entries confirmed in the same second.
  */
 class NdiscCache : public Object
 {
@@ -135,7 +140,7 @@ public:
      * \brief Constructor.
      * \param nd The NdiscCache this entry belongs to.
      */
-    Entry (NdiscCache* nd);
+    Entry (NdiscCache* nd = 0);
 
     /**
      * \brief Changes the state to this entry to INCOMPLETE.
@@ -337,6 +342,26 @@ public:
      */
     void SetIpv6Address (Ipv6Address ipv6Address);
 
+    /**
+     * \brief Get the IPv6 address.
+     * \return the IPv6 address
+     */
+    Ipv6Address GetIpv6Address () const;
+
+    /**
+     * \brief Call the handler of the first timer expired, if any.
+     *
+     * The handler may remove the entry, which must be looked up again.
+     * \return true if a timer had expired
+     */
+    bool HandleTimer ();
+
+    /**
+     * \brief Get the earliest expiration time of the timers running.
+     * \return the time, or zero if no timer is running
+     */
+    Time GetNextTimer () const;
+
 private:
     /**
      * \brief The IPv6 address.
@@ -381,24 +406,24 @@ private:
     bool m_router;
 
     /**
-     * \brief Reachable timer (used for NUD in REACHABLE state).
+     * \brief Expiration of the reachable timer (used for NUD in REACHABLE state), zero if stopped.
      */
-    Timer m_reachableTimer;
+    Time m_reachableTimer;
 
     /**
-     * \brief Retransmission timer (used for NUD in INCOMPLETE state).
+     * \brief Expiration of the retransmission timer (used for NUD in INCOMPLETE state), zero if stopped.
      */
-    Timer m_retransTimer;
+    Time m_retransTimer;
 
     /**
-     * \brief Probe timer (used for NUD in PROBE state).
+     * \brief Expiration of the probe timer (used for NUD in PROBE state), zero if stopped.
      */
-    Timer m_probeTimer;
+    Time m_probeTimer;
 
     /**
-     * \brief Delay timer (used for NUD when in DELAY state).
+     * \brief Expiration of the delay timer (used for NUD when in DELAY state), zero if stopped.
      */
-    Timer m_delayTimer;
+    Time m_delayTimer;
 
     /**
      * \brief Last time we see a reachability confirmation.
@@ -412,8 +437,7 @@ private:
   };
 
 private:
-  typedef sgi::hash_map<Ipv6Address, NdiscCache::Entry *, Ipv6AddressHash> Cache;
-  typedef sgi::hash_map<Ipv6Address, NdiscCache::Entry *, Ipv6AddressHash>::iterator CacheI;
+  typedef NeighborCacheTable<Ipv6Address, NdiscCache::Entry, Ipv6AddressHash> Cache;
 
   /**
    * \brief Copy constructor.
@@ -432,6 +456,31 @@ private:
    */
   void DoDispose ();
 
+  /**
+   * \brief Schedule the aging event, if a timer expires before it.
+   * \param expire expiration time of the timer started
+   */
+  void ScheduleAging (Time expire);
+
+  /**
+   * \brief Handle the timers expired, and schedule the next aging event.
+   */
+  void HandleAging ();
+
+  /**
+   * \brief Append a packet to a waiting list, with a node of the pool if any.
+   * \param waiting the list
+   * \param p the packet
+   */
+  void EnqueueWaiting (std::list<Ptr<Packet> > &waiting, Ptr<Packet> p);
+
+  /**
+   * \brief Return the nodes of a waiting list to the pool.
+   * \param waiting the list
+   * \param n the number of packets to remove from its head
+   */
+  void ReleaseWaiting (std::list<Ptr<Packet> > &waiting, uint32_t n);
+
   /**
    * \brief The NetDevice.
    */
@@ -451,6 +500,26 @@ private:
    * \brief Max number of packet stored in m_waiting.
    */
   uint32_t m_unresQlen;
+
+  /**
+   * \brief Spare nodes of the waiting lists.
+   */
+  std::list<Ptr<Packet> > m_waitingPool;
+
+  /**
+   * \brief The aging event, at the earliest expiration of the timers.
+   */
+  EventId m_agingEvent;
+
+  /**
+   * \brief True while the aging event runs.
+   */
+  bool m_aging;
+
+  /**
+   * \brief Earliest expiration found while the aging event runs.
+   */
+  Time m_nextAging;
 };
 
 } /* namespace ns3 */
@@ -0,0 +1,266 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef NEIGHBOR_CACHE_TABLE_H
+#define NEIGHBOR_CACHE_TABLE_H
+
+#include <stdint.h>
+#include <vector>
+#include <deque>
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup internet
+ *
+ * \brief The table of the entries of a neighbor cache (ARP or NDisc)
+ *
+ * The entries are stored inline, in the blocks of a deque, and indexed
+ * by an open addressing table of their positions, addressed by the hash
+ * H of their address A, with linear probing: a lookup reads a few
+ * consecutive slots and no entry is allocated on its own.  A removed
+ * entry leaves a tombstone in the index and its position is reused by
+ * the next insertion; the index doubles when the slots in use reach 3/4
+ * of it.
+ *
+ * The entries never move: the pointers to them stay valid until they
+ * are removed, as the handlers of the caches expect.
+ */
+template <typename A, typename E, typename H>
+class NeighborCacheTable
+{
+public:
+  /**
+   * \param capacity the initial number of slots of the index, a power of 2
+   */
+  NeighborCacheTable (uint32_t capacity = 16);
+
+  /**
+   * \param address the address of an entry
+   * \returns the entry of this address, or 0 if none
+   */
+  E *Find (A const &address);
+  /**
+   * \param address the address of the new entry, not in the table
+   * \param entry the new entry
+   * \returns the entry inserted
+   */
+  E *Insert (A const &address, E const &entry);
+  /**
+   * \param address the address of the entry to remove
+   */
+  void Erase (A const &address);
+  /**
+   * Remove all the entries.
+   */
+  void Clear (void);
+  /**
+   * \returns the number of entries
+   */
+  uint32_t GetSize (void) const;
+  /**
+   * \returns the number of positions, to be walked with GetPosition
+   */
+  uint32_t GetNPositions (void) const;
+  /**
+   * \param i a position, lower than GetNPositions
+   * \returns the entry at this position, or 0 if none
+   */
+  E *GetPosition (uint32_t i);
+
+private:
+  enum
+  {
+    EMPTY = 0xffffffff,
+    DELETED = 0xfffffffe
+  };
+  struct Node
+  {
+    bool used;
+    A address;
+    E entry;
+  };
+
+  uint32_t Probe (A const &address) const;
+  void Resize (uint32_t capacity);
+
+  std::vector<uint32_t> m_slots;  //!< positions of the entries, EMPTY or DELETED
+  std::deque<Node> m_nodes;       //!< the entries
+  std::vector<uint32_t> m_free;   //!< positions of the removed entries
+  uint32_t m_size;     //!< slots in use
+  uint32_t m_deleted;  //!< slots DELETED
+};
+
+} // namespace ns3
+
+namespace ns3 {
+
+template <typename A, typename E, typename H>
+NeighborCacheTable<A,E,H>::NeighborCacheTable (uint32_t capacity)
+  : m_slots (capacity, EMPTY),
+    m_size (0),
+    m_deleted (0)
+{
+  NS_ASSERT ((capacity & (capacity - 1)) == 0);
+}
+
+// the slot of the address, or the empty slot ending its probe sequence
+template <typename A, typename E, typename H>
+uint32_t
+NeighborCacheTable<A,E,H>::Probe (A const &address) const
+{
+  uint32_t mask = m_slots.size () - 1;
+  uint32_t i = H () (address) & mask;
+  while (m_slots[i] != EMPTY)
+    {
+      if (m_slots[i] != DELETED && m_nodes[m_slots[i]].address == address)
+        {
+          return i;
+        }
+      i = (i + 1) & mask;
+    }
+  return i;
+}
+
+template <typename A, typename E, typename H>
+E *
+NeighborCacheTable<A,E,H>::Find (A const &address)
+{
+  uint32_t i = Probe (address);
+  if (m_slots[i] != EMPTY)
+    {
+      return &m_nodes[m_slots[i]].entry;
+    }
+  return 0;
+}
+
+template <typename A, typename E, typename H>
+E *
+NeighborCacheTable<A,E,H>::Insert (A const &address, E const &entry)
+{
+  NS_ASSERT (Find (address) == 0);
+  if (4 * (m_size + m_deleted + 1) > 3 * m_slots.size ())
+    {
+      // double the index, unless the tombstones alone filled it
+      Resize (4 * (m_size + 1) > m_slots.size () ? 2 * m_slots.size () : m_slots.size ());
+    }
+
+  uint32_t position;
+  if (m_free.empty ())
+    {
+      position = m_nodes.size ();
+      m_nodes.push_back (Node ());
+    }
+  else
+    {
+      position = m_free.back ();
+      m_free.pop_back ();
+    }
+  Node &node = m_nodes[position];
+  node.used = true;
+  node.address = address;
+  node.entry = entry;
+
+  uint32_t mask = m_slots.size () - 1;
+  uint32_t i = H () (address) & mask;
+  while (m_slots[i] != EMPTY && m_slots[i] != DELETED)
+    {
+      i = (i + 1) & mask;
+    }
+  if (m_slots[i] == DELETED)
+    {
+      m_deleted--;
+    }
+  m_slots[i] = position;
+  m_size++;
+  return &node.entry;
+}
+
+template <typename A, typename E, typename H>
+void
+NeighborCacheTable<A,E,H>::Erase (A const &address)
+{
+  uint32_t i = Probe (address);
+  if (m_slots[i] != EMPTY)
+    {
+      Node &node = m_nodes[m_slots[i]];
+      node.used = false;
+      node.entry = E ();
+      m_free.push_back (m_slots[i]);
+      m_slots[i] = DELETED;
+      m_size--;
+      m_deleted++;
+    }
+}
+
+template <typename A, typename E, typename H>
+void
+NeighborCacheTable<A,E,H>::Clear (void)
+{
+  m_slots.assign (m_slots.size (), EMPTY);
+  m_nodes.clear ();
+  m_free.clear ();
+  m_size = 0;
+  m_deleted = 0;
+}
+
+template <typename A, typename E, typename H>
+uint32_t
+NeighborCacheTable<A,E,H>::GetSize (void) const
+{
+  return m_size;
+}
+
+template <typename A, typename E, typename H>
+uint32_t
+NeighborCacheTable<A,E,H>::GetNPositions (void) const
+{
+  return m_nodes.size ();
+}
+
+template <typename A, typename E, typename H>
+E *
+NeighborCacheTable<A,E,H>::GetPosition (uint32_t i)
+{
+  NS_ASSERT (i < m_nodes.size ());
+  return m_nodes[i].used ? &m_nodes[i].entry : 0;
+}
+
+template <typename A, typename E, typename H>
+void
+NeighborCacheTable<A,E,H>::Resize (uint32_t capacity)
+{
+  m_slots.assign (capacity, EMPTY);
+  m_deleted = 0;
+  uint32_t mask = capacity - 1;
+  for (uint32_t position = 0; position < m_nodes.size (); position++)
+    {
+      if (!m_nodes[position].used)
+        {
+          continue;
+        }
+      uint32_t i = H () (m_nodes[position].address) & mask;
+      while (m_slots[i] != EMPTY)
+        {
+          i = (i + 1) & mask;
+        }
+      m_slots[i] = position;
+    }
+}
+
+} // namespace ns3
+
+#endif /* NEIGHBOR_CACHE_TABLE_H */
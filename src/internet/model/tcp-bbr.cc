@@ -0,0 +1,618 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#define NS_LOG_APPEND_CONTEXT \
+  if (m_node) { std::clog << Simulator::Now ().GetSeconds () << " [node " << m_node->GetId () << "] "; }
+
+#include "tcp-bbr.h"
+#include "ns3/log.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/simulator.h"
+#include "ns3/abort.h"
+#include "ns3/node.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/random-variable.h"
+
+NS_LOG_COMPONENT_DEFINE ("TcpBbr");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (TcpBbr);
+
+// The pacing gains of the phases of PROBE_BW: probe for more bandwidth,
+// drain the queue it built, then cruise
+static const double g_pacingGainCycle[] = { 1.25, 0.75, 1, 1, 1, 1, 1, 1 };
+static const uint32_t g_cycleLength = sizeof (g_pacingGainCycle) / sizeof (g_pacingGainCycle[0]);
+
+TypeId
+TcpBbr::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpBbr")
+    .SetParent<TcpSocketBase> ()
+    .AddConstructor<TcpBbr> ()
+    .AddAttribute ("ReTxThreshold", "Threshold for fast retransmit",
+                   UintegerValue (3),
+                   MakeUintegerAccessor (&TcpBbr::m_retxThresh),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("HighGain", "Pacing and cwnd gain of STARTUP",
+                   DoubleValue (2.885),
+                   MakeDoubleAccessor (&TcpBbr::m_highGain),
+                   MakeDoubleChecker<double> (1.0))
+    .AddAttribute ("CwndGain", "cwnd gain over the bandwidth-delay product in PROBE_BW",
+                   DoubleValue (2.0),
+                   MakeDoubleAccessor (&TcpBbr::m_cwndGain),
+                   MakeDoubleChecker<double> (1.0))
+    .AddAttribute ("BandwidthWindowLength", "Number of rounds over which the bottleneck bandwidth is the highest rate",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&TcpBbr::m_bandwidthWindow),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("RtPropWindowLength", "Time over which the propagation time is the lowest RTT",
+                   TimeValue (Seconds (10)),
+                   MakeTimeAccessor (&TcpBbr::m_rtPropWindow),
+                   MakeTimeChecker ())
+    .AddAttribute ("ProbeRttDuration", "Time spent with 4 segments in flight to measure the propagation time",
+                   TimeValue (MilliSeconds (200)),
+                   MakeTimeAccessor (&TcpBbr::m_probeRttDuration),
+                   MakeTimeChecker ())
+    .AddTraceSource ("CongestionWindow",
+                     "The TCP connection's congestion window",
+                     MakeTraceSourceAccessor (&TcpBbr::m_cWnd))
+  ;
+  return tid;
+}
+
+TcpBbr::TcpBbr (void)
+  : m_retxThresh (3), // mute valgrind, actual value set by the attribute system
+    m_inFastRec (false),
+    m_mode (STARTUP),
+    m_pacingGain (2.885),
+    m_cWndGain (2.885),
+    m_rtProp (Seconds (0)),
+    m_rtPropStamp (Seconds (0)),
+    m_roundCount (0),
+    m_nextRoundDelivered (0),
+    m_roundStart (false),
+    m_fullBw (0),
+    m_fullBwCount (0),
+    m_filledPipe (false),
+    m_cycleIndex (0),
+    m_cycleStamp (Seconds (0)),
+    m_probeRttDone (Seconds (0)),
+    m_probeRttRoundDone (false),
+    m_priorCWnd (0),
+    m_delivered (0),
+    m_deliveredTime (Seconds (0)),
+    m_firstSentTime (Seconds (0)),
+    m_lastSacked (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TcpBbr::TcpBbr (const TcpBbr& sock)
+  : TcpSocketBase (sock),
+    m_cWnd (sock.m_cWnd),
+    m_ssThresh (sock.m_ssThresh),
+    m_initialCWnd (sock.m_initialCWnd),
+    m_retxThresh (sock.m_retxThresh),
+    m_inFastRec (false),
+    m_highGain (sock.m_highGain),
+    m_cwndGain (sock.m_cwndGain),
+    m_bandwidthWindow (sock.m_bandwidthWindow),
+    m_rtPropWindow (sock.m_rtPropWindow),
+    m_probeRttDuration (sock.m_probeRttDuration),
+    m_mode (STARTUP),
+    m_pacingGain (sock.m_highGain),
+    m_cWndGain (sock.m_highGain),
+    m_rtProp (Seconds (0)),
+    m_rtPropStamp (Seconds (0)),
+    m_roundCount (0),
+    m_nextRoundDelivered (0),
+    m_roundStart (false),
+    m_fullBw (0),
+    m_fullBwCount (0),
+    m_filledPipe (false),
+    m_cycleIndex (0),
+    m_cycleStamp (Seconds (0)),
+    m_probeRttDone (Seconds (0)),
+    m_probeRttRoundDone (false),
+    m_priorCWnd (0),
+    m_delivered (0),
+    m_deliveredTime (Seconds (0)),
+    m_firstSentTime (Seconds (0)),
+    m_lastSacked (0)
+{
+  NS_LOG_FUNCTION (this);
+  NS_LOG_LOGIC ("Invoked the copy constructor");
+}
+
+TcpBbr::~TcpBbr (void)
+{
+}
+
+/** We initialize m_cWnd from this function, after attributes initialized */
+int
+TcpBbr::Listen (void)
+{
+  NS_LOG_FUNCTION (this);
+  InitializeCwnd ();
+  return TcpSocketBase::Listen ();
+}
+
+/** We initialize m_cWnd from this function, after attributes initialized */
+int
+TcpBbr::Connect (const Address & address)
+{
+  NS_LOG_FUNCTION (this << address);
+  InitializeCwnd ();
+  return TcpSocketBase::Connect (address);
+}
+
+/** Limit the size of in-flight data by cwnd and receiver's rxwin */
+uint32_t
+TcpBbr::Window (void)
+{
+  NS_LOG_FUNCTION (this);
+  return std::min (m_rWnd.Get (), m_cWnd.Get ());
+}
+
+Ptr<TcpSocketBase>
+TcpBbr::Fork (void)
+{
+  return CopyObject<TcpBbr> (this);
+}
+
+/** Send the segment, and remember how much was delivered when it left */
+uint32_t
+TcpBbr::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool withAck)
+{
+  NS_LOG_FUNCTION (this << seq << maxSize << withAck);
+  Time now = Simulator::Now ();
+  if (m_highTxMark.Get () <= m_txBuffer.HeadSequence ())
+    { // Nothing in flight: the rate is measured from now
+      m_firstSentTime = now;
+      m_deliveredTime = now;
+    }
+  SendState state;
+  state.delivered = m_delivered;
+  state.deliveredTime = m_deliveredTime;
+  state.firstSentTime = m_firstSentTime;
+  state.sendTime = now;
+  uint32_t sz = TcpSocketBase::SendDataPacket (seq, maxSize, withAck);
+  if (sz > 0)
+    {
+      m_sendStates[seq] = state;
+    }
+  return sz;
+}
+
+/** New ACK (up to seqnum seq) received. Update the model and call TcpSocketBase::NewAck() */
+void
+TcpBbr::NewAck (const SequenceNumber32& seq)
+{
+  NS_LOG_FUNCTION (this << seq);
+  NS_LOG_LOGIC ("TcpBbr received ACK for seq " << seq <<
+                " cwnd " << m_cWnd <<
+                " pacing rate " << m_pacingRate);
+
+  uint32_t delivered = 0;
+  if (seq > m_txBuffer.HeadSequence ())
+    {
+      UpdateDelivered (seq);
+      delivered = seq - m_txBuffer.HeadSequence ();
+      SampleRate (seq - 1);
+    }
+  UpdateModel (delivered);
+
+  if (m_inFastRec && seq < m_recover)
+    { // Partial ACK: the next hole is lost too
+      TcpSocketBase::NewAck (seq);
+      if (m_sackPermitted)
+        {
+          SendRecoveryData (m_retxThresh);
+        }
+      else
+        {
+          DoRetransmit ();
+        }
+    }
+  else
+    {
+      if (m_inFastRec)
+        { // Full ACK: back to the cwnd of the model
+          m_inFastRec = false;
+          m_cWnd = std::max (m_cWnd.Get (), m_priorCWnd);
+          NS_LOG_INFO ("Received full ACK. Leaving fast recovery with cwnd set to " << m_cWnd);
+        }
+      TcpSocketBase::NewAck (seq);
+    }
+
+  // Forget the segments ACKed
+  while (!m_sendStates.empty () && m_sendStates.begin ()->first < m_txBuffer.HeadSequence ())
+    {
+      m_sendStates.erase (m_sendStates.begin ());
+    }
+  m_lastSacked = m_txBuffer.SackedBytes ();
+}
+
+/** Retransmit the lost data as TcpNewReno, without reducing cwnd */
+void
+TcpBbr::DupAck (const TcpHeader& t, uint32_t count)
+{
+  NS_LOG_FUNCTION (this << count);
+  // The SACK blocks delivered data as well
+  uint32_t delivered = 0;
+  if (m_txBuffer.SackedBytes () > m_lastSacked)
+    {
+      delivered = m_txBuffer.SackedBytes () - m_lastSacked;
+      UpdateDelivered (m_txBuffer.HeadSequence ());
+      SampleRate (m_txBuffer.HighestSacked () - 1);
+    }
+  m_lastSacked = m_txBuffer.SackedBytes ();
+  UpdateModel (delivered);
+
+  if (!m_inFastRec && m_sackPermitted
+      && (count == m_retxThresh || IsLost (m_txBuffer.HeadSequence (), m_retxThresh)))
+    { // Triple dupack, or the SACK blocks tell the head is lost: enter the
+      // loss recovery of RFC6675 sec.5
+      m_recover = m_highTxMark;
+      m_inFastRec = true;
+      m_priorCWnd = m_cWnd;
+      m_highRxt = m_txBuffer.HeadSequence ();
+      NS_LOG_INFO ("Dupack " << count << ". Enter SACK recovery mode with cwnd " << m_cWnd <<
+                   " at fast recovery seqnum " << m_recover);
+      RetransmitHole (m_txBuffer.HeadSequence ());
+      SendRecoveryData (m_retxThresh);
+    }
+  else if (count == m_retxThresh && !m_inFastRec)
+    { // triple duplicate ack triggers fast retransmit
+      m_recover = m_highTxMark;
+      m_inFastRec = true;
+      m_priorCWnd = m_cWnd;
+      NS_LOG_INFO ("Triple dupack. Enter fast recovery mode with cwnd " << m_cWnd <<
+                   " at fast recovery seqnum " << m_recover);
+      DoRetransmit ();
+    }
+  else if (m_inFastRec && m_sackPermitted)
+    { // Each dupack SACKed data which left the network
+      SendRecoveryData (m_retxThresh);
+    }
+}
+
+/** Retransmit timeout */
+void
+TcpBbr::Retransmit (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_LOG_LOGIC (this << " ReTxTimeout Expired at time " << Simulator::Now ().GetSeconds ());
+  m_inFastRec = false;
+
+  // If erroneous timeout in closed/timed-wait state, just return
+  if (m_state == CLOSED || m_state == TIME_WAIT) return;
+  // If all data are received (non-closing socket and nothing to send), just return
+  if (m_state <= ESTABLISHED && m_txBuffer.HeadSequence () >= m_highTxMark) return;
+
+  // Upon RTO, restart from 1*MSS; the model grows cwnd back with the ACKs
+  m_cWnd = m_segmentSize;
+  m_lastSacked = m_txBuffer.SackedBytes ();
+  m_nextTxSequence = m_txBuffer.HeadSequence (); // Restart from highest Ack
+  NS_LOG_INFO ("RTO. Reset cwnd to " << m_cWnd << ", restart from seqnum " << m_nextTxSequence);
+  m_rtt->IncreaseMultiplier ();             // Double the next RTO
+  DoRetransmit ();                          // Retransmit the packet
+}
+
+/** Count the bytes delivered by an ACK up to seq: the ones SACKed since the
+    last ACK, and the ones ACKed which were not SACKed before */
+void
+TcpBbr::UpdateDelivered (SequenceNumber32 const& seq)
+{
+  SequenceNumber32 head = m_txBuffer.HeadSequence ();
+  uint32_t sacked = m_txBuffer.SackedBytes ();
+  if (sacked > m_lastSacked)
+    {
+      m_delivered += sacked - m_lastSacked;
+    }
+  if (seq > head)
+    {
+      m_delivered += (seq - head) - m_txBuffer.SackedBytes (head, seq);
+    }
+}
+
+/** Take a delivery rate sample, from the delivery state when the segment
+    holding last was sent (draft-cheng-iccrg-delivery-rate-estimation) */
+void
+TcpBbr::SampleRate (SequenceNumber32 const& last)
+{
+  NS_LOG_FUNCTION (this << last);
+  std::map<SequenceNumber32, SendState>::const_iterator i = m_sendStates.upper_bound (last);
+  if (i == m_sendStates.begin ())
+    {
+      return;
+    }
+  --i;
+  const SendState &p = i->second;
+  Time now = Simulator::Now ();
+  m_deliveredTime = now;
+  m_firstSentTime = p.sendTime;
+
+  // A round ends when the data sent at its start is delivered
+  if (p.delivered >= m_nextRoundDelivered)
+    {
+      m_nextRoundDelivered = m_delivered;
+      m_roundCount++;
+      m_roundStart = true;
+    }
+
+  // The rate is over the longest of the send and ACK intervals
+  Time interval = std::max (p.sendTime - p.firstSentTime, now - p.deliveredTime);
+  uint64_t bytes = m_delivered - p.delivered;
+  if (!interval.IsStrictlyPositive () || bytes == 0
+      || (m_rtProp.IsStrictlyPositive () && interval < m_rtProp))
+    {
+      return;
+    }
+  uint64_t rate = static_cast<uint64_t> (bytes * 8 / interval.GetSeconds ());
+
+  // Windowed maximum over the rounds: a rate hides the older, lower ones
+  while (!m_bandwidth.empty () && m_bandwidth.back ().second <= rate)
+    {
+      m_bandwidth.pop_back ();
+    }
+  m_bandwidth.push_back (std::make_pair (m_roundCount, rate));
+  while (m_bandwidth.front ().first + m_bandwidthWindow <= m_roundCount)
+    {
+      m_bandwidth.pop_front ();
+    }
+  NS_LOG_LOGIC ("Delivery rate " << rate << "bps, bottleneck bandwidth " << BtlBw () << "bps");
+}
+
+uint64_t
+TcpBbr::BtlBw (void) const
+{
+  return m_bandwidth.empty () ? 0 : m_bandwidth.front ().second;
+}
+
+uint32_t
+TcpBbr::Bdp (double gain) const
+{
+  return static_cast<uint32_t> (gain * BtlBw () * m_rtProp.GetSeconds () / 8);
+}
+
+/** Update the propagation time and the state, then derive the pacing rate
+    and cwnd from the model */
+void
+TcpBbr::UpdateModel (uint32_t acked)
+{
+  NS_LOG_FUNCTION (this << acked);
+  Time now = Simulator::Now ();
+  bool rtPropExpired = m_rtProp.IsStrictlyPositive () && now > m_rtPropStamp + m_rtPropWindow;
+  Time rtt = m_lastRtt;
+  if (rtt.IsStrictlyPositive () && (m_rtProp.IsZero () || rtt <= m_rtProp || rtPropExpired))
+    {
+      m_rtProp = rtt;
+      m_rtPropStamp = now;
+    }
+
+  CheckFullPipe ();
+  if (m_mode == STARTUP && m_filledPipe)
+    {
+      m_mode = DRAIN;
+      m_pacingGain = 1 / m_highGain;
+      m_cWndGain = m_highGain;
+      NS_LOG_INFO ("BBR: enter DRAIN with bandwidth " << BtlBw () << "bps");
+    }
+  if (m_mode == DRAIN && BytesInFlight () <= Bdp (1.0))
+    {
+      EnterProbeBw ();
+    }
+  if (m_mode == PROBE_BW)
+    {
+      AdvanceCyclePhase ();
+    }
+  if (m_mode != PROBE_RTT && rtPropExpired)
+    {
+      m_mode = PROBE_RTT;
+      m_pacingGain = 1;
+      m_cWndGain = 1;
+      m_priorCWnd = m_cWnd;
+      m_probeRttDone = Seconds (0);
+      NS_LOG_INFO ("BBR: enter PROBE_RTT");
+    }
+  if (m_mode == PROBE_RTT)
+    {
+      CheckProbeRtt ();
+    }
+
+  // Pacing rate: only growing in STARTUP, not to lose the rate of a round
+  // which was not limited by the network
+  uint64_t bw = BtlBw ();
+  if (bw > 0)
+    {
+      uint64_t rate = static_cast<uint64_t> (m_pacingGain * bw);
+      if (m_filledPipe || rate > m_pacingRate.GetBitRate ())
+        {
+          m_pacingRate = DataRate (rate);
+        }
+    }
+  else if (m_rtProp.IsStrictlyPositive ())
+    {
+      m_pacingRate = DataRate (static_cast<uint64_t> (m_highGain * m_cWnd.Get () * 8 / m_rtProp.GetSeconds ()));
+    }
+
+  // cwnd: grow with the ACKs up to the gain times the BDP
+  uint32_t target = Bdp (m_cWndGain) + 3 * m_segmentSize;
+  if (bw == 0 || m_rtProp.IsZero ())
+    {
+      m_cWnd += acked;
+    }
+  else if (m_filledPipe)
+    {
+      m_cWnd = std::min (m_cWnd.Get () + acked, target);
+    }
+  else if (m_cWnd < target || m_delivered < m_initialCWnd * m_segmentSize)
+    {
+      m_cWnd += acked;
+    }
+  m_cWnd = std::max (m_cWnd.Get (), 4 * m_segmentSize);
+  if (m_mode == PROBE_RTT)
+    {
+      m_cWnd = std::min (m_cWnd.Get (), 4 * m_segmentSize);
+    }
+  m_roundStart = false;
+}
+
+/** STARTUP found the bandwidth when three rounds did not grow it by 25% */
+void
+TcpBbr::CheckFullPipe (void)
+{
+  if (m_filledPipe || !m_roundStart || BtlBw () == 0)
+    {
+      return;
+    }
+  if (BtlBw () >= m_fullBw * 1.25)
+    {
+      m_fullBw = BtlBw ();
+      m_fullBwCount = 0;
+      return;
+    }
+  if (++m_fullBwCount >= 3)
+    {
+      m_filledPipe = true;
+    }
+}
+
+/** Stay in PROBE_RTT for ProbeRttDuration and a round with at most 4
+    segments in flight, then resume with the new propagation time */
+void
+TcpBbr::CheckProbeRtt (void)
+{
+  Time now = Simulator::Now ();
+  if (m_probeRttDone.IsZero ())
+    {
+      if (BytesInFlight () <= 4 * m_segmentSize)
+        {
+          m_probeRttDone = now + m_probeRttDuration;
+          m_probeRttRoundDone = false;
+          m_nextRoundDelivered = m_delivered;
+        }
+      return;
+    }
+  if (m_roundStart)
+    {
+      m_probeRttRoundDone = true;
+    }
+  if (m_probeRttRoundDone && now >= m_probeRttDone)
+    {
+      m_rtPropStamp = now;
+      m_cWnd = std::max (m_cWnd.Get (), m_priorCWnd);
+      if (m_filledPipe)
+        {
+          EnterProbeBw ();
+        }
+      else
+        {
+          m_mode = STARTUP;
+          m_pacingGain = m_highGain;
+          m_cWndGain = m_highGain;
+        }
+      NS_LOG_INFO ("BBR: leave PROBE_RTT with propagation time " << m_rtProp.GetSeconds ());
+    }
+}
+
+/** Each phase lasts a propagation time; the probing one until the
+    data in flight grows, the draining one until the queue is empty */
+void
+TcpBbr::AdvanceCyclePhase (void)
+{
+  Time now = Simulator::Now ();
+  bool fullLength = now - m_cycleStamp > m_rtProp;
+  bool advance = fullLength;
+  if (m_pacingGain > 1)
+    {
+      advance = fullLength && (m_inFastRec || BytesInFlight () >= Bdp (m_pacingGain));
+    }
+  else if (m_pacingGain < 1)
+    {
+      advance = fullLength || BytesInFlight () <= Bdp (1.0);
+    }
+  if (advance)
+    {
+      m_cycleIndex = (m_cycleIndex + 1) % g_cycleLength;
+      m_cycleStamp = now;
+      m_pacingGain = g_pacingGainCycle[m_cycleIndex];
+    }
+}
+
+void
+TcpBbr::EnterProbeBw (void)
+{
+  m_mode = PROBE_BW;
+  m_pacingGain = 1;
+  m_cWndGain = m_cwndGain;
+  // Start in a random cruising phase, so that the flows do not probe together
+  m_cycleIndex = m_random.GetInteger (2, g_cycleLength - 1);
+  m_cycleStamp = Simulator::Now ();
+  NS_LOG_INFO ("BBR: enter PROBE_BW with bandwidth " << BtlBw () << "bps, propagation time " <<
+               m_rtProp.GetSeconds ());
+}
+
+int64_t
+TcpBbr::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_random.SetStream (stream);
+  return 1;
+}
+
+void
+TcpBbr::SetSegSize (uint32_t size)
+{
+  NS_ABORT_MSG_UNLESS (m_state == CLOSED, "TcpBbr::SetSegSize() cannot change segment size after connection started.");
+  m_segmentSize = size;
+}
+
+void
+TcpBbr::SetSSThresh (uint32_t threshold)
+{
+  m_ssThresh = threshold;
+}
+
+uint32_t
+TcpBbr::GetSSThresh (void) const
+{
+  return m_ssThresh;
+}
+
+void
+TcpBbr::SetInitialCwnd (uint32_t cwnd)
+{
+  NS_ABORT_MSG_UNLESS (m_state == CLOSED, "TcpBbr::SetInitialCwnd() cannot change initial cwnd after connection started.");
+  m_initialCWnd = cwnd;
+}
+
+uint32_t
+TcpBbr::GetInitialCwnd (void) const
+{
+  return m_initialCWnd;
+}
+
+void
+TcpBbr::InitializeCwnd (void)
+{
+  m_cWnd = m_initialCWnd * m_segmentSize;
+}
+
+} // namespace ns3
@@ -0,0 +1,161 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TCP_BBR_H
+#define TCP_BBR_H
+
+#include <map>
+#include <deque>
+#include "tcp-socket-base.h"
+#include "ns3/random-variable.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup socket
+ * \ingroup tcp
+ *
+ * \brief An implementation of a stream socket using TCP.
+ *
+ * This class contains a model-based congestion control after BBR: rather
+ * than reacting to the losses, it estimates the bottleneck bandwidth, as
+ * the highest delivery rate over the last rounds, and the round trip
+ * propagation time, as the lowest RTT over the last seconds.  The segments
+ * are paced at a gain times the bandwidth, and cwnd only caps the data in
+ * flight to a gain times the bandwidth-delay product.
+ *
+ * The gains follow the states of BBR: STARTUP doubles the rate each round
+ * until the bandwidth stops growing, DRAIN empties the queue built by
+ * STARTUP, PROBE_BW cycles the pacing gain around 1 to find more bandwidth,
+ * and PROBE_RTT lowers cwnd to 4 segments when the propagation time was not
+ * seen for a while.
+ *
+ * The lost segments are retransmitted as by TcpNewReno, or as in RFC6675
+ * when the peer permits SACK, without reducing cwnd.
+ */
+class TcpBbr : public TcpSocketBase
+{
+public:
+  static TypeId GetTypeId (void);
+  /**
+   * Create an unbound tcp socket.
+   */
+  TcpBbr (void);
+  TcpBbr (const TcpBbr& sock);
+  virtual ~TcpBbr (void);
+
+  // From TcpSocketBase
+  virtual int Connect (const Address &address);
+  virtual int Listen (void);
+
+  /**
+   * Draw the initial phase of the PROBE_BW gain cycle from a fixed stream.
+   * A socket forked by Listen() draws from a stream of its own.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned
+   */
+  int64_t AssignStreams (int64_t stream);
+
+protected:
+  virtual uint32_t Window (void); // Return the max possible number of unacked bytes
+  virtual Ptr<TcpSocketBase> Fork (void); // Call CopyObject<TcpBbr> to clone me
+  virtual uint32_t SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool withAck); // Note the delivery state
+  virtual void NewAck (SequenceNumber32 const& seq); // Update the model and call NewAck() of parent
+  virtual void DupAck (const TcpHeader& t, uint32_t count);  // Retransmit the lost data
+  virtual void Retransmit (void); // Exit fast recovery upon retransmit timeout
+
+  // Implementing ns3::TcpSocket -- Attribute get/set
+  virtual void     SetSegSize (uint32_t size);
+  virtual void     SetSSThresh (uint32_t threshold);
+  virtual uint32_t GetSSThresh (void) const;
+  virtual void     SetInitialCwnd (uint32_t cwnd);
+  virtual uint32_t GetInitialCwnd (void) const;
+
+private:
+  enum BbrMode_t
+  {
+    STARTUP,
+    DRAIN,
+    PROBE_BW,
+    PROBE_RTT
+  };
+  // Delivery state of the connection when a segment was sent
+  struct SendState
+  {
+    uint64_t delivered;     //< Bytes delivered
+    Time     deliveredTime; //< Time of the last delivery
+    Time     firstSentTime; //< Send time of the segment last delivered
+    Time     sendTime;      //< Send time of this segment
+  };
+
+  void InitializeCwnd (void);              // set m_cWnd when connection starts
+  void UpdateDelivered (SequenceNumber32 const& seq); // Count the bytes newly ACKed or SACKed
+  void SampleRate (SequenceNumber32 const& seq); // Take the delivery rate up to the segment at seq
+  void UpdateModel (uint32_t acked);       // Update the estimates, the state, the pacing and cwnd
+  void CheckFullPipe (void);               // Leave STARTUP when the bandwidth stops growing
+  void CheckProbeRtt (void);               // Enter or leave PROBE_RTT
+  void AdvanceCyclePhase (void);           // Next pacing gain of PROBE_BW
+  void EnterProbeBw (void);
+  uint64_t BtlBw (void) const;             // Bottleneck bandwidth, in bit/s
+  uint32_t Bdp (double gain) const;        // Gain times the bandwidth-delay product, in bytes
+
+protected:
+  TracedValue<uint32_t>  m_cWnd;         //< Congestion window
+  uint32_t               m_ssThresh;     //< Slow Start Threshold, unused
+  uint32_t               m_initialCWnd;  //< Initial cWnd value
+  SequenceNumber32       m_recover;      //< Previous highest Tx seqnum for fast recovery
+  uint32_t               m_retxThresh;   //< Fast Retransmit threshold
+  bool                   m_inFastRec;    //< currently in fast recovery
+
+  // BBR parameters
+  double                 m_highGain;        //< Gain of STARTUP
+  double                 m_cwndGain;        //< cwnd gain of PROBE_BW
+  uint32_t               m_bandwidthWindow; //< Rounds of the bandwidth filter
+  Time                   m_rtPropWindow;    //< Length of the propagation time filter
+  Time                   m_probeRttDuration; //< Time spent in PROBE_RTT
+
+  // BBR state
+  BbrMode_t              m_mode;          //< Current state
+  double                 m_pacingGain;    //< Current pacing gain
+  double                 m_cWndGain;      //< Current cwnd gain
+  std::deque<std::pair<uint32_t, uint64_t> > m_bandwidth; //< Decreasing rates of the last rounds
+  Time                   m_rtProp;        //< Propagation time, zero if unknown
+  Time                   m_rtPropStamp;   //< When m_rtProp was last seen
+  uint32_t               m_roundCount;    //< Number of rounds
+  uint64_t               m_nextRoundDelivered; //< Delivered bytes ending the current round
+  bool                   m_roundStart;    //< The last ACK started a round
+  uint64_t               m_fullBw;        //< Bandwidth when STARTUP last grew it
+  uint32_t               m_fullBwCount;   //< Rounds without growth in STARTUP
+  bool                   m_filledPipe;    //< STARTUP found the bandwidth
+  uint32_t               m_cycleIndex;    //< Phase of the PROBE_BW gain cycle
+  Time                   m_cycleStamp;    //< Start of the phase
+  UniformVariable        m_random;        //< Draws the first phase of the cycle
+  Time                   m_probeRttDone;  //< End of PROBE_RTT, zero if not scheduled
+  bool                   m_probeRttRoundDone; //< A round passed in PROBE_RTT
+  uint32_t               m_priorCWnd;     //< cwnd before PROBE_RTT or a timeout
+
+  // Delivery rate estimation
+  uint64_t               m_delivered;     //< Bytes ACKed or SACKed by the peer
+  Time                   m_deliveredTime; //< Time of the last delivery
+  Time                   m_firstSentTime; //< Send time of the segment last delivered
+  uint32_t               m_lastSacked;    //< SACKed bytes after the last ACK
+  std::map<SequenceNumber32, SendState> m_sendStates; //< Delivery state at the send time of the segments in flight
+};
+
+} // namespace ns3
+
+#endif /* TCP_BBR_H */
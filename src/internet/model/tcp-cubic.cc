@@ -0,0 +1,459 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#define NS_LOG_APPEND_CONTEXT \
+  if (m_node) { std::clog << Simulator::Now ().GetSeconds () << " [node " << m_node->GetId () << "] "; }
+
+#include "tcp-cubic.h"
+#include "ns3/log.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/simulator.h"
+#include "ns3/abort.h"
+#include "ns3/node.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include <cmath>
+
+NS_LOG_COMPONENT_DEFINE ("TcpCubic");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (TcpCubic);
+
+TypeId
+TcpCubic::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpCubic")
+    .SetParent<TcpSocketBase> ()
+    .AddConstructor<TcpCubic> ()
+    .AddAttribute ("ReTxThreshold", "Threshold for fast retransmit",
+                   UintegerValue (3),
+                   MakeUintegerAccessor (&TcpCubic::m_retxThresh),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Beta", "Multiplicative decrease factor of the window upon loss",
+                   DoubleValue (0.7),
+                   MakeDoubleAccessor (&TcpCubic::m_beta),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("C", "Scaling factor of the cubic function, in segments per second cubed",
+                   DoubleValue (0.4),
+                   MakeDoubleAccessor (&TcpCubic::m_c),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("FastConvergence", "Lower the window to reach after a loss when the window shrinks",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&TcpCubic::m_fastConvergence),
+                   MakeBooleanChecker ())
+    .AddAttribute ("HyStart", "Leave slow start when the RTT increases (HyStart)",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&TcpCubic::m_hyStart),
+                   MakeBooleanChecker ())
+    .AddAttribute ("HyStartLowWindow", "Lowest cwnd, in segments, at which HyStart leaves slow start",
+                   UintegerValue (16),
+                   MakeUintegerAccessor (&TcpCubic::m_hyStartLowWindow),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("HyStartMinSamples", "Number of RTT samples taken in each round by HyStart",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&TcpCubic::m_hyStartMinSamples),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("HyStartDelayMin", "Lowest increase of the RTT at which HyStart leaves slow start",
+                   TimeValue (MilliSeconds (4)),
+                   MakeTimeAccessor (&TcpCubic::m_hyStartDelayMin),
+                   MakeTimeChecker ())
+    .AddAttribute ("HyStartDelayMax", "Highest increase of the RTT at which HyStart leaves slow start",
+                   TimeValue (MilliSeconds (16)),
+                   MakeTimeAccessor (&TcpCubic::m_hyStartDelayMax),
+                   MakeTimeChecker ())
+    .AddTraceSource ("CongestionWindow",
+                     "The TCP connection's congestion window",
+                     MakeTraceSourceAccessor (&TcpCubic::m_cWnd))
+  ;
+  return tid;
+}
+
+TcpCubic::TcpCubic (void)
+  : m_retxThresh (3), // mute valgrind, actual value set by the attribute system
+    m_inFastRec (false),
+    m_wMax (0),
+    m_lastWMax (0),
+    m_epochStart (Seconds (0)),
+    m_k (0),
+    m_originPoint (0),
+    m_epochCWnd (0),
+    m_delayMin (Seconds (0)),
+    m_hyStartFound (false),
+    m_endSeq (0),
+    m_lastRoundMinRtt (Seconds (0)),
+    m_currRoundMinRtt (Seconds (0)),
+    m_sampleCount (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TcpCubic::TcpCubic (const TcpCubic& sock)
+  : TcpSocketBase (sock),
+    m_cWnd (sock.m_cWnd),
+    m_ssThresh (sock.m_ssThresh),
+    m_initialCWnd (sock.m_initialCWnd),
+    m_retxThresh (sock.m_retxThresh),
+    m_inFastRec (false),
+    m_beta (sock.m_beta),
+    m_c (sock.m_c),
+    m_fastConvergence (sock.m_fastConvergence),
+    m_hyStart (sock.m_hyStart),
+    m_hyStartLowWindow (sock.m_hyStartLowWindow),
+    m_hyStartMinSamples (sock.m_hyStartMinSamples),
+    m_hyStartDelayMin (sock.m_hyStartDelayMin),
+    m_hyStartDelayMax (sock.m_hyStartDelayMax),
+    m_wMax (0),
+    m_lastWMax (0),
+    m_epochStart (Seconds (0)),
+    m_k (0),
+    m_originPoint (0),
+    m_epochCWnd (0),
+    m_delayMin (Seconds (0)),
+    m_hyStartFound (false),
+    m_endSeq (0),
+    m_lastRoundMinRtt (Seconds (0)),
+    m_currRoundMinRtt (Seconds (0)),
+    m_sampleCount (0)
+{
+  NS_LOG_FUNCTION (this);
+  NS_LOG_LOGIC ("Invoked the copy constructor");
+}
+
+TcpCubic::~TcpCubic (void)
+{
+}
+
+/** We initialize m_cWnd from this function, after attributes initialized */
+int
+TcpCubic::Listen (void)
+{
+  NS_LOG_FUNCTION (this);
+  InitializeCwnd ();
+  return TcpSocketBase::Listen ();
+}
+
+/** We initialize m_cWnd from this function, after attributes initialized */
+int
+TcpCubic::Connect (const Address & address)
+{
+  NS_LOG_FUNCTION (this << address);
+  InitializeCwnd ();
+  return TcpSocketBase::Connect (address);
+}
+
+/** Limit the size of in-flight data by cwnd and receiver's rxwin */
+uint32_t
+TcpCubic::Window (void)
+{
+  NS_LOG_FUNCTION (this);
+  return std::min (m_rWnd.Get (), m_cWnd.Get ());
+}
+
+Ptr<TcpSocketBase>
+TcpCubic::Fork (void)
+{
+  return CopyObject<TcpCubic> (this);
+}
+
+/** New ACK (up to seqnum seq) received. Increase cwnd and call TcpSocketBase::NewAck() */
+void
+TcpCubic::NewAck (const SequenceNumber32& seq)
+{
+  NS_LOG_FUNCTION (this << seq);
+  NS_LOG_LOGIC ("TcpCubic received ACK for seq " << seq <<
+                " cwnd " << m_cWnd <<
+                " ssthresh " << m_ssThresh);
+
+  if (m_lastRtt.Get ().IsStrictlyPositive ()
+      && (m_delayMin.IsZero () || m_lastRtt.Get () < m_delayMin))
+    {
+      m_delayMin = m_lastRtt;
+    }
+
+  // Check for exit condition of fast recovery, as TcpNewReno
+  if (m_inFastRec && seq < m_recover)
+    { // Partial ACK
+      if (m_sackPermitted)
+        { // No window to deflate: the pipe shrank with the ACK (RFC6675 sec.5)
+          TcpSocketBase::NewAck (seq);
+          SendRecoveryData (m_retxThresh);
+          return;
+        }
+      // Partial window deflation (RFC2582 sec.3 bullet #5 paragraph 3)
+      m_cWnd -= seq - m_txBuffer.HeadSequence ();
+      m_cWnd += m_segmentSize;  // increase cwnd
+      NS_LOG_INFO ("Partial ACK in fast recovery: cwnd set to " << m_cWnd);
+      TcpSocketBase::NewAck (seq); // update m_nextTxSequence and send new data if allowed by window
+      DoRetransmit (); // Assume the next seq is lost. Retransmit lost packet
+      return;
+    }
+  else if (m_inFastRec && seq >= m_recover)
+    { // Full ACK (RFC2582 sec.3 bullet #5 paragraph 2, option 1)
+      m_cWnd = std::min (m_ssThresh, BytesInFlight () + m_segmentSize);
+      m_inFastRec = false;
+      NS_LOG_INFO ("Received full ACK. Leaving fast recovery with cwnd set to " << m_cWnd);
+    }
+
+  if (m_cWnd < m_ssThresh)
+    { // Slow start mode, add one segSize to cWnd, unless HyStart ends it
+      if (m_hyStart)
+        {
+          HyStartUpdate (seq);
+        }
+      if (m_cWnd < m_ssThresh)
+        {
+          m_cWnd += m_segmentSize;
+          NS_LOG_INFO ("In SlowStart, updated to cwnd " << m_cWnd << " ssthresh " << m_ssThresh);
+        }
+    }
+  else
+    {
+      CubicUpdate ();
+      NS_LOG_INFO ("In CongAvoid, updated to cwnd " << m_cWnd << " ssthresh " << m_ssThresh);
+    }
+
+  // Complete newAck processing
+  TcpSocketBase::NewAck (seq);
+}
+
+/** Grow cwnd towards the cubic function, or the window of a standard TCP if larger (RFC8312 sec.4) */
+void
+TcpCubic::CubicUpdate (void)
+{
+  NS_LOG_FUNCTION (this);
+  Time now = Simulator::Now ();
+  if (m_epochStart.IsZero ())
+    { // First ACK of the epoch: place the plateau of the cubic function
+      m_epochStart = now;
+      m_epochCWnd = m_cWnd;
+      if (m_cWnd < m_wMax)
+        {
+          m_k = std::pow ((m_wMax - m_cWnd.Get ()) / static_cast<double> (m_segmentSize) / m_c, 1.0 / 3.0);
+          m_originPoint = m_wMax;
+        }
+      else
+        {
+          m_k = 0;
+          m_originPoint = m_cWnd;
+        }
+    }
+  // The window expected one RTT later, in segments
+  double t = (now - m_epochStart).GetSeconds ();
+  double offset = t + m_delayMin.GetSeconds () - m_k;
+  double target = m_originPoint / static_cast<double> (m_segmentSize) + m_c * offset * offset * offset;
+  // The window of a standard TCP with the same average (RFC8312 sec.4.2),
+  // from the window at the start of the epoch as in RFC9438
+  if (m_delayMin.IsStrictlyPositive ())
+    {
+      double wEst = m_epochCWnd / static_cast<double> (m_segmentSize)
+        + 3 * (1 - m_beta) / (1 + m_beta) * t / m_delayMin.GetSeconds ();
+      target = std::max (target, wEst);
+    }
+  double cwnd = m_cWnd.Get () / static_cast<double> (m_segmentSize);
+  target = std::min (target, 1.5 * cwnd);
+  if (target > cwnd)
+    { // Increase by (target - cwnd) / cwnd segments for each ACK
+      double adder = (target - cwnd) / cwnd * m_segmentSize;
+      m_cWnd += static_cast<uint32_t> (std::max (1.0, adder));
+    }
+}
+
+/** Start a new epoch from the current cwnd, and lower ssthresh by Beta (RFC8312 sec.4.5 and 4.6) */
+void
+TcpCubic::CubicReduce (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_epochStart = Seconds (0);
+  if (m_fastConvergence && m_cWnd < m_lastWMax)
+    {
+      m_lastWMax = m_cWnd;
+      m_wMax = static_cast<uint32_t> (m_cWnd.Get () * (1 + m_beta) / 2);
+    }
+  else
+    {
+      m_lastWMax = m_cWnd;
+      m_wMax = m_cWnd;
+    }
+  m_ssThresh = std::max (2 * m_segmentSize, static_cast<uint32_t> (m_cWnd.Get () * m_beta));
+}
+
+/** Take the RTT samples of the round, and leave slow start when they grew past the previous round's */
+void
+TcpCubic::HyStartUpdate (SequenceNumber32 const& seq)
+{
+  NS_LOG_FUNCTION (this << seq);
+  if (m_hyStartFound)
+    {
+      return;
+    }
+  if (seq > m_endSeq)
+    { // A new round starts with the data sent from now on
+      m_endSeq = m_highTxMark;
+      if (m_sampleCount >= m_hyStartMinSamples)
+        {
+          m_lastRoundMinRtt = m_currRoundMinRtt;
+        }
+      m_currRoundMinRtt = Seconds (0);
+      m_sampleCount = 0;
+    }
+  Time rtt = m_lastRtt;
+  if (!rtt.IsStrictlyPositive () || m_sampleCount >= m_hyStartMinSamples)
+    {
+      return;
+    }
+  if (m_sampleCount == 0 || rtt < m_currRoundMinRtt)
+    {
+      m_currRoundMinRtt = rtt;
+    }
+  if (++m_sampleCount < m_hyStartMinSamples || m_lastRoundMinRtt.IsZero ()
+      || m_cWnd < m_hyStartLowWindow * m_segmentSize)
+    {
+      return;
+    }
+  // The threshold is an eighth of the RTT, within the bounds
+  Time eta = std::min (std::max (Seconds (m_lastRoundMinRtt.GetSeconds () / 8), m_hyStartDelayMin),
+                       m_hyStartDelayMax);
+  if (m_currRoundMinRtt >= m_lastRoundMinRtt + eta)
+    {
+      m_hyStartFound = true;
+      m_ssThresh = m_cWnd;
+      NS_LOG_INFO ("HyStart: RTT went from " << m_lastRoundMinRtt.GetSeconds () << " to " <<
+                   m_currRoundMinRtt.GetSeconds () << ". Leave slow start with ssthresh " << m_ssThresh);
+    }
+}
+
+void
+TcpCubic::HyStartReset (void)
+{
+  m_hyStartFound = false;
+  m_endSeq = m_highTxMark;
+  m_lastRoundMinRtt = Seconds (0);
+  m_currRoundMinRtt = Seconds (0);
+  m_sampleCount = 0;
+}
+
+/** Cut cwnd by Beta and enter fast recovery mode upon triple dupack */
+void
+TcpCubic::DupAck (const TcpHeader& t, uint32_t count)
+{
+  NS_LOG_FUNCTION (this << count);
+  if (!m_inFastRec && m_sackPermitted
+      && (count == m_retxThresh || IsLost (m_txBuffer.HeadSequence (), m_retxThresh)))
+    { // Triple dupack, or the SACK blocks tell the head is lost: enter the
+      // loss recovery of RFC6675 sec.5
+      CubicReduce ();
+      m_cWnd = m_ssThresh;
+      m_recover = m_highTxMark;
+      m_inFastRec = true;
+      m_highRxt = m_txBuffer.HeadSequence ();
+      NS_LOG_INFO ("Dupack " << count << ". Enter SACK recovery mode. Reset cwnd to " << m_cWnd <<
+                   ", ssthresh to " << m_ssThresh << " at fast recovery seqnum " << m_recover);
+      RetransmitHole (m_txBuffer.HeadSequence ());
+      SendRecoveryData (m_retxThresh);
+    }
+  else if (count == m_retxThresh && !m_inFastRec)
+    { // triple duplicate ack triggers fast retransmit
+      CubicReduce ();
+      m_cWnd = m_ssThresh + 3 * m_segmentSize;
+      m_recover = m_highTxMark;
+      m_inFastRec = true;
+      NS_LOG_INFO ("Triple dupack. Enter fast recovery mode. Reset cwnd to " << m_cWnd <<
+                   ", ssthresh to " << m_ssThresh << " at fast recovery seqnum " << m_recover);
+      DoRetransmit ();
+    }
+  else if (m_inFastRec && m_sackPermitted)
+    { // Each dupack SACKed data which left the network
+      SendRecoveryData (m_retxThresh);
+    }
+  else if (m_inFastRec)
+    { // Increase cwnd for every additional dupack (RFC2582, sec.3 bullet #3)
+      m_cWnd += m_segmentSize;
+      NS_LOG_INFO ("Dupack in fast recovery mode. Increase cwnd to " << m_cWnd);
+      SendPendingData (m_connected);
+    }
+}
+
+/** Retransmit timeout */
+void
+TcpCubic::Retransmit (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_LOG_LOGIC (this << " ReTxTimeout Expired at time " << Simulator::Now ().GetSeconds ());
+  m_inFastRec = false;
+
+  // If erroneous timeout in closed/timed-wait state, just return
+  if (m_state == CLOSED || m_state == TIME_WAIT) return;
+  // If all data are received (non-closing socket and nothing to send), just return
+  if (m_state <= ESTABLISHED && m_txBuffer.HeadSequence () >= m_highTxMark) return;
+
+  // Upon RTO, ssthresh is reduced by Beta and cwnd is set to 1*MSS (RFC8312
+  // sec.4.7), then the lost packet is retransmitted and TCP back to slow start
+  CubicReduce ();
+  m_cWnd = m_segmentSize;
+  HyStartReset ();
+  m_nextTxSequence = m_txBuffer.HeadSequence (); // Restart from highest Ack
+  NS_LOG_INFO ("RTO. Reset cwnd to " << m_cWnd <<
+               ", ssthresh to " << m_ssThresh << ", restart from seqnum " << m_nextTxSequence);
+  m_rtt->IncreaseMultiplier ();             // Double the next RTO
+  DoRetransmit ();                          // Retransmit the packet
+}
+
+void
+TcpCubic::SetSegSize (uint32_t size)
+{
+  NS_ABORT_MSG_UNLESS (m_state == CLOSED, "TcpCubic::SetSegSize() cannot change segment size after connection started.");
+  m_segmentSize = size;
+}
+
+void
+TcpCubic::SetSSThresh (uint32_t threshold)
+{
+  m_ssThresh = threshold;
+}
+
+uint32_t
+TcpCubic::GetSSThresh (void) const
+{
+  return m_ssThresh;
+}
+
+void
+TcpCubic::SetInitialCwnd (uint32_t cwnd)
+{
+  NS_ABORT_MSG_UNLESS (m_state == CLOSED, "TcpCubic::SetInitialCwnd() cannot change initial cwnd after connection started.");
+  m_initialCWnd = cwnd;
+}
+
+uint32_t
+TcpCubic::GetInitialCwnd (void) const
+{
+  return m_initialCWnd;
+}
+
+void
+TcpCubic::InitializeCwnd (void)
+{
+  /*
+   * Initialize congestion window, default to 1 MSS (RFC2001, sec.1) and must
+   * not be larger than 2 MSS (RFC2581, sec.3.1). Both m_initiaCWnd and
+   * m_segmentSize are set by the attribute system in ns3::TcpSocket.
+   */
+  m_cWnd = m_initialCWnd * m_segmentSize;
+}
+
+} // namespace ns3
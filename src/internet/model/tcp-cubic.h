@@ -0,0 +1,112 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TCP_CUBIC_H
+#define TCP_CUBIC_H
+
+#include "tcp-socket-base.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup socket
+ * \ingroup tcp
+ *
+ * \brief An implementation of a stream socket using TCP.
+ *
+ * This class contains the CUBIC congestion control of RFC8312: in
+ * congestion avoidance, the window follows a cubic function of the time
+ * since the last loss, centered on the window at that loss, and it is
+ * reduced by the factor Beta upon loss.  The slow start ends early with
+ * HyStart, when the minimum RTT of a round grows by a fraction of the one
+ * of the previous round, before the queue overflows.
+ *
+ * The loss recovery is the one of TcpNewReno, or the one of RFC6675 when
+ * the peer permits SACK.
+ */
+class TcpCubic : public TcpSocketBase
+{
+public:
+  static TypeId GetTypeId (void);
+  /**
+   * Create an unbound tcp socket.
+   */
+  TcpCubic (void);
+  TcpCubic (const TcpCubic& sock);
+  virtual ~TcpCubic (void);
+
+  // From TcpSocketBase
+  virtual int Connect (const Address &address);
+  virtual int Listen (void);
+
+protected:
+  virtual uint32_t Window (void); // Return the max possible number of unacked bytes
+  virtual Ptr<TcpSocketBase> Fork (void); // Call CopyObject<TcpCubic> to clone me
+  virtual void NewAck (SequenceNumber32 const& seq); // Inc cwnd and call NewAck() of parent
+  virtual void DupAck (const TcpHeader& t, uint32_t count);  // Reduce cwnd and enter fast recovery
+  virtual void Retransmit (void); // Exit fast recovery upon retransmit timeout
+
+  // Implementing ns3::TcpSocket -- Attribute get/set
+  virtual void     SetSegSize (uint32_t size);
+  virtual void     SetSSThresh (uint32_t threshold);
+  virtual uint32_t GetSSThresh (void) const;
+  virtual void     SetInitialCwnd (uint32_t cwnd);
+  virtual uint32_t GetInitialCwnd (void) const;
+private:
+  void InitializeCwnd (void);            // set m_cWnd when connection starts
+  void CubicUpdate (void);               // Increase cwnd in congestion avoidance
+  void CubicReduce (void);               // Remember the window of a loss and reduce ssthresh
+  void HyStartUpdate (SequenceNumber32 const& seq); // Look for the delay increase ending slow start
+  void HyStartReset (void);              // Restart HyStart for a new slow start
+
+protected:
+  TracedValue<uint32_t>  m_cWnd;         //< Congestion window
+  uint32_t               m_ssThresh;     //< Slow Start Threshold
+  uint32_t               m_initialCWnd;  //< Initial cWnd value
+  SequenceNumber32       m_recover;      //< Previous highest Tx seqnum for fast recovery
+  uint32_t               m_retxThresh;   //< Fast Retransmit threshold
+  bool                   m_inFastRec;    //< currently in fast recovery
+
+  // CUBIC parameters
+  double                 m_beta;            //< Multiplicative decrease factor
+  double                 m_c;               //< Cubic scaling factor
+  bool                   m_fastConvergence; //< Release bandwidth to the new flows
+  bool                   m_hyStart;         //< Leave slow start with HyStart
+  uint32_t               m_hyStartLowWindow;  //< Lowest cwnd, in segments, to leave slow start
+  uint32_t               m_hyStartMinSamples; //< Number of RTT samples per round
+  Time                   m_hyStartDelayMin;   //< Lowest delay increase leaving slow start
+  Time                   m_hyStartDelayMax;   //< Highest delay increase leaving slow start
+
+  // CUBIC state
+  uint32_t               m_wMax;         //< Window before the last reduction
+  uint32_t               m_lastWMax;     //< Window before the previous reduction
+  Time                   m_epochStart;   //< Start of the congestion avoidance epoch, zero if none
+  double                 m_k;            //< Time to reach m_wMax again, in seconds
+  uint32_t               m_originPoint;  //< Window at the plateau of the cubic function
+  uint32_t               m_epochCWnd;    //< Window at the start of the epoch
+  Time                   m_delayMin;     //< Lowest RTT seen
+
+  // HyStart state
+  bool                   m_hyStartFound; //< The end of slow start was found
+  SequenceNumber32       m_endSeq;       //< End of the current round
+  Time                   m_lastRoundMinRtt; //< Lowest RTT of the previous round, zero if none
+  Time                   m_currRoundMinRtt; //< Lowest RTT of the current round
+  uint32_t               m_sampleCount;  //< Number of RTT samples in the current round
+};
+
+} // namespace ns3
+
+#endif /* TCP_CUBIC_H */
@@ -20,9 +20,22 @@
 
 #include <stdint.h>
 #include <iostream>
+#include <algorithm>
 #include "tcp-header.h"
 #include "ns3/buffer.h"
 #include "ns3/address-utils.h"
+#include "ns3/assert.h"
+
+namespace {
+
+// the kinds of the options (RFC 793, RFC 1323, RFC 2018)
+const uint8_t OPTION_END = 0;
+const uint8_t OPTION_NOP = 1;
+const uint8_t OPTION_WINDOW_SCALE = 3;
+const uint8_t OPTION_SACK_PERMITTED = 4;
+const uint8_t OPTION_SACK = 5;
+
+} // anonymous namespace
 
 namespace ns3 {
 
@@ -37,6 +50,9 @@ TcpHeader::TcpHeader ()
     m_flags (0),
     m_windowSize (0xffff),
     m_urgentPointer (0),
+    m_hasWindowScale (false),
+    m_windowScale (0),
+    m_sackPermitted (false),
     m_calcChecksum (false),
     m_goodChecksum (true)
 {
@@ -85,6 +101,24 @@ void TcpHeader::SetUrgentPointer (uint16_t urgentPointer)
   m_urgentPointer = urgentPointer;
 }
 
+void TcpHeader::SetWindowScale (uint8_t shift)
+{
+  m_hasWindowScale = true;
+  m_windowScale = std::min (shift, (uint8_t) 14);
+  UpdateLength ();
+}
+void TcpHeader::SetSackPermitted (bool sackPermitted)
+{
+  m_sackPermitted = sackPermitted;
+  UpdateLength ();
+}
+void TcpHeader::SetSackList (const SackList &sackList)
+{
+  NS_ASSERT (sackList.size () <= 4);
+  m_sackList = sackList;
+  UpdateLength ();
+}
+
 uint16_t TcpHeader::GetSourcePort () const
 {
   return m_sourcePort;
@@ -117,6 +151,48 @@ uint16_t TcpHeader::GetUrgentPointer () const
 {
   return m_urgentPointer;
 }
+bool TcpHeader::HasWindowScale (void) const
+{
+  return m_hasWindowScale;
+}
+uint8_t TcpHeader::GetWindowScale (void) const
+{
+  return m_windowScale;
+}
+bool TcpHeader::IsSackPermitted (void) const
+{
+  return m_sackPermitted;
+}
+const TcpHeader::SackList &TcpHeader::GetSackList (void) const
+{
+  return m_sackList;
+}
+
+uint32_t
+TcpHeader::GetOptionsSize (void) const
+{
+  uint32_t size = 0;
+  if (m_sackPermitted)
+    {
+      size += 2;
+    }
+  if (m_hasWindowScale)
+    {
+      size += 3;
+    }
+  if (!m_sackList.empty ())
+    {
+      // two NOPs align the blocks
+      size += 2 + 2 + 8 * m_sackList.size ();
+    }
+  return size;
+}
+
+void
+TcpHeader::UpdateLength (void)
+{
+  m_length = 5 + (GetOptionsSize () + 3) / 4;
+}
 
 void 
 TcpHeader::InitializeChecksum (Ipv4Address source, 
@@ -252,6 +328,18 @@ void TcpHeader::Print (std::ostream &os)  const
       os<<"]";
     }
   os<<" Seq="<<m_sequenceNumber<<" Ack="<<m_ackNumber<<" Win="<<m_windowSize;
+  if (m_sackPermitted)
+    {
+      os<<" SackPermitted";
+    }
+  if (m_hasWindowScale)
+    {
+      os<<" WindowScale="<<(uint32_t)m_windowScale;
+    }
+  for (SackList::const_iterator i = m_sackList.begin (); i != m_sackList.end (); ++i)
+    {
+      os<<" Sack=["<<i->first<<":"<<i->second<<")";
+    }
 }
 uint32_t TcpHeader::GetSerializedSize (void)  const
 {
@@ -269,6 +357,36 @@ void TcpHeader::Serialize (Buffer::Iterator start)  const
   i.WriteHtonU16 (0);
   i.WriteHtonU16 (m_urgentPointer);
 
+  uint32_t optionsSize = GetOptionsSize ();
+  if (m_sackPermitted)
+    {
+      i.WriteU8 (OPTION_SACK_PERMITTED);
+      i.WriteU8 (2);
+    }
+  if (m_hasWindowScale)
+    {
+      i.WriteU8 (OPTION_WINDOW_SCALE);
+      i.WriteU8 (3);
+      i.WriteU8 (m_windowScale);
+    }
+  if (!m_sackList.empty ())
+    {
+      i.WriteU8 (OPTION_NOP);
+      i.WriteU8 (OPTION_NOP);
+      i.WriteU8 (OPTION_SACK);
+      i.WriteU8 (2 + 8 * m_sackList.size ());
+      for (SackList::const_iterator j = m_sackList.begin (); j != m_sackList.end (); ++j)
+        {
+          i.WriteHtonU32 (j->first.GetValue ());
+          i.WriteHtonU32 (j->second.GetValue ());
+        }
+    }
+  // pad up to the header length
+  for (uint32_t j = 20 + optionsSize; j < GetSerializedSize (); j++)
+    {
+      i.WriteU8 (OPTION_END);
+    }
+
   if(m_calcChecksum)
     {
       uint16_t headerChecksum = CalculateHeaderChecksum (start.GetSize ());
@@ -294,6 +412,63 @@ uint32_t TcpHeader::Deserialize (Buffer::Iterator start)
   i.Next (2);
   m_urgentPointer = i.ReadNtohU16 ();
 
+  m_hasWindowScale = false;
+  m_windowScale = 0;
+  m_sackPermitted = false;
+  m_sackList.clear ();
+  uint32_t optionsSize = m_length > 5 ? 4 * m_length - 20 : 0;
+  while (optionsSize > 0)
+    {
+      uint8_t kind = i.ReadU8 ();
+      optionsSize--;
+      if (kind == OPTION_END)
+        {
+          break;
+        }
+      if (kind == OPTION_NOP)
+        {
+          continue;
+        }
+      if (optionsSize == 0)
+        {
+          break;
+        }
+      uint8_t length = i.ReadU8 ();
+      optionsSize--;
+      if (length < 2 || length - 2U > optionsSize)
+        {
+          break; // malformed options
+        }
+      if (kind == OPTION_WINDOW_SCALE && length == 3)
+        {
+          m_hasWindowScale = true;
+          m_windowScale = std::min (i.ReadU8 (), (uint8_t) 14);
+        }
+      else if (kind == OPTION_SACK_PERMITTED && length == 2)
+        {
+          m_sackPermitted = true;
+        }
+      else if (kind == OPTION_SACK && (length - 2) % 8 == 0)
+        {
+          for (uint32_t j = 0; j < (length - 2U) / 8; j++)
+            {
+              SequenceNumber32 left = SequenceNumber32 (i.ReadNtohU32 ());
+              SequenceNumber32 right = SequenceNumber32 (i.ReadNtohU32 ());
+              m_sackList.push_back (SackBlock (left, right));
+            }
+        }
+      else
+        {
+          i.Next (length - 2);
+        }
+      optionsSize -= length - 2;
+    }
+  // the NOPs added before the SACK blocks must not overflow the header
+  while (!m_sackList.empty () && GetOptionsSize () > 4 * m_length - 20U)
+    {
+      m_sackList.pop_back ();
+    }
+
   if(m_calcChecksum)
     {
       uint16_t headerChecksum = CalculateHeaderChecksum (start.GetSize ());
@@ -22,6 +22,8 @@
 #define TCP_HEADER_H
 
 #include <stdint.h>
+#include <list>
+#include <utility>
 #include "ns3/header.h"
 #include "ns3/buffer.h"
 #include "ns3/tcp-socket-factory.h"
@@ -38,6 +40,10 @@ namespace ns3 {
  * This class has fields corresponding to those in a network TCP header
  * (port numbers, sequence and acknowledgement numbers, flags, etc) as well
  * as methods for serialization to and deserialization from a byte buffer.
+ *
+ * The window scale (RFC 1323), SACK-permitted and SACK (RFC 2018) options
+ * are supported; the header length is updated as they are set.  Other
+ * options are skipped when deserializing.
  */
 
 class TcpHeader : public Header 
@@ -119,6 +125,43 @@ public:
    */
   uint16_t GetUrgentPointer () const;
 
+  /**
+   * A block of data received by the peer, from its left edge up to but not
+   * including its right edge
+   */
+  typedef std::pair<SequenceNumber32, SequenceNumber32> SackBlock;
+  typedef std::list<SackBlock> SackList;
+
+  /**
+   * \param shift the shift count of the window scale option, at most 14
+   */
+  void SetWindowScale (uint8_t shift);
+  /**
+   * \return true if this TcpHeader carries the window scale option
+   */
+  bool HasWindowScale (void) const;
+  /**
+   * \return the shift count of the window scale option
+   */
+  uint8_t GetWindowScale (void) const;
+  /**
+   * \param sackPermitted whether this TcpHeader carries the SACK-permitted option
+   */
+  void SetSackPermitted (bool sackPermitted);
+  /**
+   * \return true if this TcpHeader carries the SACK-permitted option
+   */
+  bool IsSackPermitted (void) const;
+  /**
+   * \param sackList the blocks of the SACK option, at most 4, or an empty
+   *        list for no SACK option
+   */
+  void SetSackList (const SackList &sackList);
+  /**
+   * \return the blocks of the SACK option
+   */
+  const SackList &GetSackList (void) const;
+
   /**
    * \param source the ip source to use in the underlying
    *        ip packet.
@@ -158,6 +201,8 @@ public:
 
 private:
   uint16_t CalculateHeaderChecksum (uint16_t size) const;
+  uint32_t GetOptionsSize (void) const;
+  void UpdateLength (void);
   uint16_t m_sourcePort;
   uint16_t m_destinationPort;
   SequenceNumber32 m_sequenceNumber;
@@ -167,6 +212,11 @@ private:
   uint16_t m_windowSize;
   uint16_t m_urgentPointer;
 
+  bool m_hasWindowScale;
+  uint8_t m_windowScale;
+  bool m_sackPermitted;
+  SackList m_sackList;
+
   Address m_source;
   Address m_destination;
   uint8_t m_protocol;
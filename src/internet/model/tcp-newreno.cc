@@ -123,7 +123,14 @@ TcpNewReno::NewAck (const SequenceNumber32& seq)
 
   // Check for exit condition of fast recovery
   if (m_inFastRec && seq < m_recover)
-    { // Partial ACK, partial window deflation (RFC2582 sec.3 bullet #5 paragraph 3)
+    { // Partial ACK
+      if (m_sackPermitted)
+        { // No window to deflate: the pipe shrank with the ACK (RFC6675 sec.5)
+          TcpSocketBase::NewAck (seq);
+          SendRecoveryData (m_retxThresh);
+          return;
+        }
+      // Partial window deflation (RFC2582 sec.3 bullet #5 paragraph 3)
       m_cWnd -= seq - m_txBuffer.HeadSequence ();
       m_cWnd += m_segmentSize;  // increase cwnd
       NS_LOG_INFO ("Partial ACK in fast recovery: cwnd set to " << m_cWnd);
@@ -162,7 +169,21 @@ void
 TcpNewReno::DupAck (const TcpHeader& t, uint32_t count)
 {
   NS_LOG_FUNCTION (this << count);
-  if (count == m_retxThresh && !m_inFastRec)
+  if (!m_inFastRec && m_sackPermitted
+      && (count == m_retxThresh || IsLost (m_txBuffer.HeadSequence (), m_retxThresh)))
+    { // Triple dupack, or the SACK blocks tell the head is lost: enter the
+      // loss recovery of RFC6675 sec.5, where the pipe replaces the inflation
+      m_ssThresh = std::max (2 * m_segmentSize, BytesInFlight () / 2);
+      m_cWnd = m_ssThresh;
+      m_recover = m_highTxMark;
+      m_inFastRec = true;
+      m_highRxt = m_txBuffer.HeadSequence ();
+      NS_LOG_INFO ("Dupack " << count << ". Enter SACK recovery mode. Reset cwnd to " << m_cWnd <<
+                   ", ssthresh to " << m_ssThresh << " at fast recovery seqnum " << m_recover);
+      RetransmitHole (m_txBuffer.HeadSequence ());
+      SendRecoveryData (m_retxThresh);
+    }
+  else if (count == m_retxThresh && !m_inFastRec)
     { // triple duplicate ack triggers fast retransmit (RFC2582 sec.3 bullet #1)
       m_ssThresh = std::max (2 * m_segmentSize, BytesInFlight () / 2);
       m_cWnd = m_ssThresh + 3 * m_segmentSize;
@@ -172,6 +193,10 @@ TcpNewReno::DupAck (const TcpHeader& t, uint32_t count)
                    ", ssthresh to " << m_ssThresh << " at fast recovery seqnum " << m_recover);
       DoRetransmit ();
     }
+  else if (m_inFastRec && m_sackPermitted)
+    { // Each dupack SACKed data which left the network
+      SendRecoveryData (m_retxThresh);
+    }
   else if (m_inFastRec)
     { // Increase cwnd for every additional dupack (RFC2582, sec.3 bullet #3)
       m_cWnd += m_segmentSize;
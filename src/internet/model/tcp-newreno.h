@@ -32,6 +32,8 @@ namespace ns3 {
  * \brief An implementation of a stream socket using TCP.
  *
  * This class contains the NewReno implementation of TCP, as of RFC2582.
+ * When the peer permits SACK, the fast recovery is instead the loss
+ * recovery of RFC6675, driven by the SACK scoreboard of TcpSocketBase.
  */
 class TcpNewReno : public TcpSocketBase
 {
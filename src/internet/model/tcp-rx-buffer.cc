@@ -18,6 +18,7 @@
  * Author: Adrian Sai-wah Tam <adrian.sw.tam@gmail.com>
  */
 
+#include <algorithm>
 #include "ns3/packet.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
@@ -213,9 +214,68 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
     { // Account for the FIN packet
       ++m_nextRxSeq;
     };
+  AddSackBlock (headSeq, tailSeq);
   return true;
 }
 
+void
+TcpRxBuffer::AddSackBlock (SequenceNumber32 head, SequenceNumber32 tail)
+{
+  // Merge the new data with the blocks it touches, then forget those which
+  // nextRxSeq has reached
+  std::map<SequenceNumber32, SequenceNumber32>::iterator i = m_sackBlocks.upper_bound (head);
+  if (i != m_sackBlocks.begin ())
+    {
+      std::map<SequenceNumber32, SequenceNumber32>::iterator prev = i;
+      --prev;
+      if (prev->second >= head)
+        {
+          i = prev;
+        }
+    }
+  while (i != m_sackBlocks.end () && i->first <= tail)
+    {
+      head = std::min (head, i->first);
+      tail = std::max (tail, i->second);
+      m_sackRecent.remove (i->first);
+      m_sackBlocks.erase (i++);
+    }
+  if (tail > m_nextRxSeq)
+    {
+      m_sackBlocks[head] = tail;
+      m_sackRecent.push_front (head);
+      if (m_sackRecent.size () > 4)
+        {
+          m_sackRecent.pop_back ();
+        }
+    }
+  while (!m_sackBlocks.empty () && m_sackBlocks.begin ()->second <= m_nextRxSeq)
+    {
+      m_sackRecent.remove (m_sackBlocks.begin ()->first);
+      m_sackBlocks.erase (m_sackBlocks.begin ());
+    }
+}
+
+TcpHeader::SackList
+TcpRxBuffer::GetSackList (void) const
+{
+  TcpHeader::SackList sackList;
+  for (std::list<SequenceNumber32>::const_iterator i = m_sackRecent.begin (); i != m_sackRecent.end (); ++i)
+    {
+      sackList.push_back (*m_sackBlocks.find (*i));
+    }
+  // Then the highest of the others, if the option has room for them
+  for (std::map<SequenceNumber32, SequenceNumber32>::const_reverse_iterator i = m_sackBlocks.rbegin ();
+       i != m_sackBlocks.rend () && sackList.size () < 4; ++i)
+    {
+      if (std::find (m_sackRecent.begin (), m_sackRecent.end (), i->first) == m_sackRecent.end ())
+        {
+          sackList.push_back (*i);
+        }
+    }
+  return sackList;
+}
+
 Ptr<Packet>
 TcpRxBuffer::Extract (uint32_t maxSize)
 {
@@ -22,6 +22,7 @@
 #define TCP_RX_BUFFER_H
 
 #include <map>
+#include <list>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/sequence-number.h"
@@ -72,6 +73,16 @@ public:
    * The extracted data is going to be forwarded to the application.
    */
   Ptr<Packet> Extract (uint32_t maxSize);
+
+  /**
+   * \returns up to 4 blocks of the data received out of order, to be
+   *          reported in the SACK option: the block of the segment received
+   *          last comes first, as required by RFC 2018, then the other most
+   *          recently updated ones
+   */
+  TcpHeader::SackList GetSackList (void) const;
+private:
+  void AddSackBlock (SequenceNumber32 head, SequenceNumber32 tail);
 public:
   typedef std::map<SequenceNumber32, Ptr<Packet> >::iterator BufIterator;
   TracedValue<SequenceNumber32> m_nextRxSeq; //< Seqnum of the first missing byte in data (RCV.NXT)
@@ -82,6 +93,8 @@ public:
   uint32_t m_availBytes;                     //< Number of bytes available to read, i.e. contiguous block at head
   std::map<SequenceNumber32, Ptr<Packet> > m_data;
   //< Corresponding data (may be null)
+  std::map<SequenceNumber32, SequenceNumber32> m_sackBlocks; //< Contiguous blocks of data after nextRxSeq, by head
+  std::list<SequenceNumber32> m_sackRecent;  //< Heads of the blocks most recently updated, latest first
 };
 
 } //namepsace ns3
@@ -39,6 +39,7 @@
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
 #include "ns3/trace-source-accessor.h"
 #include "tcp-socket-base.h"
 #include "tcp-l4-protocol.h"
@@ -46,6 +47,7 @@
 #include "ipv6-end-point.h"
 #include "ipv6-l3-protocol.h"
 #include "tcp-header.h"
+#include "ipv4-receive-offload.h"
 #include "rtt-estimator.h"
 
 #include <algorithm>
@@ -75,6 +77,14 @@ TcpSocketBase::GetTypeId (void)
                    UintegerValue (65535),
                    MakeUintegerAccessor (&TcpSocketBase::m_maxWinSize),
                    MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("Sack", "Enable the selective acknowledgements (RFC 2018)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_sackEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("WindowScaling", "Enable the window scale option (RFC 1323)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_winScalingEnabled),
+                   MakeBooleanChecker ())
     .AddTraceSource ("RTO",
                      "Retransmission timeout",
                      MakeTraceSourceAccessor (&TcpSocketBase::m_rto))
@@ -119,7 +129,15 @@ TcpSocketBase::TcpSocketBase (void)
     m_connected (false),
     m_segmentSize (0),
     // For attribute initialization consistency (quiet valgrind)
-    m_rWnd (0)
+    m_rWnd (0),
+    m_pacingRate (0),
+    m_sackEnabled (false),
+    m_winScalingEnabled (false),
+    m_sackPermitted (false),
+    m_winScaling (false),
+    m_sndWindShift (0),
+    m_rcvWindShift (0),
+    m_highRxt (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -154,7 +172,15 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
     m_msl (sock.m_msl),
     m_segmentSize (sock.m_segmentSize),
     m_maxWinSize (sock.m_maxWinSize),
-    m_rWnd (sock.m_rWnd)
+    m_rWnd (sock.m_rWnd),
+    m_pacingRate (sock.m_pacingRate),
+    m_sackEnabled (sock.m_sackEnabled),
+    m_winScalingEnabled (sock.m_winScalingEnabled),
+    m_sackPermitted (false), // negotiated again in CompleteFork()
+    m_winScaling (false),
+    m_sndWindShift (0),
+    m_rcvWindShift (0),
+    m_highRxt (0)
 {
   NS_LOG_FUNCTION (this);
   NS_LOG_LOGIC ("Invoked the copy constructor");
@@ -411,6 +437,10 @@ TcpSocketBase::Connect (const Address & address)
   // Re-initialize parameters in case this socket is being reused after CLOSE
   m_rtt->Reset ();
   m_cnCount = m_cnRetries;
+  m_sackPermitted = false;
+  m_winScaling = false;
+  m_sndWindShift = 0;
+  m_rcvWindShift = 0;
 
   // DoConnect() will do state-checking and send a SYN packet
   return DoConnect ();
@@ -790,6 +820,31 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, Ipv4Header header, uint16_t port
   // Peel off TCP header and do validity checking
   TcpHeader tcpHeader;
   packet->RemoveHeader (tcpHeader);
+
+  // The segments coalesced by the receive offload of the interface are
+  // processed one by one, as if they had been received separately
+  ReceiveOffloadTag offloadTag;
+  if (packet->RemovePacketTag (offloadTag))
+    {
+      uint32_t offset = 0;
+      for (uint16_t i = 0; i < offloadTag.GetSegments () && m_endPoint != 0; i++)
+        {
+          uint32_t size = std::min<uint32_t> (offloadTag.GetSegmentSize (), packet->GetSize () - offset);
+          TcpHeader segmentHeader = tcpHeader;
+          segmentHeader.SetSequenceNumber (tcpHeader.GetSequenceNumber () + offset);
+          ProcessSegment (packet->CreateFragment (offset, size), segmentHeader, header, fromAddress, toAddress);
+          offset += size;
+        }
+      return;
+    }
+  ProcessSegment (packet, tcpHeader, header, fromAddress, toAddress);
+}
+
+/** Process a segment received from the IPv4 layer, without its TCP header */
+void
+TcpSocketBase::ProcessSegment (Ptr<Packet> packet, const TcpHeader &tcpHeader, const Ipv4Header &header,
+                               const Address &fromAddress, const Address &toAddress)
+{
   if (tcpHeader.GetFlags () & TcpHeader::ACK)
     {
       EstimateRtt (tcpHeader);
@@ -802,7 +857,8 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, Ipv4Header header, uint16_t port
       NS_LOG_LOGIC (this << " Leaving zerowindow persist state");
       m_persistEvent.Cancel ();
     }
-  m_rWnd = tcpHeader.GetWindowSize ();
+  m_rWnd = (tcpHeader.GetFlags () & TcpHeader::SYN) ? tcpHeader.GetWindowSize ()
+    : tcpHeader.GetWindowSize () << m_sndWindShift; // the window of a SYN is never scaled
 
   // Discard fully out of range data packets
   if (packet->GetSize ()
@@ -897,7 +953,8 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, Ipv6Address saddr, Ipv6Address d
       NS_LOG_LOGIC (this << " Leaving zerowindow persist state");
       m_persistEvent.Cancel ();
     }
-  m_rWnd = tcpHeader.GetWindowSize ();
+  m_rWnd = (tcpHeader.GetFlags () & TcpHeader::SYN) ? tcpHeader.GetWindowSize ()
+    : tcpHeader.GetWindowSize () << m_sndWindShift; // the window of a SYN is never scaled
 
   // Discard fully out of range packets
   if (packet->GetSize ()
@@ -1018,6 +1075,19 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
+  // Record the SACK blocks first, so that the loss recovery sees them
+  if (m_sackPermitted && (tcpHeader.GetFlags () & TcpHeader::ACK))
+    {
+      const TcpHeader::SackList &sackList = tcpHeader.GetSackList ();
+      for (TcpHeader::SackList::const_iterator i = sackList.begin (); i != sackList.end (); ++i)
+        {
+          if (i->first < i->second && i->second <= m_highTxMark)
+            {
+              m_txBuffer.AddSackBlock (i->first, i->second);
+            }
+        }
+    }
+
   // Received ACK. Compare the ACK number against highest unacked seqno
   if (0 == (tcpHeader.GetFlags () & TcpHeader::ACK))
     { // Ignore if no ACK flag
@@ -1519,10 +1589,10 @@ TcpSocketBase::SendEmptyPacket (uint8_t flags)
       header.SetSourcePort (m_endPoint6->GetLocalPort ());
       header.SetDestinationPort (m_endPoint6->GetPeerPort ());
     }
-  header.SetWindowSize (AdvertisedWindowSize ());
+  bool hasSyn = flags & TcpHeader::SYN;
+  header.SetWindowSize (AdvertisedWindowSize (!hasSyn));
   AddOptions (header);
   m_rto = m_rtt->RetransmitTimeout ();
-  bool hasSyn = flags & TcpHeader::SYN;
   bool hasFin = flags & TcpHeader::FIN;
   bool isAck = flags == TcpHeader::ACK;
   if (hasSyn)
@@ -1697,6 +1767,7 @@ TcpSocketBase::CompleteFork (Ptr<Packet> p, const TcpHeader& h,
   NS_LOG_INFO ("LISTEN -> SYN_RCVD");
   m_state = SYN_RCVD;
   m_cnCount = m_cnRetries;
+  ReadOptions (h);
   SetupCallback ();
   // Set the sequence number and send SYN+ACK
   m_rxBuffer.SetNextRxSequence (h.GetSequenceNumber () + SequenceNumber32 (1));
@@ -1808,6 +1879,16 @@ TcpSocketBase::SendPendingData (bool withAck)
   uint32_t nPacketsSent = 0;
   while (m_txBuffer.SizeFromSequence (m_nextTxSequence))
     {
+      // Skip the data SACKed by the receiver, and send no more than the hole
+      uint32_t hole = m_segmentSize;
+      if (m_txBuffer.SackedBytes () > 0)
+        {
+          m_nextTxSequence = m_txBuffer.NextUnsacked (m_nextTxSequence, hole);
+          if (hole == 0)
+            {
+              break;
+            }
+        }
       uint32_t w = AvailableWindow (); // Get available window size
       NS_LOG_LOGIC ("TcpSocketBase " << this << " SendPendingData" <<
                     " w " << w <<
@@ -1836,10 +1917,21 @@ TcpSocketBase::SendPendingData (bool withAck)
           NS_LOG_LOGIC ("Invoking Nagle's algorithm. Wait to send.");
           break;
         }
-      uint32_t s = std::min (w, m_segmentSize);  // Send no more than window
+      // Pacing: wait for the timer of the previous segment
+      if (m_pacingEvent.IsRunning ())
+        {
+          NS_LOG_LOGIC ("Pacing. Wait to send.");
+          break;
+        }
+      uint32_t s = std::min (std::min (w, m_segmentSize), hole);  // Send no more than window
       uint32_t sz = SendDataPacket (m_nextTxSequence, s, withAck);
       nPacketsSent++;                             // Count sent this loop
       m_nextTxSequence += sz;                     // Advance next tx sequence
+      if (m_pacingRate.GetBitRate () > 0)
+        {
+          m_pacingEvent = Simulator::Schedule (Seconds (m_pacingRate.CalculateTxTime (sz)),
+                                               &TcpSocketBase::PacingTimeout, this);
+        }
     }
   NS_LOG_LOGIC ("SendPendingData sent " << nPacketsSent << " packets");
   return (nPacketsSent > 0);
@@ -1877,9 +1969,14 @@ TcpSocketBase::AvailableWindow ()
 }
 
 uint16_t
-TcpSocketBase::AdvertisedWindowSize ()
+TcpSocketBase::AdvertisedWindowSize (bool scale)
 {
-  return std::min (m_rxBuffer.MaxBufferSize () - m_rxBuffer.Size (), (uint32_t)m_maxWinSize);
+  uint32_t w = m_rxBuffer.MaxBufferSize () - m_rxBuffer.Size ();
+  if (scale)
+    {
+      w >>= m_rcvWindShift;
+    }
+  return std::min (w, (uint32_t)m_maxWinSize);
 }
 
 // Receipt of new packet, put into Rx buffer
@@ -2019,6 +2116,8 @@ TcpSocketBase::ReTxTimeout ()
     {
       return;
     }
+  // The receiver may have discarded the data it SACKed (RFC 2018 sec.8)
+  m_txBuffer.ResetSackBlocks ();
 
   Retransmit ();
 }
@@ -2087,6 +2186,13 @@ TcpSocketBase::PersistTimeout ()
   m_persistEvent = Simulator::Schedule (m_persistTimeout, &TcpSocketBase::PersistTimeout, this);
 }
 
+void
+TcpSocketBase::PacingTimeout (void)
+{
+  NS_LOG_FUNCTION (this);
+  SendPendingData (m_connected);
+}
+
 void
 TcpSocketBase::Retransmit ()
 {
@@ -2138,6 +2244,7 @@ TcpSocketBase::CancelAllTimers ()
   m_delAckEvent.Cancel ();
   m_lastAckEvent.Cancel ();
   m_timewaitEvent.Cancel ();
+  m_pacingEvent.Cancel ();
 }
 
 /** Move TCP to Time_Wait state and schedule a transition to Closed state */
@@ -2277,16 +2384,136 @@ TcpSocketBase::GetAllowBroadcast (void) const
   return false;
 }
 
-/** Placeholder function for future extension that reads more from the TCP header */
+/** Negotiate the SACK and window scale options from the SYN of the peer.
+    The listening socket does not negotiate: its fork does in CompleteFork() */
 void
-TcpSocketBase::ReadOptions (const TcpHeader&)
+TcpSocketBase::ReadOptions (const TcpHeader& tcpHeader)
 {
+  if (!(tcpHeader.GetFlags () & TcpHeader::SYN) || (m_state != SYN_SENT && m_state != SYN_RCVD))
+    {
+      return;
+    }
+  m_sackPermitted = m_sackEnabled && tcpHeader.IsSackPermitted ();
+  m_winScaling = m_winScalingEnabled && tcpHeader.HasWindowScale ();
+  // A shift above 14 is used as 14 (RFC 7323, section 2.3)
+  m_sndWindShift = m_winScaling ? std::min<uint8_t> (tcpHeader.GetWindowScale (), 14) : 0;
+  m_rcvWindShift = m_winScaling ? CalculateWScale () : 0;
+  NS_LOG_LOGIC (this << " SACK " << (m_sackPermitted ? "permitted" : "not permitted") <<
+                ", window shifts " << (uint32_t)m_sndWindShift << " sent " << (uint32_t)m_rcvWindShift << " received");
 }
 
-/** Placeholder function for future extension that changes the TCP header */
+/** Offer the options on a SYN, answer those offered by the peer on a
+    SYN+ACK, then report the out of order data in the SACK option */
 void
-TcpSocketBase::AddOptions (TcpHeader&)
+TcpSocketBase::AddOptions (TcpHeader& tcpHeader)
+{
+  if (tcpHeader.GetFlags () & TcpHeader::SYN)
+    {
+      bool isSynAck = tcpHeader.GetFlags () & TcpHeader::ACK;
+      if (m_sackEnabled && (!isSynAck || m_sackPermitted))
+        {
+          tcpHeader.SetSackPermitted (true);
+        }
+      if (m_winScalingEnabled && (!isSynAck || m_winScaling))
+        {
+          tcpHeader.SetWindowScale (CalculateWScale ());
+        }
+    }
+  else if (m_sackPermitted && (tcpHeader.GetFlags () & TcpHeader::ACK))
+    {
+      TcpHeader::SackList sackList = m_rxBuffer.GetSackList ();
+      if (!sackList.empty ())
+        {
+          tcpHeader.SetSackList (sackList);
+        }
+    }
+}
+
+uint8_t
+TcpSocketBase::CalculateWScale (void) const
+{
+  // The smallest shift which lets the whole Rx buffer be advertised
+  uint32_t maxSpace = m_rxBuffer.MaxBufferSize ();
+  uint8_t scale = 0;
+  while (scale < 14 && (maxSpace >> scale) > 65535)
+    {
+      ++scale;
+    }
+  return scale;
+}
+
+/** An unSACKed seqnum is lost once dupThresh discontiguous blocks, or more
+    than (dupThresh - 1) segments, were SACKed above it (RFC 6675 sec.4) */
+bool
+TcpSocketBase::IsLost (SequenceNumber32 seq, uint32_t dupThresh) const
 {
+  return seq < m_txBuffer.LostBoundary (dupThresh, m_segmentSize);
+}
+
+/** The unSACKed bytes not deemed lost, plus those retransmitted (RFC 6675 sec.4) */
+uint32_t
+TcpSocketBase::Pipe (uint32_t dupThresh) const
+{
+  SequenceNumber32 head = m_txBuffer.HeadSequence ();
+  SequenceNumber32 high = std::max (m_highTxMark.Get (), head);
+  SequenceNumber32 lost = m_txBuffer.LostBoundary (dupThresh, m_segmentSize);
+  SequenceNumber32 rxt = std::min (std::max (m_highRxt, head), high);
+  uint32_t sacked = m_txBuffer.SackedBytes ();
+  uint32_t pipe = (high - head) - sacked;
+  // The lost boundary is the head of a block: the blocks above it are few
+  pipe -= (lost - head) - (sacked - m_txBuffer.SackedBytes (lost, high));
+  pipe += (rxt - head) - m_txBuffer.SackedBytes (head, rxt);
+  return pipe;
+}
+
+uint32_t
+TcpSocketBase::RetransmitHole (SequenceNumber32 seq)
+{
+  uint32_t hole;
+  seq = m_txBuffer.NextUnsacked (seq, hole);
+  NS_LOG_LOGIC ("TcpSocketBase " << this << " retxing hole at seq " << seq);
+  uint32_t sz = SendDataPacket (seq, std::min (hole, m_segmentSize), true);
+  m_highRxt = std::max (m_highRxt, seq + sz);
+  return sz;
+}
+
+/** The NextSeg() and the transmission loop of RFC 6675 sec.4 and 5 */
+bool
+TcpSocketBase::SendRecoveryData (uint32_t dupThresh)
+{
+  NS_LOG_FUNCTION (this << dupThresh);
+  uint32_t nPacketsSent = 0;
+  while (Window () >= Pipe (dupThresh) + m_segmentSize)
+    {
+      SequenceNumber32 head = m_txBuffer.HeadSequence ();
+      uint32_t hole;
+      SequenceNumber32 seq = m_txBuffer.NextUnsacked (std::max (m_highRxt, head), hole);
+      if (seq < m_highTxMark && IsLost (seq, dupThresh))
+        { // Rule 1: the first lost hole not retransmitted yet
+          RetransmitHole (seq);
+        }
+      else if (!m_shutdownSend && m_txBuffer.SizeFromSequence (m_highTxMark) > 0
+               && m_highTxMark.Get () + m_segmentSize <= head + m_rWnd.Get ())
+        { // Rule 2: new data, if the receiver has room for it
+          uint32_t sz = SendDataPacket (m_highTxMark, m_segmentSize, true);
+          m_nextTxSequence = std::max (m_nextTxSequence.Get (), m_highTxMark.Get ());
+          if (sz == 0)
+            {
+              break;
+            }
+        }
+      else if (seq < m_txBuffer.HighestSacked ())
+        { // Rule 3: a hole below SACKed data, even if not deemed lost yet
+          RetransmitHole (seq);
+        }
+      else
+        {
+          break;
+        }
+      nPacketsSent++;
+    }
+  NS_LOG_LOGIC ("SendRecoveryData sent " << nPacketsSent << " packets");
+  return nPacketsSent > 0;
 }
 
 } // namespace ns3
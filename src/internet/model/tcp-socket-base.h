@@ -31,6 +31,7 @@
 #include "ns3/ipv4-header.h"
 #include "ns3/ipv4-interface.h"
 #include "ns3/event-id.h"
+#include "ns3/data-rate.h"
 #include "tcp-tx-buffer.h"
 #include "tcp-rx-buffer.h"
 #include "rtt-estimator.h"
@@ -138,8 +139,10 @@ protected:
   void ForwardUp6 (Ptr<Packet> packet, Ipv6Address saddr, Ipv6Address daddr, uint16_t port);
   virtual void DoForwardUp (Ptr<Packet> packet, Ipv4Header header, uint16_t port, Ptr<Ipv4Interface> incomingInterface); //Get a pkt from L3
   virtual void DoForwardUp (Ptr<Packet> packet, Ipv6Address saddr, Ipv6Address daddr, uint16_t port); // Ipv6 version
+  void ProcessSegment (Ptr<Packet> packet, const TcpHeader& tcpHeader, const Ipv4Header& header,
+                       const Address& fromAddress, const Address& toAddress); // Process a segment from L3
   bool SendPendingData (bool withAck = false); // Send as much as the window allows
-  uint32_t SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool withAck); // Send a data packet
+  virtual uint32_t SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool withAck); // Send a data packet
   void SendEmptyPacket (uint8_t flags); // Send a empty packet that carries a flag, e.g. ACK
   void SendRST (void); // Send reset and tear down this socket
   bool OutOfRange (SequenceNumber32 head, SequenceNumber32 tail) const; // Check if a sequence number range is within the rx window
@@ -169,7 +172,7 @@ protected:
   virtual uint32_t BytesInFlight (void);        // Return total bytes in flight
   virtual uint32_t Window (void);               // Return the max possible number of unacked bytes
   virtual uint32_t AvailableWindow (void);      // Return unfilled portion of window
-  virtual uint16_t AdvertisedWindowSize (void); // The amount of Rx window announced to the peer
+  virtual uint16_t AdvertisedWindowSize (bool scale = true); // The amount of Rx window announced to the peer
 
   // Manage data tx/rx
   virtual Ptr<TcpSocketBase> Fork (void) = 0; // Call CopyObject<> to clone me
@@ -183,9 +186,17 @@ protected:
   virtual void DelAckTimeout (void);  // Action upon delay ACK timeout, i.e. send an ACK
   virtual void LastAckTimeout (void); // Timeout at LAST_ACK, close the connection
   virtual void PersistTimeout (void); // Send 1 byte probe to get an updated window size
+  virtual void PacingTimeout (void); // Release the segments held by the pacing
   virtual void DoRetransmit (void); // Retransmit the oldest packet
   virtual void ReadOptions (const TcpHeader&); // Read option from incoming packets
   virtual void AddOptions (TcpHeader&); // Add option to outgoing packets
+  uint8_t CalculateWScale (void) const; // The window scale to offer for the size of the Rx buffer
+
+  // Loss recovery with the SACK scoreboard (RFC 6675), for the daughter classes
+  bool IsLost (SequenceNumber32 seq, uint32_t dupThresh) const; // Whether an unSACKed seqnum is deemed lost
+  uint32_t Pipe (uint32_t dupThresh) const; // Estimate of the bytes outstanding in the network
+  uint32_t RetransmitHole (SequenceNumber32 seq); // Retransmit the unSACKed data at seq, up to one segment
+  bool SendRecoveryData (uint32_t dupThresh); // Send the lost, new, or unSACKed data the pipe allows
 
 protected:
   // Counters and events
@@ -194,6 +205,7 @@ protected:
   EventId           m_delAckEvent;     //< Delayed ACK timeout event
   EventId           m_persistEvent;    //< Persist event: Send 1 byte to probe for a non-zero Rx window
   EventId           m_timewaitEvent;   //< TIME_WAIT expiration event: Move this socket to CLOSED state
+  EventId           m_pacingEvent;     //< Pacing event: Send the next segment
   uint32_t          m_dupAckCount;     //< Dupack counter
   uint32_t          m_delAckCount;     //< Delayed ACK counter
   uint32_t          m_delAckMaxCount;  //< Number of packet to fire an ACK before delay timeout
@@ -235,6 +247,16 @@ protected:
   uint32_t              m_segmentSize; //< Segment size
   uint16_t              m_maxWinSize;  //< Maximum window size to advertise
   TracedValue<uint32_t> m_rWnd;        //< Flow control window at remote side
+  DataRate              m_pacingRate;  //< Rate at which the new segments are sent, 0 not to pace them
+
+  // Options
+  bool                  m_sackEnabled;       //< Offer the SACK option (RFC 2018)
+  bool                  m_winScalingEnabled; //< Offer the window scale option (RFC 1323)
+  bool                  m_sackPermitted;     //< SACK agreed with the peer
+  bool                  m_winScaling;        //< Window scaling agreed with the peer
+  uint8_t               m_sndWindShift;      //< Shift of the windows received from the peer
+  uint8_t               m_rcvWindShift;      //< Shift of the windows advertised to the peer
+  SequenceNumber32      m_highRxt;           //< Highest seqnum retransmitted in loss recovery (HighRxt)
 };
 
 } // namespace ns3
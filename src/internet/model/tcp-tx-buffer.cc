@@ -51,7 +51,7 @@ TcpTxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpTxBuffer::TcpTxBuffer (uint32_t n)
-  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_data (0)
+  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_sackedBytes (0)
 {
 }
 
@@ -105,7 +105,7 @@ TcpTxBuffer::Add (Ptr<Packet> p)
     {
       if (p->GetSize () > 0)
         {
-          m_data.push_back (p);
+          m_data.insert (m_data.end (), std::make_pair (TailSequence (), p));
           m_size += p->GetSize ();
           NS_LOG_LOGIC ("Updated size=" << m_size << ", lastSeq=" << m_firstByteSeq + SequenceNumber32 (m_size));
         }
@@ -141,56 +141,35 @@ TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
       return Create<Packet> (s);
     }
 
-  // Extract data from the buffer and return
-  uint32_t offset = seq - m_firstByteSeq.Get ();
-  uint32_t count = 0;      // Offset of the first byte of a packet in the buffer
-  uint32_t pktSize = 0;
-  bool beginFound = false;
-  int pktCount = 0;
-  Ptr<Packet> outPacket;
-  NS_LOG_LOGIC ("There are " << m_data.size () << " number of packets in buffer");
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+  // Look up the packet holding the first byte
+  BufIterator i = m_data.upper_bound (seq);
+  NS_ASSERT (i != m_data.begin ());
+  --i;
+  uint32_t packetOffset = seq - i->first;
+  uint32_t fragmentLength = i->second->GetSize () - packetOffset;
+  if (fragmentLength >= s)
+    { // Data to be copied falls entirely in this packet
+      return i->second->CreateFragment (packetOffset, s);
+    }
+  // Then append the following packets, or the head of the last one
+  Ptr<Packet> outPacket = i->second->CreateFragment (packetOffset, fragmentLength);
+  uint32_t remaining = s - fragmentLength;
+  for (++i; remaining > 0; ++i)
     {
-      pktCount++;
-      pktSize = (*i)->GetSize ();
-      if (!beginFound)
-        { // Look for first fragment
-          if (count + pktSize > offset)
-            {
-              NS_LOG_LOGIC ("First byte found in packet #" << pktCount << " at buffer offset " << count
-                                                           << ", packet len=" << pktSize);
-              beginFound = true;
-              uint32_t packetOffset = offset - count;
-              uint32_t fragmentLength = count + pktSize - offset;
-              if (fragmentLength >= s)
-                { // Data to be copied falls entirely in this packet
-                  return (*i)->CreateFragment (packetOffset, s);
-                }
-              else
-                { // This packet only fulfills part of the request
-                  outPacket = (*i)->CreateFragment (packetOffset, fragmentLength);
-                }
-              NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-            }
-        }
-      else if (count + pktSize >= offset + s)
-        { // Last packet fragment found
-          NS_LOG_LOGIC ("Last byte found in packet #" << pktCount << " at buffer offset " << count
-                                                      << ", packet len=" << pktSize);
-          uint32_t fragmentLength = offset + s - count;
-          Ptr<Packet> endFragment = (*i)->CreateFragment (0, fragmentLength);
-          outPacket->AddAtEnd (endFragment);
-          NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-          break;
+      NS_ASSERT (i != m_data.end ());
+      uint32_t pktSize = i->second->GetSize ();
+      if (pktSize <= remaining)
+        {
+          outPacket->AddAtEnd (i->second);
+          remaining -= pktSize;
         }
       else
         {
-          NS_LOG_LOGIC ("Appending to output the packet #" << pktCount << " of offset " << count << " len=" << pktSize);
-          outPacket->AddAtEnd (*i);
-          NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
+          outPacket->AddAtEnd (i->second->CreateFragment (0, remaining));
+          remaining = 0;
         }
-      count += pktSize;
     }
+  NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
   NS_ASSERT (outPacket->GetSize () == s);
   return outPacket;
 }
@@ -199,6 +178,17 @@ void
 TcpTxBuffer::SetHeadSequence (const SequenceNumber32& seq)
 {
   NS_LOG_FUNCTION (this << seq);
+  // Data may have been buffered before the connection was set up: index it
+  // from the new head
+  if (!m_data.empty ())
+    {
+      std::map<SequenceNumber32, Ptr<Packet> > data;
+      for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+        {
+          data.insert (data.end (), std::make_pair (seq + (i->first - m_firstByteSeq), i->second));
+        }
+      m_data.swap (data);
+    }
   m_firstByteSeq = seq;
 }
 
@@ -211,40 +201,157 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
   // Cases do not need to scan the buffer
   if (m_firstByteSeq >= seq) return;
 
-  // Scan the buffer and discard packets
-  uint32_t offset = seq - m_firstByteSeq.Get ();  // Number of bytes to remove
-  uint32_t pktSize;
-  NS_LOG_LOGIC ("Offset=" << offset);
-  BufIterator i = m_data.begin ();
-  while (i != m_data.end ())
+  // Drop the packets fully acknowledged; each packet is dropped once, the
+  // one holding seq is kept whole
+  while (!m_data.empty ()
+         && m_data.begin ()->first + SequenceNumber32 (m_data.begin ()->second->GetSize ()) <= seq)
     {
-      if (offset > (*i)->GetSize ())
-        { // This packet is behind the seqnum. Remove this packet from the buffer
-          pktSize = (*i)->GetSize ();
-          m_size -= pktSize;
-          offset -= pktSize;
-          m_firstByteSeq += pktSize;
-          i = m_data.erase (i);
-          NS_LOG_LOGIC ("Removed one packet of size " << pktSize << ", offset=" << offset);
-        }
-      else if (offset > 0)
-        { // Part of the packet is behind the seqnum. Fragment
-          pktSize = (*i)->GetSize () - offset;
-          *i = (*i)->CreateFragment (offset, pktSize);
-          m_size -= offset;
-          m_firstByteSeq += offset;
-          NS_LOG_LOGIC ("Fragmented one packet by size " << offset << ", new size=" << pktSize);
-          break;
-        }
+      NS_LOG_LOGIC ("Removed one packet of size " << m_data.begin ()->second->GetSize ());
+      m_data.erase (m_data.begin ());
     }
+  uint32_t acked = std::min (static_cast<uint32_t> (seq - m_firstByteSeq.Get ()), m_size);
+  m_size -= acked;
   // Catching the case of ACKing a FIN
-  if (m_size == 0)
+  m_firstByteSeq = m_size == 0 ? seq : m_firstByteSeq.Get () + SequenceNumber32 (acked);
+  // Forget the SACK blocks acknowledged by now
+  while (!m_sacked.empty () && m_sacked.begin ()->first < seq)
     {
-      m_firstByteSeq = seq;
+      std::map<SequenceNumber32, SequenceNumber32>::iterator j = m_sacked.begin ();
+      SequenceNumber32 left = j->first;
+      SequenceNumber32 right = j->second;
+      m_sacked.erase (j);
+      if (right <= seq)
+        {
+          m_sackedBytes -= right - left;
+        }
+      else
+        {
+          m_sackedBytes -= seq - left;
+          m_sacked[seq] = right;
+          break;
+        }
     }
   NS_LOG_LOGIC ("size=" << m_size << " headSeq=" << m_firstByteSeq << " maxBuffer=" << m_maxBuffer
-                        <<" numPkts="<< m_data.size ());
+                        << " numPkts=" << m_data.size ());
   NS_ASSERT (m_firstByteSeq == seq);
 }
 
+uint32_t
+TcpTxBuffer::AddSackBlock (const SequenceNumber32& head, const SequenceNumber32& tail)
+{
+  NS_LOG_FUNCTION (this << head << tail);
+  SequenceNumber32 left = std::max (head, m_firstByteSeq.Get ());
+  SequenceNumber32 right = std::min (tail, TailSequence ());
+  if (left >= right)
+    {
+      return 0;
+    }
+  uint32_t sackedBytes = m_sackedBytes;
+  // Merge the block with those it overlaps or touches
+  std::map<SequenceNumber32, SequenceNumber32>::iterator i = m_sacked.upper_bound (left);
+  if (i != m_sacked.begin ())
+    {
+      std::map<SequenceNumber32, SequenceNumber32>::iterator prev = i;
+      --prev;
+      if (prev->second >= left)
+        {
+          i = prev;
+          left = prev->first;
+        }
+    }
+  while (i != m_sacked.end () && i->first <= right)
+    {
+      right = std::max (right, i->second);
+      m_sackedBytes -= i->second - i->first;
+      m_sacked.erase (i++);
+    }
+  m_sacked[left] = right;
+  m_sackedBytes += right - left;
+  NS_LOG_LOGIC ("SACK block [" << left << ":" << right << "), " << m_sacked.size () <<
+                " blocks of " << m_sackedBytes << " bytes");
+  return m_sackedBytes - sackedBytes;
+}
+
+void
+TcpTxBuffer::ResetSackBlocks (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_sacked.clear ();
+  m_sackedBytes = 0;
+}
+
+uint32_t
+TcpTxBuffer::SackedBytes (void) const
+{
+  return m_sackedBytes;
+}
+
+uint32_t
+TcpTxBuffer::SackedBytes (const SequenceNumber32& head, const SequenceNumber32& tail) const
+{
+  uint32_t bytes = 0;
+  std::map<SequenceNumber32, SequenceNumber32>::const_iterator i = m_sacked.upper_bound (head);
+  if (i != m_sacked.begin ())
+    {
+      --i;
+      if (i->second <= head)
+        {
+          ++i;
+        }
+    }
+  for (; i != m_sacked.end () && i->first < tail; ++i)
+    {
+      bytes += std::min (i->second, tail) - std::max (i->first, head);
+    }
+  return bytes;
+}
+
+SequenceNumber32
+TcpTxBuffer::HighestSacked (void) const
+{
+  if (m_sacked.empty ())
+    {
+      return m_firstByteSeq;
+    }
+  return m_sacked.rbegin ()->second;
+}
+
+SequenceNumber32
+TcpTxBuffer::NextUnsacked (const SequenceNumber32& seq, uint32_t &length) const
+{
+  SequenceNumber32 next = seq;
+  std::map<SequenceNumber32, SequenceNumber32>::const_iterator i = m_sacked.upper_bound (seq);
+  if (i != m_sacked.begin ())
+    {
+      std::map<SequenceNumber32, SequenceNumber32>::const_iterator prev = i;
+      --prev;
+      if (prev->second > seq)
+        { // seq was SACKed, skip its block
+          next = prev->second;
+        }
+    }
+  SequenceNumber32 limit = i != m_sacked.end () ? i->first : TailSequence ();
+  length = limit > next ? limit - next : 0;
+  return next;
+}
+
+SequenceNumber32
+TcpTxBuffer::LostBoundary (uint32_t dupThresh, uint32_t segmentSize) const
+{
+  // Only the highest dupThresh blocks at most need to be looked at
+  uint32_t bytes = 0;
+  uint32_t blocks = 0;
+  for (std::map<SequenceNumber32, SequenceNumber32>::const_reverse_iterator i = m_sacked.rbegin ();
+       i != m_sacked.rend (); ++i)
+    {
+      bytes += i->second - i->first;
+      blocks++;
+      if (blocks >= dupThresh || bytes > (dupThresh - 1) * segmentSize)
+        {
+          return i->first;
+        }
+    }
+  return m_firstByteSeq;
+}
+
 } // namepsace ns3
@@ -21,7 +21,7 @@
 #ifndef TCP_TX_BUFFER_H
 #define TCP_TX_BUFFER_H
 
-#include <list>
+#include <map>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/object.h"
@@ -36,6 +36,16 @@ class Packet;
  *
  * \brief class for keeping the data sent by the application to the TCP socket, i.e.
  *        the sending buffer.
+ *
+ * The packets of the application are kept whole, indexed by the sequence
+ * number of their first byte: the packet holding a sequence number is found
+ * in logarithmic time, the segments are fragments of one or a few of them,
+ * and the acknowledged packets are dropped from the head of the index.
+ *
+ * The buffer also keeps the SACK scoreboard: the blocks of its data which the
+ * peer reported as received (RFC 2018), merged into disjoint intervals keyed
+ * by their left edge, so that the loss recovery of RFC 6675 looks them up in
+ * logarithmic time whatever the size of the window.
  */
 class TcpTxBuffer : public Object
 {
@@ -107,13 +117,67 @@ public:
    */
   void DiscardUpTo (const SequenceNumber32& seq);
 
+  /**
+   * Mark the data in [head, tail) as received by the peer.  The part of the
+   * block out of the buffer is ignored.
+   *
+   * \param head The left edge of a SACK block
+   * \param tail The right edge of a SACK block
+   * \return The number of bytes newly SACKed
+   */
+  uint32_t AddSackBlock (const SequenceNumber32& head, const SequenceNumber32& tail);
+
+  /**
+   * Forget all the SACK blocks, e.g. after a retransmission timeout (RFC 2018 sec.8)
+   */
+  void ResetSackBlocks (void);
+
+  /**
+   * Returns the number of bytes SACKed
+   */
+  uint32_t SackedBytes (void) const;
+
+  /**
+   * Returns the number of bytes SACKed in the range [head, tail)
+   */
+  uint32_t SackedBytes (const SequenceNumber32& head, const SequenceNumber32& tail) const;
+
+  /**
+   * Returns the right edge of the highest SACK block, or the head sequence if
+   * there is none
+   */
+  SequenceNumber32 HighestSacked (void) const;
+
+  /**
+   * \param seq A sequence number in the buffer
+   * \param length Set to the number of bytes from the returned sequence number
+   *        up to the next SACK block, or to the tail of the buffer
+   * \return The first sequence number from seq which was not SACKed
+   */
+  SequenceNumber32 NextUnsacked (const SequenceNumber32& seq, uint32_t &length) const;
+
+  /**
+   * The unSACKed bytes below the returned sequence number are deemed lost
+   * (IsLost () of RFC 6675): either dupThresh SACK blocks, or more than
+   * (dupThresh - 1) * segmentSize SACKed bytes are above them.
+   *
+   * \param dupThresh The number of duplicate ACKs which triggers a fast retransmit
+   * \param segmentSize The segment size
+   * \return The sequence number up to which the unSACKed bytes are lost, which
+   *         is the head sequence if none is
+   */
+  SequenceNumber32 LostBoundary (uint32_t dupThresh, uint32_t segmentSize) const;
+
 private:
-  typedef std::list<Ptr<Packet> >::iterator BufIterator;
+  typedef std::map<SequenceNumber32, Ptr<Packet> >::const_iterator BufIterator;
 
   TracedValue<SequenceNumber32> m_firstByteSeq; //< Sequence number of the first byte in data (SND.UNA)
   uint32_t m_size;                              //< Number of data bytes
   uint32_t m_maxBuffer;                         //< Max number of data bytes in buffer (SND.WND)
-  std::list<Ptr<Packet> > m_data;               //< Corresponding data (may be null)
+  std::map<SequenceNumber32, Ptr<Packet> > m_data; //< Corresponding data, by the seqnum of their first byte;
+                                                   //< the first packet may start before m_firstByteSeq
+  std::map<SequenceNumber32, SequenceNumber32> m_sacked; //< SACK blocks, from left to right edge
+  uint32_t m_sackedBytes;                       //< Number of bytes in the SACK blocks
 };
 
 } // namepsace ns3
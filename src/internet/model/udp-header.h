@@ -140,6 +140,12 @@ private:
   bool m_goodChecksum;
 };
 
+template <>
+struct FixedSerializedSize<UdpHeader>
+{
+  static const uint32_t value = 8;
+};
+
 } // namespace ns3
 
 #endif /* UDP_HEADER */
@@ -0,0 +1,168 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/ipv4-end-point.h"
+#include "ns3/ipv4-end-point-demux.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv6-end-point.h"
+#include "ns3/ipv6-end-point-demux.h"
+
+using namespace ns3;
+
+class Ipv4EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxTestCase ();
+private:
+  virtual void DoRun (void);
+  Ipv4EndPointDemux::EndPoints Lookup (Ipv4Address daddr, uint16_t dport, Ipv4Address saddr, uint16_t sport);
+
+  Ipv4EndPointDemux m_demux;
+  Ptr<Ipv4Interface> m_interface;
+};
+
+Ipv4EndPointDemuxTestCase::Ipv4EndPointDemuxTestCase ()
+  : TestCase ("Check the lookups of the Ipv4EndPointDemux as endpoints are connected and removed")
+{
+}
+
+Ipv4EndPointDemux::EndPoints
+Ipv4EndPointDemuxTestCase::Lookup (Ipv4Address daddr, uint16_t dport, Ipv4Address saddr, uint16_t sport)
+{
+  return m_demux.Lookup (daddr, dport, saddr, sport, m_interface);
+}
+
+void
+Ipv4EndPointDemuxTestCase::DoRun (void)
+{
+  m_interface = CreateObject<Ipv4Interface> ();
+  m_interface->SetDevice (CreateObject<SimpleNetDevice> ());
+  m_interface->AddAddress (Ipv4InterfaceAddress ("10.0.0.1", "255.255.255.0"));
+  Ipv4Address local ("10.0.0.1");
+
+  Ipv4EndPoint *listener = m_demux.Allocate (80);
+  Ipv4EndPoint *connection = m_demux.Allocate (local, 80, "10.0.0.2", 1234);
+  NS_TEST_ASSERT_MSG_NE (connection, 0, "Connection not allocated");
+  NS_TEST_EXPECT_MSG_EQ (m_demux.Allocate (local, 80, "10.0.0.2", 1234), 0, "Duplicate connection allocated");
+  NS_TEST_EXPECT_MSG_EQ (m_demux.Allocate (local, 80), 0, "Duplicate address and port allocated");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 80, "10.0.0.2", 1234).front (), connection, "Connection not found");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 80, "10.0.0.3", 1234).front (), listener, "Listener not found");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 81, "10.0.0.2", 1234).empty (), true, "Endpoint found on a free port");
+
+  // the connections of a busy server
+  std::vector<Ipv4EndPoint *> connections;
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      connections.push_back (m_demux.Allocate (local, 80, Ipv4Address (0x0b000000 + i), 1024 + i % 7));
+    }
+  for (uint32_t i = 0; i < connections.size (); i++)
+    {
+      Ipv4EndPointDemux::EndPoints endPoints = Lookup (local, 80, Ipv4Address (0x0b000000 + i), 1024 + i % 7);
+      NS_TEST_ASSERT_MSG_EQ (endPoints.size (), 1, "Wrong number of endpoints found");
+      NS_TEST_ASSERT_MSG_EQ (endPoints.front (), connections[i], "Wrong connection found");
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_demux.LookupLocal (local, 80), true, "Local address and port not used");
+  NS_TEST_EXPECT_MSG_EQ (m_demux.LookupLocal ("10.0.0.5", 80), false, "Other local address used");
+
+  // half of them close, in another order than they were opened
+  for (uint32_t i = 1; i < connections.size (); i += 2)
+    {
+      m_demux.DeAllocate (connections[i]);
+    }
+  for (uint32_t i = 0; i < connections.size (); i++)
+    {
+      Ipv4EndPointDemux::EndPoints endPoints = Lookup (local, 80, Ipv4Address (0x0b000000 + i), 1024 + i % 7);
+      NS_TEST_ASSERT_MSG_EQ (endPoints.size (), 1, "Wrong number of endpoints found");
+      NS_TEST_ASSERT_MSG_EQ (endPoints.front (), (i % 2 == 0 ? connections[i] : listener), "Wrong endpoint found");
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_demux.GetAllEndPoints ().size (), 2 + connections.size () / 2, "Endpoints not removed");
+
+  // an ephemeral port, before and after it connects
+  Ipv4EndPoint *client = m_demux.Allocate ();
+  NS_TEST_ASSERT_MSG_NE (client, 0, "Ephemeral port not allocated");
+  uint16_t port = client->GetLocalPort ();
+  NS_TEST_EXPECT_MSG_EQ (m_demux.LookupPortLocal (port), true, "Ephemeral port not used");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, port, "10.0.0.9", 80).front (), client, "Unconnected client not found");
+  client->SetPeer ("10.0.0.9", 80);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, port, "10.0.0.9", 80).front (), client, "Connected client not found");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, port, "10.0.0.8", 80).empty (), true, "Connected client found from another peer");
+  NS_TEST_EXPECT_MSG_NE (m_demux.Allocate ()->GetLocalPort (), port, "Ephemeral port allocated twice");
+
+  m_demux.DeAllocate (connection);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 80, "10.0.0.2", 1234).front (), listener, "Removed connection found");
+  m_demux.DeAllocate (client);
+  NS_TEST_EXPECT_MSG_EQ (m_demux.LookupPortLocal (port), false, "Ephemeral port still used");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, port, "10.0.0.9", 80).empty (), true, "Removed client found");
+
+  m_interface = 0;
+  Simulator::Destroy ();
+}
+
+class Ipv6EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv6EndPointDemuxTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+Ipv6EndPointDemuxTestCase::Ipv6EndPointDemuxTestCase ()
+  : TestCase ("Check the lookups of the Ipv6EndPointDemux as endpoints are connected and removed")
+{
+}
+
+void
+Ipv6EndPointDemuxTestCase::DoRun (void)
+{
+  Ipv6EndPointDemux demux;
+  Ipv6Address local ("2001::1");
+  Ipv6Address peer ("2001::2");
+
+  Ipv6EndPoint *listener = demux.Allocate (80);
+  Ipv6EndPoint *connection = demux.Allocate (local, 80, peer, 1234);
+  NS_TEST_ASSERT_MSG_NE (connection, 0, "Connection not allocated");
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (local, 80, peer, 1234), 0, "Duplicate connection allocated");
+  NS_TEST_EXPECT_MSG_EQ (demux.Lookup (local, 80, peer, 1234, 0).front (), connection, "Connection not found");
+  NS_TEST_EXPECT_MSG_EQ (demux.Lookup (local, 80, "2001::3", 1234, 0).front (), listener, "Listener not found");
+
+  Ipv6EndPoint *client = demux.Allocate (local);
+  uint16_t port = client->GetLocalPort ();
+  client->SetPeer (peer, 80);
+  NS_TEST_EXPECT_MSG_EQ (demux.Lookup (local, port, peer, 80, 0).front (), client, "Connected client not found");
+  NS_TEST_EXPECT_MSG_EQ (demux.Lookup (local, port, "2001::3", 80, 0).empty (), true, "Connected client found from another peer");
+
+  demux.DeAllocate (connection);
+  NS_TEST_EXPECT_MSG_EQ (demux.Lookup (local, 80, peer, 1234, 0).front (), listener, "Removed connection found");
+  demux.DeAllocate (client);
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (port), false, "Ephemeral port still used");
+}
+
+class EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  EndPointDemuxTestSuite ();
+};
+
+EndPointDemuxTestSuite::EndPointDemuxTestSuite ()
+  : TestSuite ("end-point-demux", UNIT)
+{
+  AddTestCase (new Ipv4EndPointDemuxTestCase);
+  AddTestCase (new Ipv6EndPointDemuxTestCase);
+}
+
+static EndPointDemuxTestSuite g_endPointDemuxTestSuite;
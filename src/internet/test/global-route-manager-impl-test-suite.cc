@@ -26,7 +26,20 @@
 #include "ns3/global-route-manager-impl.h"
 #include "ns3/candidate-queue.h"
 #include "ns3/simulator.h"
+#include "ns3/global-value.h"
+#include "ns3/boolean.h"
+#include "ns3/random-variable.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/global-router-interface.h"
 #include <stdlib.h> // for rand()
+#include <sstream>
+#include <algorithm>
 
 namespace ns3 {
 
@@ -214,6 +227,174 @@ GlobalRouteManagerImplTestCase::DoRun (void)
 }
 
 
+class CandidateQueueTestCase : public TestCase
+{
+public:
+  CandidateQueueTestCase ();
+  virtual void DoRun (void);
+};
+
+CandidateQueueTestCase::CandidateQueueTestCase ()
+  : TestCase ("Check the order of the vertices popped from the CandidateQueue")
+{
+}
+
+void
+CandidateQueueTestCase::DoRun (void)
+{
+  SeedManager::SetSeed (1);
+  UniformVariable random;
+  CandidateQueue candidate;
+  std::vector<SPFVertex *> vertices;
+  for (uint32_t i = 0; i < 200; ++i)
+    {
+      SPFVertex *v = new SPFVertex;
+      v->SetVertexId (Ipv4Address (i + 1));
+      v->SetDistanceFromRoot (random.GetInteger (0, 1000));
+      candidate.Push (v);
+      vertices.push_back (v);
+    }
+  NS_TEST_ASSERT_MSG_EQ (candidate.Size (), 200, "Wrong size");
+  NS_TEST_ASSERT_MSG_EQ (candidate.Find (Ipv4Address (42)), vertices[41], "Vertex not found");
+
+  // decrease the distances of some vertices, as SPFNext does
+  for (uint32_t i = 0; i < vertices.size (); i += 3)
+    {
+      vertices[i]->SetDistanceFromRoot (vertices[i]->GetDistanceFromRoot () / 2);
+      candidate.Update (vertices[i]);
+    }
+
+  uint32_t distance = 0;
+  for (uint32_t i = 0; i < 200; ++i)
+    {
+      SPFVertex *v = candidate.Pop ();
+      NS_TEST_ASSERT_MSG_EQ ((v->GetDistanceFromRoot () >= distance), true, "Vertex popped out of order");
+      NS_TEST_ASSERT_MSG_EQ (candidate.Find (v->GetVertexId ()), 0, "Popped vertex still found");
+      distance = v->GetDistanceFromRoot ();
+      delete v;
+    }
+  NS_TEST_ASSERT_MSG_EQ (candidate.Empty (), true, "Queue not empty");
+}
+
+class IncrementalRecomputationTestCase : public TestCase
+{
+public:
+  IncrementalRecomputationTestCase ();
+  virtual void DoRun (void);
+private:
+  std::vector<std::string> GetRoutes (NodeContainer nodes);
+};
+
+IncrementalRecomputationTestCase::IncrementalRecomputationTestCase ()
+  : TestCase ("Check that the incremental recomputation of the global routes finds all the routes")
+{
+}
+
+std::vector<std::string>
+IncrementalRecomputationTestCase::GetRoutes (NodeContainer nodes)
+{
+  std::vector<std::string> routes;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Ptr<Ipv4GlobalRouting> gr = nodes.Get (i)->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+      for (uint32_t j = 0; j < gr->GetNRoutes (); j++)
+        {
+          std::ostringstream oss;
+          oss << i << " " << *gr->GetRoute (j);
+          routes.push_back (oss.str ());
+        }
+    }
+  std::sort (routes.begin (), routes.end ());
+  return routes;
+}
+
+void
+IncrementalRecomputationTestCase::DoRun (void)
+{
+  SeedManager::SetSeed (2);
+  UniformVariable random;
+  GlobalValue::Bind ("IncrementalRouteRecomputation", BooleanValue (true));
+
+  // a ring of routers, with some chords and a shared link of three
+  // routers.  The metrics are drawn from a large range, as the SPF
+  // calculation does not support equal cost paths through a network.
+  const uint32_t N = 10;
+  NodeContainer nodes;
+  nodes.Create (N);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  std::vector<std::pair<Ptr<Ipv4>, uint32_t> > interfaces;
+  for (uint32_t i = 0; i < N + 4; i++)
+    {
+      NodeContainer link;
+      link.Add (nodes.Get (i % N));
+      link.Add (nodes.Get (i < N ? (i + 1) % N : (i + N / 2) % N));
+      if (i == N + 3)
+        {
+          link.Add (nodes.Get ((i + 3) % N));
+        }
+      Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+      NetDeviceContainer devices;
+      for (uint32_t j = 0; j < link.GetN (); j++)
+        {
+          Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+          device->SetAddress (Mac48Address::Allocate ());
+          device->SetChannel (channel);
+          link.Get (j)->AddDevice (device);
+          devices.Add (device);
+        }
+      address.Assign (devices);
+      address.NewNetwork ();
+      for (uint32_t j = 0; j < devices.GetN (); j++)
+        {
+          Ptr<Ipv4> ipv4 = link.Get (j)->GetObject<Ipv4> ();
+          interfaces.push_back (std::make_pair (ipv4, ipv4->GetInterfaceForDevice (devices.Get (j))));
+          ipv4->SetMetric (interfaces.back ().second, random.GetInteger (1, 60000));
+        }
+    }
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  for (uint32_t step = 0; step < 30; step++)
+    {
+      // one or two changes between the comparisons: mostly metrics, which
+      // are recomputed incrementally, sometimes an interface going down
+      // or up, which recomputes everything
+      for (uint32_t k = random.GetInteger (1, 2); k > 0; k--)
+        {
+          std::pair<Ptr<Ipv4>, uint32_t> interface = interfaces[random.GetInteger (0, interfaces.size () - 1)];
+          if (random.GetValue () < 0.8)
+            {
+              interface.first->SetMetric (interface.second, random.GetInteger (1, 60000));
+            }
+          else if (interface.first->IsUp (interface.second))
+            {
+              interface.first->SetDown (interface.second);
+            }
+          else
+            {
+              interface.first->SetUp (interface.second);
+            }
+        }
+      Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+      std::vector<std::string> incremental = GetRoutes (nodes);
+
+      GlobalRouteManager::DeleteGlobalRoutes ();
+      GlobalRouteManager::BuildGlobalRoutingDatabase ();
+      GlobalRouteManager::InitializeRoutes ();
+      std::vector<std::string> full = GetRoutes (nodes);
+      NS_TEST_ASSERT_MSG_EQ (incremental.size (), full.size (), "Wrong number of routes at step " << step);
+      for (uint32_t i = 0; i < full.size (); i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (incremental[i], full[i], "Wrong route at step " << step);
+        }
+    }
+
+  Simulator::Destroy ();
+  GlobalValue::Bind ("IncrementalRouteRecomputation", BooleanValue (false));
+}
+
 static class GlobalRouteManagerImplTestSuite : public TestSuite
 {
 public:
@@ -221,6 +402,8 @@ public:
     : TestSuite ("global-route-manager-impl", UNIT)
   {
     AddTestCase (new GlobalRouteManagerImplTestCase ());
+    AddTestCase (new CandidateQueueTestCase ());
+    AddTestCase (new IncrementalRecomputationTestCase ());
   }
 } g_globalRoutingManagerImplTestSuite;
 
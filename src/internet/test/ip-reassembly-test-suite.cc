@@ -0,0 +1,192 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ip-reassembly.h"
+
+using namespace ns3;
+
+class IpReassemblyTestCase : public TestCase
+{
+public:
+  IpReassemblyTestCase ();
+private:
+  virtual void DoRun (void);
+  IpReassembly::Key MakeKey (uint32_t identification);
+  Ptr<Packet> CreatePacket (uint32_t size, uint32_t offset);
+  bool CheckBytes (Ptr<Packet> p);
+  bool Add (Ptr<IpReassembly> reassembly, uint32_t identification, uint32_t offset, uint32_t size, bool more);
+  void AddAt (Ptr<IpReassembly> reassembly, uint32_t identification, uint32_t offset, uint32_t size, bool more);
+  void Dropped (Ptr<Packet> header, Ptr<Packet> packet, uint32_t iif, IpReassembly::DropReason reason);
+
+  Ptr<Packet> m_packet;
+  uint32_t m_timeouts;
+  uint32_t m_evictions;
+  uint32_t m_partialSize;
+};
+
+IpReassemblyTestCase::IpReassemblyTestCase ()
+  : TestCase ("Check the reassembly, the expiry and the memory limit of IpReassembly")
+{
+}
+
+IpReassembly::Key
+IpReassemblyTestCase::MakeKey (uint32_t identification)
+{
+  IpReassembly::Key key;
+  key.source = Ipv4Address ("10.0.0.1");
+  key.destination = Ipv4Address ("10.0.0.2");
+  key.identification = identification;
+  key.protocol = 17;
+  return key;
+}
+
+// the bytes of the datagram are their offset modulo 256
+Ptr<Packet>
+IpReassemblyTestCase::CreatePacket (uint32_t size, uint32_t offset)
+{
+  uint8_t buffer[2000];
+  for (uint32_t i = 0; i < size; i++)
+    {
+      buffer[i] = offset + i;
+    }
+  return Create<Packet> (buffer, size);
+}
+
+bool
+IpReassemblyTestCase::CheckBytes (Ptr<Packet> p)
+{
+  uint8_t buffer[4000];
+  p->CopyData (buffer, p->GetSize ());
+  for (uint32_t i = 0; i < p->GetSize (); i++)
+    {
+      if (buffer[i] != static_cast<uint8_t> (i))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+bool
+IpReassemblyTestCase::Add (Ptr<IpReassembly> reassembly, uint32_t identification, uint32_t offset, uint32_t size, bool more)
+{
+  Ptr<Packet> p = CreatePacket (size, offset);
+  Ptr<Packet> header = Create<Packet> (20);
+  bool complete = reassembly->AddFragment (MakeKey (identification), p, offset, more, header, 1);
+  m_packet = complete ? p : 0;
+  return complete;
+}
+
+void
+IpReassemblyTestCase::AddAt (Ptr<IpReassembly> reassembly, uint32_t identification, uint32_t offset, uint32_t size, bool more)
+{
+  Add (reassembly, identification, offset, size, more);
+}
+
+void
+IpReassemblyTestCase::Dropped (Ptr<Packet> header, Ptr<Packet> packet, uint32_t iif, IpReassembly::DropReason reason)
+{
+  if (reason == IpReassembly::DROP_TIMEOUT)
+    {
+      m_timeouts++;
+    }
+  else
+    {
+      m_evictions++;
+    }
+  m_partialSize = packet->GetSize ();
+}
+
+void
+IpReassemblyTestCase::DoRun (void)
+{
+  m_timeouts = 0;
+  m_evictions = 0;
+  m_partialSize = 0;
+
+  Ptr<IpReassembly> reassembly = CreateObject<IpReassembly> ();
+  reassembly->SetDropCallback (MakeCallback (&IpReassemblyTestCase::Dropped, this));
+
+  // out of order, with the last fragment first
+  NS_TEST_EXPECT_MSG_EQ (Add (reassembly, 1, 2000, 500, false), false, "Complete with a hole");
+  NS_TEST_EXPECT_MSG_EQ (Add (reassembly, 1, 1000, 1000, true), false, "Complete with a hole");
+  NS_TEST_EXPECT_MSG_EQ (Add (reassembly, 1, 0, 1000, true), true, "Not complete without a hole");
+  NS_TEST_EXPECT_MSG_EQ (m_packet->GetSize (), 2500, "Wrong size of the datagram");
+  NS_TEST_EXPECT_MSG_EQ (CheckBytes (m_packet), true, "Wrong data of the datagram");
+  NS_TEST_EXPECT_MSG_EQ (reassembly->GetNDatagrams (), 0, "Datagram kept once complete");
+  NS_TEST_EXPECT_MSG_EQ (reassembly->GetMemory (), 0, "Memory kept once complete");
+
+  // overlapping and duplicate fragments fill the holes only
+  NS_TEST_EXPECT_MSG_EQ (Add (reassembly, 2, 0, 800, true), false, "Complete with a hole");
+  NS_TEST_EXPECT_MSG_EQ (Add (reassembly, 2, 1200, 800, true), false, "Complete with a hole");
+  NS_TEST_EXPECT_MSG_EQ (Add (reassembly, 2, 400, 400, true), false, "Complete with a duplicate");
+  NS_TEST_EXPECT_MSG_EQ (reassembly->GetMemory (), 20 + 1600, "Duplicate bytes kept");
+  NS_TEST_EXPECT_MSG_EQ (Add (reassembly, 2, 600, 1000, true), false, "Complete without the last fragment");
+  NS_TEST_EXPECT_MSG_EQ (Add (reassembly, 2, 1800, 400, false), true, "Not complete without a hole");
+  NS_TEST_EXPECT_MSG_EQ (m_packet->GetSize (), 2200, "Wrong size of the overlapping datagram");
+  NS_TEST_EXPECT_MSG_EQ (CheckBytes (m_packet), true, "Wrong data of the overlapping datagram");
+
+  // the datagrams which miss fragments expire together after the timeout
+  reassembly->SetTimeout (Seconds (30));
+  Simulator::Schedule (Seconds (1), &IpReassemblyTestCase::AddAt, this, reassembly, 3, 0, 1000, true);
+  Simulator::Schedule (Seconds (2), &IpReassemblyTestCase::AddAt, this, reassembly, 4, 1000, 1000, false);
+  Simulator::Schedule (Seconds (3), &IpReassemblyTestCase::AddAt, this, reassembly, 5, 1000, 1000, false);
+  Simulator::Schedule (Seconds (4), &IpReassemblyTestCase::AddAt, this, reassembly, 5, 0, 1000, true);
+  Simulator::Stop (Seconds (31.5));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_timeouts, 1, "Wrong number of timeouts after 31.5 s");
+  NS_TEST_EXPECT_MSG_EQ (m_partialSize, 1000, "Wrong partial data of the expired datagram");
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_timeouts, 2, "Wrong number of timeouts after 32.5 s");
+  NS_TEST_EXPECT_MSG_EQ (m_partialSize, 0, "Partial data of a datagram without its start");
+  NS_TEST_EXPECT_MSG_EQ (reassembly->GetNDatagrams (), 0, "Datagrams left after the timeout");
+  Simulator::Destroy ();
+
+  // the oldest datagrams make room for the new ones
+  reassembly->SetMaxMemory (5000);
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      Add (reassembly, 10 + i, 0, 1000, true);
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_evictions, 0, "Eviction below the memory limit");
+  Add (reassembly, 14, 0, 1000, true);
+  NS_TEST_EXPECT_MSG_EQ (m_evictions, 1, "No eviction beyond the memory limit");
+  NS_TEST_EXPECT_MSG_EQ (reassembly->GetNDatagrams (), 4, "Wrong number of datagrams after the eviction");
+  NS_TEST_EXPECT_MSG_EQ ((reassembly->GetMemory () <= 5000), true, "Memory beyond the limit");
+  NS_TEST_EXPECT_MSG_EQ (Add (reassembly, 10, 1000, 10, false), false, "The oldest datagram was not evicted");
+  NS_TEST_EXPECT_MSG_EQ (Add (reassembly, 14, 1000, 10, false), true, "The newest datagram was evicted");
+
+  reassembly->Dispose ();
+  Simulator::Destroy ();
+}
+
+class IpReassemblyTestSuite : public TestSuite
+{
+public:
+  IpReassemblyTestSuite ();
+};
+
+IpReassemblyTestSuite::IpReassemblyTestSuite ()
+  : TestSuite ("ip-reassembly", UNIT)
+{
+  AddTestCase (new IpReassemblyTestCase);
+}
+
+static IpReassemblyTestSuite g_ipReassemblyTestSuite;
@@ -0,0 +1,205 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/boolean.h"
+#include "ns3/packet.h"
+#include "ns3/random-variable.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/global-router-interface.h"
+
+using namespace ns3;
+
+class Ipv4GlobalRoutingEcmpTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingEcmpTestCase ();
+private:
+  virtual void DoRun (void);
+  Ptr<NetDevice> Connect (NodeContainer nodes, Ipv4AddressHelper &address);
+  Ipv4Address Forward (Ptr<Ipv4GlobalRouting> gr, Ptr<NetDevice> idev, uint16_t sport, uint16_t dport);
+  void Forwarded (Ptr<Ipv4Route> route, Ptr<const Packet> p, const Ipv4Header &header);
+  double CheckFlows (Ptr<Ipv4GlobalRouting> gr, Ptr<NetDevice> idev, Ipv4Address gateway);
+
+  Ipv4Address m_destination;
+  Ipv4Address m_gateway;
+};
+
+Ipv4GlobalRoutingEcmpTestCase::Ipv4GlobalRoutingEcmpTestCase ()
+  : TestCase ("Check the weights of the equal cost routes and their choice by the flow hash")
+{
+}
+
+// a link between the nodes, a stub network if there is one node only
+Ptr<NetDevice>
+Ipv4GlobalRoutingEcmpTestCase::Connect (NodeContainer nodes, Ipv4AddressHelper &address)
+{
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetChannel (channel);
+      nodes.Get (i)->AddDevice (device);
+      devices.Add (device);
+    }
+  address.Assign (devices);
+  address.NewNetwork ();
+  return devices.Get (0);
+}
+
+void
+Ipv4GlobalRoutingEcmpTestCase::Forwarded (Ptr<Ipv4Route> route, Ptr<const Packet> p, const Ipv4Header &header)
+{
+  m_gateway = route->GetGateway ();
+}
+
+// the gateway of a UDP packet received by the node of the routing
+Ipv4Address
+Ipv4GlobalRoutingEcmpTestCase::Forward (Ptr<Ipv4GlobalRouting> gr, Ptr<NetDevice> idev, uint16_t sport, uint16_t dport)
+{
+  uint8_t buffer[8] = { static_cast<uint8_t> (sport >> 8), static_cast<uint8_t> (sport & 0xff),
+                        static_cast<uint8_t> (dport >> 8), static_cast<uint8_t> (dport & 0xff) };
+  Ptr<Packet> p = Create<Packet> (buffer, 8);
+  Ipv4Header header;
+  header.SetSource (Ipv4Address ("10.3.1.2"));
+  header.SetDestination (m_destination);
+  header.SetProtocol (17);
+  m_gateway = Ipv4Address ();
+  gr->RouteInput (p, header, idev, MakeCallback (&Ipv4GlobalRoutingEcmpTestCase::Forwarded, this),
+                  Ipv4RoutingProtocol::MulticastForwardCallback (),
+                  Ipv4RoutingProtocol::LocalDeliverCallback (),
+                  Ipv4RoutingProtocol::ErrorCallback ());
+  return m_gateway;
+}
+
+// the share of the flows sent to the gateway, each of them always on the same route
+double
+Ipv4GlobalRoutingEcmpTestCase::CheckFlows (Ptr<Ipv4GlobalRouting> gr, Ptr<NetDevice> idev, Ipv4Address gateway)
+{
+  UniformVariable random;
+  uint32_t n = 3000;
+  uint32_t count = 0;
+  bool consistent = true;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint16_t sport = random.GetInteger (1024, 65535);
+      uint16_t dport = random.GetInteger (1, 1023);
+      Ipv4Address first = Forward (gr, idev, sport, dport);
+      for (uint32_t j = 0; j < 3; j++)
+        {
+          consistent = consistent && Forward (gr, idev, sport, dport) == first;
+        }
+      if (first == gateway)
+        {
+          count++;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (consistent, true, "The packets of a flow took different routes");
+  return static_cast<double> (count) / n;
+}
+
+void
+Ipv4GlobalRoutingEcmpTestCase::DoRun (void)
+{
+  // 0 reaches the stub network of 3 by three paths of equal cost, two
+  // through 1 and one through 2:
+  //
+  //      +- 1 -+- 4 -+
+  //      |     +- 5 -+
+  //  0 --+           +-- 3
+  //      +- 2 --- 6 -+
+  NodeContainer nodes;
+  nodes.Create (7);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.3.1.0", "255.255.255.0");
+  uint32_t links[8][2] = { { 0, 1 }, { 0, 2 }, { 1, 4 }, { 1, 5 }, { 4, 3 }, { 5, 3 }, { 2, 6 }, { 6, 3 } };
+  Ptr<NetDevice> stub = Connect (NodeContainer (nodes.Get (0)), address);
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      Connect (NodeContainer (nodes.Get (links[i][0]), nodes.Get (links[i][1])), address);
+    }
+  Ptr<NetDevice> destination = Connect (NodeContainer (nodes.Get (3)), address);
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  Ptr<Ipv4> ipv4 = nodes.Get (3)->GetObject<Ipv4> ();
+  m_destination = ipv4->GetAddress (ipv4->GetInterfaceForDevice (destination), 0).GetLocal ();
+  Ipv4Address network = m_destination.CombineMask (Ipv4Mask ("255.255.255.0"));
+  // the gateways of 0 towards 1 and 2
+  Ipv4Address gateway1 = nodes.Get (1)->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ();
+  Ipv4Address gateway2 = nodes.Get (2)->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ();
+
+  // the weights count the paths behind each gateway
+  Ptr<Ipv4GlobalRouting> gr = nodes.Get (0)->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+  uint32_t weight1 = 0;
+  uint32_t weight2 = 0;
+  for (uint32_t i = 0; i < gr->GetNRoutes (); i++)
+    {
+      Ipv4RoutingTableEntry *route = gr->GetRoute (i);
+      if (route->IsNetwork () && route->GetDestNetwork () == network)
+        {
+          if (route->GetGateway () == gateway1)
+            {
+              weight1 = gr->GetRouteWeight (i);
+            }
+          else if (route->GetGateway () == gateway2)
+            {
+              weight2 = gr->GetRouteWeight (i);
+            }
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (weight1, 2, "Wrong weight of the route through 1");
+  NS_TEST_EXPECT_MSG_EQ (weight2, 1, "Wrong weight of the route through 2");
+
+  // without ECMP, the first route only
+  double share = CheckFlows (gr, stub, gateway1);
+  NS_TEST_EXPECT_MSG_EQ ((share == 0.0 || share == 1.0), true, "Flows spread without ECMP");
+
+  gr->SetAttribute ("FlowEcmpRouting", BooleanValue (true));
+  share = CheckFlows (gr, stub, gateway1);
+  NS_TEST_EXPECT_MSG_EQ_TOL (share, 0.5, 0.05, "Flows not spread evenly");
+
+  gr->SetAttribute ("WeightedEcmpRouting", BooleanValue (true));
+  share = CheckFlows (gr, stub, gateway1);
+  NS_TEST_EXPECT_MSG_EQ_TOL (share, 2.0 / 3, 0.05, "Flows not spread by the weights");
+
+  Simulator::Destroy ();
+}
+
+class Ipv4GlobalRoutingEcmpTestSuite : public TestSuite
+{
+public:
+  Ipv4GlobalRoutingEcmpTestSuite ();
+};
+
+Ipv4GlobalRoutingEcmpTestSuite::Ipv4GlobalRoutingEcmpTestSuite ()
+  : TestSuite ("ipv4-global-routing-ecmp", UNIT)
+{
+  AddTestCase (new Ipv4GlobalRoutingEcmpTestCase);
+}
+
+static Ipv4GlobalRoutingEcmpTestSuite g_ipv4GlobalRoutingEcmpTestSuite;
@@ -0,0 +1,401 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <algorithm>
+#include <vector>
+#include <utility>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/error-model.h"
+#include "ns3/flow-id-tag.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv4-receive-offload.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/uinteger.h"
+#include "ns3/data-rate.h"
+#include "ns3/internet-stack-helper.h"
+#include <algorithm>
+
+using namespace ns3;
+
+/**
+ * Drop the first transmission of a data segment, and record the segments
+ * received, which are numbered by a FlowIdTag.
+ */
+class OffloadTestErrorModel : public ErrorModel
+{
+public:
+  OffloadTestErrorModel ();
+  bool m_drop;
+  SequenceNumber32 m_dropSeq;
+  bool m_dropped;
+  uint32_t m_count;
+  std::vector<std::pair<Time, SequenceNumber32> > m_acks;
+  // arrival time and end of the data segments
+  std::vector<std::pair<Time, SequenceNumber32> > m_data;
+private:
+  virtual bool DoCorrupt (Ptr<Packet> p);
+  virtual void DoReset (void);
+};
+
+OffloadTestErrorModel::OffloadTestErrorModel ()
+  : m_drop (false),
+    m_dropped (false),
+    m_count (0)
+{
+}
+
+bool
+OffloadTestErrorModel::DoCorrupt (Ptr<Packet> p)
+{
+  Ptr<Packet> copy = p->Copy ();
+  Ipv4Header ipHeader;
+  copy->RemoveHeader (ipHeader);
+  TcpHeader tcpHeader;
+  copy->RemoveHeader (tcpHeader);
+  m_acks.push_back (std::make_pair (Simulator::Now (), tcpHeader.GetAckNumber ()));
+  if (m_drop && !m_dropped && copy->GetSize () > 0 && tcpHeader.GetSequenceNumber () == m_dropSeq)
+    {
+      m_dropped = true;
+      return true;
+    }
+  if (copy->GetSize () > 0)
+    {
+      p->AddPacketTag (FlowIdTag (m_count++));
+      m_data.push_back (std::make_pair (Simulator::Now (), tcpHeader.GetSequenceNumber () + copy->GetSize ()));
+    }
+  return false;
+}
+
+void
+OffloadTestErrorModel::DoReset (void)
+{
+}
+
+/**
+ * A device of a serial link: the packets are sent one after the other at
+ * the DataRate, so that they arrive one at a time, as on a point-to-point
+ * link.
+ */
+class SerialTestNetDevice : public SimpleNetDevice
+{
+public:
+  SerialTestNetDevice ();
+  virtual bool Send (Ptr<Packet> packet, const Address &dest, uint16_t protocolNumber);
+  virtual bool IsPointToPoint (void) const;
+  DataRate m_rate;
+private:
+  void Transmit (Ptr<Packet> packet, Address dest, uint16_t protocolNumber);
+  Time m_busyUntil;
+};
+
+SerialTestNetDevice::SerialTestNetDevice ()
+  : m_rate ("10Mbps")
+{
+}
+
+bool
+SerialTestNetDevice::Send (Ptr<Packet> packet, const Address &dest, uint16_t protocolNumber)
+{
+  Time start = std::max (Simulator::Now (), m_busyUntil);
+  m_busyUntil = start + Seconds (m_rate.CalculateTxTime (packet->GetSize ()));
+  Simulator::Schedule (m_busyUntil - Simulator::Now (), &SerialTestNetDevice::Transmit, this,
+                       packet, dest, protocolNumber);
+  return true;
+}
+
+void
+SerialTestNetDevice::Transmit (Ptr<Packet> packet, Address dest, uint16_t protocolNumber)
+{
+  SimpleNetDevice::Send (packet, dest, protocolNumber);
+}
+
+bool
+SerialTestNetDevice::IsPointToPoint (void) const
+{
+  return true;
+}
+
+class Ipv4ReceiveOffloadTestCase : public TestCase
+{
+public:
+  Ipv4ReceiveOffloadTestCase (std::string name);
+protected:
+  /**
+   * A bulk transfer through a channel of 5 ms, with a segment lost if
+   * loss: through a SimpleChannel, the windows of segments arrive at once
+   * at the server, through a serial link, one after the other.
+   */
+  Ptr<Ipv4ReceiveOffload> Transfer (bool offload, uint32_t maxSize, Time flushTimeout, bool serial, bool loss);
+  void HandleAccept (Ptr<Socket> socket, const Address &from);
+  void HandleRead (Ptr<Socket> socket);
+  void LocalDeliverTrace (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t interface);
+
+  Ptr<OffloadTestErrorModel> m_clientModel;
+  Ptr<OffloadTestErrorModel> m_serverModel;
+  uint32_t m_received;
+  // time and total size of the data read by the server
+  std::vector<std::pair<Time, uint32_t> > m_reads;
+  // numbers of the data segments delivered by the IP layer of the server
+  std::vector<uint32_t> m_delivered;
+  static const uint32_t m_segmentSize = 536;
+  static const uint32_t m_size = 600 * m_segmentSize;
+};
+
+Ipv4ReceiveOffloadTestCase::Ipv4ReceiveOffloadTestCase (std::string name)
+  : TestCase (name),
+    m_received (0)
+{
+}
+
+void
+Ipv4ReceiveOffloadTestCase::HandleAccept (Ptr<Socket> socket, const Address &from)
+{
+  socket->SetRecvCallback (MakeCallback (&Ipv4ReceiveOffloadTestCase::HandleRead, this));
+}
+
+void
+Ipv4ReceiveOffloadTestCase::HandleRead (Ptr<Socket> socket)
+{
+  Ptr<Packet> p;
+  while ((p = socket->Recv ()) != 0)
+    {
+      m_received += p->GetSize ();
+    }
+  m_reads.push_back (std::make_pair (Simulator::Now (), m_received));
+}
+
+void
+Ipv4ReceiveOffloadTestCase::LocalDeliverTrace (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t interface)
+{
+  FlowIdTag tag;
+  if (packet->PeekPacketTag (tag))
+    {
+      m_delivered.push_back (tag.GetFlowId ());
+    }
+}
+
+Ptr<Ipv4ReceiveOffload>
+Ipv4ReceiveOffloadTestCase::Transfer (bool offload, uint32_t maxSize, Time flushTimeout, bool serial, bool loss)
+{
+  m_received = 0;
+  m_reads.clear ();
+  m_delivered.clear ();
+  NodeContainer nodes;
+  nodes.Create (2);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (MilliSeconds (5)));
+  m_clientModel = CreateObject<OffloadTestErrorModel> ();
+  m_serverModel = CreateObject<OffloadTestErrorModel> ();
+  m_serverModel->m_drop = loss;
+  m_serverModel->m_dropSeq = SequenceNumber32 (1 + 100 * m_segmentSize);
+  Ptr<Ipv4ReceiveOffload> receiveOffload;
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<SimpleNetDevice> device;
+      if (serial)
+        {
+          device = CreateObject<SerialTestNetDevice> ();
+        }
+      else
+        {
+          device = CreateObject<SimpleNetDevice> ();
+        }
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetChannel (channel);
+      device->SetReceiveErrorModel (i == 0 ? m_clientModel : m_serverModel);
+      nodes.Get (i)->AddDevice (device);
+      Ptr<Ipv4> ipv4 = nodes.Get (i)->GetObject<Ipv4> ();
+      uint32_t interface = ipv4->AddInterface (device);
+      ipv4->AddAddress (interface, Ipv4InterfaceAddress (Ipv4Address (i == 0 ? "10.0.0.1" : "10.0.0.2"), "255.255.255.0"));
+      ipv4->SetUp (interface);
+      if (i == 1 && offload)
+        {
+          receiveOffload = CreateObject<Ipv4ReceiveOffload> ();
+          receiveOffload->SetAttribute ("MaxSize", UintegerValue (maxSize));
+          receiveOffload->SetAttribute ("FlushTimeout", TimeValue (flushTimeout));
+          nodes.Get (i)->GetObject<Ipv4L3Protocol> ()->GetInterface (interface)->SetReceiveOffload (receiveOffload);
+        }
+    }
+
+  nodes.Get (1)->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext (
+    "LocalDeliver", MakeCallback (&Ipv4ReceiveOffloadTestCase::LocalDeliverTrace, this));
+  Ptr<Socket> server = Socket::CreateSocket (nodes.Get (1), TcpSocketFactory::GetTypeId ());
+  server->Bind (InetSocketAddress (Ipv4Address::GetAny (), 80));
+  server->Listen ();
+  server->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                             MakeCallback (&Ipv4ReceiveOffloadTestCase::HandleAccept, this));
+
+  Ptr<Socket> client = Socket::CreateSocket (nodes.Get (0), TcpSocketFactory::GetTypeId ());
+  client->SetAttribute ("SegmentSize", UintegerValue (m_segmentSize));
+  client->SetAttribute ("SndBufSize", UintegerValue (1 << 22));
+  client->Connect (InetSocketAddress ("10.0.0.2", 80));
+  client->Send (Create<Packet> (m_size));
+  Simulator::Run ();
+  return receiveOffload;
+}
+
+class Ipv4ReceiveOffloadBurstTestCase : public Ipv4ReceiveOffloadTestCase
+{
+public:
+  Ipv4ReceiveOffloadBurstTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4ReceiveOffloadBurstTestCase::Ipv4ReceiveOffloadBurstTestCase ()
+  : Ipv4ReceiveOffloadTestCase ("Check that the segments coalesced by the receive offload are acknowledged as without it")
+{
+}
+
+void
+Ipv4ReceiveOffloadBurstTestCase::DoRun (void)
+{
+  Transfer (false, 0, Seconds (0), false, true);
+  NS_TEST_EXPECT_MSG_EQ (m_received, m_size, "Data not received without offload");
+  std::vector<std::pair<Time, SequenceNumber32> > acks = m_clientModel->m_acks;
+  uint32_t delivered = m_delivered.size ();
+  Simulator::Destroy ();
+
+  // coalescing the whole windows, then at most 4 segments at once
+  uint32_t maxSizes[2] = { 64000, 4 * m_segmentSize };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<Ipv4ReceiveOffload> offload = Transfer (true, maxSizes[i], Seconds (0), false, true);
+      NS_TEST_EXPECT_MSG_EQ (m_received, m_size, "Data not received with offload");
+      NS_TEST_EXPECT_MSG_EQ ((m_clientModel->m_acks == acks), true, "Acknowledgments differ with offload");
+      NS_TEST_EXPECT_MSG_GT (offload->GetNSegments (), 2 * offload->GetNDelivered (), "Segments not coalesced");
+      NS_TEST_EXPECT_MSG_EQ ((offload->GetNDelivered () * 4 >= offload->GetNSegments ()), (i == 1),
+                             "MaxSize not applied");
+      // Each segment is traced as received, with its own tags
+      NS_TEST_EXPECT_MSG_EQ (m_delivered.size (), delivered, "Segments not traced one by one");
+      std::sort (m_delivered.begin (), m_delivered.end ());
+      NS_TEST_EXPECT_MSG_EQ ((std::unique (m_delivered.begin (), m_delivered.end ()) == m_delivered.end ()), true,
+                             "Segments traced with the tags of another");
+      Simulator::Destroy ();
+    }
+}
+
+class Ipv4ReceiveOffloadSerialTestCase : public Ipv4ReceiveOffloadTestCase
+{
+public:
+  Ipv4ReceiveOffloadSerialTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4ReceiveOffloadSerialTestCase::Ipv4ReceiveOffloadSerialTestCase ()
+  : Ipv4ReceiveOffloadTestCase ("Check that the receive offload holds no segment of a point-to-point link without timeout")
+{
+}
+
+void
+Ipv4ReceiveOffloadSerialTestCase::DoRun (void)
+{
+  Transfer (false, 0, Seconds (0), true, true);
+  NS_TEST_EXPECT_MSG_EQ (m_received, m_size, "Data not received without offload");
+  std::vector<std::pair<Time, SequenceNumber32> > acks = m_clientModel->m_acks;
+  std::vector<std::pair<Time, uint32_t> > reads = m_reads;
+  Simulator::Destroy ();
+
+  Ptr<Ipv4ReceiveOffload> offload = Transfer (true, 64000, Seconds (0), true, true);
+  NS_TEST_EXPECT_MSG_EQ (m_received, m_size, "Data not received with offload");
+  NS_TEST_EXPECT_MSG_EQ (offload->GetNSegments (), 0, "Segments held");
+  NS_TEST_EXPECT_MSG_EQ ((m_clientModel->m_acks == acks), true, "Acknowledgments differ with offload");
+  NS_TEST_EXPECT_MSG_EQ ((m_reads == reads), true, "Data read at other times with offload");
+  Simulator::Destroy ();
+}
+
+class Ipv4ReceiveOffloadTimeoutTestCase : public Ipv4ReceiveOffloadTestCase
+{
+public:
+  Ipv4ReceiveOffloadTimeoutTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4ReceiveOffloadTimeoutTestCase::Ipv4ReceiveOffloadTimeoutTestCase ()
+  : Ipv4ReceiveOffloadTestCase ("Check that the receive offload delivers the segments within FlushTimeout")
+{
+}
+
+void
+Ipv4ReceiveOffloadTimeoutTestCase::DoRun (void)
+{
+  // A segment takes 0.46 ms on the link: 4 or 5 segments are coalesced
+  Time timeout = MilliSeconds (2);
+  Ptr<Ipv4ReceiveOffload> offload = Transfer (true, 64000, timeout, true, false);
+  NS_TEST_EXPECT_MSG_EQ (m_received, m_size, "Data not received with offload");
+  NS_TEST_EXPECT_MSG_GT (offload->GetNSegments (), 3 * offload->GetNDelivered (), "Segments not coalesced");
+
+  // Every segment is read by the server after its arrival, at most
+  // FlushTimeout later, and some of them are held.  The segments held
+  // may be retransmitted by the sender: only the first copy counts.
+  const std::vector<std::pair<Time, SequenceNumber32> > &data = m_serverModel->m_data;
+  NS_TEST_ASSERT_MSG_EQ ((data.size () > 0), true, "No segment received");
+  bool held = false;
+  uint32_t j = 0;
+  uint32_t received = 0;
+  for (uint32_t i = 0; i < data.size (); i++)
+    {
+      uint32_t end = data[i].second.GetValue () - 1;
+      if (end <= received)
+        {
+          continue;
+        }
+      received = end;
+      while (j < m_reads.size () && m_reads[j].second < end)
+        {
+          j++;
+        }
+      NS_TEST_ASSERT_MSG_LT (j, m_reads.size (), "Segment " << i << " not read");
+      Time arrival = data[i].first;
+      Time read = m_reads[j].first;
+      NS_TEST_EXPECT_MSG_EQ ((read >= arrival), true, "Segment " << i << " read before its arrival");
+      NS_TEST_EXPECT_MSG_EQ ((read <= arrival + timeout), true, "Segment " << i << " held beyond FlushTimeout");
+      held = held || read > arrival;
+    }
+  NS_TEST_EXPECT_MSG_EQ (held, true, "No segment held");
+  Simulator::Destroy ();
+}
+
+class Ipv4ReceiveOffloadTestSuite : public TestSuite
+{
+public:
+  Ipv4ReceiveOffloadTestSuite ();
+};
+
+Ipv4ReceiveOffloadTestSuite::Ipv4ReceiveOffloadTestSuite ()
+  : TestSuite ("ipv4-receive-offload", UNIT)
+{
+  AddTestCase (new Ipv4ReceiveOffloadBurstTestCase);
+  AddTestCase (new Ipv4ReceiveOffloadSerialTestCase);
+  AddTestCase (new Ipv4ReceiveOffloadTimeoutTestCase);
+}
+
+static Ipv4ReceiveOffloadTestSuite g_ipv4ReceiveOffloadTestSuite;
@@ -0,0 +1,243 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <list>
+#include <cstring>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/random-variable.h"
+#include "ns3/lpm-trie.h"
+#include "ns3/node.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/internet-stack-helper.h"
+
+using namespace ns3;
+
+namespace {
+
+struct TestRoute
+{
+  uint8_t key[16];
+  uint8_t length;
+  uint32_t metric;
+};
+
+// the linear scan of the routing tables
+TestRoute *
+LinearLookup (std::list<TestRoute *> const &routes, uint8_t const *key)
+{
+  TestRoute *found = 0;
+  for (std::list<TestRoute *>::const_iterator i = routes.begin (); i != routes.end (); ++i)
+    {
+      TestRoute *route = *i;
+      bool match = true;
+      for (uint32_t bit = 0; bit < route->length && match; bit++)
+        {
+          uint8_t mask = 0x80 >> (bit % 8);
+          match = (route->key[bit / 8] & mask) == (key[bit / 8] & mask);
+        }
+      if (!match || (found != 0 && route->length < found->length))
+        {
+          continue;
+        }
+      if (found != 0 && route->length == found->length && route->metric > found->metric)
+        {
+          continue;
+        }
+      found = route;
+    }
+  return found;
+}
+
+} // anonymous namespace
+
+template <uint32_t N>
+class LpmTrieTestCase : public TestCase
+{
+public:
+  LpmTrieTestCase ();
+private:
+  virtual void DoRun (void);
+  void RandomKey (uint8_t *key);
+  void CheckLookups (LpmTrie<N, TestRoute> const &trie, std::list<TestRoute *> const &routes);
+
+  UniformVariable m_random;
+};
+
+template <uint32_t N>
+LpmTrieTestCase<N>::LpmTrieTestCase ()
+  : TestCase (N == 4 ? "Check the lookups of a trie of 4 byte keys against a linear scan"
+              : "Check the lookups of a trie of 16 byte keys against a linear scan")
+{
+}
+
+template <uint32_t N>
+void
+LpmTrieTestCase<N>::RandomKey (uint8_t *key)
+{
+  // few distinct values, so that the prefixes overlap
+  for (uint32_t i = 0; i < N; i++)
+    {
+      key[i] = (i % 2) ? m_random.GetInteger (0, 3) << 6 : m_random.GetInteger (0, 3);
+    }
+}
+
+template <uint32_t N>
+void
+LpmTrieTestCase<N>::CheckLookups (LpmTrie<N, TestRoute> const &trie, std::list<TestRoute *> const &routes)
+{
+  NS_TEST_ASSERT_MSG_EQ (trie.GetNRoutes (), routes.size (), "Wrong number of routes");
+  for (uint32_t k = 0; k < 200; k++)
+    {
+      uint8_t key[N];
+      RandomKey (key);
+      NS_TEST_ASSERT_MSG_EQ (trie.Lookup (key), LinearLookup (routes, key), "Wrong route found by lookup " << k);
+    }
+}
+
+template <uint32_t N>
+void
+LpmTrieTestCase<N>::DoRun (void)
+{
+  SeedManager::SetSeed (1);
+  LpmTrie<N, TestRoute> trie;
+  std::list<TestRoute *> routes;
+  uint8_t key[N];
+  RandomKey (key);
+  NS_TEST_ASSERT_MSG_EQ (trie.Lookup (key), 0, "Route found in an empty trie");
+
+  for (uint32_t step = 0; step < 600; step++)
+    {
+      if (routes.empty () || m_random.GetValue () < 0.6)
+        {
+          TestRoute *route = new TestRoute ();
+          memset (route->key, 0, sizeof (route->key));
+          RandomKey (route->key);
+          // the default route, and the lengths around the strides
+          route->length = m_random.GetInteger (0, 10) == 0 ? 0 : m_random.GetInteger (1, 8 * N);
+          route->metric = m_random.GetInteger (0, 2);
+          routes.push_back (route);
+          trie.Insert (route->key, route->length, route, route->metric);
+        }
+      else
+        {
+          std::list<TestRoute *>::iterator i = routes.begin ();
+          std::advance (i, m_random.GetInteger (0, routes.size () - 1));
+          trie.Remove ((*i)->key, (*i)->length, *i);
+          delete *i;
+          routes.erase (i);
+        }
+      if (step % 50 == 0)
+        {
+          CheckLookups (trie, routes);
+        }
+    }
+  CheckLookups (trie, routes);
+
+  while (!routes.empty ())
+    {
+      trie.Remove (routes.front ()->key, routes.front ()->length, routes.front ());
+      delete routes.front ();
+      routes.pop_front ();
+    }
+  CheckLookups (trie, routes);
+}
+
+class StaticRoutingLookupTestCase : public TestCase
+{
+public:
+  StaticRoutingLookupTestCase ();
+private:
+  virtual void DoRun (void);
+  Ipv4Address Lookup (Ptr<Ipv4StaticRouting> routing, Ipv4Address dest);
+};
+
+StaticRoutingLookupTestCase::StaticRoutingLookupTestCase ()
+  : TestCase ("Check the longest prefix match and the metrics of Ipv4StaticRouting")
+{
+}
+
+Ipv4Address
+StaticRoutingLookupTestCase::Lookup (Ptr<Ipv4StaticRouting> routing, Ipv4Address dest)
+{
+  Ipv4Header header;
+  header.SetDestination (dest);
+  Socket::SocketErrno sockerr;
+  Ptr<Ipv4Route> route = routing->RouteOutput (0, header, 0, sockerr);
+  return route != 0 ? route->GetGateway () : Ipv4Address::GetBroadcast ();
+}
+
+void
+StaticRoutingLookupTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (node);
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  device->SetAddress (Mac48Address::Allocate ());
+  node->AddDevice (device);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  uint32_t interface = ipv4->AddInterface (device);
+  ipv4->AddAddress (interface, Ipv4InterfaceAddress ("10.0.0.1", "255.255.255.0"));
+  ipv4->SetUp (interface);
+
+  Ipv4StaticRoutingHelper helper;
+  Ptr<Ipv4StaticRouting> routing = helper.GetStaticRouting (ipv4);
+  uint32_t nRoutes = routing->GetNRoutes ();
+  routing->SetDefaultRoute ("10.0.0.2", interface);
+  routing->AddNetworkRouteTo ("172.16.0.0", "255.240.0.0", "10.0.0.3", interface, 5);
+  routing->AddNetworkRouteTo ("172.16.0.0", "255.240.0.0", "10.0.0.4", interface, 2);
+  routing->AddNetworkRouteTo ("172.17.0.0", "255.255.0.0", "10.0.0.5", interface, 7);
+  routing->AddNetworkRouteTo ("172.17.0.0", "255.255.0.0", "10.0.0.6", interface, 7);
+  routing->AddHostRouteTo ("172.17.0.9", "10.0.0.7", interface);
+
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "192.168.0.1"), Ipv4Address ("10.0.0.2"), "Default route not used");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "10.0.0.9"), Ipv4Address::GetZero (), "Route to the interface not used");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "172.18.0.1"), Ipv4Address ("10.0.0.4"), "Lowest metric not used");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "172.17.1.1"), Ipv4Address ("10.0.0.6"), "Last route of equal metric not used");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "172.17.0.9"), Ipv4Address ("10.0.0.7"), "Host route not used");
+
+  // remove the host route, then the route of lowest metric
+  routing->RemoveRoute (nRoutes + 5);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "172.17.0.9"), Ipv4Address ("10.0.0.6"), "Host route not removed");
+  routing->RemoveRoute (nRoutes + 2);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "172.18.0.1"), Ipv4Address ("10.0.0.3"), "Route of lowest metric not removed");
+
+  // the routes through the interface go down with it
+  ipv4->SetDown (interface);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "172.17.1.1"), Ipv4Address::GetBroadcast (), "Routes not removed with their interface");
+  Simulator::Destroy ();
+}
+
+class LpmTrieTestSuite : public TestSuite
+{
+public:
+  LpmTrieTestSuite ();
+};
+
+LpmTrieTestSuite::LpmTrieTestSuite ()
+  : TestSuite ("lpm-trie", UNIT)
+{
+  AddTestCase (new LpmTrieTestCase<4>);
+  AddTestCase (new LpmTrieTestCase<16>);
+  AddTestCase (new StaticRoutingLookupTestCase);
+}
+
+static LpmTrieTestSuite g_lpmTrieTestSuite;
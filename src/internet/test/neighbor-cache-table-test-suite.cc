@@ -0,0 +1,188 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <map>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/random-variable.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv6-address.h"
+#include "ns3/neighbor-cache-table.h"
+#include "ns3/ndisc-cache.h"
+
+using namespace ns3;
+
+namespace {
+
+struct TestEntry
+{
+  TestEntry (uint32_t v = 0) : value (v) {}
+  uint32_t value;
+};
+
+} // anonymous namespace
+
+class NeighborCacheTableTestCase : public TestCase
+{
+public:
+  NeighborCacheTableTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+NeighborCacheTableTestCase::NeighborCacheTableTestCase ()
+  : TestCase ("Check the lookups of a NeighborCacheTable against a map, and the stability of its entries")
+{
+}
+
+void
+NeighborCacheTableTestCase::DoRun (void)
+{
+  NeighborCacheTable<Ipv4Address, TestEntry, Ipv4AddressHash> table;
+  std::map<Ipv4Address, uint32_t> reference;
+  std::map<Ipv4Address, TestEntry *> pointers;
+  UniformVariable random;
+  bool ok = true;
+
+  // addresses of a few /24, inserted and removed at random
+  for (uint32_t i = 0; i < 20000; i++)
+    {
+      Ipv4Address address (0x0a000000 + random.GetInteger (0, 1023));
+      TestEntry *entry = table.Find (address);
+      if (entry == 0)
+        {
+          ok = ok && reference.find (address) == reference.end ();
+          entry = table.Insert (address, TestEntry (i));
+          reference[address] = i;
+          pointers[address] = entry;
+        }
+      else
+        {
+          ok = ok && reference[address] == entry->value && pointers[address] == entry;
+          if (random.GetInteger (0, 1) == 0)
+            {
+              table.Erase (address);
+              reference.erase (address);
+              pointers.erase (address);
+            }
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (ok, true, "Lookup different from the map, or entry moved");
+  NS_TEST_EXPECT_MSG_EQ (table.GetSize (), reference.size (), "Wrong number of entries");
+
+  // the walk finds the entries once each
+  uint32_t found = 0;
+  for (uint32_t i = 0; i < table.GetNPositions (); i++)
+    {
+      if (table.GetPosition (i) != 0)
+        {
+          found++;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (found, reference.size (), "Wrong number of entries walked");
+
+  table.Clear ();
+  NS_TEST_EXPECT_MSG_EQ (table.GetSize (), 0, "Entries left after Clear");
+  NS_TEST_EXPECT_MSG_EQ (table.Find (reference.begin ()->first), 0, "Entry found after Clear");
+}
+
+class NdiscCacheAgingTestCase : public TestCase
+{
+public:
+  NdiscCacheAgingTestCase ();
+private:
+  virtual void DoRun (void);
+  void Confirm (Ptr<NdiscCache> cache, Ipv6Address address);
+  void Check (Ptr<NdiscCache> cache, uint32_t n, uint32_t reachable);
+};
+
+NdiscCacheAgingTestCase::NdiscCacheAgingTestCase ()
+  : TestCase ("Check that the single aging event of an NdiscCache makes the reachable entries stale")
+{
+}
+
+void
+NdiscCacheAgingTestCase::Confirm (Ptr<NdiscCache> cache, Ipv6Address address)
+{
+  NdiscCache::Entry *entry = cache->Lookup (address);
+  if (entry == 0)
+    {
+      entry = cache->Add (address);
+    }
+  entry->MarkReachable ();
+  entry->StopReachableTimer ();
+  entry->StartReachableTimer ();
+}
+
+void
+NdiscCacheAgingTestCase::Check (Ptr<NdiscCache> cache, uint32_t n, uint32_t reachable)
+{
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint8_t buffer[16] = { 0x20, 0x01, 0x0d, 0xb8 };
+      buffer[14] = i >> 8;
+      buffer[15] = i & 0xff;
+      NdiscCache::Entry *entry = cache->Lookup (Ipv6Address (buffer));
+      if (entry != 0 && entry->IsReachable ())
+        {
+          count++;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (count, reachable, "Wrong number of reachable entries at " << Simulator::Now ().GetSeconds ());
+}
+
+void
+NdiscCacheAgingTestCase::DoRun (void)
+{
+  Ptr<NdiscCache> cache = CreateObject<NdiscCache> ();
+  uint32_t n = 1000;
+
+  // confirmed from 0.5 s to 1.5 s, stale from 31 s to 32 s
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint8_t buffer[16] = { 0x20, 0x01, 0x0d, 0xb8 };
+      buffer[14] = i >> 8;
+      buffer[15] = i & 0xff;
+      Simulator::Schedule (MilliSeconds (500 + i), &NdiscCacheAgingTestCase::Confirm, this, cache, Ipv6Address (buffer));
+    }
+  // a second confirmation of the first entry postpones its aging
+  uint8_t first[16] = { 0x20, 0x01, 0x0d, 0xb8 };
+  Simulator::Schedule (Seconds (20), &NdiscCacheAgingTestCase::Confirm, this, cache, Ipv6Address (first));
+
+  Simulator::Schedule (Seconds (30.9), &NdiscCacheAgingTestCase::Check, this, cache, n, n);
+  Simulator::Schedule (Seconds (31.5), &NdiscCacheAgingTestCase::Check, this, cache, n, 500);
+  Simulator::Schedule (Seconds (32.5), &NdiscCacheAgingTestCase::Check, this, cache, n, 1);
+  Simulator::Schedule (Seconds (50.5), &NdiscCacheAgingTestCase::Check, this, cache, n, 0);
+  Simulator::Run ();
+  cache->Dispose ();
+  Simulator::Destroy ();
+}
+
+class NeighborCacheTableTestSuite : public TestSuite
+{
+public:
+  NeighborCacheTableTestSuite ();
+};
+
+NeighborCacheTableTestSuite::NeighborCacheTableTestSuite ()
+  : TestSuite ("neighbor-cache-table", UNIT)
+{
+  AddTestCase (new NeighborCacheTableTestCase);
+  AddTestCase (new NdiscCacheAgingTestCase);
+}
+
+static NeighborCacheTableTestSuite g_neighborCacheTableTestSuite;
@@ -0,0 +1,335 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <set>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/error-model.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/internet-stack-helper.h"
+
+using namespace ns3;
+
+/**
+ * Drop the first transmission of chosen data segments, and count the data
+ * segments arriving together with the previous one.
+ */
+class CongestionTestErrorModel : public ErrorModel
+{
+public:
+  CongestionTestErrorModel ();
+  std::set<SequenceNumber32> m_drops;
+  std::set<SequenceNumber32> m_sent;
+  uint32_t m_bursts;
+  Time m_last;
+private:
+  virtual bool DoCorrupt (Ptr<Packet> p);
+  virtual void DoReset (void);
+};
+
+CongestionTestErrorModel::CongestionTestErrorModel ()
+  : m_bursts (0),
+    m_last (Seconds (-1))
+{
+}
+
+bool
+CongestionTestErrorModel::DoCorrupt (Ptr<Packet> p)
+{
+  Ptr<Packet> copy = p->Copy ();
+  Ipv4Header ipHeader;
+  copy->RemoveHeader (ipHeader);
+  TcpHeader tcpHeader;
+  copy->RemoveHeader (tcpHeader);
+  if (copy->GetSize () == 0)
+    {
+      return false;
+    }
+  if (Simulator::Now () == m_last)
+    {
+      m_bursts++;
+    }
+  m_last = Simulator::Now ();
+  SequenceNumber32 seq = tcpHeader.GetSequenceNumber ();
+  return m_sent.insert (seq).second && m_drops.find (seq) != m_drops.end ();
+}
+
+void
+CongestionTestErrorModel::DoReset (void)
+{
+  m_sent.clear ();
+}
+
+/**
+ * A bulk transfer from a socket of the congestion control under test,
+ * through a channel of 5 ms.
+ */
+class TcpCongestionTestCase : public TestCase
+{
+public:
+  TcpCongestionTestCase (std::string name);
+protected:
+  Ptr<Socket> Setup (std::string socketType);
+  void HandleAccept (Ptr<Socket> socket, const Address &from);
+  void HandleRead (Ptr<Socket> socket);
+
+  Ptr<SimpleChannel> m_channel;
+  Ptr<CongestionTestErrorModel> m_errorModel;
+  uint32_t m_received;
+  static const uint32_t m_segmentSize = 536;
+};
+
+TcpCongestionTestCase::TcpCongestionTestCase (std::string name)
+  : TestCase (name),
+    m_received (0)
+{
+}
+
+void
+TcpCongestionTestCase::HandleAccept (Ptr<Socket> socket, const Address &from)
+{
+  socket->SetRecvCallback (MakeCallback (&TcpCongestionTestCase::HandleRead, this));
+}
+
+void
+TcpCongestionTestCase::HandleRead (Ptr<Socket> socket)
+{
+  Ptr<Packet> p;
+  while ((p = socket->Recv ()) != 0)
+    {
+      m_received += p->GetSize ();
+    }
+}
+
+Ptr<Socket>
+TcpCongestionTestCase::Setup (std::string socketType)
+{
+  m_received = 0;
+  NodeContainer nodes;
+  nodes.Create (2);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  m_channel = CreateObject<SimpleChannel> ();
+  m_channel->SetAttribute ("Delay", TimeValue (MilliSeconds (5)));
+  m_errorModel = CreateObject<CongestionTestErrorModel> ();
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetChannel (m_channel);
+      nodes.Get (i)->AddDevice (device);
+      Ptr<Ipv4> ipv4 = nodes.Get (i)->GetObject<Ipv4> ();
+      uint32_t interface = ipv4->AddInterface (device);
+      ipv4->AddAddress (interface, Ipv4InterfaceAddress (Ipv4Address (i == 0 ? "10.0.0.1" : "10.0.0.2"), "255.255.255.0"));
+      ipv4->SetUp (interface);
+      if (i == 1)
+        {
+          device->SetReceiveErrorModel (m_errorModel);
+        }
+    }
+
+  Ptr<Socket> server = Socket::CreateSocket (nodes.Get (1), TcpSocketFactory::GetTypeId ());
+  // an ACK, and an RTT sample, for each segment
+  server->SetAttribute ("DelAckCount", UintegerValue (1));
+  // windows larger than 64KB, and recovery of the losses from the SACK
+  // blocks
+  server->SetAttribute ("WindowScaling", BooleanValue (true));
+  server->SetAttribute ("Sack", BooleanValue (true));
+  server->Bind (InetSocketAddress (Ipv4Address::GetAny (), 80));
+  server->Listen ();
+  server->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                             MakeCallback (&TcpCongestionTestCase::HandleAccept, this));
+
+  nodes.Get (0)->GetObject<TcpL4Protocol> ()->SetAttribute ("SocketType", TypeIdValue (TypeId::LookupByName (socketType)));
+  Ptr<Socket> client = Socket::CreateSocket (nodes.Get (0), TcpSocketFactory::GetTypeId ());
+  client->SetAttribute ("SndBufSize", UintegerValue (1 << 22));
+  client->SetAttribute ("WindowScaling", BooleanValue (true));
+  client->SetAttribute ("Sack", BooleanValue (true));
+  return client;
+}
+
+class TcpCubicReductionTestCase : public TcpCongestionTestCase
+{
+public:
+  TcpCubicReductionTestCase ();
+private:
+  virtual void DoRun (void);
+  void CwndTrace (uint32_t oldValue, uint32_t newValue);
+
+  uint32_t m_cwndBeforeLoss;
+  uint32_t m_cwndAfterLoss;
+  uint32_t m_cwndMax;
+};
+
+TcpCubicReductionTestCase::TcpCubicReductionTestCase ()
+  : TcpCongestionTestCase ("Check that TcpCubic reduces cwnd by Beta upon loss, and grows it back"),
+    m_cwndBeforeLoss (0),
+    m_cwndAfterLoss (0),
+    m_cwndMax (0)
+{
+}
+
+void
+TcpCubicReductionTestCase::CwndTrace (uint32_t oldValue, uint32_t newValue)
+{
+  if (newValue < oldValue && m_cwndAfterLoss == 0)
+    {
+      m_cwndBeforeLoss = oldValue;
+      m_cwndAfterLoss = newValue;
+    }
+  else if (m_cwndAfterLoss != 0)
+    {
+      m_cwndMax = std::max (m_cwndMax, newValue);
+    }
+}
+
+void
+TcpCubicReductionTestCase::DoRun (void)
+{
+  Ptr<Socket> client = Setup ("ns3::TcpCubic");
+  client->SetAttribute ("HyStart", BooleanValue (false));
+  // a steep cubic function, to reach the window of the loss again within the transfer
+  client->SetAttribute ("C", DoubleValue (40));
+  client->SetAttribute ("SlowStartThreshold", UintegerValue (40 * m_segmentSize));
+  client->TraceConnectWithoutContext ("CongestionWindow", MakeCallback (&TcpCubicReductionTestCase::CwndTrace, this));
+  m_errorModel->m_drops.insert (SequenceNumber32 (1 + 100 * m_segmentSize));
+
+  uint32_t size = 1200 * m_segmentSize;
+  client->Connect (InetSocketAddress ("10.0.0.2", 80));
+  client->Send (Create<Packet> (size));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_received, size, "Data not received");
+  NS_TEST_ASSERT_MSG_GT (m_cwndAfterLoss, 0, "cwnd not reduced");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_cwndAfterLoss, 0.7 * m_cwndBeforeLoss, 1, "cwnd not reduced by Beta");
+  NS_TEST_EXPECT_MSG_GT (m_cwndMax, m_cwndBeforeLoss, "cwnd not grown back after the loss");
+  Simulator::Destroy ();
+}
+
+class TcpCubicHyStartTestCase : public TcpCongestionTestCase
+{
+public:
+  TcpCubicHyStartTestCase (bool hyStart);
+private:
+  virtual void DoRun (void);
+  void CwndTrace (uint32_t oldValue, uint32_t newValue);
+
+  bool m_hyStart;
+};
+
+TcpCubicHyStartTestCase::TcpCubicHyStartTestCase (bool hyStart)
+  : TcpCongestionTestCase (hyStart ? "Check that HyStart leaves slow start when the RTT grows"
+                           : "Check that TcpCubic stays in slow start without HyStart"),
+    m_hyStart (hyStart)
+{
+}
+
+void
+TcpCubicHyStartTestCase::CwndTrace (uint32_t oldValue, uint32_t newValue)
+{
+  // a queue builds up, once the window is large enough for HyStart
+  if (newValue >= 24 * m_segmentSize && oldValue < 24 * m_segmentSize)
+    {
+      m_channel->SetAttribute ("Delay", TimeValue (MilliSeconds (10)));
+    }
+}
+
+void
+TcpCubicHyStartTestCase::DoRun (void)
+{
+  Ptr<Socket> client = Setup ("ns3::TcpCubic");
+  client->SetAttribute ("HyStart", BooleanValue (m_hyStart));
+  client->TraceConnectWithoutContext ("CongestionWindow", MakeCallback (&TcpCubicHyStartTestCase::CwndTrace, this));
+
+  uint32_t size = 300 * m_segmentSize;
+  client->Connect (InetSocketAddress ("10.0.0.2", 80));
+  client->Send (Create<Packet> (size));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_received, size, "Data not received");
+  UintegerValue ssThresh;
+  client->GetAttribute ("SlowStartThreshold", ssThresh);
+  if (m_hyStart)
+    {
+      NS_TEST_EXPECT_MSG_LT (ssThresh.Get (), 65535, "Slow start not left by HyStart");
+      NS_TEST_EXPECT_MSG_GT (ssThresh.Get (), 24 * m_segmentSize, "Slow start left before the RTT grew");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_EQ (ssThresh.Get (), 65535, "Slow start left without HyStart nor loss");
+    }
+  Simulator::Destroy ();
+}
+
+class TcpBbrPacingTestCase : public TcpCongestionTestCase
+{
+public:
+  TcpBbrPacingTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TcpBbrPacingTestCase::TcpBbrPacingTestCase ()
+  : TcpCongestionTestCase ("Check that TcpBbr paces its segments, and recovers from a loss")
+{
+}
+
+void
+TcpBbrPacingTestCase::DoRun (void)
+{
+  Ptr<Socket> client = Setup ("ns3::TcpBbr");
+  m_errorModel->m_drops.insert (SequenceNumber32 (1 + 500 * m_segmentSize));
+
+  uint32_t size = 2000 * m_segmentSize;
+  client->Connect (InetSocketAddress ("10.0.0.2", 80));
+  client->Send (Create<Packet> (size));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_received, size, "Data not received");
+  // only the retransmission is sent with other segments
+  NS_TEST_EXPECT_MSG_LT (m_errorModel->m_bursts, 2, "Segments not paced");
+  Simulator::Destroy ();
+}
+
+class TcpCongestionTestSuite : public TestSuite
+{
+public:
+  TcpCongestionTestSuite ();
+};
+
+TcpCongestionTestSuite::TcpCongestionTestSuite ()
+  : TestSuite ("tcp-congestion", UNIT)
+{
+  AddTestCase (new TcpCubicReductionTestCase);
+  AddTestCase (new TcpCubicHyStartTestCase (true));
+  AddTestCase (new TcpCubicHyStartTestCase (false));
+  AddTestCase (new TcpBbrPacingTestCase);
+}
+
+static TcpCongestionTestSuite g_tcpCongestionTestSuite;
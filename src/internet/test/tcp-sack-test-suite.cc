@@ -0,0 +1,331 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <map>
+#include <set>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/error-model.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-tx-buffer.h"
+#include "ns3/tcp-rx-buffer.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/internet-stack-helper.h"
+
+using namespace ns3;
+
+class TcpSackOptionsTestCase : public TestCase
+{
+public:
+  TcpSackOptionsTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TcpSackOptionsTestCase::TcpSackOptionsTestCase ()
+  : TestCase ("Check the serialization of the SACK and window scale options")
+{
+}
+
+void
+TcpSackOptionsTestCase::DoRun (void)
+{
+  TcpHeader header;
+  NS_TEST_EXPECT_MSG_EQ (header.GetSerializedSize (), 20, "Options in an empty header");
+
+  header.SetFlags (TcpHeader::SYN);
+  header.SetSackPermitted (true);
+  header.SetWindowScale (7);
+  NS_TEST_EXPECT_MSG_EQ (header.GetSerializedSize (), 28, "Wrong size of a SYN with options");
+  Ptr<Packet> p = Create<Packet> (10);
+  p->AddHeader (header);
+  TcpHeader syn;
+  p->RemoveHeader (syn);
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 10, "Options not removed with the header");
+  NS_TEST_EXPECT_MSG_EQ (syn.IsSackPermitted (), true, "SACK-permitted option lost");
+  NS_TEST_EXPECT_MSG_EQ (syn.HasWindowScale (), true, "Window scale option lost");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t)syn.GetWindowScale (), 7, "Wrong window scale");
+  NS_TEST_EXPECT_MSG_EQ (syn.GetSackList ().empty (), true, "SACK blocks in a SYN");
+
+  TcpHeader::SackList sackList;
+  sackList.push_back (TcpHeader::SackBlock (SequenceNumber32 (3000), SequenceNumber32 (4000)));
+  sackList.push_back (TcpHeader::SackBlock (SequenceNumber32 (1000), SequenceNumber32 (2000)));
+  header = TcpHeader ();
+  header.SetFlags (TcpHeader::ACK);
+  header.SetSackList (sackList);
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t)header.GetLength (), 10, "Wrong length of an ACK with 2 SACK blocks");
+  p = Create<Packet> ();
+  p->AddHeader (header);
+  TcpHeader ack;
+  p->RemoveHeader (ack);
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 0, "Options not removed with the header");
+  NS_TEST_EXPECT_MSG_EQ (ack.IsSackPermitted (), false, "SACK-permitted option in an ACK");
+  NS_TEST_EXPECT_MSG_EQ (ack.HasWindowScale (), false, "Window scale option in an ACK");
+  NS_TEST_EXPECT_MSG_EQ ((ack.GetSackList () == sackList), true, "SACK blocks lost or reordered");
+}
+
+class TcpSackScoreboardTestCase : public TestCase
+{
+public:
+  TcpSackScoreboardTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TcpSackScoreboardTestCase::TcpSackScoreboardTestCase ()
+  : TestCase ("Check the SACK blocks kept by the Tx and Rx buffers")
+{
+}
+
+void
+TcpSackScoreboardTestCase::DoRun (void)
+{
+  // 10 segments of 100 bytes, from seqnum 1
+  TcpTxBuffer tx (1);
+  tx.SetMaxBufferSize (10000);
+  tx.Add (Create<Packet> (1000));
+  SequenceNumber32 s (1);
+
+  NS_TEST_EXPECT_MSG_EQ (tx.AddSackBlock (s + 200, s + 300), 100, "Block not SACKed");
+  NS_TEST_EXPECT_MSG_EQ (tx.AddSackBlock (s + 400, s + 500), 100, "Block not SACKed");
+  NS_TEST_EXPECT_MSG_EQ (tx.AddSackBlock (s + 250, s + 450), 100, "Overlapping block not merged");
+  NS_TEST_EXPECT_MSG_EQ (tx.SackedBytes (), 300, "Wrong number of SACKed bytes");
+  NS_TEST_EXPECT_MSG_EQ (tx.HighestSacked (), s + 500, "Wrong highest SACKed seqnum");
+  uint32_t length;
+  NS_TEST_EXPECT_MSG_EQ (tx.NextUnsacked (s + 250, length), s + 500, "SACKed data not skipped");
+  NS_TEST_EXPECT_MSG_EQ (length, 500, "Wrong length after the last block");
+  NS_TEST_EXPECT_MSG_EQ (tx.NextUnsacked (s, length), s, "UnSACKed data skipped");
+  NS_TEST_EXPECT_MSG_EQ (length, 200, "Wrong length of the first hole");
+
+  // more than 2 segments SACKed above the first hole
+  NS_TEST_EXPECT_MSG_EQ (tx.LostBoundary (3, 100), s + 200, "First hole not lost");
+  // then 3 small blocks above the second hole
+  tx.AddSackBlock (s + 600, s + 610);
+  tx.AddSackBlock (s + 700, s + 710);
+  tx.AddSackBlock (s + 800, s + 810);
+  NS_TEST_EXPECT_MSG_EQ (tx.LostBoundary (3, 100), s + 600, "Second hole not lost");
+  NS_TEST_EXPECT_MSG_EQ (tx.LostBoundary (4, 100), s + 200, "Second hole lost with a higher threshold");
+  NS_TEST_EXPECT_MSG_EQ (tx.SackedBytes (s + 250, s + 705), 265, "Wrong number of SACKed bytes in a range");
+
+  // the cumulative ACK prunes the blocks
+  tx.DiscardUpTo (s + 300);
+  NS_TEST_EXPECT_MSG_EQ (tx.SackedBytes (), 230, "Acknowledged blocks not pruned");
+  tx.ResetSackBlocks ();
+  NS_TEST_EXPECT_MSG_EQ (tx.SackedBytes (), 0, "Blocks not reset");
+  NS_TEST_EXPECT_MSG_EQ (tx.HighestSacked (), s + 300, "Highest SACKed seqnum not reset");
+
+  // the receiver reports the block of the latest segment first
+  TcpRxBuffer rx (1);
+  rx.SetMaxBufferSize (10000);
+  TcpHeader header;
+  header.SetSequenceNumber (s + 500);
+  rx.Add (Create<Packet> (100), header);
+  header.SetSequenceNumber (s + 200);
+  rx.Add (Create<Packet> (100), header);
+  header.SetSequenceNumber (s + 600);
+  rx.Add (Create<Packet> (100), header);
+  TcpHeader::SackList sackList = rx.GetSackList ();
+  NS_TEST_ASSERT_MSG_EQ (sackList.size (), 2, "Wrong number of SACK blocks");
+  NS_TEST_EXPECT_MSG_EQ (sackList.front ().first, s + 500, "Latest block not first");
+  NS_TEST_EXPECT_MSG_EQ (sackList.front ().second, s + 700, "Adjacent blocks not merged");
+  header.SetSequenceNumber (s);
+  rx.Add (Create<Packet> (200), header);
+  sackList = rx.GetSackList ();
+  NS_TEST_ASSERT_MSG_EQ (sackList.size (), 1, "Block below RCV.NXT still reported");
+  NS_TEST_EXPECT_MSG_EQ (sackList.front ().first, s + 500, "Wrong block reported");
+}
+
+/**
+ * Drop the first transmission of chosen data segments, count the
+ * transmissions of every segment, and the SACK blocks of the ACKs.
+ */
+class SackTestErrorModel : public ErrorModel
+{
+public:
+  SackTestErrorModel ();
+  std::set<SequenceNumber32> m_drops;
+  std::map<SequenceNumber32, uint32_t> m_transmissions;
+  uint32_t m_maxSackBlocks;
+private:
+  virtual bool DoCorrupt (Ptr<Packet> p);
+  virtual void DoReset (void);
+};
+
+SackTestErrorModel::SackTestErrorModel ()
+  : m_maxSackBlocks (0)
+{
+}
+
+bool
+SackTestErrorModel::DoCorrupt (Ptr<Packet> p)
+{
+  if (p->GetSize () < 40)
+    { // ARP
+      return false;
+    }
+  Ptr<Packet> copy = p->Copy ();
+  Ipv4Header ipHeader;
+  copy->RemoveHeader (ipHeader);
+  TcpHeader tcpHeader;
+  copy->RemoveHeader (tcpHeader);
+  m_maxSackBlocks = std::max (m_maxSackBlocks, (uint32_t)tcpHeader.GetSackList ().size ());
+  if (copy->GetSize () == 0)
+    {
+      return false;
+    }
+  SequenceNumber32 seq = tcpHeader.GetSequenceNumber ();
+  return ++m_transmissions[seq] == 1 && m_drops.find (seq) != m_drops.end ();
+}
+
+void
+SackTestErrorModel::DoReset (void)
+{
+  m_transmissions.clear ();
+}
+
+class TcpSackRecoveryTestCase : public TestCase
+{
+public:
+  TcpSackRecoveryTestCase ();
+private:
+  virtual void DoRun (void);
+  void HandleAccept (Ptr<Socket> socket, const Address &from);
+  void HandleRead (Ptr<Socket> socket);
+  void RwndTrace (uint32_t oldValue, uint32_t newValue);
+
+  uint32_t m_received;
+  uint32_t m_maxRwnd;
+};
+
+TcpSackRecoveryTestCase::TcpSackRecoveryTestCase ()
+  : TestCase ("Check that the SACK recovery retransmits the lost segments only, through a scaled window"),
+    m_received (0),
+    m_maxRwnd (0)
+{
+}
+
+void
+TcpSackRecoveryTestCase::HandleAccept (Ptr<Socket> socket, const Address &from)
+{
+  socket->SetRecvCallback (MakeCallback (&TcpSackRecoveryTestCase::HandleRead, this));
+}
+
+void
+TcpSackRecoveryTestCase::HandleRead (Ptr<Socket> socket)
+{
+  Ptr<Packet> p;
+  while ((p = socket->Recv ()) != 0)
+    {
+      m_received += p->GetSize ();
+    }
+}
+
+void
+TcpSackRecoveryTestCase::RwndTrace (uint32_t oldValue, uint32_t newValue)
+{
+  m_maxRwnd = std::max (m_maxRwnd, newValue);
+}
+
+void
+TcpSackRecoveryTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  Ptr<SimpleNetDevice> devices[2];
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      devices[i] = CreateObject<SimpleNetDevice> ();
+      devices[i]->SetAddress (Mac48Address::Allocate ());
+      devices[i]->SetChannel (channel);
+      nodes.Get (i)->AddDevice (devices[i]);
+      Ptr<Ipv4> ipv4 = nodes.Get (i)->GetObject<Ipv4> ();
+      uint32_t interface = ipv4->AddInterface (devices[i]);
+      ipv4->AddAddress (interface, Ipv4InterfaceAddress (Ipv4Address (i == 0 ? "10.0.0.1" : "10.0.0.2"), "255.255.255.0"));
+      ipv4->SetUp (interface);
+    }
+
+  // drop 2 segments of a window, and then 3 contiguous ones
+  Ptr<SackTestErrorModel> errorModel = CreateObject<SackTestErrorModel> ();
+  uint32_t segmentSize = 536;
+  uint32_t drops[] = { 30, 34, 60, 61, 62 };
+  for (uint32_t i = 0; i < sizeof (drops) / sizeof (drops[0]); i++)
+    {
+      errorModel->m_drops.insert (SequenceNumber32 (1 + drops[i] * segmentSize));
+    }
+  devices[1]->SetReceiveErrorModel (errorModel);
+  Ptr<SackTestErrorModel> ackModel = CreateObject<SackTestErrorModel> ();
+  devices[0]->SetReceiveErrorModel (ackModel);
+
+  Ptr<Socket> server = Socket::CreateSocket (nodes.Get (1), TcpSocketFactory::GetTypeId ());
+  // no delayed ACK of the last segment, which would race with the RTO
+  server->SetAttribute ("DelAckCount", UintegerValue (1));
+  server->SetAttribute ("WindowScaling", BooleanValue (true));
+  server->SetAttribute ("Sack", BooleanValue (true));
+  server->Bind (InetSocketAddress (Ipv4Address::GetAny (), 80));
+  server->Listen ();
+  server->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                             MakeCallback (&TcpSackRecoveryTestCase::HandleAccept, this));
+
+  uint32_t size = 120 * segmentSize;
+  Ptr<Socket> client = Socket::CreateSocket (nodes.Get (0), TcpSocketFactory::GetTypeId ());
+  client->SetAttribute ("WindowScaling", BooleanValue (true));
+  client->SetAttribute ("Sack", BooleanValue (true));
+  client->TraceConnectWithoutContext ("RWND", MakeCallback (&TcpSackRecoveryTestCase::RwndTrace, this));
+  client->Connect (InetSocketAddress ("10.0.0.2", 80));
+  client->Send (Create<Packet> (size));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_received, size, "Data not received");
+  NS_TEST_EXPECT_MSG_GT (m_maxRwnd, 65535, "Window not scaled");
+  NS_TEST_EXPECT_MSG_EQ (ackModel->m_maxSackBlocks, 2, "Holes not reported by the SACK blocks");
+  NS_TEST_EXPECT_MSG_EQ (errorModel->m_transmissions.size (), 120, "Segments split or merged");
+  for (std::map<SequenceNumber32, uint32_t>::const_iterator i = errorModel->m_transmissions.begin ();
+       i != errorModel->m_transmissions.end (); ++i)
+    {
+      uint32_t expected = errorModel->m_drops.count (i->first) ? 2 : 1;
+      NS_TEST_EXPECT_MSG_EQ (i->second, expected, "Wrong number of transmissions of seqnum " << i->first);
+    }
+  Simulator::Destroy ();
+}
+
+class TcpSackTestSuite : public TestSuite
+{
+public:
+  TcpSackTestSuite ();
+};
+
+TcpSackTestSuite::TcpSackTestSuite ()
+  : TestSuite ("tcp-sack", UNIT)
+{
+  AddTestCase (new TcpSackOptionsTestCase);
+  AddTestCase (new TcpSackScoreboardTestCase);
+  AddTestCase (new TcpSackRecoveryTestCase);
+}
+
+static TcpSackTestSuite g_tcpSackTestSuite;
@@ -0,0 +1,117 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/tcp-tx-buffer.h"
+
+using namespace ns3;
+
+class TcpTxBufferTestCase : public TestCase
+{
+public:
+  TcpTxBufferTestCase ();
+private:
+  virtual void DoRun (void);
+  Ptr<Packet> CreatePacket (uint32_t size, uint8_t first);
+  bool CheckBytes (Ptr<Packet> p, uint8_t first);
+};
+
+TcpTxBufferTestCase::TcpTxBufferTestCase ()
+  : TestCase ("Check the segments copied from and the data discarded in a TcpTxBuffer")
+{
+}
+
+Ptr<Packet>
+TcpTxBufferTestCase::CreatePacket (uint32_t size, uint8_t first)
+{
+  uint8_t buffer[2000];
+  for (uint32_t i = 0; i < size; i++)
+    {
+      buffer[i] = first + i;
+    }
+  return Create<Packet> (buffer, size);
+}
+
+// the bytes of the packet follow each other from first
+bool
+TcpTxBufferTestCase::CheckBytes (Ptr<Packet> p, uint8_t first)
+{
+  uint8_t buffer[4000];
+  p->CopyData (buffer, p->GetSize ());
+  for (uint32_t i = 0; i < p->GetSize (); i++)
+    {
+      if (buffer[i] != static_cast<uint8_t> (first + i))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+TcpTxBufferTestCase::DoRun (void)
+{
+  TcpTxBuffer buffer;
+  buffer.SetMaxBufferSize (10000);
+
+  // data added before the connection is set up
+  buffer.Add (CreatePacket (500, 0));
+  buffer.Add (CreatePacket (1000, 500 % 256));
+  buffer.SetHeadSequence (SequenceNumber32 (1000));
+  buffer.Add (CreatePacket (700, 1500 % 256));
+  NS_TEST_ASSERT_MSG_EQ (buffer.Size (), 2200, "Wrong buffer size");
+  NS_TEST_ASSERT_MSG_EQ (buffer.TailSequence (), SequenceNumber32 (3200), "Wrong tail sequence");
+
+  // segments within one packet and across several
+  Ptr<Packet> p = buffer.CopyFromSequence (100, SequenceNumber32 (1600));
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 100, "Wrong segment size");
+  NS_TEST_EXPECT_MSG_EQ (CheckBytes (p, 600 % 256), true, "Wrong segment data");
+  p = buffer.CopyFromSequence (1536, SequenceNumber32 (1400));
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 1536, "Wrong segment size across packets");
+  NS_TEST_EXPECT_MSG_EQ (CheckBytes (p, 400 % 256), true, "Wrong segment data across packets");
+  p = buffer.CopyFromSequence (1000, SequenceNumber32 (3000));
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 200, "Segment beyond the tail of the buffer");
+
+  // partial acknowledgments keep the packet, and the data, of the head
+  buffer.DiscardUpTo (SequenceNumber32 (1700));
+  NS_TEST_EXPECT_MSG_EQ (buffer.HeadSequence (), SequenceNumber32 (1700), "Wrong head after a partial ACK");
+  NS_TEST_EXPECT_MSG_EQ (buffer.Size (), 1500, "Wrong size after a partial ACK");
+  p = buffer.CopyFromSequence (1000, SequenceNumber32 (1700));
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 1000, "Wrong segment size after a partial ACK");
+  NS_TEST_EXPECT_MSG_EQ (CheckBytes (p, 700 % 256), true, "Wrong segment data after a partial ACK");
+  buffer.DiscardUpTo (SequenceNumber32 (2500));
+  p = buffer.CopyFromSequence (700, SequenceNumber32 (2500));
+  NS_TEST_EXPECT_MSG_EQ (CheckBytes (p, 1500 % 256), true, "Wrong segment data after a full ACK");
+
+  // the ACK of a FIN goes one past the data
+  buffer.DiscardUpTo (SequenceNumber32 (3201));
+  NS_TEST_EXPECT_MSG_EQ (buffer.Size (), 0, "Data left after the ACK of a FIN");
+  NS_TEST_EXPECT_MSG_EQ (buffer.HeadSequence (), SequenceNumber32 (3201), "Wrong head after the ACK of a FIN");
+}
+
+class TcpTxBufferTestSuite : public TestSuite
+{
+public:
+  TcpTxBufferTestSuite ();
+};
+
+TcpTxBufferTestSuite::TcpTxBufferTestSuite ()
+  : TestSuite ("tcp-tx-buffer", UNIT)
+{
+  AddTestCase (new TcpTxBufferTestCase);
+}
+
+static TcpTxBufferTestSuite g_tcpTxBufferTestSuite;
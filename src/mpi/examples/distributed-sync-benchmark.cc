@@ -0,0 +1,312 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ * Compares the two synchronization algorithms of DistributedSimulatorImpl
+ * (global LBTS and Chandy-Misra-Bryant null messages) on two topologies:
+ *
+ *  - ring: one router per rank, the routers form a ring across the ranks
+ *    and every router has a few leaf nodes sending UDP traffic to the
+ *    leaves of the next rank.  Every rank has exactly two neighbors.
+ *
+ *  - fattree: a k-ary fat-tree; pod p lives on rank p % N and core switch
+ *    c on rank c % N.  Every host sends UDP traffic to a host in another
+ *    pod.
+ *
+ * Run it once per mode and compare the wall-clock times reported by rank 0;
+ * the bytes received by all sinks must be identical in both modes.  For
+ * example:
+ *
+ *   mpirun -np 4 ./distributed-sync-benchmark --topology=ring --nullmsg=0
+ *   mpirun -np 4 ./distributed-sync-benchmark --topology=ring --nullmsg=1
+ *   mpirun -np 4 ./distributed-sync-benchmark --topology=fattree --k=4 --nullmsg=1
+ */
+
+// for timing functions
+#include <cstdlib>
+#include <sys/time.h>
+#include <iostream>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mpi-interface.h"
+#include "ns3/distributed-simulator-impl.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/on-off-helper.h"
+#include "ns3/packet-sink-helper.h"
+#include "ns3/packet-sink.h"
+
+#ifdef NS3_MPI
+#include <mpi.h>
+#endif
+
+using namespace ns3;
+
+typedef struct timeval TIMER_TYPE;
+#define TIMER_NOW(_t) gettimeofday (&_t,NULL);
+#define TIMER_SECONDS(_t) ((double)(_t).tv_sec + (_t).tv_usec * 1e-6)
+#define TIMER_DIFF(_t1, _t2) (TIMER_SECONDS (_t1) - TIMER_SECONDS (_t2))
+
+NS_LOG_COMPONENT_DEFINE ("DistributedSyncBenchmark");
+
+#ifdef NS3_MPI
+// Sinks installed on this rank
+static ApplicationContainer g_sinks;
+
+static void
+Connect (PointToPointHelper &link, Ipv4AddressHelper &address, Ptr<Node> a, Ptr<Node> b)
+{
+  NetDeviceContainer devices = link.Install (a, b);
+  address.Assign (devices);
+  address.NewNetwork ();
+}
+
+static void
+InstallFlow (Ptr<Node> source, Ptr<Node> sink, double stopTime)
+{
+  uint16_t port = 50000;
+  uint32_t systemId = MpiInterface::GetSystemId ();
+  if (sink->GetSystemId () == systemId)
+    {
+      PacketSinkHelper sinkHelper ("ns3::UdpSocketFactory",
+                                   InetSocketAddress (Ipv4Address::GetAny (), port));
+      ApplicationContainer sinkApp = sinkHelper.Install (sink);
+      sinkApp.Start (Seconds (0.5));
+      sinkApp.Stop (Seconds (stopTime));
+      g_sinks.Add (sinkApp);
+    }
+  if (source->GetSystemId () == systemId)
+    {
+      Ipv4Address remote = sink->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ();
+      OnOffHelper clientHelper ("ns3::UdpSocketFactory", InetSocketAddress (remote, port));
+      clientHelper.SetAttribute ("OnTime", RandomVariableValue (ConstantVariable (1)));
+      clientHelper.SetAttribute ("OffTime", RandomVariableValue (ConstantVariable (0)));
+      ApplicationContainer clientApp = clientHelper.Install (source);
+      clientApp.Start (Seconds (1.0));
+      clientApp.Stop (Seconds (stopTime));
+    }
+}
+
+static void
+BuildRing (uint32_t systemCount, uint32_t leaves, double stopTime)
+{
+  PointToPointHelper routerLink;
+  routerLink.SetDeviceAttribute ("DataRate", StringValue ("100Mbps"));
+  routerLink.SetChannelAttribute ("Delay", StringValue ("5ms"));
+  PointToPointHelper leafLink;
+  leafLink.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  leafLink.SetChannelAttribute ("Delay", StringValue ("1ms"));
+
+  NodeContainer routers;
+  std::vector<NodeContainer> leafNodes (systemCount);
+  for (uint32_t i = 0; i < systemCount; ++i)
+    {
+      routers.Add (CreateObject<Node> (i));
+      leafNodes[i].Create (leaves, i);
+    }
+
+  InternetStackHelper stack;
+  stack.InstallAll ();
+
+  // Leaf links first, so that every leaf owns interface 1
+  Ipv4AddressHelper address;
+  address.SetBase ("10.0.0.0", "255.255.255.0");
+  for (uint32_t i = 0; i < systemCount; ++i)
+    {
+      for (uint32_t j = 0; j < leaves; ++j)
+        {
+          Connect (leafLink, address, leafNodes[i].Get (j), routers.Get (i));
+        }
+    }
+  // Two ranks only need a single link to close the ring
+  uint32_t ringLinks = systemCount > 2 ? systemCount : systemCount - 1;
+  for (uint32_t i = 0; i < ringLinks; ++i)
+    {
+      Connect (routerLink, address, routers.Get (i), routers.Get ((i + 1) % systemCount));
+    }
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  for (uint32_t i = 0; i < systemCount; ++i)
+    {
+      for (uint32_t j = 0; j < leaves; ++j)
+        {
+          InstallFlow (leafNodes[i].Get (j), leafNodes[(i + 1) % systemCount].Get (j), stopTime);
+        }
+    }
+}
+
+static void
+BuildFatTree (uint32_t systemCount, uint32_t k, double stopTime)
+{
+  PointToPointHelper link;
+  link.SetDeviceAttribute ("DataRate", StringValue ("100Mbps"));
+  link.SetChannelAttribute ("Delay", StringValue ("2ms"));
+
+  uint32_t half = k / 2;
+  NodeContainer core;
+  for (uint32_t c = 0; c < half * half; ++c)
+    {
+      core.Add (CreateObject<Node> (c % systemCount));
+    }
+  std::vector<NodeContainer> aggregation (k);
+  std::vector<NodeContainer> edge (k);
+  NodeContainer hosts;
+  for (uint32_t p = 0; p < k; ++p)
+    {
+      aggregation[p].Create (half, p % systemCount);
+      edge[p].Create (half, p % systemCount);
+      hosts.Create (half * half, p % systemCount);
+    }
+
+  InternetStackHelper stack;
+  stack.InstallAll ();
+
+  // Host links first, so that every host owns interface 1
+  Ipv4AddressHelper address;
+  address.SetBase ("10.0.0.0", "255.255.255.0");
+  for (uint32_t p = 0; p < k; ++p)
+    {
+      for (uint32_t e = 0; e < half; ++e)
+        {
+          for (uint32_t h = 0; h < half; ++h)
+            {
+              Connect (link, address, hosts.Get (p * half * half + e * half + h), edge[p].Get (e));
+            }
+        }
+    }
+  for (uint32_t p = 0; p < k; ++p)
+    {
+      for (uint32_t e = 0; e < half; ++e)
+        {
+          for (uint32_t a = 0; a < half; ++a)
+            {
+              Connect (link, address, edge[p].Get (e), aggregation[p].Get (a));
+            }
+        }
+      for (uint32_t a = 0; a < half; ++a)
+        {
+          for (uint32_t c = 0; c < half; ++c)
+            {
+              Connect (link, address, aggregation[p].Get (a), core.Get (a * half + c));
+            }
+        }
+    }
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  uint32_t nHosts = hosts.GetN ();
+  for (uint32_t h = 0; h < nHosts; ++h)
+    {
+      InstallFlow (hosts.Get (h), hosts.Get ((h + nHosts / 2) % nHosts), stopTime);
+    }
+}
+#endif
+
+int
+main (int argc, char *argv[])
+{
+#ifdef NS3_MPI
+  // Distributed simulation setup
+  MpiInterface::Enable (&argc, &argv);
+  GlobalValue::Bind ("SimulatorImplementationType",
+                     StringValue ("ns3::DistributedSimulatorImpl"));
+
+  uint32_t systemId = MpiInterface::GetSystemId ();
+  uint32_t systemCount = MpiInterface::GetSize ();
+
+  if (systemCount < 2)
+    {
+      std::cout << "This simulation requires at least 2 logical processors." << std::endl;
+      return 1;
+    }
+
+  std::string topology = "ring";
+  bool nullmsg = false;
+  uint32_t leaves = 4;
+  uint32_t k = 4;
+  double stopTime = 10.0;
+
+  Config::SetDefault ("ns3::OnOffApplication::PacketSize", UintegerValue (512));
+  Config::SetDefault ("ns3::OnOffApplication::DataRate", StringValue ("1Mbps"));
+
+  CommandLine cmd;
+  cmd.AddValue ("topology", "Topology to simulate: ring or fattree", topology);
+  cmd.AddValue ("nullmsg", "Synchronize with null messages instead of LBTS", nullmsg);
+  cmd.AddValue ("leaves", "Number of leaf nodes per router in the ring", leaves);
+  cmd.AddValue ("k", "Arity of the fat-tree (even)", k);
+  cmd.AddValue ("stop", "Simulation stop time in seconds", stopTime);
+  cmd.Parse (argc, argv);
+
+  if (nullmsg)
+    {
+      Config::SetDefault ("ns3::DistributedSimulatorImpl::SynchronizationMode",
+                          EnumValue (DistributedSimulatorImpl::SYNC_NULL_MESSAGE));
+    }
+
+  TIMER_TYPE t0, t1, t2;
+  TIMER_NOW (t0);
+
+  if (topology == "fattree")
+    {
+      if (k < 2 || k % 2 != 0)
+        {
+          std::cout << "The fat-tree arity must be even." << std::endl;
+          return 1;
+        }
+      BuildFatTree (systemCount, k, stopTime);
+    }
+  else
+    {
+      BuildRing (systemCount, leaves, stopTime);
+    }
+
+  TIMER_NOW (t1);
+  Simulator::Stop (Seconds (stopTime));
+  Simulator::Run ();
+  TIMER_NOW (t2);
+
+  double runTime = TIMER_DIFF (t2, t1);
+  double slowest = 0;
+  MPI_Reduce (&runTime, &slowest, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+  // Both algorithms must deliver exactly the same traffic
+  unsigned long received = 0;
+  for (ApplicationContainer::Iterator i = g_sinks.Begin (); i != g_sinks.End (); ++i)
+    {
+      received += DynamicCast<PacketSink> (*i)->GetTotalRx ();
+    }
+  unsigned long totalReceived = 0;
+  MPI_Reduce (&received, &totalReceived, 1, MPI_UNSIGNED_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+  if (systemId == 0)
+    {
+      std::cout << "topology=" << topology
+                << " ranks=" << systemCount
+                << " sync=" << (nullmsg ? "NullMessage" : "Lbts")
+                << " setup=" << TIMER_DIFF (t1, t0) << "s"
+                << " run=" << slowest << "s"
+                << " rxBytes=" << totalReceived << std::endl;
+    }
+
+  Simulator::Destroy ();
+  // Exit the MPI execution environment
+  MpiInterface::Disable ();
+  return 0;
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
@@ -26,6 +26,7 @@
 #include "ns3/node-container.h"
 #include "ns3/ptr.h"
 #include "ns3/pointer.h"
+#include "ns3/enum.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
 
@@ -76,6 +77,12 @@ DistributedSimulatorImpl::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::DistributedSimulatorImpl")
     .SetParent<Object> ()
     .AddConstructor<DistributedSimulatorImpl> ()
+    .AddAttribute ("SynchronizationMode",
+                   "Conservative synchronization algorithm used between ranks.",
+                   EnumValue (SYNC_LBTS),
+                   MakeEnumAccessor (&DistributedSimulatorImpl::SetSynchronizationMode),
+                   MakeEnumChecker (SYNC_LBTS, "Lbts",
+                                    SYNC_NULL_MESSAGE, "NullMessage"))
   ;
   return tid;
 }
@@ -85,6 +92,10 @@ DistributedSimulatorImpl::DistributedSimulatorImpl ()
 #ifdef NS3_MPI
   m_myId = MpiInterface::GetSystemId ();
   m_systemCount = MpiInterface::GetSize ();
+  if (MpiInterface::IsEnabled ())
+    {
+      MpiInterface::AllocateBuffers ();
+    }
 
   // Allocate the LBTS message buffer
   m_pLBTS = new LbtsMessage[m_systemCount];
@@ -105,6 +116,7 @@ DistributedSimulatorImpl::DistributedSimulatorImpl ()
   m_currentContext = 0xffffffff;
   m_unscheduledEvents = 0;
   m_events = 0;
+  m_synchronizationMode = SYNC_LBTS;
 }
 
 DistributedSimulatorImpl::~DistributedSimulatorImpl ()
@@ -142,10 +154,24 @@ DistributedSimulatorImpl::Destroy ()
 }
 
 
+void
+DistributedSimulatorImpl::SetSynchronizationMode (DistributedSimulatorImpl::SynchronizationMode mode)
+{
+  NS_LOG_FUNCTION (this << mode);
+  m_synchronizationMode = mode;
+}
+
+DistributedSimulatorImpl::SynchronizationMode
+DistributedSimulatorImpl::GetSynchronizationMode (void) const
+{
+  return m_synchronizationMode;
+}
+
 void
 DistributedSimulatorImpl::CalculateLookAhead (void)
 {
 #ifdef NS3_MPI
+  m_neighborLookAhead.clear ();
   if (MpiInterface::GetSize () <= 1)
     {
       DistributedSimulatorImpl::m_lookAhead = Seconds (0);
@@ -207,6 +233,15 @@ DistributedSimulatorImpl::CalculateLookAhead (void)
                   DistributedSimulatorImpl::m_lookAhead = delay.Get ();
                   m_grantedTime = delay.Get ();
                 }
+
+              // the smallest delay towards each neighbor rank bounds the
+              // null messages sent to it
+              uint32_t remoteId = remoteNode->GetSystemId ();
+              NeighborTimes::iterator neighbor = m_neighborLookAhead.find (remoteId);
+              if (neighbor == m_neighborLookAhead.end () || delay.Get () < neighbor->second)
+                {
+                  m_neighborLookAhead[remoteId] = delay.Get ();
+                }
             }
         }
     }
@@ -273,6 +308,27 @@ DistributedSimulatorImpl::Run (void)
 #ifdef NS3_MPI
   CalculateLookAhead ();
   m_stop = false;
+  if (m_synchronizationMode == SYNC_NULL_MESSAGE)
+    {
+      RunNullMessage ();
+    }
+  else
+    {
+      RunLbts ();
+    }
+
+  // If the simulator stopped naturally by lack of events, make a
+  // consistency test to check that we didn't lose any events along the way.
+  NS_ASSERT (!m_events->IsEmpty () || m_unscheduledEvents == 0);
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
+
+void
+DistributedSimulatorImpl::RunLbts (void)
+{
+#ifdef NS3_MPI
   while (!m_events->IsEmpty () && !m_stop)
     {
       Time nextTime = Next ();
@@ -316,10 +372,96 @@ DistributedSimulatorImpl::Run (void)
           ProcessOneEvent ();
         }
     }
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
 
-  // If the simulator stopped naturally by lack of events, make a
-  // consistency test to check that we didn't lose any events along the way.
-  NS_ASSERT (!m_events->IsEmpty () || m_unscheduledEvents == 0);
+void
+DistributedSimulatorImpl::RunNullMessage (void)
+{
+#ifdef NS3_MPI
+  m_grantedTime = Seconds (0);
+  m_nullMessageSent.clear ();
+  MpiInterface::ResetNullMessages ();
+  while (!m_stop)
+    {
+      if (!m_events->IsEmpty () && Next () <= m_grantedTime)
+        { // Safe to process
+          ProcessOneEvent ();
+          continue;
+        }
+      // Can't process; pick up packets and null messages from the neighbors
+      MpiInterface::ReceiveMessages ();
+      MpiInterface::TestSendComplete ();
+      // We may run up to the smallest guarantee of our neighbors
+      Time grantedTime = GetMaximumSimulationTime ();
+      for (NeighborTimes::const_iterator i = m_neighborLookAhead.begin (); i != m_neighborLookAhead.end (); ++i)
+        {
+          Time guarantee = MpiInterface::GetNullMessageGuarantee (i->first);
+          if (guarantee < grantedTime)
+            {
+              grantedTime = guarantee;
+            }
+        }
+      m_grantedTime = grantedTime;
+      // Nothing we send can leave earlier than our next event or anything
+      // a neighbor may still send us
+      Time lowerBound = m_grantedTime;
+      if (!m_events->IsEmpty () && Next () < lowerBound)
+        {
+          lowerBound = Next ();
+        }
+      SendNullMessages (lowerBound);
+      if (m_events->IsEmpty () && m_grantedTime == GetMaximumSimulationTime ())
+        { // Every neighbor is done and so are we
+          break;
+        }
+    }
+  // Let the neighbors run to completion without waiting on this rank
+  SendNullMessages (GetMaximumSimulationTime ());
+  // When stopped early, neighbors may still be sending to us.  Their final
+  // null message is the last thing they send, so drain until it arrived
+  // from all of them before the receive buffers get released.
+  bool draining = true;
+  while (draining)
+    {
+      MpiInterface::ReceiveMessages ();
+      MpiInterface::TestSendComplete ();
+      draining = false;
+      for (NeighborTimes::const_iterator i = m_neighborLookAhead.begin (); i != m_neighborLookAhead.end (); ++i)
+        {
+          if (MpiInterface::GetNullMessageGuarantee (i->first) < GetMaximumSimulationTime ())
+            {
+              draining = true;
+            }
+        }
+    }
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
+
+void
+DistributedSimulatorImpl::SendNullMessages (Time const &lowerBound)
+{
+#ifdef NS3_MPI
+  Time maximum = GetMaximumSimulationTime ();
+  for (NeighborTimes::const_iterator i = m_neighborLookAhead.begin (); i != m_neighborLookAhead.end (); ++i)
+    {
+      Time guarantee = maximum;
+      if (lowerBound < maximum - i->second)
+        {
+          guarantee = lowerBound + i->second;
+        }
+      NeighborTimes::iterator sent = m_nullMessageSent.find (i->first);
+      if (sent == m_nullMessageSent.end () || guarantee > sent->second)
+        {
+          NS_LOG_LOGIC ("null message to " << i->first << " guarantee " << guarantee);
+          MpiInterface::SendNullMessage (guarantee, i->first);
+          m_nullMessageSent[i->first] = guarantee;
+        }
+    }
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
 #endif
@@ -25,6 +25,7 @@
 #include "ns3/ptr.h"
 
 #include <list>
+#include <map>
 
 namespace ns3 {
 
@@ -87,10 +88,27 @@ private:
  * \ingroup mpi
  *
  * \brief distributed simulator implementation using lookahead
+ *
+ * Two conservative synchronization algorithms are available through the
+ * SynchronizationMode attribute.  SYNC_LBTS computes a global lower bound
+ * on time stamps with an all-gather across every rank each time a rank runs
+ * out of safe events.  SYNC_NULL_MESSAGE implements Chandy-Misra-Bryant null
+ * messages: each rank only tells the ranks it shares a point-to-point link
+ * with how far ahead they may safely run, which scales better when the cut
+ * graph is sparse.  In that mode the simulation must be bounded with
+ * Simulator::Stop, and remote links need a non-zero delay.
  */
 class DistributedSimulatorImpl : public SimulatorImpl
 {
 public:
+  /**
+   * Conservative synchronization algorithm used between ranks
+   */
+  enum SynchronizationMode {
+    SYNC_LBTS, /** All-gather of the lower bound on time stamps across all ranks */
+    SYNC_NULL_MESSAGE, /** Null messages exchanged with neighboring ranks only */
+  };
+
   static TypeId GetTypeId (void);
 
   DistributedSimulatorImpl ();
@@ -116,9 +134,20 @@ public:
   virtual uint32_t GetSystemId (void) const;
   virtual uint32_t GetContext (void) const;
 
+  void SetSynchronizationMode (DistributedSimulatorImpl::SynchronizationMode mode);
+  DistributedSimulatorImpl::SynchronizationMode GetSynchronizationMode (void) const;
+
 private:
   virtual void DoDispose (void);
   void CalculateLookAhead (void);
+  void RunLbts (void);
+  void RunNullMessage (void);
+  /**
+   * \param lowerBound earliest time at which this rank may still send a packet
+   *
+   * Send a null message to every neighbor whose guarantee has advanced
+   */
+  void SendNullMessages (Time const &lowerBound);
 
   void ProcessOneEvent (void);
   uint64_t NextTs (void) const;
@@ -142,6 +171,10 @@ private:
   Time         m_grantedTime; // Last LBTS
   static Time  m_lookAhead;   // Lookahead value
 
+  SynchronizationMode m_synchronizationMode;
+  typedef std::map<uint32_t, Time> NeighborTimes;
+  NeighborTimes m_neighborLookAhead; // Smallest link delay to each neighbor rank
+  NeighborTimes m_nullMessageSent;   // Last guarantee sent to each neighbor rank
 };
 
 } // namespace ns3
@@ -39,6 +39,9 @@
 
 namespace ns3 {
 
+// Destination node id marking a null message rather than a packet
+static const uint32_t NULL_MESSAGE_NODE = 0xffffffff;
+
 SentBuffer::SentBuffer ()
 {
   m_buffer = 0;
@@ -76,28 +79,79 @@ bool                  MpiInterface::m_initialized = false;
 bool                  MpiInterface::m_enabled = false;
 uint32_t              MpiInterface::m_rxCount = 0;
 uint32_t              MpiInterface::m_txCount = 0;
+uint32_t*             MpiInterface::m_pRxCounts = 0;
+uint32_t*             MpiInterface::m_pTxCounts = 0;
+Time*                 MpiInterface::m_pPendingGuarantees = 0;
+uint32_t*             MpiInterface::m_pPendingTxCounts = 0;
+Time*                 MpiInterface::m_pGuarantees = 0;
 std::list<SentBuffer> MpiInterface::m_pendingTx;
 
 #ifdef NS3_MPI
-MPI_Request* MpiInterface::m_requests;
-char**       MpiInterface::m_pRxBuffers;
+MPI_Request* MpiInterface::m_requests = 0;
+char**       MpiInterface::m_pRxBuffers = 0;
 #endif
 
 void
 MpiInterface::Destroy ()
 {
 #ifdef NS3_MPI
+  if (m_pRxBuffers == 0)
+    {
+      return;
+    }
   for (uint32_t i = 0; i < GetSize (); ++i)
     {
+      // MPI must not write into the buffer once it is deleted
+      MPI_Cancel (&m_requests[i]);
+      MPI_Wait (&m_requests[i], MPI_STATUS_IGNORE);
       delete [] m_pRxBuffers[i];
     }
   delete [] m_pRxBuffers;
   delete [] m_requests;
+  delete [] m_pRxCounts;
+  delete [] m_pTxCounts;
+  delete [] m_pPendingGuarantees;
+  delete [] m_pPendingTxCounts;
+  delete [] m_pGuarantees;
+  m_pRxBuffers = 0;
+  m_requests = 0;
 
   m_pendingTx.clear ();
 #endif
 }
 
+void
+MpiInterface::AllocateBuffers ()
+{
+#ifdef NS3_MPI
+  if (m_pRxBuffers != 0)
+    {
+      return;
+    }
+  m_rxCount = 0;
+  m_txCount = 0;
+  // Post a non-blocking receive for all peers
+  m_pRxBuffers = new char*[m_size];
+  m_requests = new MPI_Request[m_size];
+  m_pRxCounts = new uint32_t[m_size];
+  m_pTxCounts = new uint32_t[m_size];
+  m_pPendingGuarantees = new Time[m_size];
+  m_pPendingTxCounts = new uint32_t[m_size];
+  m_pGuarantees = new Time[m_size];
+  for (uint32_t i = 0; i < GetSize (); ++i)
+    {
+      m_pRxBuffers[i] = new char[MAX_MPI_MSG_SIZE];
+      m_pRxCounts[i] = 0;
+      m_pTxCounts[i] = 0;
+      m_pPendingTxCounts[i] = 0;
+      MPI_Irecv (m_pRxBuffers[i], MAX_MPI_MSG_SIZE, MPI_CHAR, MPI_ANY_SOURCE, 0,
+                 MPI_COMM_WORLD, &m_requests[i]);
+    }
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
+
 uint32_t
 MpiInterface::GetRxCount ()
 {
@@ -154,15 +208,7 @@ MpiInterface::Enable (int* pargc, char*** pargv)
   MPI_Comm_size (MPI_COMM_WORLD, reinterpret_cast <int *> (&m_size));
   m_enabled = true;
   m_initialized = true;
-  // Post a non-blocking receive for all peers
-  m_pRxBuffers = new char*[m_size];
-  m_requests = new MPI_Request[m_size];
-  for (uint32_t i = 0; i < GetSize (); ++i)
-    {
-      m_pRxBuffers[i] = new char[MAX_MPI_MSG_SIZE];
-      MPI_Irecv (m_pRxBuffers[i], MAX_MPI_MSG_SIZE, MPI_CHAR, MPI_ANY_SOURCE, 0,
-                 MPI_COMM_WORLD, &m_requests[i]);
-    }
+  AllocateBuffers ();
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
 #endif
@@ -196,6 +242,64 @@ MpiInterface::SendPacket (Ptr<Packet> p, const Time& rxTime, uint32_t node, uint
   MPI_Isend (reinterpret_cast<void *> (i->GetBuffer ()), serializedSize + 16, MPI_CHAR, nodeSysId,
              0, MPI_COMM_WORLD, (i->GetRequest ()));
   m_txCount++;
+  m_pTxCounts[nodeSysId]++;
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
+
+void
+MpiInterface::SendNullMessage (const Time &guarantee, uint32_t rank)
+{
+#ifdef NS3_MPI
+  SentBuffer sendBuf;
+  m_pendingTx.push_back (sendBuf);
+  std::list<SentBuffer>::reverse_iterator i = m_pendingTx.rbegin (); // Points to the last element
+
+  uint8_t* buffer =  new uint8_t[16];
+  i->SetBuffer (buffer);
+  // Same layout as a packet header, but the time is sent in time steps,
+  // the node is the null message marker and the device slot carries the
+  // number of packets sent to rank so far
+  uint64_t* pTime = reinterpret_cast <uint64_t *> (buffer);
+  *pTime++ = guarantee.GetTimeStep ();
+  uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
+  *pData++ = NULL_MESSAGE_NODE;
+  *pData++ = m_pTxCounts[rank];
+
+  MPI_Isend (reinterpret_cast<void *> (i->GetBuffer ()), 16, MPI_CHAR, rank,
+             0, MPI_COMM_WORLD, (i->GetRequest ()));
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
+
+Time
+MpiInterface::GetNullMessageGuarantee (uint32_t rank)
+{
+#ifdef NS3_MPI
+  // A guarantee only holds once all the packets sent ahead of it
+  // have arrived; until then keep relying on the previous one.
+  if (m_pRxCounts[rank] >= m_pPendingTxCounts[rank])
+    {
+      m_pGuarantees[rank] = m_pPendingGuarantees[rank];
+    }
+  return m_pGuarantees[rank];
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
+
+void
+MpiInterface::ResetNullMessages ()
+{
+#ifdef NS3_MPI
+  for (uint32_t i = 0; i < GetSize (); ++i)
+    {
+      m_pPendingGuarantees[i] = Seconds (0);
+      m_pPendingTxCounts[i] = 0;
+      m_pGuarantees[i] = Seconds (0);
+    }
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
 #endif
@@ -218,7 +322,6 @@ MpiInterface::ReceiveMessages ()
         }
       int count;
       MPI_Get_count (&status, MPI_CHAR, &count);
-      m_rxCount++; // Count this receive
 
       // Get the meta data first
       uint64_t* pTime = reinterpret_cast<uint64_t *> (m_pRxBuffers[index]);
@@ -227,6 +330,23 @@ MpiInterface::ReceiveMessages ()
       uint32_t node = *pData++;
       uint32_t dev  = *pData++;
 
+      if (node == NULL_MESSAGE_NODE)
+        { // Null message, see SendNullMessage for the layout.  Guarantees
+          // only ever grow, so a stale one completing late is ignored.
+          if (TimeStep (nanoSeconds) > m_pPendingGuarantees[status.MPI_SOURCE])
+            {
+              m_pPendingGuarantees[status.MPI_SOURCE] = TimeStep (nanoSeconds);
+              m_pPendingTxCounts[status.MPI_SOURCE] = dev;
+            }
+
+          MPI_Irecv (m_pRxBuffers[index], MAX_MPI_MSG_SIZE, MPI_CHAR, MPI_ANY_SOURCE, 0,
+                     MPI_COMM_WORLD, &m_requests[index]);
+          continue;
+        }
+
+      m_rxCount++; // Count this receive
+      m_pRxCounts[status.MPI_SOURCE]++;
+
       Time rxTime = NanoSeconds (nanoSeconds);
 
       count -= sizeof (nanoSeconds) + sizeof (node) + sizeof (dev);
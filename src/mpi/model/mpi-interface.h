@@ -90,9 +90,15 @@ class MpiInterface
 {
 public:
   /**
-   * Delete all buffers
+   * Cancel the pending receives and delete all buffers
    */
   static void Destroy ();
+  /**
+   * Allocate the buffers and post the receives, unless already done.
+   * Called by Enable and, for another run after Simulator::Destroy, by
+   * the DistributedSimulatorImpl constructor.
+   */
+  static void AllocateBuffers ();
   /**
    * \return MPI rank
    */
@@ -143,6 +149,25 @@ public:
    * \return transmitted count in packets
    */
   static uint32_t GetTxCount ();
+  /**
+   * \param guarantee lower bound on the receive time of any packet this
+   *        system will send to rank from now on
+   * \param rank destination system
+   *
+   * Send a Chandy-Misra-Bryant null message to the specified system
+   */
+  static void SendNullMessage (const Time &guarantee, uint32_t rank);
+  /**
+   * \param rank source system
+   * \return the latest null message guarantee received from rank for
+   * which every packet rank sent beforehand has also been received
+   */
+  static Time GetNullMessageGuarantee (uint32_t rank);
+  /**
+   * Forget the null messages of a previous run, so that the guarantees
+   * of the next one start from zero
+   */
+  static void ResetNullMessages ();
 
 private:
   static uint32_t m_sid;
@@ -153,6 +178,18 @@ private:
 
   // Total packets sent
   static uint32_t m_txCount;
+
+  // Packets received from and sent to each system
+  static uint32_t* m_pRxCounts;
+  static uint32_t* m_pTxCounts;
+
+  // Latest null message from each system, along with the number of
+  // packets that system had sent to us when it issued the message
+  static Time*     m_pPendingGuarantees;
+  static uint32_t* m_pPendingTxCounts;
+
+  // Latest null message guarantee from each system known to be safe
+  static Time*     m_pGuarantees;
   static bool     m_initialized;
   static bool     m_enabled;
 
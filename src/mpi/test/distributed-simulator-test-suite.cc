@@ -0,0 +1,360 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// The same scenario is run with both synchronization algorithms of
+// DistributedSimulatorImpl, which must process the same events at the
+// same times.  The test runner alone runs it on a single rank; to check
+// the synchronization across ranks, run it under MPI, e.g.:
+//
+//   mpirun -np 3 ./test-runner --suite=distributed-simulator
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/simulator-impl.h"
+#include "ns3/object-factory.h"
+#include "ns3/string.h"
+#include "ns3/nstime.h"
+#include "ns3/channel.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/error-model.h"
+#include "ns3/mpi-interface.h"
+#include "ns3/mpi-receiver.h"
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+#ifdef NS3_MPI
+#include <mpi.h>
+#endif
+
+namespace ns3 {
+
+class DistributedTestChannel;
+
+// A device of a DistributedTestChannel
+class DistributedTestDevice : public SimpleNetDevice
+{
+public:
+  static TypeId GetTypeId (void);
+  typedef Callback<void, Ptr<DistributedTestDevice>, Ptr<Packet> > HandlerCallback;
+
+  void SetTestChannel (Ptr<DistributedTestChannel> channel);
+  void SetHandler (HandlerCallback handler);
+  void Transmit (Ptr<Packet> packet);
+  void ReceiveFromChannel (Ptr<Packet> packet);
+
+  virtual Ptr<Channel> GetChannel (void) const;
+  virtual bool IsPointToPoint (void) const;
+
+private:
+  virtual void DoDispose (void);
+
+  Ptr<DistributedTestChannel> m_testChannel;
+  HandlerCallback m_handler;
+};
+
+// Point-to-point channel which hands the packets to MPI when the peer
+// device lives on another rank, like PointToPointRemoteChannel
+class DistributedTestChannel : public Channel
+{
+public:
+  static TypeId GetTypeId (void);
+
+  void Attach (Ptr<DistributedTestDevice> device);
+  void Transmit (Ptr<Packet> packet, Ptr<DistributedTestDevice> source);
+
+  virtual uint32_t GetNDevices (void) const;
+  virtual Ptr<NetDevice> GetDevice (uint32_t i) const;
+
+private:
+  virtual void DoDispose (void);
+
+  Time m_delay;
+  std::vector<Ptr<DistributedTestDevice> > m_devices;
+};
+
+TypeId
+DistributedTestDevice::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DistributedTestDevice")
+    .SetParent<SimpleNetDevice> ()
+    .AddConstructor<DistributedTestDevice> ()
+  ;
+  return tid;
+}
+
+void
+DistributedTestDevice::SetTestChannel (Ptr<DistributedTestChannel> channel)
+{
+  m_testChannel = channel;
+}
+
+void
+DistributedTestDevice::SetHandler (HandlerCallback handler)
+{
+  m_handler = handler;
+}
+
+void
+DistributedTestDevice::Transmit (Ptr<Packet> packet)
+{
+  m_testChannel->Transmit (packet, this);
+}
+
+void
+DistributedTestDevice::ReceiveFromChannel (Ptr<Packet> packet)
+{
+  m_handler (this, packet);
+}
+
+Ptr<Channel>
+DistributedTestDevice::GetChannel (void) const
+{
+  return m_testChannel;
+}
+
+bool
+DistributedTestDevice::IsPointToPoint (void) const
+{
+  return true;
+}
+
+void
+DistributedTestDevice::DoDispose (void)
+{
+  m_testChannel = 0;
+  m_handler = HandlerCallback ();
+  SimpleNetDevice::DoDispose ();
+}
+
+TypeId
+DistributedTestChannel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DistributedTestChannel")
+    .SetParent<Channel> ()
+    .AddConstructor<DistributedTestChannel> ()
+    .AddAttribute ("Delay", "Propagation delay through the channel",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&DistributedTestChannel::m_delay),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+void
+DistributedTestChannel::Attach (Ptr<DistributedTestDevice> device)
+{
+  NS_ASSERT (m_devices.size () < 2);
+  m_devices.push_back (device);
+  device->SetTestChannel (this);
+}
+
+void
+DistributedTestChannel::Transmit (Ptr<Packet> packet, Ptr<DistributedTestDevice> source)
+{
+  Ptr<DistributedTestDevice> destination = m_devices[source == m_devices[0] ? 1 : 0];
+  Ptr<Node> node = destination->GetNode ();
+  if (node->GetSystemId () == MpiInterface::GetSystemId ())
+    {
+      Simulator::ScheduleWithContext (node->GetId (), m_delay,
+                                      &DistributedTestDevice::ReceiveFromChannel, destination, packet);
+    }
+  else
+    {
+      MpiInterface::SendPacket (packet, Simulator::Now () + m_delay, node->GetId (), destination->GetIfIndex ());
+    }
+}
+
+uint32_t
+DistributedTestChannel::GetNDevices (void) const
+{
+  return m_devices.size ();
+}
+
+Ptr<NetDevice>
+DistributedTestChannel::GetDevice (uint32_t i) const
+{
+  return m_devices[i];
+}
+
+void
+DistributedTestChannel::DoDispose (void)
+{
+  m_devices.clear ();
+  Channel::DoDispose ();
+}
+
+class DistributedSimulatorSyncTestCase : public TestCase
+{
+public:
+  DistributedSimulatorSyncTestCase ();
+
+private:
+  virtual void DoRun (void);
+  // Run the ring with the given synchronization mode, returning the
+  // trace of the packets received by the nodes of this rank
+  void RunRing (std::string mode, std::vector<std::string> &trace, Time &end);
+  void Receive (Ptr<DistributedTestDevice> device, Ptr<Packet> packet);
+  void Forward (uint32_t node, uint8_t token, uint8_t hops);
+
+  std::vector<Ptr<DistributedTestDevice> > m_next;
+  std::vector<std::string> m_trace;
+};
+
+DistributedSimulatorSyncTestCase::DistributedSimulatorSyncTestCase ()
+  : TestCase ("Check that the null message and LBTS synchronizations process the same events")
+{
+}
+
+void
+DistributedSimulatorSyncTestCase::Forward (uint32_t node, uint8_t token, uint8_t hops)
+{
+  uint8_t data[2] = { token, hops };
+  m_next[node]->Transmit (Create<Packet> (data, 2));
+}
+
+void
+DistributedSimulatorSyncTestCase::Receive (Ptr<DistributedTestDevice> device, Ptr<Packet> packet)
+{
+  uint8_t data[2];
+  packet->CopyData (data, 2);
+  uint32_t node = device->GetNode ()->GetId ();
+  std::ostringstream oss;
+  oss << Simulator::Now ().GetNanoSeconds () << " node " << node
+      << " token " << uint32_t (data[0]) << " hop " << uint32_t (data[1]);
+  m_trace.push_back (oss.str ());
+  if (data[1] < 40)
+    {
+      // Whole milliseconds, so that the times of token k are k ns past
+      // a millisecond: events of different tokens never tie, and the
+      // order of the trace is the order of the events
+      Simulator::Schedule (MilliSeconds (1 + (data[0] + data[1]) % 3),
+                           &DistributedSimulatorSyncTestCase::Forward, this, node, data[0], data[1] + 1);
+    }
+}
+
+void
+DistributedSimulatorSyncTestCase::RunRing (std::string mode, std::vector<std::string> &trace, Time &end)
+{
+  ObjectFactory factory;
+  factory.SetTypeId ("ns3::DistributedSimulatorImpl");
+  factory.Set ("SynchronizationMode", StringValue (mode));
+  Simulator::SetImplementation (factory.Create<SimulatorImpl> ());
+
+  // Two nodes per rank, every node linked to the next one of the ring
+  uint32_t ranks = MpiInterface::GetSize ();
+  uint32_t nNodes = std::max (2 * ranks, 4u);
+  std::vector<Ptr<Node> > nodes;
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      nodes.push_back (CreateObject<Node> ((i / 2) % ranks));
+    }
+  m_next.clear ();
+  m_next.resize (nNodes);
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      Ptr<DistributedTestChannel> channel = CreateObject<DistributedTestChannel> ();
+      channel->SetAttribute ("Delay", TimeValue (MilliSeconds (2 + i % 3)));
+      Ptr<Node> ends[2] = { nodes[i], nodes[(i + 1) % nNodes] };
+      for (uint32_t j = 0; j < 2; ++j)
+        {
+          Ptr<DistributedTestDevice> device = CreateObject<DistributedTestDevice> ();
+          device->SetHandler (MakeCallback (&DistributedSimulatorSyncTestCase::Receive, this));
+          ends[j]->AddDevice (device);
+          channel->Attach (device);
+          Ptr<MpiReceiver> receiver = CreateObject<MpiReceiver> ();
+          receiver->SetReceiveCallback (MakeCallback (&DistributedTestDevice::ReceiveFromChannel, device));
+          device->AggregateObject (receiver);
+          if (j == 0)
+            {
+              m_next[i] = device;
+            }
+        }
+    }
+
+  // One token starts on every even node
+  for (uint32_t i = 0; i < nNodes; i += 2)
+    {
+      if (nodes[i]->GetSystemId () == MpiInterface::GetSystemId ())
+        {
+          Simulator::ScheduleWithContext (i, NanoSeconds (i / 2), &DistributedSimulatorSyncTestCase::Forward,
+                                          this, i, uint8_t (i / 2), uint8_t (0));
+        }
+    }
+
+  m_trace.clear ();
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+  trace = m_trace;
+  end = Simulator::Now ();
+  m_next.clear ();
+  Simulator::Destroy ();
+#ifdef NS3_MPI
+  // The next run must not receive the messages of this one
+  MPI_Barrier (MPI_COMM_WORLD);
+#endif
+}
+
+void
+DistributedSimulatorSyncTestCase::DoRun (void)
+{
+  bool enabled = MpiInterface::IsEnabled ();
+  Simulator::Destroy ();
+  if (!enabled)
+    {
+      MpiInterface::Enable (0, 0);
+    }
+
+  std::vector<std::string> lbts;
+  Time lbtsEnd;
+  RunRing ("Lbts", lbts, lbtsEnd);
+  std::vector<std::string> nullMessage;
+  Time nullMessageEnd;
+  RunRing ("NullMessage", nullMessage, nullMessageEnd);
+
+  if (!enabled)
+    {
+      MpiInterface::Disable ();
+    }
+
+  NS_TEST_ASSERT_MSG_EQ ((lbts.size () > 0), true, "No packet received");
+  NS_TEST_ASSERT_MSG_EQ (nullMessage.size (), lbts.size (), "Not the same number of events");
+  for (uint32_t i = 0; i < lbts.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (nullMessage[i], lbts[i], "Event " << i << " differs");
+    }
+  NS_TEST_ASSERT_MSG_EQ (nullMessageEnd, lbtsEnd, "Not the same final time");
+}
+
+class DistributedSimulatorTestSuite : public TestSuite
+{
+public:
+  DistributedSimulatorTestSuite ();
+};
+
+DistributedSimulatorTestSuite::DistributedSimulatorTestSuite ()
+  : TestSuite ("distributed-simulator", SYSTEM)
+{
+  AddTestCase (new DistributedSimulatorSyncTestCase);
+}
+
+static DistributedSimulatorTestSuite g_distributedSimulatorTestSuite;
+
+} // namespace ns3
@@ -0,0 +1,427 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <cstring>
+#include <algorithm>
+#include <stdlib.h>
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "binary-trace.h"
+
+NS_LOG_COMPONENT_DEFINE ("BinaryTrace");
+
+namespace {
+
+const char MAGIC[7] = { 'n', 's', '3', 'b', 't', 'r', 'c' };
+const uint8_t VERSION = 1;
+
+// the columns, in the order in which they are written
+enum Field
+{
+  TIME,
+  NODE,
+  DEVICE,
+  EVENT,
+  UID,
+  SIZE,
+  HEADER,
+  N_FIELDS
+};
+const char *FIELD_NAMES[N_FIELDS] = { "time", "node", "device", "event", "uid", "size", "header" };
+const uint32_t FIELD_WIDTHS[N_FIELDS] = { 8, 4, 4, 1, 8, 4, 0 };
+
+void
+Encode (uint8_t *buffer, uint64_t value, uint32_t width)
+{
+  for (uint32_t i = 0; i < width; i++)
+    {
+      buffer[i] = value & 0xff;
+      value >>= 8;
+    }
+}
+
+uint64_t
+Decode (uint8_t const *buffer, uint32_t width)
+{
+  uint64_t value = 0;
+  for (uint32_t i = width; i > 0; i--)
+    {
+      value <<= 8;
+      value |= buffer[i - 1];
+    }
+  return value;
+}
+
+void
+WriteU32 (std::ostream *os, uint32_t value)
+{
+  uint8_t buffer[4];
+  Encode (buffer, value, 4);
+  os->write ((const char *)buffer, 4);
+}
+
+bool
+ReadU32 (std::istream &is, uint32_t &value)
+{
+  uint8_t buffer[4];
+  is.read ((char *)buffer, 4);
+  value = Decode (buffer, 4);
+  return is.gcount () == 4;
+}
+
+// the number after prefix in context, or NO_ID
+uint32_t
+FindId (std::string const &context, const char *prefix)
+{
+  std::string::size_type pos = context.find (prefix);
+  if (pos == std::string::npos)
+    {
+      return ns3::BinaryTraceRecord::NO_ID;
+    }
+  const char *start = context.c_str () + pos + strlen (prefix);
+  char *end;
+  unsigned long id = strtoul (start, &end, 10);
+  if (end == start)
+    {
+      return ns3::BinaryTraceRecord::NO_ID;
+    }
+  return id;
+}
+
+} // anonymous namespace
+
+namespace ns3 {
+
+BinaryTraceWriter::BinaryTraceWriter (std::ostream *os, uint32_t headerBytes, uint32_t chunkRecords)
+  : m_os (os),
+    m_headerBytes (headerBytes),
+    m_chunkRecords (chunkRecords),
+    m_count (0)
+{
+  NS_LOG_FUNCTION (this << os << headerBytes << chunkRecords);
+  NS_ASSERT (chunkRecords > 0);
+  m_os->write (MAGIC, sizeof (MAGIC));
+  m_os->put (VERSION);
+  uint32_t nColumns = headerBytes == 0 ? N_FIELDS - 1 : N_FIELDS;
+  WriteU32 (m_os, nColumns);
+  for (uint32_t i = 0; i < nColumns; i++)
+    {
+      uint32_t width = i == HEADER ? headerBytes : FIELD_WIDTHS[i];
+      WriteColumn (FIELD_NAMES[i], width);
+      m_columns[i].resize (width * chunkRecords);
+    }
+}
+
+BinaryTraceWriter::~BinaryTraceWriter ()
+{
+  NS_LOG_FUNCTION (this);
+  Flush ();
+}
+
+void
+BinaryTraceWriter::WriteColumn (std::string name, uint32_t width)
+{
+  m_os->put (name.size ());
+  m_os->write (name.c_str (), name.size ());
+  WriteU32 (m_os, width);
+}
+
+uint8_t *
+BinaryTraceWriter::GetColumn (uint32_t column, uint32_t width)
+{
+  return &m_columns[column][m_count * width];
+}
+
+void
+BinaryTraceWriter::Write (const BinaryTraceRecord &record)
+{
+  NS_LOG_FUNCTION (this << record.time << record.node << record.device << record.event);
+  Encode (GetColumn (TIME, 8), record.time, 8);
+  Encode (GetColumn (NODE, 4), record.node, 4);
+  Encode (GetColumn (DEVICE, 4), record.device, 4);
+  *GetColumn (EVENT, 1) = record.event;
+  Encode (GetColumn (UID, 8), record.uid, 8);
+  Encode (GetColumn (SIZE, 4), record.size, 4);
+  if (m_headerBytes != 0)
+    {
+      uint8_t *header = GetColumn (HEADER, m_headerBytes);
+      uint32_t n = std::min<uint32_t> (m_headerBytes, record.header.size ());
+      if (n != 0)
+        {
+          memcpy (header, &record.header[0], n);
+        }
+      memset (header + n, 0, m_headerBytes - n);
+    }
+  m_count++;
+  if (m_count == m_chunkRecords)
+    {
+      Flush ();
+    }
+}
+
+void
+BinaryTraceWriter::Write (uint8_t event, uint32_t node, uint32_t device, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << event << node << device << p);
+  Encode (GetColumn (TIME, 8), Simulator::Now ().GetNanoSeconds (), 8);
+  Encode (GetColumn (NODE, 4), node, 4);
+  Encode (GetColumn (DEVICE, 4), device, 4);
+  *GetColumn (EVENT, 1) = event;
+  Encode (GetColumn (UID, 8), p->GetUid (), 8);
+  Encode (GetColumn (SIZE, 4), p->GetSize (), 4);
+  if (m_headerBytes != 0)
+    {
+      uint8_t *header = GetColumn (HEADER, m_headerBytes);
+      uint32_t n = p->CopyData (header, m_headerBytes);
+      memset (header + n, 0, m_headerBytes - n);
+    }
+  m_count++;
+  if (m_count == m_chunkRecords)
+    {
+      Flush ();
+    }
+}
+
+void
+BinaryTraceWriter::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_count == 0)
+    {
+      return;
+    }
+  WriteU32 (m_os, m_count);
+  for (uint32_t i = 0; i < N_FIELDS; i++)
+    {
+      uint32_t width = i == HEADER ? m_headerBytes : FIELD_WIDTHS[i];
+      if (width != 0)
+        {
+          m_os->write ((const char *)&m_columns[i][0], m_count * width);
+        }
+    }
+  m_os->flush ();
+  m_count = 0;
+}
+
+uint32_t
+BinaryTraceWriter::GetHeaderBytes (void) const
+{
+  return m_headerBytes;
+}
+
+BinaryTraceReader::BinaryTraceReader ()
+  : m_headerBytes (0),
+    m_count (0),
+    m_current (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+BinaryTraceReader::~BinaryTraceReader ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+bool
+BinaryTraceReader::Open (std::string const &filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  Close ();
+  m_file.open (filename.c_str (), std::ios::in | std::ios::binary);
+  char magic[sizeof (MAGIC)];
+  m_file.read (magic, sizeof (MAGIC));
+  if (m_file.gcount () != sizeof (MAGIC) || memcmp (magic, MAGIC, sizeof (MAGIC)) != 0)
+    {
+      NS_LOG_LOGIC ("not a binary trace: " << filename);
+      Close ();
+      return false;
+    }
+  if (m_file.get () != VERSION)
+    {
+      NS_LOG_LOGIC ("unknown version of binary trace: " << filename);
+      Close ();
+      return false;
+    }
+  uint32_t nColumns;
+  if (!ReadU32 (m_file, nColumns))
+    {
+      Close ();
+      return false;
+    }
+  for (uint32_t i = 0; i < nColumns; i++)
+    {
+      Column column;
+      int length = m_file.get ();
+      if (length == std::char_traits<char>::eof ())
+        {
+          Close ();
+          return false;
+        }
+      column.name.resize (length);
+      m_file.read (&column.name[0], length);
+      if (!ReadU32 (m_file, column.width))
+        {
+          Close ();
+          return false;
+        }
+      column.field = -1;
+      for (uint32_t j = 0; j < N_FIELDS; j++)
+        {
+          if (column.name == FIELD_NAMES[j]
+              && (j == HEADER || column.width == FIELD_WIDTHS[j]))
+            {
+              column.field = j;
+            }
+        }
+      if (column.field == HEADER)
+        {
+          m_headerBytes = column.width;
+        }
+      m_columns.push_back (column);
+    }
+  return true;
+}
+
+void
+BinaryTraceReader::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_file.is_open ())
+    {
+      m_file.close ();
+    }
+  m_file.clear ();
+  m_columns.clear ();
+  m_headerBytes = 0;
+  m_count = 0;
+  m_current = 0;
+}
+
+bool
+BinaryTraceReader::ReadChunk (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t count;
+  if (!ReadU32 (m_file, count) || count == 0)
+    {
+      return false;
+    }
+  for (std::vector<Column>::iterator i = m_columns.begin (); i != m_columns.end (); i++)
+    {
+      i->data.resize (count * i->width);
+      if (i->data.empty ())
+        {
+          continue;
+        }
+      m_file.read ((char *)&i->data[0], i->data.size ());
+      if ((uint32_t)m_file.gcount () != i->data.size ())
+        {
+          NS_LOG_LOGIC ("truncated chunk");
+          return false;
+        }
+    }
+  m_count = count;
+  m_current = 0;
+  return true;
+}
+
+bool
+BinaryTraceReader::Read (BinaryTraceRecord &record)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_file.is_open ())
+    {
+      return false;
+    }
+  if (m_current == m_count && !ReadChunk ())
+    {
+      return false;
+    }
+  record.time = 0;
+  record.node = 0;
+  record.device = 0;
+  record.event = 0;
+  record.uid = 0;
+  record.size = 0;
+  record.header.clear ();
+  for (std::vector<Column>::const_iterator i = m_columns.begin (); i != m_columns.end (); i++)
+    {
+      uint8_t const *value = i->data.empty () ? 0 : &i->data[m_current * i->width];
+      switch (i->field)
+        {
+        case TIME:
+          record.time = Decode (value, 8);
+          break;
+        case NODE:
+          record.node = Decode (value, 4);
+          break;
+        case DEVICE:
+          record.device = Decode (value, 4);
+          break;
+        case EVENT:
+          record.event = *value;
+          break;
+        case UID:
+          record.uid = Decode (value, 8);
+          break;
+        case SIZE:
+          record.size = Decode (value, 4);
+          break;
+        case HEADER:
+          record.header.assign (value, value + i->width);
+          break;
+        default:
+          break;
+        }
+    }
+  m_current++;
+  return true;
+}
+
+uint32_t
+BinaryTraceReader::GetHeaderBytes (void) const
+{
+  return m_headerBytes;
+}
+
+BinaryTraceStreamWrapper::BinaryTraceStreamWrapper (std::string filename, uint32_t headerBytes)
+  : OutputStreamWrapper (filename, std::ios::out | std::ios::binary),
+    m_writer (GetStream (), headerBytes)
+{
+  NS_LOG_FUNCTION (this << filename << headerBytes);
+}
+
+BinaryTraceStreamWrapper::~BinaryTraceStreamWrapper ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+BinaryTraceStreamWrapper::Write (uint8_t event, std::string const &context, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << event << context << p);
+  m_writer.Write (event, FindId (context, "/NodeList/"), FindId (context, "/DeviceList/"), p);
+}
+
+BinaryTraceWriter &
+BinaryTraceStreamWrapper::GetWriter (void)
+{
+  return m_writer;
+}
+
+} // namespace ns3
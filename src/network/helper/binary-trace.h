@@ -0,0 +1,201 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef BINARY_TRACE_H
+#define BINARY_TRACE_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdint.h>
+#include "ns3/ptr.h"
+#include "ns3/output-stream-wrapper.h"
+
+namespace ns3 {
+
+class Packet;
+
+/**
+ * \brief One event of a binary trace
+ *
+ * The event types are the characters which start the lines of the
+ * ascii traces: '+' (enqueue), '-' (dequeue), 'd' (drop) and 'r'
+ * (receive).  The node and the device are NO_ID when the trace sink
+ * had no context to find them in.
+ */
+struct BinaryTraceRecord
+{
+  static const uint32_t NO_ID = 0xffffffff;
+
+  int64_t time;                //!< nanoseconds
+  uint32_t node;
+  uint32_t device;
+  uint8_t event;
+  uint64_t uid;
+  uint32_t size;
+  std::vector<uint8_t> header; //!< the first bytes of the packet
+};
+
+/**
+ * \brief Write binary traces
+ *
+ * A binary trace starts with a schema: the magic "ns3btrc", a version
+ * byte, the number of columns, then the name (length-prefixed) and the
+ * width in bytes of each column.  The columns are "time" (8 bytes),
+ * "node" (4), "device" (4), "event" (1), "uid" (8), "size" (4) and,
+ * when headerBytes is not zero, "header" (headerBytes).  Records
+ * follow in chunks: the number of records of the chunk, then the
+ * values of each column in turn.  All the integers are little endian.
+ *
+ * The records are buffered until a chunk is full, or Flush is called.
+ */
+class BinaryTraceWriter
+{
+public:
+  static const uint32_t CHUNK_RECORDS_DEFAULT = 4096;
+
+  /**
+   * \param os the stream to write to, opened in binary mode
+   * \param headerBytes the number of bytes of each packet to store
+   * \param chunkRecords the number of records of a chunk
+   */
+  BinaryTraceWriter (std::ostream *os, uint32_t headerBytes = 0,
+                     uint32_t chunkRecords = CHUNK_RECORDS_DEFAULT);
+  ~BinaryTraceWriter ();
+
+  /**
+   * \param record the record to add; only the first headerBytes
+   *        bytes of its header are stored, padded with zeroes.
+   */
+  void Write (const BinaryTraceRecord &record);
+  /**
+   * Add a record for the packet, at the current simulation time.
+   *
+   * \param event the event type
+   * \param node the index of the node
+   * \param device the index of the device in its node
+   * \param p the packet
+   */
+  void Write (uint8_t event, uint32_t node, uint32_t device, Ptr<const Packet> p);
+  /**
+   * Write the records buffered, as a chunk.
+   */
+  void Flush (void);
+
+  uint32_t GetHeaderBytes (void) const;
+
+private:
+  BinaryTraceWriter (const BinaryTraceWriter &o);
+  BinaryTraceWriter &operator = (const BinaryTraceWriter &o);
+
+  void WriteColumn (std::string name, uint32_t width);
+  uint8_t *GetColumn (uint32_t column, uint32_t width);
+
+  std::ostream *m_os;
+  uint32_t m_headerBytes;
+  uint32_t m_chunkRecords;
+  uint32_t m_count;
+  std::vector<uint8_t> m_columns[7];
+};
+
+/**
+ * \brief Read binary traces written by BinaryTraceWriter
+ *
+ * Unknown columns are skipped and missing ones read as zero, so that
+ * later versions of the writer may add columns.
+ */
+class BinaryTraceReader
+{
+public:
+  BinaryTraceReader ();
+  ~BinaryTraceReader ();
+
+  /**
+   * Open a binary trace and read its schema.
+   *
+   * \param filename the name of the file
+   * \returns false if the file could not be opened or has no valid
+   *          schema, true otherwise
+   */
+  bool Open (std::string const &filename);
+  void Close (void);
+
+  /**
+   * \param record [out] the next record
+   * \returns false at the end of the trace, true otherwise
+   */
+  bool Read (BinaryTraceRecord &record);
+
+  /**
+   * \returns the number of bytes of the header column
+   */
+  uint32_t GetHeaderBytes (void) const;
+
+private:
+  struct Column
+  {
+    std::string name;
+    uint32_t width;
+    int32_t field;
+    std::vector<uint8_t> data;
+  };
+
+  bool ReadChunk (void);
+
+  std::ifstream m_file;
+  std::vector<Column> m_columns;
+  uint32_t m_headerBytes;
+  uint32_t m_count;
+  uint32_t m_current;
+};
+
+/**
+ * \brief An output stream of binary traces
+ *
+ * The default ascii trace sinks of AsciiTraceHelper write a record of
+ * a BinaryTraceWriter, instead of a line of text, into such a stream.
+ * It is created by AsciiTraceHelper::CreateBinaryFileStream and passed
+ * to the EnableAscii methods of the device helpers like any other
+ * stream.  Trace sinks which format text into its stream corrupt the
+ * trace.
+ */
+class BinaryTraceStreamWrapper : public OutputStreamWrapper
+{
+public:
+  /**
+   * \param filename the name of the file to create
+   * \param headerBytes the number of bytes of each packet to store
+   */
+  BinaryTraceStreamWrapper (std::string filename, uint32_t headerBytes);
+  virtual ~BinaryTraceStreamWrapper ();
+
+  /**
+   * Add a record, with the node and the device found in the
+   * context ("/NodeList/[i]/DeviceList/[j]/...").
+   *
+   * \param event the event type
+   * \param context the context of the trace source, or an empty string
+   * \param p the packet
+   */
+  void Write (uint8_t event, std::string const &context, Ptr<const Packet> p);
+  BinaryTraceWriter &GetWriter (void);
+
+private:
+  BinaryTraceWriter m_writer;
+};
+
+} // namespace ns3
+
+#endif /* BINARY_TRACE_H */
@@ -28,6 +28,7 @@
 #include "ns3/names.h"
 #include "ns3/net-device.h"
 #include "ns3/pcap-file-wrapper.h"
+#include "ns3/binary-trace.h"
 
 #include "trace-helper.h"
 
@@ -201,6 +202,17 @@ AsciiTraceHelper::CreateFileStream (std::string filename, std::ios::openmode fil
   return StreamWrapper;
 }
 
+Ptr<OutputStreamWrapper>
+AsciiTraceHelper::CreateBinaryFileStream (std::string filename, uint32_t headerBytes)
+{
+  NS_LOG_FUNCTION (filename << headerBytes);
+  //
+  // The ownership of the stream works as for CreateFileStream; the last
+  // records are written when it is destroyed.
+  //
+  return Create<BinaryTraceStreamWrapper> (filename, headerBytes);
+}
+
 std::string
 AsciiTraceHelper::GetFilenameFromDevice (std::string prefix, Ptr<NetDevice> device, bool useObjectNames)
 {
@@ -390,6 +402,82 @@ AsciiTraceHelper::DefaultReceiveSinkWithContext (Ptr<OutputStreamWrapper> stream
   *stream->GetStream () << "r " << Simulator::Now ().GetSeconds () << " " << context << " " << *p << std::endl;
 }
 
+//
+// The sinks of the streams created by CreateBinaryFileStream write a record,
+// instead of a line of text.
+//
+template <uint8_t EVENT>
+void
+AsciiTraceHelper::BinarySinkWithoutContext (Ptr<BinaryTraceStreamWrapper> stream, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (stream << p);
+  stream->Write (EVENT, "", p);
+}
+
+template <uint8_t EVENT>
+void
+AsciiTraceHelper::BinarySinkWithContext (Ptr<BinaryTraceStreamWrapper> stream, std::string context, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (stream << p);
+  stream->Write (EVENT, context, p);
+}
+
+bool
+AsciiTraceHelper::IsBinaryStream (Ptr<OutputStreamWrapper> stream)
+{
+  return dynamic_cast<BinaryTraceStreamWrapper *> (PeekPointer (stream)) != 0;
+}
+
+Callback<void, Ptr<const Packet> >
+AsciiTraceHelper::MakeDefaultSinkWithoutContext (char event, Ptr<OutputStreamWrapper> stream)
+{
+  NS_LOG_FUNCTION (event << stream);
+  Ptr<BinaryTraceStreamWrapper> binary (dynamic_cast<BinaryTraceStreamWrapper *> (PeekPointer (stream)));
+  switch (event)
+    {
+    case '+':
+      return binary != 0 ? MakeBoundCallback (&BinarySinkWithoutContext<'+'>, binary)
+             : MakeBoundCallback (&DefaultEnqueueSinkWithoutContext, stream);
+    case '-':
+      return binary != 0 ? MakeBoundCallback (&BinarySinkWithoutContext<'-'>, binary)
+             : MakeBoundCallback (&DefaultDequeueSinkWithoutContext, stream);
+    case 'd':
+      return binary != 0 ? MakeBoundCallback (&BinarySinkWithoutContext<'d'>, binary)
+             : MakeBoundCallback (&DefaultDropSinkWithoutContext, stream);
+    case 'r':
+      return binary != 0 ? MakeBoundCallback (&BinarySinkWithoutContext<'r'>, binary)
+             : MakeBoundCallback (&DefaultReceiveSinkWithoutContext, stream);
+    default:
+      NS_FATAL_ERROR ("AsciiTraceHelper::MakeDefaultSinkWithoutContext(): unknown event " << event);
+    }
+  return MakeNullCallback<void, Ptr<const Packet> > ();
+}
+
+Callback<void, std::string, Ptr<const Packet> >
+AsciiTraceHelper::MakeDefaultSinkWithContext (char event, Ptr<OutputStreamWrapper> stream)
+{
+  NS_LOG_FUNCTION (event << stream);
+  Ptr<BinaryTraceStreamWrapper> binary (dynamic_cast<BinaryTraceStreamWrapper *> (PeekPointer (stream)));
+  switch (event)
+    {
+    case '+':
+      return binary != 0 ? MakeBoundCallback (&BinarySinkWithContext<'+'>, binary)
+             : MakeBoundCallback (&DefaultEnqueueSinkWithContext, stream);
+    case '-':
+      return binary != 0 ? MakeBoundCallback (&BinarySinkWithContext<'-'>, binary)
+             : MakeBoundCallback (&DefaultDequeueSinkWithContext, stream);
+    case 'd':
+      return binary != 0 ? MakeBoundCallback (&BinarySinkWithContext<'d'>, binary)
+             : MakeBoundCallback (&DefaultDropSinkWithContext, stream);
+    case 'r':
+      return binary != 0 ? MakeBoundCallback (&BinarySinkWithContext<'r'>, binary)
+             : MakeBoundCallback (&DefaultReceiveSinkWithContext, stream);
+    default:
+      NS_FATAL_ERROR ("AsciiTraceHelper::MakeDefaultSinkWithContext(): unknown event " << event);
+    }
+  return MakeNullCallback<void, std::string, Ptr<const Packet> > ();
+}
+
 void 
 PcapHelperForDevice::EnablePcap (std::string prefix, Ptr<NetDevice> nd, bool promiscuous, bool explicitFilename)
 {
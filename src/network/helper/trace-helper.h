@@ -28,6 +28,8 @@
 
 namespace ns3 {
 
+class BinaryTraceStreamWrapper;
+
 /**
  * \brief Manage pcap files for device models
  *
@@ -155,6 +157,20 @@ public:
   Ptr<OutputStreamWrapper> CreateFileStream (std::string filename, 
                                              std::ios::openmode filemode = std::ios::out);
 
+  /**
+   * @brief Create an output stream of binary traces, to pass to the
+   * EnableAscii methods which take a stream instead of a prefix.
+   *
+   * The default trace sinks write fixed-width records (time, node, device,
+   * event type, packet uid and size, and the first headerBytes bytes of
+   * the packet) into it, in the columnar format of BinaryTraceWriter,
+   * instead of lines of text.  BinaryTraceReader reads them back.
+   *
+   * \param filename the name of the file to create
+   * \param headerBytes the number of bytes of each packet to store
+   */
+  Ptr<OutputStreamWrapper> CreateBinaryFileStream (std::string filename, uint32_t headerBytes = 0);
+
   /**
    * @brief Hook a trace source to the default enqueue operation trace sink that
    * does not accept nor log a trace context.
@@ -226,13 +242,47 @@ public:
 
   static void DefaultReceiveSinkWithoutContext (Ptr<OutputStreamWrapper> file, Ptr<const Packet> p);
   static void DefaultReceiveSinkWithContext (Ptr<OutputStreamWrapper> file, std::string context, Ptr<const Packet> p);
+
+  /**
+   * @brief Make the default trace sink of an event, bound to a stream, that
+   * does not accept nor log a trace context.
+   *
+   * The sink writes records into the streams created by
+   * CreateBinaryFileStream and lines of text into the others.  The kind of
+   * the stream is checked here, when the trace is enabled, rather than for
+   * each packet traced.
+   *
+   * \param event '+' (enqueue), '-' (dequeue), 'd' (drop) or 'r' (receive)
+   * \param stream the stream of the traces
+   */
+  static Callback<void, Ptr<const Packet> > MakeDefaultSinkWithoutContext (char event, Ptr<OutputStreamWrapper> stream);
+  /**
+   * @brief Make the default trace sink of an event, bound to a stream, that
+   * does accept and log a trace context.
+   *
+   * \param event '+' (enqueue), '-' (dequeue), 'd' (drop) or 'r' (receive)
+   * \param stream the stream of the traces
+   */
+  static Callback<void, std::string, Ptr<const Packet> > MakeDefaultSinkWithContext (char event, Ptr<OutputStreamWrapper> stream);
+  /**
+   * \param stream a stream of traces
+   * \returns true if the stream was created by CreateBinaryFileStream.  The
+   * trace sinks which only write text must not be given such a stream.
+   */
+  static bool IsBinaryStream (Ptr<OutputStreamWrapper> stream);
+
+private:
+  template <uint8_t EVENT>
+  static void BinarySinkWithoutContext (Ptr<BinaryTraceStreamWrapper> stream, Ptr<const Packet> p);
+  template <uint8_t EVENT>
+  static void BinarySinkWithContext (Ptr<BinaryTraceStreamWrapper> stream, std::string context, Ptr<const Packet> p);
 };
 
 template <typename T> void
 AsciiTraceHelper::HookDefaultEnqueueSinkWithoutContext (Ptr<T> object, std::string tracename, Ptr<OutputStreamWrapper> file)
 {
   bool result =
-    object->TraceConnectWithoutContext (tracename, MakeBoundCallback (&DefaultEnqueueSinkWithoutContext, file));
+    object->TraceConnectWithoutContext (tracename, MakeDefaultSinkWithoutContext ('+', file));
   NS_ASSERT_MSG (result == true, "AsciiTraceHelper::HookDefaultEnqueueSinkWithoutContext():  Unable to hook \"" 
                  << tracename << "\"");
 }
@@ -245,7 +295,7 @@ AsciiTraceHelper::HookDefaultEnqueueSinkWithContext (
   Ptr<OutputStreamWrapper> stream)
 {
   bool result =
-    object->TraceConnect (tracename, context, MakeBoundCallback (&DefaultEnqueueSinkWithContext, stream));
+    object->TraceConnect (tracename, context, MakeDefaultSinkWithContext ('+', stream));
   NS_ASSERT_MSG (result == true, "AsciiTraceHelper::HookDefaultEnqueueSinkWithContext():  Unable to hook \"" 
                  << tracename << "\"");
 }
@@ -254,7 +304,7 @@ template <typename T> void
 AsciiTraceHelper::HookDefaultDropSinkWithoutContext (Ptr<T> object, std::string tracename, Ptr<OutputStreamWrapper> file)
 {
   bool result =
-    object->TraceConnectWithoutContext (tracename, MakeBoundCallback (&DefaultDropSinkWithoutContext, file));
+    object->TraceConnectWithoutContext (tracename, MakeDefaultSinkWithoutContext ('d', file));
   NS_ASSERT_MSG (result == true, "AsciiTraceHelper::HookDefaultDropSinkWithoutContext():  Unable to hook \"" 
                  << tracename << "\"");
 }
@@ -267,7 +317,7 @@ AsciiTraceHelper::HookDefaultDropSinkWithContext (
   Ptr<OutputStreamWrapper> stream)
 {
   bool result =
-    object->TraceConnect (tracename, context, MakeBoundCallback (&DefaultDropSinkWithContext, stream));
+    object->TraceConnect (tracename, context, MakeDefaultSinkWithContext ('d', stream));
   NS_ASSERT_MSG (result == true, "AsciiTraceHelper::HookDefaultDropSinkWithContext():  Unable to hook \"" 
                  << tracename << "\"");
 }
@@ -276,7 +326,7 @@ template <typename T> void
 AsciiTraceHelper::HookDefaultDequeueSinkWithoutContext (Ptr<T> object, std::string tracename, Ptr<OutputStreamWrapper> file)
 {
   bool result =
-    object->TraceConnectWithoutContext (tracename, MakeBoundCallback (&DefaultDequeueSinkWithoutContext, file));
+    object->TraceConnectWithoutContext (tracename, MakeDefaultSinkWithoutContext ('-', file));
   NS_ASSERT_MSG (result == true, "AsciiTraceHelper::HookDefaultDequeueSinkWithoutContext():  Unable to hook \"" 
                  << tracename << "\"");
 }
@@ -289,7 +339,7 @@ AsciiTraceHelper::HookDefaultDequeueSinkWithContext (
   Ptr<OutputStreamWrapper> stream)
 {
   bool result =
-    object->TraceConnect (tracename, context, MakeBoundCallback (&DefaultDequeueSinkWithContext, stream));
+    object->TraceConnect (tracename, context, MakeDefaultSinkWithContext ('-', stream));
   NS_ASSERT_MSG (result == true, "AsciiTraceHelper::HookDefaultDequeueSinkWithContext():  Unable to hook \"" 
                  << tracename << "\"");
 }
@@ -298,7 +348,7 @@ template <typename T> void
 AsciiTraceHelper::HookDefaultReceiveSinkWithoutContext (Ptr<T> object, std::string tracename, Ptr<OutputStreamWrapper> file)
 {
   bool result =
-    object->TraceConnectWithoutContext (tracename, MakeBoundCallback (&DefaultReceiveSinkWithoutContext, file));
+    object->TraceConnectWithoutContext (tracename, MakeDefaultSinkWithoutContext ('r', file));
   NS_ASSERT_MSG (result == true, "AsciiTraceHelper::HookDefaultReceiveSinkWithoutContext():  Unable to hook \"" 
                  << tracename << "\"");
 }
@@ -311,7 +361,7 @@ AsciiTraceHelper::HookDefaultReceiveSinkWithContext (
   Ptr<OutputStreamWrapper> stream)
 {
   bool result =
-    object->TraceConnect (tracename, context, MakeBoundCallback (&DefaultReceiveSinkWithContext, stream));
+    object->TraceConnect (tracename, context, MakeDefaultSinkWithContext ('r', stream));
   NS_ASSERT_MSG (result == true, "AsciiTraceHelper::HookDefaultReceiveSinkWithContext():  Unable to hook \"" 
                  << tracename << "\"");
 }
@@ -25,8 +25,6 @@
 #include <ostream>
 #include "ns3/assert.h"
 
-#define noBUFFER_FREE_LIST 1
-
 namespace ns3 {
 
 /**
@@ -65,10 +63,14 @@ namespace ns3 {
  * contains real data bytes in its BufferData instance but it also
  * contains "virtual zero data" which typically is used to represent
  * application-level payload. No memory is allocated to store the
- * zero bytes of application-level payload unless the user fragments
- * a Buffer: this application-level payload is kept track of with
- * a pair of integers which describe where in the buffer content
- * the "virtual zero area" starts and ends.
+ * zero bytes of application-level payload unless the user reads
+ * them with PeekData or concatenates two Buffers which both contain
+ * real bytes around their zero areas: this application-level payload
+ * is kept track of with a pair of integers which describe where in
+ * the buffer content the "virtual zero area" starts and ends.
+ * Fragments share the real bytes of the original Buffer, and
+ * concatenating Buffers whose zero areas are adjacent (such as
+ * fragments of the same application-level payload) merges them.
  *
  * ***: unused bytes
  * xxx: bytes "added" at the front of the zero area
@@ -437,7 +439,10 @@ private:
   /**
    * \param o the buffer to append to the end of this buffer.
    *
-   * Add bytes at the end of the Buffer.
+   * Add bytes at the end of the Buffer. Only real bytes
+   * are copied: if the zero areas of the two buffers are
+   * adjacent, they are merged, otherwise the smallest one
+   * is materialized.
    * Any call to this method invalidates any Iterator
    * pointing to this Buffer.
    */
@@ -611,16 +616,6 @@ private:
    */
   uint32_t m_end;
 
-#ifdef BUFFER_FREE_LIST
-  typedef std::vector<struct Buffer::Data*> FreeList;
-  struct LocalStaticDestructor 
-  {
-    ~LocalStaticDestructor ();
-  };
-  static uint32_t g_maxSize;
-  static FreeList *g_freeList;
-  static struct LocalStaticDestructor g_localStaticDestructor;
-#endif
 };
 
 } // namespace ns3
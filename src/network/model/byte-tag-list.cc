@@ -18,15 +18,16 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "byte-tag-list.h"
+#include "size-class-allocator.h"
 #include "ns3/log.h"
-#include <vector>
 #include <string.h>
 
 NS_LOG_COMPONENT_DEFINE ("ByteTagList");
 
-#define USE_FREE_LIST 1
-#define FREE_LIST_SIZE 1000
 #define OFFSET_MAX (2147483647)
+// bound of the clip window on the side which was not set, small enough
+// to never overflow once adjusted
+#define CLIP_MAX (1073741823)
 
 namespace ns3 {
 
@@ -37,25 +38,6 @@ struct ByteTagListData {
   uint8_t data[4];
 };
 
-#ifdef USE_FREE_LIST
-static class ByteTagListDataFreeList : public std::vector<struct ByteTagListData *>
-{
-public:
-  ~ByteTagListDataFreeList ();
-} g_freeList;
-static uint32_t g_maxSize = 0;
-
-ByteTagListDataFreeList::~ByteTagListDataFreeList ()
-{
-  for (ByteTagListDataFreeList::iterator i = begin ();
-       i != end (); i++)
-    {
-      uint8_t *buffer = (uint8_t *)(*i);
-      delete [] buffer;
-    }
-}
-#endif /* USE_FREE_LIST */
-
 ByteTagList::Iterator::Item::Item (TagBuffer buf_)
   : buf (buf_)
 {
@@ -90,7 +72,20 @@ ByteTagList::Iterator::PrepareForNext (void)
       m_nextSize = buf.ReadU32 ();
       m_nextStart = buf.ReadU32 ();
       m_nextEnd = buf.ReadU32 ();
-      if (m_nextStart >= m_offsetEnd || m_nextEnd <= m_offsetStart)
+      while (m_nClips > 0 && m_current >= m_start + m_clips->used)
+        {
+          m_clips++;
+          m_nClips--;
+        }
+      if (m_nClips > 0)
+        {
+          m_nextStart = std::max (m_nextStart, m_clips->start);
+          m_nextEnd = std::min (m_nextEnd, m_clips->end);
+        }
+      bool empty = m_nextStart >= m_nextEnd;
+      m_nextStart += m_adjustment;
+      m_nextEnd += m_adjustment;
+      if (empty || m_nextStart >= m_offsetEnd || m_nextEnd <= m_offsetStart)
         {
           m_current += 4 + 4 + 4 + 4 + m_nextSize;
         }
@@ -100,11 +95,16 @@ ByteTagList::Iterator::PrepareForNext (void)
         }
     }
 }
-ByteTagList::Iterator::Iterator (uint8_t *start, uint8_t *end, int32_t offsetStart, int32_t offsetEnd)
-  : m_current (start),
+ByteTagList::Iterator::Iterator (uint8_t *start, uint8_t *end, int32_t offsetStart, int32_t offsetEnd,
+                                 int32_t adjustment, const struct ByteTagListClip *clips, uint32_t nClips)
+  : m_start (start),
+    m_current (start),
     m_end (end),
     m_offsetStart (offsetStart),
-    m_offsetEnd (offsetEnd)
+    m_offsetEnd (offsetEnd),
+    m_adjustment (adjustment),
+    m_clips (clips),
+    m_nClips (nClips)
 {
   PrepareForNext ();
 }
@@ -118,19 +118,28 @@ ByteTagList::Iterator::GetOffsetStart (void) const
 
 ByteTagList::ByteTagList ()
   : m_used (0),
+    m_nClips (0),
+    m_adjustment (0),
     m_data (0)
 {
   NS_LOG_FUNCTION (this);
 }
 ByteTagList::ByteTagList (const ByteTagList &o)
   : m_used (o.m_used),
+    m_nClips (o.m_nClips),
+    m_adjustment (o.m_adjustment),
     m_data (o.m_data)
 {
   NS_LOG_FUNCTION (this << &o);
+  memcpy (m_clips, o.m_clips, m_nClips * sizeof (struct ByteTagListClip));
   if (m_data != 0)
     {
       m_data->count++;
     }
+  else
+    {
+      memcpy (m_inline, o.m_inline, m_used);
+    }
 }
 ByteTagList &
 ByteTagList::operator = (const ByteTagList &o)
@@ -144,10 +153,17 @@ ByteTagList::operator = (const ByteTagList &o)
   Deallocate (m_data);
   m_data = o.m_data;
   m_used = o.m_used;
+  m_nClips = o.m_nClips;
+  m_adjustment = o.m_adjustment;
+  memcpy (m_clips, o.m_clips, m_nClips * sizeof (struct ByteTagListClip));
   if (m_data != 0)
     {
       m_data->count++;
     }
+  else
+    {
+      memcpy (m_inline, o.m_inline, m_used);
+    }
   return *this;
 }
 ByteTagList::~ByteTagList ()
@@ -166,25 +182,34 @@ ByteTagList::Add (TypeId tid, uint32_t bufferSize, int32_t start, int32_t end)
   NS_ASSERT (m_used <= spaceNeeded);
   if (m_data == 0)
     {
-      m_data = Allocate (spaceNeeded);
-      m_used = 0;
+      if (spaceNeeded > INLINE_SIZE)
+        {
+          m_data = Allocate (spaceNeeded);
+          memcpy (&m_data->data, m_inline, m_used);
+        }
     } 
   else if (m_data->size < spaceNeeded ||
            (m_data->count != 1 && m_data->dirty != m_used))
     {
-      struct ByteTagListData *newData = Allocate (spaceNeeded);
+      // leave room for the next tags: lists are appended to in a row
+      // when packets are put back together
+      struct ByteTagListData *newData = Allocate (std::max (spaceNeeded, 2U * m_used));
       memcpy (&newData->data, &m_data->data, m_used);
       Deallocate (m_data);
       m_data = newData;
     }
-  TagBuffer tag = TagBuffer (&m_data->data[m_used], 
-                             &m_data->data[spaceNeeded]);
+  uint8_t *data = GetData ();
+  TagBuffer tag = TagBuffer (&data[m_used], 
+                             &data[spaceNeeded]);
   tag.WriteU32 (tid.GetUid ());
   tag.WriteU32 (bufferSize);
-  tag.WriteU32 (start);
-  tag.WriteU32 (end);
+  tag.WriteU32 (start - m_adjustment);
+  tag.WriteU32 (end - m_adjustment);
   m_used = spaceNeeded;
-  m_data->dirty = m_used;
+  if (m_data != 0)
+    {
+      m_data->dirty = m_used;
+    }
   return tag;
 }
 
@@ -192,11 +217,21 @@ void
 ByteTagList::Add (const ByteTagList &o)
 {
   NS_LOG_FUNCTION (this << &o);
-  ByteTagList::Iterator i = o.BeginAll ();
+  Add (o, 0, OFFSET_MAX, 0);
+}
+
+void
+ByteTagList::Add (const ByteTagList &o, int32_t offsetStart, int32_t offsetEnd, int32_t adjustment)
+{
+  NS_LOG_FUNCTION (this << &o << offsetStart << offsetEnd << adjustment);
+  // o may be this list or share its data
+  ByteTagList copy = o;
+  ByteTagList::Iterator i = copy.Begin (offsetStart, offsetEnd);
   while (i.HasNext ())
     {
       ByteTagList::Iterator::Item item = i.Next ();
-      TagBuffer buf = Add (item.tid, item.size, item.start, item.end);
+      // the items are trimmed to the range by the iterator
+      TagBuffer buf = Add (item.tid, item.size, item.start + adjustment, item.end + adjustment);
       buf.CopyFrom (item.buf);
     }
 }
@@ -208,6 +243,18 @@ ByteTagList::RemoveAll (void)
   Deallocate (m_data);
   m_data = 0;
   m_used = 0;
+  m_nClips = 0;
+  m_adjustment = 0;
+}
+
+uint8_t *
+ByteTagList::GetData (void) const
+{
+  if (m_data == 0)
+    {
+      return const_cast<uint8_t *> (m_inline);
+    }
+  return m_data->data;
 }
 
 ByteTagList::Iterator 
@@ -223,14 +270,9 @@ ByteTagList::Iterator
 ByteTagList::Begin (int32_t offsetStart, int32_t offsetEnd) const
 {
   NS_LOG_FUNCTION (this << offsetStart << offsetEnd);
-  if (m_data == 0)
-    {
-      return Iterator (0, 0, offsetStart, offsetEnd);
-    }
-  else
-    {
-      return Iterator (m_data->data, &m_data->data[m_used], offsetStart, offsetEnd);
-    }
+  uint8_t *data = GetData ();
+  return Iterator (data, &data[m_used], offsetStart, offsetEnd, m_adjustment,
+                   m_clips, m_nClips);
 }
 
 bool 
@@ -265,11 +307,40 @@ ByteTagList::IsDirtyAtStart (int32_t prependOffset)
   return false;
 }
 
+bool
+ByteTagList::Clip (int32_t clipStart, int32_t clipEnd)
+{
+  NS_LOG_FUNCTION (this << clipStart << clipEnd << m_nClips);
+  if (m_nClips == 0 || m_clips[m_nClips - 1].used != m_used)
+    {
+      if (m_nClips == MAX_CLIPS)
+        {
+          return false;
+        }
+      struct ByteTagListClip *clip = &m_clips[m_nClips];
+      clip->used = m_used;
+      clip->start = -CLIP_MAX;
+      clip->end = CLIP_MAX;
+      m_nClips++;
+    }
+  for (uint32_t i = 0; i < m_nClips; i++)
+    {
+      m_clips[i].start = std::max (m_clips[i].start, clipStart - m_adjustment);
+      m_clips[i].end = std::min (m_clips[i].end, clipEnd - m_adjustment);
+    }
+  return true;
+}
+
 void 
 ByteTagList::AddAtEnd (int32_t adjustment, int32_t appendOffset)
 {
   NS_LOG_FUNCTION (this << adjustment << appendOffset);
-  if (adjustment == 0 && !IsDirtyAtEnd (appendOffset))
+  m_adjustment += adjustment;
+  if (!IsDirtyAtEnd (appendOffset))
+    {
+      return;
+    }
+  if (Clip (-CLIP_MAX, appendOffset))
     {
       return;
     }
@@ -278,8 +349,6 @@ ByteTagList::AddAtEnd (int32_t adjustment, int32_t appendOffset)
   while (i.HasNext ())
     {
       ByteTagList::Iterator::Item item = i.Next ();
-      item.start += adjustment;
-      item.end += adjustment;
 
       if (item.start >= appendOffset)
         {
@@ -303,7 +372,12 @@ void
 ByteTagList::AddAtStart (int32_t adjustment, int32_t prependOffset)
 {
   NS_LOG_FUNCTION (this << adjustment << prependOffset);
-  if (adjustment == 0 && !IsDirtyAtStart (prependOffset))
+  m_adjustment += adjustment;
+  if (!IsDirtyAtStart (prependOffset))
+    {
+      return;
+    }
+  if (Clip (prependOffset, CLIP_MAX))
     {
       return;
     }
@@ -312,8 +386,6 @@ ByteTagList::AddAtStart (int32_t adjustment, int32_t prependOffset)
   while (i.HasNext ())
     {
       ByteTagList::Iterator::Item item = i.Next ();
-      item.start += adjustment;
-      item.end += adjustment;
 
       if (item.end <= prependOffset)
         {
@@ -333,69 +405,15 @@ ByteTagList::AddAtStart (int32_t adjustment, int32_t prependOffset)
   *this = list;
 }
 
-#ifdef USE_FREE_LIST
-
 struct ByteTagListData *
 ByteTagList::Allocate (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
-  while (!g_freeList.empty ())
-    {
-      struct ByteTagListData *data = g_freeList.back ();
-      g_freeList.pop_back ();
-      NS_ASSERT (data != 0);
-      if (data->size >= size)
-        {
-          data->count = 1;
-          data->dirty = 0;
-          return data;
-        }
-      uint8_t *buffer = (uint8_t *)data;
-      delete [] buffer;
-    }
-  uint8_t *buffer = new uint8_t [std::max (size, g_maxSize) + sizeof (struct ByteTagListData) - 4];
+  uint32_t blockSize = size + sizeof (struct ByteTagListData) - 4;
+  uint8_t *buffer = SizeClassAllocator::Allocate (blockSize);
   struct ByteTagListData *data = (struct ByteTagListData *)buffer;
   data->count = 1;
-  data->size = size;
-  data->dirty = 0;
-  return data;
-}
-
-void 
-ByteTagList::Deallocate (struct ByteTagListData *data)
-{
-  NS_LOG_FUNCTION (this << data);
-  if (data == 0)
-    {
-      return;
-    }
-  g_maxSize = std::max (g_maxSize, data->size);
-  data->count--;
-  if (data->count == 0)
-    {
-      if (g_freeList.size () > FREE_LIST_SIZE ||
-          data->size < g_maxSize)
-        {
-          uint8_t *buffer = (uint8_t *)data;
-          delete [] buffer;
-        }
-      else
-        {
-          g_freeList.push_back (data);
-        }
-    }
-}
-
-#else /* USE_FREE_LIST */
-
-struct ByteTagListData *
-ByteTagList::Allocate (uint32_t size)
-{
-  NS_LOG_FUNCTION (this << size);
-  uint8_t *buffer = new uint8_t [size + sizeof (struct ByteTagListData) - 4];
-  struct ByteTagListData *data = (struct ByteTagListData *)buffer;
-  data->count = 1;
-  data->size = size;
+  data->size = blockSize + 4 - sizeof (struct ByteTagListData);
   data->dirty = 0;
   return data;
 }
@@ -412,11 +430,9 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
   if (data->count == 0)
     {
       uint8_t *buffer = (uint8_t *)data;
-      delete [] buffer;
+      SizeClassAllocator::Deallocate (buffer, data->size + sizeof (struct ByteTagListData) - 4);
     }
 }
 
-#endif /* USE_FREE_LIST */
-
 
 } // namespace ns3
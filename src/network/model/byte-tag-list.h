@@ -28,6 +28,18 @@ namespace ns3 {
 
 struct ByteTagListData;
 
+/**
+ * The window [start,end) of the stored offsets of the tags which precede
+ * the byte used of the tag buffer, and follow the ones of the previous
+ * window.
+ */
+struct ByteTagListClip
+{
+  uint32_t used;
+  int32_t start;
+  int32_t end;
+};
+
 /**
  * \ingroup packet
  *
@@ -64,6 +76,17 @@ struct ByteTagListData;
  *     either the next call to Packet::AddHeader or Packet::AddTrailer or when
  *     the user iterates the tag list with Packet::GetTagIterator and 
  *     TagIterator::Next.
+ *
+ *   - the offsets are stored relative to an adjustment kept by each ByteTagList
+ *     instance: a change of the origin of the Buffer offsets only updates the
+ *     adjustment. When bytes are added to the packet, the tags which overlap
+ *     them are trimmed by clip windows rather than rewritten: each window
+ *     applies to the tags stored before the ones of the next window, and a
+ *     tag trimmed to nothing is skipped. The tags are rewritten, and the
+ *     skipped tags dropped, only when more than MAX_CLIPS windows are needed.
+ *
+ *   - a list whose tags fit in INLINE_SIZE bytes is stored in the ByteTagList
+ *     instance itself rather than in a shared struct ByteTagListData.
  */
 class ByteTagList
 {
@@ -89,12 +112,17 @@ private:
     uint32_t GetOffsetStart (void) const;
 private:
     friend class ByteTagList;
-    Iterator (uint8_t *start, uint8_t *end, int32_t offsetStart, int32_t offsetEnd);
+    Iterator (uint8_t *start, uint8_t *end, int32_t offsetStart, int32_t offsetEnd,
+              int32_t adjustment, const struct ByteTagListClip *clips, uint32_t nClips);
     void PrepareForNext (void);
+    uint8_t *m_start;
     uint8_t *m_current;
     uint8_t *m_end;
     int32_t m_offsetStart;
     int32_t m_offsetEnd;
+    int32_t m_adjustment;
+    const struct ByteTagListClip *m_clips;
+    uint32_t m_nClips;
     uint32_t m_nextTid;
     uint32_t m_nextSize;
     int32_t m_nextStart;
@@ -125,6 +153,18 @@ private:
    */
   void Add (const ByteTagList &o);
 
+  /**
+   * \param o the other list of tags to aggregate.
+   * \param offsetStart the offset of the first byte of o to consider.
+   * \param offsetEnd the offset of the byte which follows the last byte
+   *        of o to consider.
+   * \param adjustment the delta to add to the offsets of the tags of o.
+   *
+   * Add the tags of o which tag bytes between offsetStart and offsetEnd,
+   * trimmed to these bytes.
+   */
+  void Add (const ByteTagList &o, int32_t offsetStart, int32_t offsetEnd, int32_t adjustment);
+
   void RemoveAll (void);
 
   /**
@@ -156,13 +196,23 @@ private:
 private:
   bool IsDirtyAtEnd (int32_t appendOffset);
   bool IsDirtyAtStart (int32_t prependOffset);
+  bool Clip (int32_t clipStart, int32_t clipEnd);
   ByteTagList::Iterator BeginAll (void) const;
 
+  uint8_t *GetData (void) const;
   struct ByteTagListData *Allocate (uint32_t size);
   void Deallocate (struct ByteTagListData *data);
 
+  /* enough for one tag of up to 16 bytes */
+  static const uint32_t INLINE_SIZE = 32;
+  static const uint32_t MAX_CLIPS = 3;
+
   uint16_t m_used;
+  uint16_t m_nClips;
+  int32_t m_adjustment;
+  struct ByteTagListClip m_clips[MAX_CLIPS];
   struct ByteTagListData *m_data;
+  uint8_t m_inline[INLINE_SIZE];
 };
 
 } // namespace ns3
@@ -20,6 +20,24 @@ public:
   virtual void Print (std::ostream &os) const = 0;
 };
 
+/**
+ * \ingroup packet
+ *
+ * \brief The serialized size of all the headers or trailers of type T
+ *
+ * Zero, the default, stands for a size known only at runtime.  A
+ * header or trailer whose size never changes specializes this template
+ * next to its declaration to get the fast path of the Packet methods:
+ * its size is a constant, and its Serialize and Deserialize methods are
+ * called directly rather than through the virtual table.  For this
+ * reason, the types derived from T must serialize exactly like T.
+ */
+template <typename T>
+struct FixedSerializedSize
+{
+  static const uint32_t value = 0;
+};
+
 } // namespace ns3
 
 #endif /* CHUNK_H */
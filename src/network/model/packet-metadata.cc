@@ -23,6 +23,7 @@
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
 #include "packet-metadata.h"
+#include "size-class-allocator.h"
 #include "buffer.h"
 #include "header.h"
 #include "trailer.h"
@@ -36,20 +37,22 @@ bool PacketMetadata::m_enableChecking = false;
 bool PacketMetadata::m_metadataSkipped = false;
 uint32_t PacketMetadata::m_maxSize = 0;
 uint16_t PacketMetadata::m_chunkUid = 0;
-PacketMetadata::DataFreeList PacketMetadata::m_freeList;
+Callback<bool, uint64_t> PacketMetadata::m_sampler;
 
-PacketMetadata::DataFreeList::~DataFreeList ()
+static bool
+SampleOneIn (uint32_t n, uint64_t uid)
 {
-  for (iterator i = begin (); i != end (); i++)
-    {
-      PacketMetadata::Deallocate (*i);
-    }
-  PacketMetadata::m_enable = false;
+  // the low bits of the uid count the packets of this system
+  return (uid & 0xffffffff) % n == 0;
 }
 
 void 
 PacketMetadata::Enable (void)
 {
+  if (m_enable)
+    {
+      return;
+    }
   NS_ASSERT_MSG (!m_metadataSkipped,
                  "Error: attempting to enable the packet metadata "
                  "subsystem too late in the simulation, which is not allowed.\n"
@@ -67,10 +70,32 @@ PacketMetadata::EnableChecking (void)
   m_enableChecking = true;
 }
 
+void
+PacketMetadata::EnableSampling (Callback<bool, uint64_t> sampler)
+{
+  Enable ();
+  m_sampler = sampler;
+}
+
+void
+PacketMetadata::EnableSampling (uint32_t n)
+{
+  NS_ASSERT (n > 0);
+  EnableSampling (MakeBoundCallback (&SampleOneIn, n));
+}
+
 void
 PacketMetadata::ReserveCopy (uint32_t size)
 {
   struct PacketMetadata::Data *newData = PacketMetadata::Create (m_used + size);
+  if (m_data == 0)
+    {
+      // the first item of this packet
+      NS_ASSERT (m_used == 0);
+      memset (newData->m_data, 0xff, 4);
+      m_data = newData;
+      return;
+    }
   memcpy (newData->m_data, m_data->m_data, m_used);
   newData->m_dirtyEnd = m_used;
   m_data->m_count--;
@@ -125,6 +150,10 @@ PacketMetadata::IsPointerOk (uint16_t pointer) const
 bool
 PacketMetadata::IsStateOk (void) const
 {
+  if (m_data == 0)
+    {
+      return m_used == 0 && m_head == 0xffff && m_tail == 0xffff;
+    }
   bool ok = m_used <= m_data->m_size;
   ok &= IsPointerOk (m_head);
   ok &= IsPointerOk (m_tail);
@@ -361,12 +390,12 @@ uint16_t
 PacketMetadata::AddSmall (const struct PacketMetadata::SmallItem *item)
 {
   NS_LOG_FUNCTION (this << item->next << item->prev << item->typeUid << item->size << item->chunkUid);
-  NS_ASSERT (m_data != 0);
   NS_ASSERT (m_used != item->prev && m_used != item->next);
   uint32_t typeUidSize = GetUleb128Size (item->typeUid);
   uint32_t sizeSize = GetUleb128Size (item->size);
   uint32_t n =  2 + 2 + typeUidSize + sizeSize + 2;
-  if (m_used + n > m_data->m_size ||
+  if (m_data == 0 ||
+      m_used + n > m_data->m_size ||
       (m_head != 0xffff &&
        m_data->m_count != 1 &&
        m_used != m_data->m_dirtyEnd))
@@ -394,7 +423,6 @@ PacketMetadata::AddBig (uint32_t next, uint32_t prev,
   NS_LOG_FUNCTION (this << next << prev <<
                    item->next << item->prev << item->typeUid << item->size << item->chunkUid <<
                    extraItem->fragmentStart << extraItem->fragmentEnd << extraItem->packetUid);
-  NS_ASSERT (m_data != 0);
   uint32_t typeUid = ((item->typeUid & 0x1) == 0x1) ? item->typeUid : item->typeUid+1;
   NS_ASSERT (m_used != prev && m_used != next);
 
@@ -404,7 +432,8 @@ PacketMetadata::AddBig (uint32_t next, uint32_t prev,
   uint32_t fragEndSize = GetUleb128Size (extraItem->fragmentEnd);
   uint32_t n = 2 + 2 + typeUidSize + sizeSize + 2 + fragStartSize + fragEndSize + 4;
 
-  if (m_used + n > m_data->m_size ||
+  if (m_data == 0 ||
+      m_used + n > m_data->m_size ||
       (m_head != 0xffff &&
        m_data->m_count != 1 &&
        m_used != m_data->m_dirtyEnd))
@@ -570,19 +599,6 @@ PacketMetadata::Create (uint32_t size)
     {
       m_maxSize = size;
     }
-  while (!m_freeList.empty ()) 
-    {
-      struct PacketMetadata::Data *data = m_freeList.back ();
-      m_freeList.pop_back ();
-      if (data->m_size >= size) 
-        {
-          NS_LOG_LOGIC ("create found size="<<data->m_size);
-          data->m_count = 1;
-          return data;
-        }
-      PacketMetadata::Deallocate (data);
-      NS_LOG_LOGIC ("create dealloc size="<<data->m_size);
-    }
   NS_LOG_LOGIC ("create alloc size="<<m_maxSize);
   return PacketMetadata::Allocate (m_maxSize);
 }
@@ -590,22 +606,9 @@ PacketMetadata::Create (uint32_t size)
 void
 PacketMetadata::Recycle (struct PacketMetadata::Data *data)
 {
-  if (!m_enable)
-    {
-      PacketMetadata::Deallocate (data);
-      return;
-    } 
-  NS_LOG_LOGIC ("recycle size="<<data->m_size<<", list="<<m_freeList.size ());
+  NS_LOG_LOGIC ("recycle size="<<data->m_size);
   NS_ASSERT (data->m_count == 0);
-  if (m_freeList.size () > 1000 ||
-      data->m_size < m_maxSize) 
-    {
-      PacketMetadata::Deallocate (data);
-    } 
-  else 
-    {
-      m_freeList.push_back (data);
-    }
+  PacketMetadata::Deallocate (data);
 }
 
 struct PacketMetadata::Data *
@@ -616,10 +619,13 @@ PacketMetadata::Allocate (uint32_t n)
     {
       n = PACKET_METADATA_DATA_M_DATA_SIZE;
     }
+  // m_size is 16 bits wide
+  NS_ASSERT (n <= 0xffff);
   size += n - PACKET_METADATA_DATA_M_DATA_SIZE;
-  uint8_t *buf = new uint8_t [size];
+  uint8_t *buf = SizeClassAllocator::Allocate (size);
   struct PacketMetadata::Data *data = (struct PacketMetadata::Data *)buf;
-  data->m_size = n;
+  // the block may be larger than requested: make it all available
+  data->m_size = size - sizeof (struct Data) + PACKET_METADATA_DATA_M_DATA_SIZE;
   data->m_count = 1;
   data->m_dirtyEnd = 0;
   return data;
@@ -628,7 +634,7 @@ void
 PacketMetadata::Deallocate (struct PacketMetadata::Data *data)
 {
   uint8_t *buf = (uint8_t *)data;
-  delete [] buf;
+  SizeClassAllocator::Deallocate (buf, sizeof (struct Data) + data->m_size - PACKET_METADATA_DATA_M_DATA_SIZE);
 }
 
 
@@ -645,6 +651,11 @@ void
 PacketMetadata::AddHeader (const Header &header, uint32_t size)
 {
   NS_ASSERT (IsStateOk ());
+  if (!m_enable || m_sampledOut)
+    {
+      m_metadataSkipped = true;
+      return;
+    }
   uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
   DoAddHeader (uid, size);
   NS_ASSERT (IsStateOk ());
@@ -653,7 +664,7 @@ void
 PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
 {
   NS_LOG_FUNCTION (this << uid << size);
-  if (!m_enable)
+  if (!m_enable || m_sampledOut)
     {
       m_metadataSkipped = true;
       return;
@@ -672,14 +683,23 @@ PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
 void 
 PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
 {
-  uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
-  NS_LOG_FUNCTION (this << uid << size);
+  NS_LOG_FUNCTION (this << &header << size);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
+  if (!m_enable || m_sampledOut)
     {
       m_metadataSkipped = true;
       return;
     }
+  uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
+  if (m_head == 0xffff)
+    {
+      // nothing recorded, possibly not even an item to read
+      if (m_enableChecking)
+        {
+          NS_FATAL_ERROR ("Removing header of packet without metadata.");
+        }
+      return;
+    }
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_head, &item, &extraItem);
@@ -720,14 +740,14 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
 void 
 PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
 {
-  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
-  NS_LOG_FUNCTION (this << uid << size);
+  NS_LOG_FUNCTION (this << &trailer << size);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable)
+  if (!m_enable || m_sampledOut)
     {
       m_metadataSkipped = true;
       return;
     }
+  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
   struct PacketMetadata::SmallItem item;
   item.next = 0xffff;
   item.prev = m_tail;
@@ -742,14 +762,23 @@ PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
 void 
 PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
 {
-  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
-  NS_LOG_FUNCTION (this << uid << size);
+  NS_LOG_FUNCTION (this << &trailer << size);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
+  if (!m_enable || m_sampledOut)
     {
       m_metadataSkipped = true;
       return;
     }
+  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
+  if (m_tail == 0xffff)
+    {
+      // nothing recorded, possibly not even an item to read
+      if (m_enableChecking)
+        {
+          NS_FATAL_ERROR ("Removing trailer of packet without metadata.");
+        }
+      return;
+    }
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_tail, &item, &extraItem);
@@ -792,11 +821,19 @@ PacketMetadata::AddAtEnd (PacketMetadata const&o)
 {
   NS_LOG_FUNCTION (this << &o);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
+  if (!m_enable || m_sampledOut)
     {
       m_metadataSkipped = true;
       return;
     }
+  if (o.m_sampledOut)
+    {
+      // the bytes of o are not described: describe none
+      m_head = 0xffff;
+      m_tail = 0xffff;
+      m_sampledOut = true;
+      return;
+    }
   if (m_tail == 0xffff)
     {
       // We have no items so 'AddAtEnd' is 
@@ -868,7 +905,7 @@ PacketMetadata::AddAtEnd (PacketMetadata const&o)
 void
 PacketMetadata::AddPaddingAtEnd (uint32_t end)
 {
-  if (!m_enable)
+  if (!m_enable || m_sampledOut)
     {
       m_metadataSkipped = true;
       return;
@@ -879,12 +916,11 @@ PacketMetadata::RemoveAtStart (uint32_t start)
 {
   NS_LOG_FUNCTION (this << start);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
+  if (!m_enable || m_sampledOut)
     {
       m_metadataSkipped = true;
       return;
     }
-  NS_ASSERT (m_data != 0);
   uint32_t leftToRemove = start;
   uint16_t current = m_head;
   while (current != 0xffff && leftToRemove > 0)
@@ -910,7 +946,7 @@ PacketMetadata::RemoveAtStart (uint32_t start)
       else
         {
           // fragment the list item.
-          PacketMetadata fragment (m_packetUid, 0);
+          PacketMetadata fragment (m_packetUid);
           extraItem.fragmentStart += leftToRemove;
           leftToRemove = 0;
           uint16_t written = fragment.AddBig (0xffff, fragment.m_tail,
@@ -942,12 +978,11 @@ PacketMetadata::RemoveAtEnd (uint32_t end)
 {
   NS_LOG_FUNCTION (this << end);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
+  if (!m_enable || m_sampledOut)
     {
       m_metadataSkipped = true;
       return;
     }
-  NS_ASSERT (m_data != 0);
 
   uint32_t leftToRemove = end;
   uint16_t current = m_tail;
@@ -974,7 +1009,7 @@ PacketMetadata::RemoveAtEnd (uint32_t end)
       else
         {
           // fragment the list item.
-          PacketMetadata fragment (m_packetUid, 0);
+          PacketMetadata fragment (m_packetUid);
           NS_ASSERT (extraItem.fragmentEnd > leftToRemove);
           extraItem.fragmentEnd -= leftToRemove;
           leftToRemove = 0;
@@ -1029,6 +1064,11 @@ PacketMetadata::GetUid (void) const
 {
   return m_packetUid;
 }
+bool
+PacketMetadata::IsSampledOut (void) const
+{
+  return m_sampledOut;
+}
 PacketMetadata::ItemIterator 
 PacketMetadata::BeginItem (Buffer buffer) const
 {
@@ -1271,6 +1311,8 @@ PacketMetadata::Deserialize (const uint8_t* buffer, uint32_t size)
 
   buffer = ReadFromRawU64 (m_packetUid, start, buffer, size);
   desSize -= 8;
+  // the sender records the metadata of the packets it sampled only
+  m_sampledOut = !m_sampler.IsNull () && desSize == 0;
 
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
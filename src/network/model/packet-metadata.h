@@ -75,6 +75,10 @@ class Trailer;
  * integers, and some others as variable-size 32-bit integers.
  * The variable-size 32 bit integers are stored using the uleb128
  * encoding.
+ *
+ * The byte buffer is allocated with the first item: a packet whose
+ * metadata is not recorded, because the metadata is not enabled or
+ * the packet was not sampled, allocates nothing.
  */
 class PacketMetadata 
 {
@@ -127,6 +131,27 @@ private:
 
   static void Enable (void);
   static void EnableChecking (void);
+  /**
+   * \param sampler the callback which decides, when a packet is created,
+   *        whether its metadata is recorded: it is given the uid of the
+   *        packet, and Simulator::GetContext returns the node which
+   *        creates it. A null callback records the metadata of every
+   *        packet.
+   *
+   * Enable the metadata, but record it only for the packets selected
+   * by sampler. The metadata operations on the other packets return
+   * at once, as when the metadata is not enabled. The packets and
+   * their fragments keep the choice made when they were created,
+   * and appending a packet which was not sampled to one which was
+   * drops the metadata of the latter.
+   */
+  static void EnableSampling (Callback<bool, uint64_t> sampler);
+  /**
+   * \param n the sampling period
+   *
+   * Record the metadata of one packet in n, by uid.
+   */
+  static void EnableSampling (uint32_t n);
 
   inline PacketMetadata (uint64_t uid, uint32_t size);
   inline PacketMetadata (PacketMetadata const &o);
@@ -153,6 +178,11 @@ private:
   void RemoveAtEnd (uint32_t end);
 
   uint64_t GetUid (void) const;
+  /**
+   * \returns true if the metadata is enabled but this packet was not
+   *          sampled
+   */
+  bool IsSampledOut (void) const;
 
   uint32_t GetSerializedSize (void) const;
 
@@ -292,16 +322,11 @@ private:
     uint64_t packetUid;
   };
 
-  class DataFreeList : public std::vector<struct Data *>
-  {
-public:
-    ~DataFreeList ();
-  };
-
-  friend DataFreeList::~DataFreeList ();
   friend class ItemIterator;
 
   PacketMetadata ();
+  // an empty list which is recorded whatever the sampler
+  explicit inline PacketMetadata (uint64_t uid);
 
   inline uint16_t AddSmall (const PacketMetadata::SmallItem *item);
   uint16_t AddBig (uint32_t head, uint32_t tail,
@@ -335,9 +360,9 @@ public:
   static struct PacketMetadata::Data *Allocate (uint32_t n);
   static void Deallocate (struct PacketMetadata::Data *data);
 
-  static DataFreeList m_freeList;
   static bool m_enable;
   static bool m_enableChecking;
+  static Callback<bool, uint64_t> m_sampler;
 
   // set to true when adding metadata to a packet is skipped because
   // m_enable is false; used to detect enabling of metadata in the
@@ -356,6 +381,8 @@ public:
   uint16_t m_head;
   uint16_t m_tail;
   uint16_t m_used;
+  // true if this packet was not selected by m_sampler
+  bool m_sampledOut;
   uint64_t m_packetUid;
 };
 
@@ -364,28 +391,40 @@ public:
 namespace ns3 {
 
 PacketMetadata::PacketMetadata (uint64_t uid, uint32_t size)
-  : m_data (PacketMetadata::Create (10)),
+  : m_data (0),
     m_head (0xffff),
     m_tail (0xffff),
     m_used (0),
+    m_sampledOut (!m_sampler.IsNull () && !m_sampler (uid)),
     m_packetUid (uid)
 {
-  memset (m_data->m_data, 0xff, 4);
   if (size > 0)
     {
       DoAddHeader (0, size);
     }
 }
+PacketMetadata::PacketMetadata (uint64_t uid)
+  : m_data (0),
+    m_head (0xffff),
+    m_tail (0xffff),
+    m_used (0),
+    m_sampledOut (false),
+    m_packetUid (uid)
+{
+}
 PacketMetadata::PacketMetadata (PacketMetadata const &o)
   : m_data (o.m_data),
     m_head (o.m_head),
     m_tail (o.m_tail),
     m_used (o.m_used),
+    m_sampledOut (o.m_sampledOut),
     m_packetUid (o.m_packetUid)
 {
-  NS_ASSERT (m_data != 0);
-  NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
-  m_data->m_count++;
+  if (m_data != 0)
+    {
+      NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
+      m_data->m_count++;
+    }
 }
 PacketMetadata &
 PacketMetadata::operator = (PacketMetadata const& o)
@@ -393,25 +432,33 @@ PacketMetadata::operator = (PacketMetadata const& o)
   if (m_data != o.m_data) 
     {
       // not self assignment
-      NS_ASSERT (m_data != 0);
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (m_data != 0)
         {
-          PacketMetadata::Recycle (m_data);
+          m_data->m_count--;
+          if (m_data->m_count == 0) 
+            {
+              PacketMetadata::Recycle (m_data);
+            }
         }
       m_data = o.m_data;
-      NS_ASSERT (m_data != 0);
-      m_data->m_count++;
+      if (m_data != 0)
+        {
+          m_data->m_count++;
+        }
     }
   m_head = o.m_head;
   m_tail = o.m_tail;
   m_used = o.m_used;
+  m_sampledOut = o.m_sampledOut;
   m_packetUid = o.m_packetUid;
   return *this;
 }
 PacketMetadata::~PacketMetadata ()
 {
-  NS_ASSERT (m_data != 0);
+  if (m_data == 0)
+    {
+      return;
+    }
   m_data->m_count--;
   if (m_data->m_count == 0) 
     {
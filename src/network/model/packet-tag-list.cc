@@ -83,10 +83,67 @@ PacketTagList::FreeData (struct TagData *data) const
 }
 #endif
 
+PacketTagList::Iterator::Iterator (const PacketTagList *list)
+  : m_list (list),
+    m_next (list->m_next),
+    m_inline (list->m_nInline)
+{
+}
+bool
+PacketTagList::Iterator::HasNext (void) const
+{
+  return m_next != 0 || m_inline > 0;
+}
+struct PacketTagList::Iterator::Item
+PacketTagList::Iterator::Next (void)
+{
+  NS_ASSERT (HasNext ());
+  struct Item item;
+  if (m_next != 0)
+    {
+      item.tid = m_next->tid;
+      item.data = m_next->data;
+      m_next = m_next->next;
+    }
+  else
+    {
+      m_inline--;
+      item.tid = m_list->m_tids[m_inline];
+      item.data = m_list->m_data[m_inline];
+    }
+  return item;
+}
+
+bool
+PacketTagList::RemoveInline (Tag &tag)
+{
+  TypeId tid = tag.GetInstanceTypeId ();
+  for (uint32_t i = 0; i < m_nInline; i++)
+    {
+      if (m_tids[i] == tid)
+        {
+          tag.Deserialize (TagBuffer (m_data[i], m_data[i]+PACKET_TAG_MAX_SIZE));
+          // keep the remaining tags in the order they were added
+          for (uint32_t j = i + 1; j < m_nInline; j++)
+            {
+              m_tids[j - 1] = m_tids[j];
+              memcpy (m_data[j - 1], m_data[j], PACKET_TAG_MAX_SIZE);
+            }
+          m_nInline--;
+          return true;
+        }
+    }
+  return false;
+}
+
 bool
 PacketTagList::Remove (Tag &tag)
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
+  if (RemoveInline (tag))
+    {
+      return true;
+    }
   TypeId tid = tag.GetInstanceTypeId ();
   bool found = false;
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
@@ -124,7 +181,7 @@ PacketTagList::Remove (Tag &tag)
       prevNext = &copy->next;
     }
   *prevNext = 0;
-  RemoveAll ();
+  RemoveNext ();
   m_next = start;
   return true;
 }
@@ -133,20 +190,34 @@ void
 PacketTagList::Add (const Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
+  TypeId tid = tag.GetInstanceTypeId ();
   // ensure this id was not yet added
+  for (uint32_t i = 0; i < m_nInline; i++)
+    {
+      NS_ASSERT (m_tids[i] != tid);
+    }
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
     {
-      NS_ASSERT (cur->tid != tag.GetInstanceTypeId ());
+      NS_ASSERT (cur->tid != tid);
+    }
+  NS_ASSERT (tag.GetSerializedSize () <= PACKET_TAG_MAX_SIZE);
+  PacketTagList *self = const_cast<PacketTagList *> (this);
+  if (m_next == 0 && m_nInline < INLINE_TAGS)
+    {
+      // the shared nodes hold the most recent tags only
+      self->m_tids[m_nInline] = tid;
+      tag.Serialize (TagBuffer (self->m_data[m_nInline], self->m_data[m_nInline]+tag.GetSerializedSize ()));
+      self->m_nInline++;
+      return;
     }
   struct TagData *head = AllocData ();
   head->count = 1;
   head->next = 0;
-  head->tid = tag.GetInstanceTypeId ();
+  head->tid = tid;
   head->next = m_next;
-  NS_ASSERT (tag.GetSerializedSize () <= PACKET_TAG_MAX_SIZE);
   tag.Serialize (TagBuffer (head->data, head->data+tag.GetSerializedSize ()));
 
-  const_cast<PacketTagList *> (this)->m_next = head;
+  self->m_next = head;
 }
 
 bool
@@ -154,6 +225,15 @@ PacketTagList::Peek (Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   TypeId tid = tag.GetInstanceTypeId ();
+  for (uint32_t i = 0; i < m_nInline; i++)
+    {
+      if (m_tids[i] == tid)
+        {
+          tag.Deserialize (TagBuffer (const_cast<uint8_t *> (m_data[i]), 
+                                      const_cast<uint8_t *> (m_data[i])+PACKET_TAG_MAX_SIZE));
+          return true;
+        }
+    }
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
     {
       if (cur->tid == tid) 
@@ -167,11 +247,10 @@ PacketTagList::Peek (Tag &tag) const
   return false;
 }
 
-const struct PacketTagList::TagData *
-PacketTagList::Head (void) const
+PacketTagList::Iterator
+PacketTagList::Begin (void) const
 {
-  return m_next;
+  return Iterator (this);
 }
 
 } // namespace ns3
-
@@ -22,6 +22,7 @@
 
 #include <stdint.h>
 #include <ostream>
+#include <string.h>
 #include "ns3/type-id.h"
 
 namespace ns3 {
@@ -36,6 +37,16 @@ class Tag;
  */
 #define PACKET_TAG_MAX_SIZE 20
 
+/**
+ * \ingroup packet
+ *
+ * The first INLINE_TAGS tags of a packet are stored in the list
+ * itself, so that adding them requires no allocation and copying
+ * the list copies them.  Their TypeIds are kept in a separate array
+ * which Peek scans before looking at any data.  Further tags are
+ * stored in a linked list of nodes shared, copy-on-write, between
+ * copies of the list.
+ */
 class PacketTagList 
 {
 public:
@@ -46,6 +57,29 @@ public:
     uint32_t count;
   };
 
+  /**
+   * Iterates over the tags of the list, the most recently added first.
+   */
+  class Iterator
+  {
+public:
+    struct Item
+    {
+      TypeId tid;
+      uint8_t const *data;
+    };
+    bool HasNext (void) const;
+    struct PacketTagList::Iterator::Item Next (void);
+private:
+    friend class PacketTagList;
+    Iterator (const PacketTagList *list);
+    const PacketTagList *m_list;
+    const struct TagData *m_next;
+    uint32_t m_inline;
+  };
+
+  static const uint32_t INLINE_TAGS = 3;
+
   inline PacketTagList ();
   inline PacketTagList (PacketTagList const &o);
   inline PacketTagList &operator = (PacketTagList const &o);
@@ -56,17 +90,22 @@ public:
   bool Peek (Tag &tag) const;
   inline void RemoveAll (void);
 
-  const struct PacketTagList::TagData *Head (void) const;
+  PacketTagList::Iterator Begin (void) const;
 
 private:
 
-  bool Remove (TypeId tid);
+  inline void CopyInline (PacketTagList const &o);
+  bool RemoveInline (Tag &tag);
+  inline void RemoveNext (void);
   struct PacketTagList::TagData *AllocData (void) const;
   void FreeData (struct TagData *data) const;
 
   static struct PacketTagList::TagData *g_free;
   static uint32_t g_nfree;
 
+  uint32_t m_nInline;
+  TypeId m_tids[INLINE_TAGS];
+  uint8_t m_data[INLINE_TAGS][PACKET_TAG_MAX_SIZE];
   struct TagData *m_next;
 };
 
@@ -79,13 +118,15 @@ private:
 namespace ns3 {
 
 PacketTagList::PacketTagList ()
-  : m_next ()
+  : m_nInline (0),
+    m_next ()
 {
 }
 
 PacketTagList::PacketTagList (PacketTagList const &o)
   : m_next (o.m_next)
 {
+  CopyInline (o);
   if (m_next != 0)
     {
       m_next->count++;
@@ -96,11 +137,16 @@ PacketTagList &
 PacketTagList::operator = (PacketTagList const &o)
 {
   // self assignment
+  if (this == &o) 
+    {
+      return *this;
+    }
+  CopyInline (o);
   if (m_next == o.m_next) 
     {
       return *this;
     }
-  RemoveAll ();
+  RemoveNext ();
   m_next = o.m_next;
   if (m_next != 0) 
     {
@@ -111,11 +157,29 @@ PacketTagList::operator = (PacketTagList const &o)
 
 PacketTagList::~PacketTagList ()
 {
-  RemoveAll ();
+  RemoveNext ();
+}
+
+void
+PacketTagList::CopyInline (PacketTagList const &o)
+{
+  m_nInline = o.m_nInline;
+  for (uint32_t i = 0; i < m_nInline; i++)
+    {
+      m_tids[i] = o.m_tids[i];
+    }
+  memcpy (m_data, o.m_data, m_nInline * PACKET_TAG_MAX_SIZE);
 }
 
 void
 PacketTagList::RemoveAll (void)
+{
+  m_nInline = 0;
+  RemoveNext ();
+}
+
+void
+PacketTagList::RemoveNext (void)
 {
   struct TagData *prev = 0;
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
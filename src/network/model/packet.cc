@@ -21,14 +21,92 @@
 #include "ns3/assert.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-mutex.h"
+#endif /* HAVE_PTHREAD_H */
 #include <string>
 #include <stdarg.h>
 
 NS_LOG_COMPONENT_DEFINE ("Packet");
 
+namespace {
+
+// The freed Packet objects of a thread, linked through their first bytes
+struct PacketPool
+{
+  void *free;
+  uint32_t count;
+  ns3::Packet::PoolStats stats;
+  PacketPool *next;
+};
+
+const uint32_t POOL_BYTES = 1 << 20;
+
+#ifdef __GNUC__
+__thread PacketPool *t_pool = 0;
+#else
+PacketPool *t_pool = 0;
+#endif
+
+// All the pools ever created, to free their objects at exit
+PacketPool *g_pools = 0;
+// Set once the static destructors of this file ran: the packets freed
+// by later static destructors go straight to the system allocator
+bool g_poolsDestroyed = false;
+
+#ifdef HAVE_PTHREAD_H
+ns3::SystemMutex &
+GetPoolsMutex (void)
+{
+  // Never deleted: threads may still free packets during static destruction
+  static ns3::SystemMutex *mutex = new ns3::SystemMutex ();
+  return *mutex;
+}
+#endif /* HAVE_PTHREAD_H */
+
+PacketPool *
+GetPool (void)
+{
+  if (t_pool == 0)
+    {
+      PacketPool *pool = new PacketPool ();
+      {
+#ifdef HAVE_PTHREAD_H
+        ns3::CriticalSection cs (GetPoolsMutex ());
+#endif /* HAVE_PTHREAD_H */
+        pool->next = g_pools;
+        g_pools = pool;
+      }
+      t_pool = pool;
+    }
+  return t_pool;
+}
+
+struct PoolDestructor
+{
+  ~PoolDestructor ()
+  {
+    g_poolsDestroyed = true;
+    for (PacketPool *pool = g_pools; pool != 0; pool = pool->next)
+      {
+        while (pool->free != 0)
+          {
+            void *object = pool->free;
+            pool->free = *static_cast<void **> (object);
+            ::operator delete (object);
+          }
+        pool->count = 0;
+      }
+  }
+} g_poolDestructor;
+
+} // anonymous namespace
+
 namespace ns3 {
 
 uint32_t Packet::m_globalUid = 0;
+bool Packet::m_pool = false;
 
 TypeId 
 ByteTagIterator::Item::GetTypeId (void) const
@@ -81,38 +159,36 @@ ByteTagIterator::ByteTagIterator (ByteTagList::Iterator i)
 }
 
 
-PacketTagIterator::PacketTagIterator (const struct PacketTagList::TagData *head)
-  : m_current (head)
+PacketTagIterator::PacketTagIterator (PacketTagList::Iterator i)
+  : m_current (i)
 {
 }
 bool
 PacketTagIterator::HasNext (void) const
 {
-  return m_current != 0;
+  return m_current.HasNext ();
 }
 PacketTagIterator::Item
 PacketTagIterator::Next (void)
 {
   NS_ASSERT (HasNext ());
-  const struct PacketTagList::TagData *prev = m_current;
-  m_current = m_current->next;
-  return PacketTagIterator::Item (prev);
+  return PacketTagIterator::Item (m_current.Next ());
 }
 
-PacketTagIterator::Item::Item (const struct PacketTagList::TagData *data)
-  : m_data (data)
+PacketTagIterator::Item::Item (struct PacketTagList::Iterator::Item item)
+  : m_item (item)
 {
 }
 TypeId
 PacketTagIterator::Item::GetTypeId (void) const
 {
-  return m_data->tid;
+  return m_item.tid;
 }
 void
 PacketTagIterator::Item::GetTag (Tag &tag) const
 {
-  NS_ASSERT (tag.GetInstanceTypeId () == m_data->tid);
-  tag.Deserialize (TagBuffer ((uint8_t*)m_data->data, (uint8_t*)m_data->data+PACKET_TAG_MAX_SIZE));
+  NS_ASSERT (tag.GetInstanceTypeId () == m_item.tid);
+  tag.Deserialize (TagBuffer ((uint8_t*)m_item.data, (uint8_t*)m_item.data+PACKET_TAG_MAX_SIZE));
 }
 
 
@@ -247,11 +323,10 @@ Packet::GetNixVector (void) const
   return m_nixVector;
 } 
 
-void
-Packet::AddHeader (const Header &header)
+Buffer::Iterator
+Packet::ReserveAtStart (uint32_t size)
 {
-  uint32_t size = header.GetSerializedSize ();
-  NS_LOG_FUNCTION (this << header.GetInstanceTypeId ().GetName () << size);
+  NS_LOG_FUNCTION (this << size);
   uint32_t orgStart = m_buffer.GetCurrentStartOffset ();
   bool resized = m_buffer.AddAtStart (size);
   if (resized)
@@ -259,7 +334,28 @@ Packet::AddHeader (const Header &header)
       m_byteTagList.AddAtStart (m_buffer.GetCurrentStartOffset () + size - orgStart,
                                 m_buffer.GetCurrentStartOffset () + size);
     }
-  header.Serialize (m_buffer.Begin ());
+  return m_buffer.Begin ();
+}
+Buffer::Iterator
+Packet::ReserveAtEnd (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  uint32_t orgStart = m_buffer.GetCurrentStartOffset ();
+  bool resized = m_buffer.AddAtEnd (size);
+  if (resized)
+    {
+      m_byteTagList.AddAtEnd (m_buffer.GetCurrentStartOffset () - orgStart,
+                              m_buffer.GetCurrentEndOffset () - size);
+    }
+  return m_buffer.End ();
+}
+
+void
+Packet::AddHeader (const Header &header)
+{
+  uint32_t size = header.GetSerializedSize ();
+  NS_LOG_FUNCTION (this << header.GetInstanceTypeId ().GetName () << size);
+  header.Serialize (ReserveAtStart (size));
   m_metadata.AddHeader (header, size);
 }
 uint32_t
@@ -283,15 +379,7 @@ Packet::AddTrailer (const Trailer &trailer)
 {
   uint32_t size = trailer.GetSerializedSize ();
   NS_LOG_FUNCTION (this << trailer.GetInstanceTypeId ().GetName () << size);
-  uint32_t orgStart = m_buffer.GetCurrentStartOffset ();
-  bool resized = m_buffer.AddAtEnd (size);
-  if (resized)
-    {
-      m_byteTagList.AddAtEnd (m_buffer.GetCurrentStartOffset () - orgStart,
-                              m_buffer.GetCurrentEndOffset () - size);
-    }
-  Buffer::Iterator end = m_buffer.End ();
-  trailer.Serialize (end);
+  trailer.Serialize (ReserveAtEnd (size));
   m_metadata.AddTrailer (trailer, size);
 }
 uint32_t
@@ -316,15 +404,15 @@ Packet::AddAtEnd (Ptr<const Packet> packet)
 {
   NS_LOG_FUNCTION (this << packet << packet->GetSize ());
   uint32_t aStart = m_buffer.GetCurrentStartOffset ();
+  uint32_t bStart = packet->m_buffer.GetCurrentStartOffset ();
   uint32_t bEnd = packet->m_buffer.GetCurrentEndOffset ();
   m_buffer.AddAtEnd (packet->m_buffer);
-  uint32_t appendPrependOffset = m_buffer.GetCurrentEndOffset () - packet->m_buffer.GetSize ();
+  uint32_t appendPrependOffset = m_buffer.GetCurrentEndOffset () - (bEnd - bStart);
   m_byteTagList.AddAtEnd (m_buffer.GetCurrentStartOffset () - aStart, 
                           appendPrependOffset);
-  ByteTagList copy = packet->m_byteTagList;
-  copy.AddAtStart (m_buffer.GetCurrentEndOffset () - bEnd,
-                   appendPrependOffset);
-  m_byteTagList.Add (copy);
+  // only the tags of the bytes of packet, which a fragment may not all own
+  m_byteTagList.Add (packet->m_byteTagList, bStart, bEnd,
+                     m_buffer.GetCurrentEndOffset () - bEnd);
   m_metadata.AddAtEnd (packet->m_metadata);
 }
 void
@@ -426,6 +514,11 @@ Packet::PrintByteTags (std::ostream &os) const
 void 
 Packet::Print (std::ostream &os) const
 {
+  if (m_metadata.IsSampledOut ())
+    {
+      os << "Unsampled (size=" << GetSize () << ")";
+      return;
+    }
   PacketMetadata::ItemIterator i = m_metadata.BeginItem (m_buffer);
   while (i.HasNext ())
     {
@@ -553,6 +646,20 @@ Packet::EnablePrinting (void)
   PacketMetadata::Enable ();
 }
 
+void
+Packet::EnableSampledPrinting (Callback<bool, uint64_t> sampler)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  PacketMetadata::EnableSampling (sampler);
+}
+
+void
+Packet::EnableSampledPrinting (uint32_t n)
+{
+  NS_LOG_FUNCTION (n);
+  PacketMetadata::EnableSampling (n);
+}
+
 void
 Packet::EnableChecking (void)
 {
@@ -560,6 +667,65 @@ Packet::EnableChecking (void)
   PacketMetadata::EnableChecking ();
 }
 
+void
+Packet::EnablePool (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_pool = true;
+}
+
+void
+Packet::DisablePool (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_pool = false;
+}
+
+struct Packet::PoolStats
+Packet::GetPoolStats (void)
+{
+  return GetPool ()->stats;
+}
+
+void *
+Packet::operator new (size_t size)
+{
+  if (!m_pool || size != sizeof (Packet) || g_poolsDestroyed)
+    {
+      return ::operator new (size);
+    }
+  PacketPool *pool = GetPool ();
+  void *object = pool->free;
+  if (object != 0)
+    {
+      pool->free = *static_cast<void **> (object);
+      pool->count--;
+      pool->stats.hits++;
+      return object;
+    }
+  pool->stats.misses++;
+  return ::operator new (size);
+}
+
+void
+Packet::operator delete (void *object, size_t size)
+{
+  if (!m_pool || size != sizeof (Packet) || g_poolsDestroyed)
+    {
+      ::operator delete (object);
+      return;
+    }
+  PacketPool *pool = GetPool ();
+  if (pool->count >= POOL_BYTES / sizeof (Packet))
+    {
+      ::operator delete (object);
+      return;
+    }
+  *static_cast<void **> (object) = pool->free;
+  pool->free = object;
+  pool->count++;
+}
+
 uint32_t Packet::GetSerializedSize (void) const
 {
   uint32_t size = 0;
@@ -887,7 +1053,7 @@ Packet::PrintPacketTags (std::ostream &os) const
 PacketTagIterator 
 Packet::GetPacketTagIterator (void) const
 {
-  return PacketTagIterator (m_packetTagList.Head ());
+  return PacketTagIterator (m_packetTagList.Begin ());
 }
 
 std::ostream& operator<< (std::ostream& os, const Packet &packet)
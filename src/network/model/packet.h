@@ -134,8 +134,8 @@ public:
     void GetTag (Tag &tag) const;
 private:
     friend class PacketTagIterator;
-    Item (const struct PacketTagList::TagData *data);
-    const struct PacketTagList::TagData *m_data;
+    Item (struct PacketTagList::Iterator::Item item);
+    struct PacketTagList::Iterator::Item m_item;
   };
   /**
    * \returns true if calling Next is safe, false otherwise.
@@ -147,8 +147,8 @@ private:
   Item Next (void);
 private:
   friend class Packet;
-  PacketTagIterator (const struct PacketTagList::TagData *head);
-  const struct PacketTagList::TagData *m_current;
+  PacketTagIterator (PacketTagList::Iterator i);
+  PacketTagList::Iterator m_current;
 };
 
 /**
@@ -171,7 +171,8 @@ private:
  * output from Packet::Print. If you wish to only enable
  * checking of metadata, and do not need any printing capability, you can
  * call Packet::EnableChecking: its runtime cost is lower than
- * Packet::EnablePrinting.
+ * Packet::EnablePrinting. Packet::EnableSampledPrinting records the
+ * metadata of a few packets only, at a fraction of the cost.
  *
  * - The set of tags contain simulation-specific information which cannot
  * be stored in the packet byte buffer because the protocol headers or trailers
@@ -265,6 +266,14 @@ public:
    * \param header a reference to the header to add to this packet.
    */
   void AddHeader (const Header & header);
+  /**
+   * Add a header of a type with a FixedSerializedSize without calling
+   * its virtual methods; add any other header like AddHeader above.
+   *
+   * \param header a reference to the header to add to this packet.
+   */
+  template <typename T>
+  void AddHeader (const T &header);
   /**
    * Deserialize and remove the header from the internal buffer.
    * This method invokes Header::Deserialize.
@@ -273,6 +282,15 @@ public:
    * \returns the number of bytes removed from the packet.
    */
   uint32_t RemoveHeader (Header &header);
+  /**
+   * The fast path of RemoveHeader, for the types with a
+   * FixedSerializedSize.
+   *
+   * \param header a reference to the header to remove from the internal buffer.
+   * \returns the number of bytes removed from the packet.
+   */
+  template <typename T>
+  uint32_t RemoveHeader (T &header);
   /**
    * Deserialize but does _not_ remove the header from the internal buffer.
    * This method invokes Header::Deserialize.
@@ -281,6 +299,15 @@ public:
    * \returns the number of bytes read from the packet.
    */
   uint32_t PeekHeader (Header &header) const;
+  /**
+   * The fast path of PeekHeader, for the types with a
+   * FixedSerializedSize: it only deserializes the header.
+   *
+   * \param header a reference to the header to read from the internal buffer.
+   * \returns the number of bytes read from the packet.
+   */
+  template <typename T>
+  uint32_t PeekHeader (T &header) const;
   /**
    * Add trailer to this packet. This method invokes the
    * Trailer::GetSerializedSize and Trailer::Serialize
@@ -290,6 +317,14 @@ public:
    * \param trailer a reference to the trailer to add to this packet.
    */
   void AddTrailer (const Trailer &trailer);
+  /**
+   * The fast path of AddTrailer, for the types with a
+   * FixedSerializedSize.
+   *
+   * \param trailer a reference to the trailer to add to this packet.
+   */
+  template <typename T>
+  void AddTrailer (const T &trailer);
   /**
    * Remove a deserialized trailer from the internal buffer.
    * This method invokes the Deserialize method.
@@ -298,6 +333,15 @@ public:
    * \returns the number of bytes removed from the end of the packet.
    */
   uint32_t RemoveTrailer (Trailer &trailer);
+  /**
+   * The fast path of RemoveTrailer, for the types with a
+   * FixedSerializedSize.
+   *
+   * \param trailer a reference to the trailer to remove from the internal buffer.
+   * \returns the number of bytes removed from the end of the packet.
+   */
+  template <typename T>
+  uint32_t RemoveTrailer (T &trailer);
   /**
    * Deserialize but does _not_ remove a trailer from the internal buffer.
    * This method invokes the Trailer::Deserialize method.
@@ -306,6 +350,15 @@ public:
    * \returns the number of bytes read from the end of the packet.
    */
   uint32_t PeekTrailer (Trailer &trailer);
+  /**
+   * The fast path of PeekTrailer, for the types with a
+   * FixedSerializedSize.
+   *
+   * \param trailer a reference to the trailer to read from the internal buffer.
+   * \returns the number of bytes read from the end of the packet.
+   */
+  template <typename T>
+  uint32_t PeekTrailer (T &trailer);
 
   /**
    * Concatenate the input packet at the end of the current
@@ -421,6 +474,25 @@ public:
    * simulation setup and before any packet is created.
    */
   static void EnablePrinting (void);
+  /**
+   * \param sampler the callback which decides, when a packet is created,
+   *        whether its metadata is recorded: it is given the uid of the
+   *        packet, and Simulator::GetContext returns the node which
+   *        creates it. A null callback records every packet.
+   *
+   * Like EnablePrinting, but the metadata is recorded only for the
+   * packets selected by sampler, which are the only ones whose
+   * headers and trailers Print describes: the other packets, and the
+   * packets to which one of them is appended, cost as little as when
+   * the metadata is not enabled.
+   */
+  static void EnableSampledPrinting (Callback<bool, uint64_t> sampler);
+  /**
+   * \param n the sampling period
+   *
+   * Record the metadata of one packet in n.
+   */
+  static void EnableSampledPrinting (uint32_t n);
   /**
    * The packet metadata is also used to perform extensive
    * sanity checks at runtime when performing operations on a 
@@ -431,6 +503,34 @@ public:
    */
   static void EnableChecking (void);
 
+  /**
+   * Counters of the pool of Packet objects of a thread.
+   */
+  struct PoolStats
+  {
+    uint64_t hits;   //!< objects taken from the pool
+    uint64_t misses; //!< objects passed to the system allocator
+  };
+  /**
+   * Keep the memory of the Packet objects which are destroyed, up to
+   * a megabyte per thread, and use it again for the next ones instead
+   * of going back to the system allocator: Create<Packet>, Copy and
+   * the fragments reuse the most recently freed objects, whose
+   * embedded tag lists, still in the cache, are reset by the
+   * constructors.  The pool may be enabled and disabled at any time;
+   * when it is disabled, the objects cost one branch more to allocate
+   * and to free.
+   */
+  static void EnablePool (void);
+  static void DisablePool (void);
+  /**
+   * \returns the counters of the pool of the calling thread
+   */
+  static struct PoolStats GetPoolStats (void);
+
+  static void *operator new (size_t size);
+  static void operator delete (void *object, size_t size);
+
   /**
    * For packet serializtion, the total size is checked 
    * in order to determine the size of the buffer 
@@ -559,6 +659,34 @@ private:
 
   uint32_t Deserialize (uint8_t const*buffer, uint32_t size);
 
+  // make room for a header or a trailer of size bytes, and return
+  // where to serialize it
+  Buffer::Iterator ReserveAtStart (uint32_t size);
+  Buffer::Iterator ReserveAtEnd (uint32_t size);
+
+  // the header and trailer templates select one of the overloads below
+  // at compile time: the others are never instantiated
+  template <bool FIXED>
+  struct FastPath {};
+  inline void DoAddHeader (const Header &header, FastPath<false>);
+  inline uint32_t DoRemoveHeader (Header &header, FastPath<false>);
+  inline uint32_t DoPeekHeader (Header &header, FastPath<false>) const;
+  inline void DoAddTrailer (const Trailer &trailer, FastPath<false>);
+  inline uint32_t DoRemoveTrailer (Trailer &trailer, FastPath<false>);
+  inline uint32_t DoPeekTrailer (Trailer &trailer, FastPath<false>);
+  template <typename T>
+  void DoAddHeader (const T &header, FastPath<true>);
+  template <typename T>
+  uint32_t DoRemoveHeader (T &header, FastPath<true>);
+  template <typename T>
+  uint32_t DoPeekHeader (T &header, FastPath<true>) const;
+  template <typename T>
+  void DoAddTrailer (const T &trailer, FastPath<true>);
+  template <typename T>
+  uint32_t DoRemoveTrailer (T &trailer, FastPath<true>);
+  template <typename T>
+  uint32_t DoPeekTrailer (T &trailer, FastPath<true>);
+
   Buffer m_buffer;
   ByteTagList m_byteTagList;
   PacketTagList m_packetTagList;
@@ -568,6 +696,7 @@ private:
   Ptr<NixVector> m_nixVector;
 
   static uint32_t m_globalUid;
+  static bool m_pool;
 };
 
 std::ostream& operator<< (std::ostream& os, const Packet &packet);
@@ -622,6 +751,129 @@ Packet::GetSize (void) const
   return m_buffer.GetSize ();
 }
 
+template <typename T>
+void
+Packet::AddHeader (const T &header)
+{
+  DoAddHeader (header, FastPath<FixedSerializedSize<T>::value != 0> ());
+}
+template <typename T>
+uint32_t
+Packet::RemoveHeader (T &header)
+{
+  return DoRemoveHeader (header, FastPath<FixedSerializedSize<T>::value != 0> ());
+}
+template <typename T>
+uint32_t
+Packet::PeekHeader (T &header) const
+{
+  return DoPeekHeader (header, FastPath<FixedSerializedSize<T>::value != 0> ());
+}
+template <typename T>
+void
+Packet::AddTrailer (const T &trailer)
+{
+  DoAddTrailer (trailer, FastPath<FixedSerializedSize<T>::value != 0> ());
+}
+template <typename T>
+uint32_t
+Packet::RemoveTrailer (T &trailer)
+{
+  return DoRemoveTrailer (trailer, FastPath<FixedSerializedSize<T>::value != 0> ());
+}
+template <typename T>
+uint32_t
+Packet::PeekTrailer (T &trailer)
+{
+  return DoPeekTrailer (trailer, FastPath<FixedSerializedSize<T>::value != 0> ());
+}
+
+void
+Packet::DoAddHeader (const Header &header, FastPath<false>)
+{
+  AddHeader (header);
+}
+uint32_t
+Packet::DoRemoveHeader (Header &header, FastPath<false>)
+{
+  return RemoveHeader (header);
+}
+uint32_t
+Packet::DoPeekHeader (Header &header, FastPath<false>) const
+{
+  return PeekHeader (header);
+}
+void
+Packet::DoAddTrailer (const Trailer &trailer, FastPath<false>)
+{
+  AddTrailer (trailer);
+}
+uint32_t
+Packet::DoRemoveTrailer (Trailer &trailer, FastPath<false>)
+{
+  return RemoveTrailer (trailer);
+}
+uint32_t
+Packet::DoPeekTrailer (Trailer &trailer, FastPath<false>)
+{
+  return PeekTrailer (trailer);
+}
+
+template <typename T>
+void
+Packet::DoAddHeader (const T &header, FastPath<true>)
+{
+  const uint32_t size = FixedSerializedSize<T>::value;
+  NS_ASSERT (header.GetInstanceTypeId () == T::GetTypeId () &&
+             header.GetSerializedSize () == size);
+  header.T::Serialize (ReserveAtStart (size));
+  m_metadata.AddHeader (header, size);
+}
+template <typename T>
+uint32_t
+Packet::DoRemoveHeader (T &header, FastPath<true>)
+{
+  NS_ASSERT (header.GetInstanceTypeId () == T::GetTypeId ());
+  uint32_t deserialized = header.T::Deserialize (m_buffer.Begin ());
+  m_buffer.RemoveAtStart (deserialized);
+  m_metadata.RemoveHeader (header, deserialized);
+  return deserialized;
+}
+template <typename T>
+uint32_t
+Packet::DoPeekHeader (T &header, FastPath<true>) const
+{
+  NS_ASSERT (header.GetInstanceTypeId () == T::GetTypeId ());
+  return header.T::Deserialize (m_buffer.Begin ());
+}
+template <typename T>
+void
+Packet::DoAddTrailer (const T &trailer, FastPath<true>)
+{
+  const uint32_t size = FixedSerializedSize<T>::value;
+  NS_ASSERT (trailer.GetInstanceTypeId () == T::GetTypeId () &&
+             trailer.GetSerializedSize () == size);
+  trailer.T::Serialize (ReserveAtEnd (size));
+  m_metadata.AddTrailer (trailer, size);
+}
+template <typename T>
+uint32_t
+Packet::DoRemoveTrailer (T &trailer, FastPath<true>)
+{
+  NS_ASSERT (trailer.GetInstanceTypeId () == T::GetTypeId ());
+  uint32_t deserialized = trailer.T::Deserialize (m_buffer.End ());
+  m_buffer.RemoveAtEnd (deserialized);
+  m_metadata.RemoveTrailer (trailer, deserialized);
+  return deserialized;
+}
+template <typename T>
+uint32_t
+Packet::DoPeekTrailer (T &trailer, FastPath<true>)
+{
+  NS_ASSERT (trailer.GetInstanceTypeId () == T::GetTypeId ());
+  return trailer.T::Deserialize (m_buffer.End ());
+}
+
 } // namespace ns3
 
 #endif /* PACKET_H */
@@ -0,0 +1,279 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "size-class-allocator.h"
+#include "ns3/assert.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-mutex.h"
+#include <pthread.h>
+#endif /* HAVE_PTHREAD_H */
+
+namespace {
+
+// 64 bytes, then 4 classes for each power of two up to 65536
+const uint32_t MIN_SIZE = 64;
+const uint32_t N_CLASSES = 41;
+
+struct Block
+{
+  Block *next;
+};
+
+struct Cache
+{
+  Block *free[N_CLASSES];
+  uint32_t count[N_CLASSES];
+  ns3::SizeClassAllocator::Stats stats;
+  bool inUse;
+  Cache *next;
+};
+
+#ifdef __GNUC__
+__thread Cache *t_cache = 0;
+#else
+Cache *t_cache = 0;
+#endif
+
+// All the caches ever created, for GetStats.  The caches of the exited
+// threads are empty and handed to the next new threads.
+Cache *g_caches = 0;
+// Set once the static destructors of this file ran: buffers released
+// by later static destructors go straight to the system allocator
+bool g_destroyed = false;
+
+#ifdef HAVE_PTHREAD_H
+ns3::SystemMutex &
+GetCachesMutex (void)
+{
+  // Never deleted: threads may still allocate during static destruction
+  static ns3::SystemMutex *mutex = new ns3::SystemMutex ();
+  return *mutex;
+}
+#endif /* HAVE_PTHREAD_H */
+
+void
+ReleaseBlocks (Cache *cache)
+{
+  for (uint32_t i = 0; i < N_CLASSES; i++)
+    {
+      while (cache->free[i] != 0)
+        {
+          Block *block = cache->free[i];
+          cache->free[i] = block->next;
+          delete [] reinterpret_cast<uint8_t *> (block);
+        }
+      cache->count[i] = 0;
+    }
+  cache->stats.releasedBytes += cache->stats.cachedBytes;
+  cache->stats.cachedBytes = 0;
+}
+
+#ifdef HAVE_PTHREAD_H
+// Run when a thread which used the allocator exits
+void
+ReleaseCache (void *data)
+{
+  Cache *cache = static_cast<Cache *> (data);
+  ReleaseBlocks (cache);
+  t_cache = 0;
+  ns3::CriticalSection cs (GetCachesMutex ());
+  cache->inUse = false;
+}
+
+pthread_key_t g_cacheKey;
+pthread_once_t g_cacheKeyOnce = PTHREAD_ONCE_INIT;
+
+void
+CreateCacheKey (void)
+{
+  pthread_key_create (&g_cacheKey, &ReleaseCache);
+}
+#endif /* HAVE_PTHREAD_H */
+
+Cache *
+GetCache (void)
+{
+  if (t_cache == 0)
+    {
+      Cache *cache = 0;
+      {
+#ifdef HAVE_PTHREAD_H
+        ns3::CriticalSection cs (GetCachesMutex ());
+#endif /* HAVE_PTHREAD_H */
+        for (cache = g_caches; cache != 0 && cache->inUse; cache = cache->next)
+          {
+          }
+        if (cache == 0)
+          {
+            cache = new Cache ();
+            cache->next = g_caches;
+            g_caches = cache;
+          }
+        cache->inUse = true;
+      }
+#ifdef HAVE_PTHREAD_H
+      pthread_once (&g_cacheKeyOnce, &CreateCacheKey);
+      pthread_setspecific (g_cacheKey, cache);
+#endif /* HAVE_PTHREAD_H */
+      t_cache = cache;
+    }
+  return t_cache;
+}
+
+uint32_t
+Log2 (uint32_t v)
+{
+#ifdef __GNUC__
+  return 31 - __builtin_clz (v);
+#else
+  uint32_t log = 0;
+  while (v >>= 1)
+    {
+      log++;
+    }
+  return log;
+#endif
+}
+
+uint32_t
+GetClass (uint32_t size)
+{
+  if (size <= MIN_SIZE)
+    {
+      return 0;
+    }
+  uint32_t e = Log2 (size - 1);
+  uint32_t sub = ((size - 1) >> (e - 2)) & 3;
+  return (e - 6) * 4 + sub + 1;
+}
+
+uint32_t
+GetSize (uint32_t sizeClass)
+{
+  if (sizeClass == 0)
+    {
+      return MIN_SIZE;
+    }
+  uint32_t e = (sizeClass - 1) / 4 + 6;
+  uint32_t sub = (sizeClass - 1) % 4;
+  return (5 + sub) << (e - 2);
+}
+
+struct CacheDestructor
+{
+  ~CacheDestructor ()
+  {
+    g_destroyed = true;
+    for (Cache *cache = g_caches; cache != 0; cache = cache->next)
+      {
+        ReleaseBlocks (cache);
+      }
+  }
+} g_cacheDestructor;
+
+} // anonymous namespace
+
+namespace ns3 {
+
+uint32_t
+SizeClassAllocator::GetClassSize (uint32_t size)
+{
+  if (size > MAX_SIZE)
+    {
+      return size;
+    }
+  return GetSize (GetClass (size));
+}
+
+uint8_t *
+SizeClassAllocator::Allocate (uint32_t &size)
+{
+  if (g_destroyed)
+    {
+      return new uint8_t [size];
+    }
+  Cache *cache = GetCache ();
+  if (size > MAX_SIZE)
+    {
+      cache->stats.misses++;
+      cache->stats.allocatedBytes += size;
+      return new uint8_t [size];
+    }
+  uint32_t sizeClass = GetClass (size);
+  size = GetSize (sizeClass);
+  Block *block = cache->free[sizeClass];
+  if (block != 0)
+    {
+      cache->free[sizeClass] = block->next;
+      cache->count[sizeClass]--;
+      cache->stats.hits++;
+      cache->stats.cachedBytes -= size;
+      return reinterpret_cast<uint8_t *> (block);
+    }
+  cache->stats.misses++;
+  cache->stats.allocatedBytes += size;
+  return new uint8_t [size];
+}
+
+void
+SizeClassAllocator::Deallocate (uint8_t *buffer, uint32_t size)
+{
+  if (g_destroyed)
+    {
+      delete [] buffer;
+      return;
+    }
+  Cache *cache = GetCache ();
+  if (size > MAX_SIZE)
+    {
+      cache->stats.releasedBytes += size;
+      delete [] buffer;
+      return;
+    }
+  uint32_t sizeClass = GetClass (size);
+  NS_ASSERT (GetSize (sizeClass) == size);
+  if (cache->count[sizeClass] >= CACHE_BYTES / size)
+    {
+      cache->stats.releasedBytes += size;
+      delete [] buffer;
+      return;
+    }
+  Block *block = reinterpret_cast<Block *> (buffer);
+  block->next = cache->free[sizeClass];
+  cache->free[sizeClass] = block;
+  cache->count[sizeClass]++;
+  cache->stats.cachedBytes += size;
+}
+
+struct SizeClassAllocator::Stats
+SizeClassAllocator::GetStats (void)
+{
+  struct Stats stats = { 0, 0, 0, 0, 0 };
+#ifdef HAVE_PTHREAD_H
+  CriticalSection cs (GetCachesMutex ());
+#endif /* HAVE_PTHREAD_H */
+  for (Cache *cache = g_caches; cache != 0; cache = cache->next)
+    {
+      stats.hits += cache->stats.hits;
+      stats.misses += cache->stats.misses;
+      stats.allocatedBytes += cache->stats.allocatedBytes;
+      stats.releasedBytes += cache->stats.releasedBytes;
+      stats.cachedBytes += cache->stats.cachedBytes;
+    }
+  return stats;
+}
+
+} // namespace ns3
@@ -0,0 +1,82 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef SIZE_CLASS_ALLOCATOR_H
+#define SIZE_CLASS_ALLOCATOR_H
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ *
+ * \brief Allocator of the byte buffers of Buffer and PacketMetadata
+ *
+ * Requests are rounded up to a size class: 64 bytes, then four classes
+ * per power of two (80, 96, 112, 128, 160, ...) up to MAX_SIZE, which
+ * wastes at most a fifth of a block.  Freed blocks are kept in a cache
+ * per size class and per thread, so that threads (realtime, emulation)
+ * never contend, and are handed out again to the next request of the
+ * same class.  Larger requests go to the system allocator.
+ *
+ * Each cache holds at most CACHE_BYTES bytes per size class.  When a
+ * thread exits, the blocks of its cache go back to the system
+ * allocator, and the emptied cache to the next new thread.
+ */
+class SizeClassAllocator
+{
+public:
+  static const uint32_t MAX_SIZE = 65536;
+  static const uint32_t CACHE_BYTES = 1 << 20;
+
+  /**
+   * Counters summed over all threads.  The counters of the other
+   * threads are read without synchronization and may lag.
+   */
+  struct Stats
+  {
+    uint64_t hits;           //!< allocations served from a cache
+    uint64_t misses;         //!< allocations passed to the system allocator
+    uint64_t allocatedBytes; //!< bytes obtained from the system allocator
+    uint64_t releasedBytes;  //!< bytes returned to the system allocator
+    uint64_t cachedBytes;    //!< bytes currently held by the caches
+  };
+
+  /**
+   * \param size the number of bytes requested; on return, the size of
+   *        the block, which the caller may use entirely
+   * \returns the block
+   */
+  static uint8_t *Allocate (uint32_t &size);
+  /**
+   * \param block a block returned by Allocate
+   * \param size the size of the block returned by Allocate
+   */
+  static void Deallocate (uint8_t *block, uint32_t size);
+  /**
+   * \returns the counters of all threads
+   */
+  static struct Stats GetStats (void);
+  /**
+   * \param size a number of bytes
+   * \returns the size of the block Allocate returns for size bytes
+   */
+  static uint32_t GetClassSize (uint32_t size);
+};
+
+} // namespace ns3
+
+#endif /* SIZE_CLASS_ALLOCATOR_H */
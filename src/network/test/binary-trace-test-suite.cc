@@ -0,0 +1,161 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <stdio.h>
+#include <sstream>
+
+#include "ns3/test.h"
+#include "ns3/binary-trace.h"
+#include "ns3/trace-helper.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+
+using namespace ns3;
+
+// Records written by BinaryTraceWriter are read back unchanged, across
+// several chunks
+class BinaryTraceRecordTestCase : public TestCase
+{
+public:
+  BinaryTraceRecordTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+BinaryTraceRecordTestCase::BinaryTraceRecordTestCase ()
+  : TestCase ("Check that records are written and read back")
+{
+}
+
+void
+BinaryTraceRecordTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("records.btr");
+  {
+    std::ofstream os (filename.c_str (), std::ios::out | std::ios::binary);
+    BinaryTraceWriter writer (&os, 4, 3);
+    for (uint32_t i = 0; i < 10; i++)
+      {
+        BinaryTraceRecord record;
+        record.time = 1000000000LL * i - 5;
+        record.node = i;
+        record.device = i == 7 ? BinaryTraceRecord::NO_ID : 2 * i;
+        record.event = "+-dr"[i % 4];
+        record.uid = 0x100000000ULL + i;
+        record.size = 1500 - i;
+        for (uint32_t j = 0; j < i; j++)
+          {
+            record.header.push_back (i + j);
+          }
+        writer.Write (record);
+      }
+  }
+
+  BinaryTraceReader reader;
+  NS_TEST_ASSERT_MSG_EQ (reader.Open (filename), true, "Could not open " << filename);
+  NS_TEST_EXPECT_MSG_EQ (reader.GetHeaderBytes (), 4, "Wrong header column width");
+  BinaryTraceRecord record;
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (reader.Read (record), true, "Missing record " << i);
+      NS_TEST_EXPECT_MSG_EQ (record.time, 1000000000LL * i - 5, "Wrong time");
+      NS_TEST_EXPECT_MSG_EQ (record.node, i, "Wrong node");
+      NS_TEST_EXPECT_MSG_EQ (record.device, (i == 7 ? BinaryTraceRecord::NO_ID : 2 * i), "Wrong device");
+      NS_TEST_EXPECT_MSG_EQ (record.event, "+-dr"[i % 4], "Wrong event");
+      NS_TEST_EXPECT_MSG_EQ (record.uid, 0x100000000ULL + i, "Wrong uid");
+      NS_TEST_EXPECT_MSG_EQ (record.size, 1500 - i, "Wrong size");
+      NS_TEST_ASSERT_MSG_EQ (record.header.size (), 4, "Wrong header size");
+      for (uint32_t j = 0; j < 4; j++)
+        {
+          NS_TEST_EXPECT_MSG_EQ ((uint32_t)record.header[j], (j < i ? i + j : 0), "Wrong header byte " << j);
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (reader.Read (record), false, "Unexpected record");
+  reader.Close ();
+  remove (filename.c_str ());
+}
+
+// The default ascii trace sinks write records into a binary stream
+class BinaryTraceSinkTestCase : public TestCase
+{
+public:
+  BinaryTraceSinkTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+BinaryTraceSinkTestCase::BinaryTraceSinkTestCase ()
+  : TestCase ("Check that the default ascii trace sinks write binary records")
+{
+}
+
+void
+BinaryTraceSinkTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("sinks.btr");
+  uint8_t data[3] = { 0x45, 0x00, 0x01 };
+  Ptr<Packet> p = Create<Packet> (data, 3);
+  {
+    AsciiTraceHelper helper;
+    Ptr<OutputStreamWrapper> stream = helper.CreateBinaryFileStream (filename, 2);
+    NS_TEST_EXPECT_MSG_EQ (AsciiTraceHelper::IsBinaryStream (stream), true, "Binary stream not recognized");
+    AsciiTraceHelper::MakeDefaultSinkWithContext ('+', stream) ("/NodeList/3/DeviceList/1/$ns3::CsmaNetDevice/TxQueue/Enqueue", p);
+    AsciiTraceHelper::MakeDefaultSinkWithContext ('-', stream) ("/NodeList/3/DeviceList/1/$ns3::CsmaNetDevice/TxQueue/Dequeue", p);
+    AsciiTraceHelper::MakeDefaultSinkWithoutContext ('d', stream) (p);
+    AsciiTraceHelper::MakeDefaultSinkWithContext ('r', stream) ("/NodeList/12/DeviceList/0/MacRx", p);
+  }
+  {
+    AsciiTraceHelper helper;
+    Ptr<OutputStreamWrapper> stream = helper.CreateFileStream (CreateTempDirFilename ("sinks.tr"));
+    NS_TEST_EXPECT_MSG_EQ (AsciiTraceHelper::IsBinaryStream (stream), false, "Text stream taken as binary");
+  }
+
+  BinaryTraceReader reader;
+  NS_TEST_ASSERT_MSG_EQ (reader.Open (filename), true, "Could not open " << filename);
+  const char events[4] = { '+', '-', 'd', 'r' };
+  const uint32_t nodes[4] = { 3, 3, BinaryTraceRecord::NO_ID, 12 };
+  const uint32_t devices[4] = { 1, 1, BinaryTraceRecord::NO_ID, 0 };
+  BinaryTraceRecord record;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (reader.Read (record), true, "Missing record " << i);
+      NS_TEST_EXPECT_MSG_EQ (record.event, events[i], "Wrong event");
+      NS_TEST_EXPECT_MSG_EQ (record.node, nodes[i], "Wrong node");
+      NS_TEST_EXPECT_MSG_EQ (record.device, devices[i], "Wrong device");
+      NS_TEST_EXPECT_MSG_EQ (record.uid, p->GetUid (), "Wrong uid");
+      NS_TEST_EXPECT_MSG_EQ (record.size, 3, "Wrong size");
+      NS_TEST_ASSERT_MSG_EQ (record.header.size (), 2, "Wrong header size");
+      NS_TEST_EXPECT_MSG_EQ ((uint32_t)record.header[0], 0x45, "Wrong header");
+      NS_TEST_EXPECT_MSG_EQ ((uint32_t)record.header[1], 0x00, "Wrong header");
+    }
+  NS_TEST_EXPECT_MSG_EQ (reader.Read (record), false, "Unexpected record");
+  reader.Close ();
+  remove (filename.c_str ());
+}
+
+class BinaryTraceTestSuite : public TestSuite
+{
+public:
+  BinaryTraceTestSuite ();
+};
+
+BinaryTraceTestSuite::BinaryTraceTestSuite ()
+  : TestSuite ("binary-trace", UNIT)
+{
+  AddTestCase (new BinaryTraceRecordTestCase);
+  AddTestCase (new BinaryTraceSinkTestCase);
+}
+
+static BinaryTraceTestSuite g_binaryTraceTestSuite;
@@ -1,6 +1,7 @@
 #include "ns3/buffer.h"
 #include "ns3/random-variable.h"
 #include "ns3/test.h"
+#include <vector>
 
 namespace ns3 {
 
@@ -320,6 +321,110 @@ BufferTest::DoRun (void)
   free (cBuf);
 }
 //-----------------------------------------------------------------------------
+class BufferZeroAreaTest : public TestCase
+{
+private:
+  Buffer CreateBuffer (uint8_t head, uint32_t zeroSize, uint8_t tail);
+  bool IsZero (Buffer b, uint32_t start, uint32_t end);
+public:
+  virtual void DoRun (void);
+  BufferZeroAreaTest ();
+};
+
+BufferZeroAreaTest::BufferZeroAreaTest ()
+  : TestCase ("Buffer zero area")
+{
+}
+
+Buffer
+BufferZeroAreaTest::CreateBuffer (uint8_t head, uint32_t zeroSize, uint8_t tail)
+{
+  Buffer buffer = Buffer (zeroSize);
+  buffer.AddAtStart (1);
+  buffer.Begin ().WriteU8 (head);
+  buffer.AddAtEnd (1);
+  Buffer::Iterator i = buffer.End ();
+  i.Prev ();
+  i.WriteU8 (tail);
+  return buffer;
+}
+
+bool
+BufferZeroAreaTest::IsZero (Buffer b, uint32_t start, uint32_t end)
+{
+  std::vector<uint8_t> data (b.GetSize ());
+  b.CopyData (&data[0], b.GetSize ());
+  for (uint32_t i = start; i < end; i++)
+    {
+      if (data[i] != 0)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+BufferZeroAreaTest::DoRun (void)
+{
+  // The zero area of a buffer cut into fragments and put back
+  // together again is never materialized.
+  Buffer buffer = CreateBuffer (0x1, 100000, 0x2);
+  Buffer copy = buffer.CreateFragment (0, 1000);
+  for (uint32_t start = 1000; start < buffer.GetSize (); start += 1000)
+    {
+      uint32_t length = std::min (buffer.GetSize () - start, 1000U);
+      copy.AddAtEnd (buffer.CreateFragment (start, length));
+    }
+  NS_TEST_ASSERT_MSG_EQ (copy.GetSize (), 100002, "bad size");
+  // zero area size, start and end data sizes and padded data
+  NS_TEST_EXPECT_MSG_EQ (copy.GetSerializedSize (), 20, "zero area materialized");
+  NS_TEST_EXPECT_MSG_EQ (copy.Begin ().ReadU8 (), 0x1, "bad head");
+  Buffer::Iterator i = copy.End ();
+  i.Prev ();
+  NS_TEST_EXPECT_MSG_EQ (i.ReadU8 (), 0x2, "bad tail");
+  NS_TEST_EXPECT_MSG_EQ (IsZero (copy, 1, 100001), true, "bad zero area");
+  NS_TEST_EXPECT_MSG_EQ (buffer.GetSerializedSize (), 20, "original buffer modified");
+
+  // Real bytes appended to a zero area
+  Buffer real;
+  real.AddAtStart (3);
+  real.Begin ().WriteU8 (0x3, 3);
+  copy = Buffer (1000);
+  copy.AddAtEnd (real);
+  NS_TEST_EXPECT_MSG_EQ (copy.GetSerializedSize (), 16, "zero area materialized");
+  NS_TEST_EXPECT_MSG_EQ (IsZero (copy, 0, 1000), true, "bad zero area");
+  i = copy.End ();
+  i.Prev (3);
+  NS_TEST_EXPECT_MSG_EQ (i.ReadU8 (), 0x3, "bad real bytes");
+
+  // Real bytes prepended to a zero area
+  copy = real;
+  copy.AddAtEnd (Buffer (1000));
+  NS_TEST_EXPECT_MSG_EQ (copy.GetSerializedSize (), 16, "zero area materialized");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetSize (), 1003, "bad size");
+  NS_TEST_EXPECT_MSG_EQ (IsZero (copy, 3, 1003), true, "bad zero area");
+
+  // With real bytes between the zero areas, the smallest is materialized
+  Buffer small = CreateBuffer (0x4, 10, 0x5);
+  Buffer large = CreateBuffer (0x6, 1000, 0x7);
+  copy = small;
+  copy.AddAtEnd (large);
+  NS_TEST_EXPECT_MSG_EQ (copy.GetSerializedSize (), 4 + 4 + 16 + 4 + 4, "large zero area materialized");
+  copy = large;
+  copy.AddAtEnd (small);
+  NS_TEST_EXPECT_MSG_EQ (copy.GetSerializedSize (), 4 + 4 + 4 + 4 + 16, "large zero area materialized");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetSize (), 1014, "bad size");
+  NS_TEST_EXPECT_MSG_EQ (IsZero (copy, 1, 1001), true, "bad zero area");
+  NS_TEST_EXPECT_MSG_EQ (IsZero (copy, 1003, 1013), true, "bad zero area");
+  i = copy.Begin ();
+  i.Next (1001);
+  NS_TEST_EXPECT_MSG_EQ (i.ReadU8 (), 0x7, "bad real bytes");
+  NS_TEST_EXPECT_MSG_EQ (i.ReadU8 (), 0x4, "bad real bytes");
+  i.Next (10);
+  NS_TEST_EXPECT_MSG_EQ (i.ReadU8 (), 0x5, "bad real bytes");
+}
+//-----------------------------------------------------------------------------
 class BufferTestSuite : public TestSuite
 {
 public:
@@ -330,6 +435,7 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest);
+  AddTestCase (new BufferZeroAreaTest);
 }
 
 static BufferTestSuite g_bufferTestSuite;
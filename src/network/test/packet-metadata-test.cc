@@ -248,6 +248,12 @@ HistoryTrailer<N>::Deserialize (Buffer::Iterator start)
   return N;
 }
 
+bool
+SampleEvenUids (uint64_t uid)
+{
+  return uid % 2 == 0;
+}
+
 }
 
 namespace ns3 {
@@ -820,6 +826,36 @@ PacketMetadataTest::DoRun (void)
                                  p3->GetSize ());
   delete [] buf;
   NS_TEST_EXPECT_MSG_EQ (msg, std::string ("hello world"), "Could not find original data in received packet");
+
+  // only the packets selected by the sampler carry metadata
+  PacketMetadata::EnableSampling (MakeCallback (&SampleEvenUids));
+  p = Create<Packet> (10);
+  if (p->GetUid () % 2 != 0)
+    {
+      p = Create<Packet> (10);
+    }
+  p1 = Create<Packet> (10);
+  ADD_HEADER (p, 2);
+  ADD_HEADER (p1, 2);
+  CHECK_HISTORY (p, 2, 2, 10);
+  CHECK_HISTORY (p1, 0);
+  std::ostringstream oss;
+  p1->Print (oss);
+  NS_TEST_EXPECT_MSG_EQ (oss.str (), "Unsampled (size=12)", "Unexpected output for a packet not sampled");
+  REM_HEADER (p1, 2);
+  p2 = p->CreateFragment (0, 4);
+  CHECK_HISTORY (p2, 2, 2, 2);
+  p2->AddAtEnd (p1);
+  CHECK_HISTORY (p2, 0);
+  oss.str ("");
+  p2->Print (oss);
+  NS_TEST_EXPECT_MSG_EQ (oss.str (), "Unsampled (size=14)", "Unexpected output for a packet partly sampled");
+  CHECK_HISTORY (p, 2, 2, 10);
+  PacketMetadata::EnableSampling (MakeNullCallback<bool, uint64_t> ());
+  p1 = Create<Packet> (10);
+  p2 = Create<Packet> (10);
+  CHECK_HISTORY (p1, 1, 10);
+  CHECK_HISTORY (p2, 1, 10);
 }
 //-----------------------------------------------------------------------------
 class PacketMetadataTestSuite : public TestSuite
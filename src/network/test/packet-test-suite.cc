@@ -196,6 +196,18 @@ struct Expected
 
 }
 
+// take the fast path of Packet for these two only
+template <>
+struct FixedSerializedSize<ATestHeader<7> >
+{
+  static const uint32_t value = 7;
+};
+template <>
+struct FixedSerializedSize<ATestTrailer<7> >
+{
+  static const uint32_t value = 7;
+};
+
 // tag name, start, end
 #define E(a,b,c) a,b,c
 
@@ -420,6 +432,51 @@ PacketTest::DoRun (void)
     NS_TEST_EXPECT_MSG_EQ (p.PeekPacketTag (b), false, "trivial");
   }
 
+  {
+    // more tags than the list stores inline
+    Packet p;
+    ATestTag<10> a;
+    ATestTag<11> b;
+    ATestTag<12> c;
+    ATestTag<13> d;
+    ATestTag<14> e;
+    p.AddPacketTag (a);
+    p.AddPacketTag (b);
+    p.AddPacketTag (c);
+    p.AddPacketTag (d);
+    p.AddPacketTag (e);
+    TypeId expected[] = { e.GetTypeId (), d.GetTypeId (), c.GetTypeId (), b.GetTypeId (), a.GetTypeId () };
+    uint32_t n = 0;
+    for (PacketTagIterator i = p.GetPacketTagIterator (); i.HasNext (); n++)
+      {
+        PacketTagIterator::Item item = i.Next ();
+        NS_TEST_ASSERT_MSG_LT (n, 5, "too many tags");
+        NS_TEST_EXPECT_MSG_EQ (item.GetTypeId (), expected[n], "tags not iterated most recent first");
+      }
+    NS_TEST_EXPECT_MSG_EQ (n, 5, "missing tags");
+    Packet copy = p;
+    NS_TEST_EXPECT_MSG_EQ (copy.RemovePacketTag (b), true, "inline tag");
+    NS_TEST_EXPECT_MSG_EQ (copy.RemovePacketTag (d), true, "shared tag");
+    NS_TEST_EXPECT_MSG_EQ (b.m_error, false, "inline tag corrupted");
+    NS_TEST_EXPECT_MSG_EQ (d.m_error, false, "shared tag corrupted");
+    NS_TEST_EXPECT_MSG_EQ (copy.PeekPacketTag (a), true, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (copy.PeekPacketTag (b), false, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (copy.PeekPacketTag (c), true, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (copy.PeekPacketTag (d), false, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (copy.PeekPacketTag (e), true, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (p.PeekPacketTag (b), true, "tag removed from the original");
+    NS_TEST_EXPECT_MSG_EQ (p.PeekPacketTag (d), true, "tag removed from the original");
+    copy.AddPacketTag (b);
+    NS_TEST_EXPECT_MSG_EQ (copy.GetPacketTagIterator ().Next ().GetTypeId (), b.GetTypeId (), "last tag not first");
+    NS_TEST_EXPECT_MSG_EQ (p.PeekPacketTag (a), true, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (a.m_error, false, "inline tag corrupted");
+    NS_TEST_EXPECT_MSG_EQ (p.PeekPacketTag (e), true, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (e.m_error, false, "shared tag corrupted");
+    p.RemoveAllPacketTags ();
+    NS_TEST_EXPECT_MSG_EQ (p.GetPacketTagIterator ().HasNext (), false, "tags left");
+    NS_TEST_EXPECT_MSG_EQ (copy.PeekPacketTag (e), true, "tag removed from the copy");
+  }
+
   {
     // bug 572
     Ptr<Packet> tmp = Create<Packet> (1000);
@@ -434,6 +491,113 @@ PacketTest::DoRun (void)
     CHECK (tmp, 1, E (20, 1, 1001));
 #endif
   }
+
+  {
+    // fragments with their own headers and tags put back together
+    Ptr<Packet> tmp = Create<Packet> (1000);
+    tmp->AddByteTag (ATestTag<20> ());
+    tmp->AddHeader (ATestHeader<10> ());
+    tmp->AddByteTag (ATestTag<3> ());
+    Ptr<Packet> a = tmp->CreateFragment (0, 500);
+    Ptr<Packet> b = tmp->CreateFragment (500, 510);
+    CHECK (a, 2, E (20, 10, 500), E (3, 0, 500));
+    b->AddHeader (ATestHeader<2> ());
+    CHECK (b, 2, E (20, 2, 512), E (3, 2, 512));
+    b->AddByteTag (ATestTag<4> ());
+    CHECK (b, 3, E (20, 2, 512), E (3, 2, 512), E (4, 0, 512));
+    ATestHeader<2> header;
+    b->RemoveHeader (header);
+    CHECK (b, 3, E (20, 0, 510), E (3, 0, 510), E (4, 0, 510));
+    a->AddAtEnd (b);
+    CHECK (a, 5, E (20, 10, 500), E (3, 0, 500), E (20, 500, 1010), E (3, 500, 1010), E (4, 500, 1010));
+    b->AddHeader (ATestHeader<1> ());
+    CHECK (b, 3, E (20, 1, 511), E (3, 1, 511), E (4, 1, 511));
+    a->AddTrailer (ATestTrailer<5> ());
+    CHECK (a, 5, E (20, 10, 500), E (3, 0, 500), E (20, 500, 1010), E (3, 500, 1010), E (4, 500, 1010));
+    CHECK (tmp, 2, E (20, 10, 1010), E (3, 0, 1010));
+  }
+
+  {
+    // more headers over trimmed tags than the list keeps clip windows for
+    Ptr<Packet> tmp = Create<Packet> (100);
+    tmp->AddByteTag (ATestTag<5> ());
+    for (uint32_t i = 0; i < 5; i++)
+      {
+        Ptr<Packet> copy = tmp->Copy ();
+        copy->AddHeader (ATestHeader<10> ());
+        tmp->RemoveAtStart (1);
+        tmp->AddHeader (ATestHeader<10> ());
+        switch (i)
+          {
+          case 0:
+            tmp->AddByteTag (ATestTag<6> ());
+            CHECK (tmp, 2, E (5, 10, 109), E (6, 0, 109));
+            break;
+          case 1:
+            tmp->AddByteTag (ATestTag<7> ());
+            CHECK (tmp, 3, E (5, 19, 118), E (6, 10, 118), E (7, 0, 118));
+            break;
+          case 2:
+            tmp->AddByteTag (ATestTag<8> ());
+            CHECK (tmp, 4, E (5, 28, 127), E (6, 19, 127), E (7, 10, 127), E (8, 0, 127));
+            break;
+          case 3:
+            tmp->AddByteTag (ATestTag<9> ());
+            CHECK (tmp, 5, E (5, 37, 136), E (6, 28, 136), E (7, 19, 136), E (8, 10, 136), E (9, 0, 136));
+            break;
+          case 4:
+            tmp->AddByteTag (ATestTag<10> ());
+            CHECK (tmp, 6, E (5, 46, 145), E (6, 37, 145), E (7, 28, 145), E (8, 19, 145), E (9, 10, 145),
+                   E (10, 0, 145));
+            break;
+          }
+      }
+  }
+
+  {
+    // headers and trailers of a fixed serialized size
+    Ptr<Packet> tmp = Create<Packet> (10);
+    tmp->AddByteTag (ATestTag<1> ());
+    tmp->AddHeader (ATestHeader<7> ());
+    tmp->AddTrailer (ATestTrailer<7> ());
+    NS_TEST_EXPECT_MSG_EQ (tmp->GetSize (), 24, "trivial");
+    CHECK (tmp, 1, E (1, 7, 17));
+    ATestHeader<7> header;
+    NS_TEST_EXPECT_MSG_EQ (tmp->PeekHeader (header), 7, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (tmp->RemoveHeader (header), 7, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (header.m_error, false, "Could not deserialize the header");
+    ATestTrailer<7> trailer;
+    NS_TEST_EXPECT_MSG_EQ (tmp->PeekTrailer (trailer), 7, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (tmp->RemoveTrailer (trailer), 7, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (trailer.m_error, false, "Could not deserialize the trailer");
+    NS_TEST_EXPECT_MSG_EQ (tmp->GetSize (), 10, "trivial");
+    CHECK (tmp, 1, E (1, 0, 10));
+  }
+
+  {
+    // packet objects recycled by the pool start empty
+    Packet::EnablePool ();
+    Ptr<Packet> tmp = Create<Packet> (10);
+    tmp->AddByteTag (ATestTag<1> ());
+    tmp->AddPacketTag (ATestTag<2> ());
+    Packet *object = PeekPointer (tmp);
+    tmp = 0;
+    Packet::PoolStats before = Packet::GetPoolStats ();
+    tmp = Create<Packet> (20);
+    Packet::PoolStats after = Packet::GetPoolStats ();
+    NS_TEST_EXPECT_MSG_EQ (after.hits, before.hits + 1, "Packet not taken from the pool");
+    NS_TEST_EXPECT_MSG_EQ (PeekPointer (tmp), object, "Most recently freed packet not reused");
+    NS_TEST_EXPECT_MSG_EQ (tmp->GetSize (), 20, "trivial");
+    CHECK (tmp, 0, E (0, 0, 0));
+    ATestTag<2> tag;
+    NS_TEST_EXPECT_MSG_EQ (tmp->PeekPacketTag (tag), false, "Packet tag kept by the pool");
+    Ptr<Packet> copy = tmp->Copy ();
+    tmp = 0;
+    copy = 0;
+    Packet::DisablePool ();
+    tmp = Create<Packet> (10);
+    NS_TEST_EXPECT_MSG_EQ (Packet::GetPoolStats ().hits, after.hits, "Pool used while disabled");
+  }
 }
 //-----------------------------------------------------------------------------
 class PacketTestSuite : public TestSuite
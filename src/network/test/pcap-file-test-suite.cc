@@ -24,6 +24,10 @@
 
 #include "ns3/test.h"
 #include "ns3/pcap-file.h"
+#include "ns3/pcap-file-wrapper.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 
 using namespace ns3;
 
@@ -1101,6 +1105,102 @@ DiffTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (usec, 3696, "Files are different from 2.3696 seconds");
 }
 
+// ===========================================================================
+// Test case to make sure that PcapFileWrapper writes the same file from its
+// background thread, including the records still in memory when the
+// simulator is destroyed
+// ===========================================================================
+class AsynchronousWriteTestCase : public TestCase
+{
+public:
+  AsynchronousWriteTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void WriteAll (Ptr<PcapFileWrapper> f);
+};
+
+AsynchronousWriteTestCase::AsynchronousWriteTestCase ()
+  : TestCase ("Check that PcapFileWrapper writes the same records asynchronously")
+{
+}
+
+void
+AsynchronousWriteTestCase::WriteAll (Ptr<PcapFileWrapper> f)
+{
+  uint8_t payload[1500];
+  for (uint32_t i = 0; i < sizeof (payload); ++i)
+    {
+      payload[i] = i * 7;
+    }
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      uint32_t size = (i * 131) % sizeof (payload);
+      Time t = MicroSeconds (i * 1000 + size);
+      if (i % 2)
+        {
+          f->Write (t, Create<Packet> (payload, size));
+        }
+      else
+        {
+          f->Write (t, payload, size);
+        }
+    }
+}
+
+void
+AsynchronousWriteTestCase::DoRun (void)
+{
+  std::string synchronous = CreateTempDirFilename ("synchronous.pcap");
+  std::string asynchronous = CreateTempDirFilename ("asynchronous.pcap");
+
+  Ptr<PcapFileWrapper> f = CreateObject<PcapFileWrapper> ();
+  f->Open (synchronous, std::ios::out);
+  f->Init (1, 1000);
+  WriteAll (f);
+  f->Close ();
+
+  // Small batches and buffer, for the simulation thread to wait for the
+  // background thread
+  f = CreateObject<PcapFileWrapper> ();
+  f->SetAttribute ("Asynchronous", BooleanValue (true));
+  f->SetAttribute ("BatchSize", UintegerValue (500));
+  f->SetAttribute ("BufferSize", UintegerValue (2000));
+  f->Open (asynchronous, std::ios::out);
+  f->Init (1, 1000);
+  NS_TEST_ASSERT_MSG_EQ (f->Fail (), false, "Init (" << asynchronous << ") returns error");
+  WriteAll (f);
+  Simulator::Destroy ();
+  NS_TEST_EXPECT_MSG_EQ (f->GetDroppedRecords (), 0, "No record may be dropped when blocking");
+
+  uint32_t sec (0), usec (0);
+  bool diff = PcapFile::Diff (synchronous, asynchronous, sec, usec);
+  NS_TEST_EXPECT_MSG_EQ (diff, false, "Files differ at " << sec << "." << usec);
+  f->Close ();
+
+  // Reopening the wrapper while the writer thread has records of the
+  // previous file must complete that file before starting the new one
+  std::string first = CreateTempDirFilename ("first.pcap");
+  std::string second = CreateTempDirFilename ("second.pcap");
+  f = CreateObject<PcapFileWrapper> ();
+  f->SetAttribute ("Asynchronous", BooleanValue (true));
+  f->SetAttribute ("BatchSize", UintegerValue (500));
+  f->Open (first, std::ios::out);
+  f->Init (1, 1000);
+  WriteAll (f);
+  f->Open (second, std::ios::out);
+  f->Init (1, 1000);
+  NS_TEST_ASSERT_MSG_EQ (f->Fail (), false, "Init (" << second << ") returns error");
+  WriteAll (f);
+  Simulator::Destroy ();
+  f->Close ();
+
+  diff = PcapFile::Diff (synchronous, first, sec, usec);
+  NS_TEST_EXPECT_MSG_EQ (diff, false, "First file differs at " << sec << "." << usec);
+  diff = PcapFile::Diff (synchronous, second, sec, usec);
+  NS_TEST_EXPECT_MSG_EQ (diff, false, "Second file differs at " << sec << "." << usec);
+}
+
 class PcapFileTestSuite : public TestSuite
 {
 public:
@@ -1118,6 +1218,7 @@ PcapFileTestSuite::PcapFileTestSuite ()
   AddTestCase (new RecordHeaderTestCase);
   AddTestCase (new ReadFileTestCase);
   AddTestCase (new DiffTestCase);
+  AddTestCase (new AsynchronousWriteTestCase);
 }
 
 static PcapFileTestSuite pcapFileTestSuite;
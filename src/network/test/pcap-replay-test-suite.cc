@@ -0,0 +1,404 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <stdio.h>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+
+#include "ns3/test.h"
+#include "ns3/pcap-file.h"
+#include "ns3/mapped-pcap-file.h"
+#include "ns3/pcap-replay-net-device.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/double.h"
+
+using namespace ns3;
+
+namespace {
+
+const uint32_t N_RECORDS = 10;
+
+// Ethernet frames of 14 + i bytes, with the ethertype 0x0800, i
+// milliseconds after 100 seconds, with the snapshot length cutting the
+// last ones
+void
+WriteTestFile (std::string filename, bool swapMode)
+{
+  PcapFile f;
+  f.Open (filename, std::ios::out);
+  f.Init (1, 20, 0, swapMode);
+  for (uint32_t i = 0; i < N_RECORDS; i++)
+    {
+      uint8_t data[64];
+      memset (data, 0, sizeof (data));
+      data[0] = 0xff; // to a multicast address
+      data[12] = 0x08;
+      for (uint32_t j = 14; j < 14 + i; j++)
+        {
+          data[j] = i;
+        }
+      f.Write (100, i * 1000, data, 14 + i);
+    }
+  f.Close ();
+}
+
+} // anonymous namespace
+
+class MappedPcapFileTestCase : public TestCase
+{
+public:
+  MappedPcapFileTestCase (bool swapMode);
+private:
+  virtual void DoRun (void);
+  bool m_swapMode;
+};
+
+MappedPcapFileTestCase::MappedPcapFileTestCase (bool swapMode)
+  : TestCase (swapMode ? "Check random access to the records of a swapped pcap file"
+              : "Check random access to the records of a pcap file"),
+    m_swapMode (swapMode)
+{
+}
+
+void
+MappedPcapFileTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("mapped.pcap");
+  WriteTestFile (filename, m_swapMode);
+
+  MappedPcapFile f;
+  NS_TEST_ASSERT_MSG_EQ (f.Open (filename), true, "Could not map " << filename);
+  NS_TEST_EXPECT_MSG_EQ (f.GetSwapMode (), m_swapMode, "Wrong swap mode");
+  NS_TEST_EXPECT_MSG_EQ (f.GetDataLinkType (), 1, "Wrong data link type");
+  NS_TEST_EXPECT_MSG_EQ (f.GetSnapLen (), 20, "Wrong snapshot length");
+  NS_TEST_ASSERT_MSG_EQ (f.GetNRecords (), N_RECORDS, "Wrong number of records");
+  for (uint32_t k = 0; k < N_RECORDS; k++)
+    {
+      // out of order
+      uint32_t i = (k * 7) % N_RECORDS;
+      struct MappedPcapFile::Record record = f.GetRecord (i);
+      NS_TEST_EXPECT_MSG_EQ (record.time, 100000000000ULL + i * 1000000, "Wrong time of record " << i);
+      NS_TEST_EXPECT_MSG_EQ (record.origLen, 14 + i, "Wrong length of record " << i);
+      NS_TEST_ASSERT_MSG_EQ (record.inclLen, std::min<uint32_t> (20, 14 + i), "Wrong included length of record " << i);
+      if (record.inclLen > 14)
+        {
+          NS_TEST_EXPECT_MSG_EQ ((uint32_t)record.data[record.inclLen - 1], i, "Wrong data in record " << i);
+        }
+      NS_TEST_EXPECT_MSG_EQ (f.CreatePacket (i)->GetSize (), record.inclLen, "Wrong packet size");
+    }
+  f.Close ();
+  NS_TEST_EXPECT_MSG_EQ (f.IsOpen (), false, "File still open");
+  remove (filename.c_str ());
+}
+
+class MappedPcapFileIndexTestCase : public TestCase
+{
+public:
+  MappedPcapFileIndexTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+MappedPcapFileIndexTestCase::MappedPcapFileIndexTestCase ()
+  : TestCase ("Check random access to the records of a pcap file larger than its index")
+{
+}
+
+void
+MappedPcapFileIndexTestCase::DoRun (void)
+{
+  // records of 4 bytes holding their index, the last one truncated
+  std::string filename = CreateTempDirFilename ("index.pcap");
+  uint32_t n = 2000;
+  PcapFile w;
+  w.Open (filename, std::ios::out);
+  w.Init (1, 64, 0, false);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      w.Write (100, i, (uint8_t const *)&i, 4);
+    }
+  w.Close ();
+  std::ofstream truncated (filename.c_str (), std::ios::out | std::ios::app | std::ios::binary);
+  truncated.write ("\0\0\0\0\0\0\0\0\4\0\0\0", 12);
+  truncated.close ();
+
+  MappedPcapFile f;
+  NS_TEST_ASSERT_MSG_EQ (f.Open (filename), true, "Could not map " << filename);
+  for (uint32_t k = 0; k < n; k++)
+    {
+      // out of order, then in order
+      uint32_t i = k < n / 2 ? (k * 337) % n : k;
+      NS_TEST_ASSERT_MSG_EQ (f.HasRecord (i), true, "Record " << i << " not found");
+      struct MappedPcapFile::Record record = f.GetRecord (i);
+      uint32_t value;
+      memcpy (&value, record.data, 4);
+      NS_TEST_EXPECT_MSG_EQ (value, i, "Wrong data in record " << i);
+      NS_TEST_EXPECT_MSG_EQ (record.time, 100000000000ULL + i * 1000, "Wrong time of record " << i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (f.HasRecord (n), false, "Truncated record found");
+  NS_TEST_EXPECT_MSG_EQ (f.GetNRecords (), n, "Wrong number of records");
+  NS_TEST_EXPECT_MSG_EQ (f.GetRecord (5).time, 100000000000ULL + 5000, "Wrong time of a record found again");
+  f.Close ();
+  remove (filename.c_str ());
+}
+
+class PcapReplayNetDeviceTestCase : public TestCase
+{
+public:
+  PcapReplayNetDeviceTestCase ();
+private:
+  virtual void DoRun (void);
+  void Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol,
+                const Address &from, const Address &to, NetDevice::PacketType packetType);
+
+  std::vector<Time> m_times;
+  std::vector<uint32_t> m_sizes;
+};
+
+PcapReplayNetDeviceTestCase::PcapReplayNetDeviceTestCase ()
+  : TestCase ("Check that PcapReplayNetDevice receives the frames on their timestamps")
+{
+}
+
+void
+PcapReplayNetDeviceTestCase::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol,
+                                      const Address &from, const Address &to, NetDevice::PacketType packetType)
+{
+  NS_TEST_EXPECT_MSG_EQ (protocol, 0x0800, "Wrong protocol");
+  NS_TEST_EXPECT_MSG_EQ (packetType, NetDevice::PACKET_MULTICAST, "Wrong packet type");
+  m_times.push_back (Simulator::Now ());
+  m_sizes.push_back (p->GetSize ());
+}
+
+void
+PcapReplayNetDeviceTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("replay.pcap");
+  WriteTestFile (filename, false);
+
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<PcapReplayNetDevice> device = CreateObject<PcapReplayNetDevice> ();
+  device->SetAttribute ("FileName", StringValue (filename));
+  device->SetAttribute ("StartTime", TimeValue (Seconds (1.0)));
+  device->SetAttribute ("Speedup", DoubleValue (2.0));
+  device->SetAttribute ("Granularity", TimeValue (MicroSeconds (1500)));
+  device->SetAddress (Mac48Address ("00:00:00:00:00:01"));
+  node->AddDevice (device);
+  node->RegisterProtocolHandler (MakeCallback (&PcapReplayNetDeviceTestCase::Receive, this),
+                                 0x0800, device, true);
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (device->GetNReplayed (), N_RECORDS, "Frames not replayed");
+  NS_TEST_ASSERT_MSG_EQ (m_times.size (), N_RECORDS, "Frames not received");
+  for (uint32_t i = 0; i < N_RECORDS; i++)
+    {
+      // the frames are 0.5ms apart and each event takes those due in
+      // the next 1.5ms: 0 to 3, then 4 to 7, then 8 and 9
+      uint32_t batch = (i / 4) * 4;
+      NS_TEST_EXPECT_MSG_EQ (m_times[i], Seconds (1.0) + MicroSeconds (500 * batch), "Wrong time of frame " << i);
+      NS_TEST_EXPECT_MSG_EQ (m_sizes[i], std::min<uint32_t> (20, 14 + i) - 14, "Wrong size of frame " << i);
+    }
+  remove (filename.c_str ());
+}
+
+class PcapReplayOrderTestCase : public TestCase
+{
+public:
+  PcapReplayOrderTestCase ();
+private:
+  virtual void DoRun (void);
+  void Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol,
+                const Address &from, const Address &to, NetDevice::PacketType packetType);
+
+  std::vector<Time> m_times;
+};
+
+PcapReplayOrderTestCase::PcapReplayOrderTestCase ()
+  : TestCase ("Check that PcapReplayNetDevice replays the frames of a capture out of order")
+{
+}
+
+void
+PcapReplayOrderTestCase::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol,
+                                  const Address &from, const Address &to, NetDevice::PacketType packetType)
+{
+  m_times.push_back (Simulator::Now ());
+}
+
+void
+PcapReplayOrderTestCase::DoRun (void)
+{
+  // the second frame before the first one, the fourth before the third
+  std::string filename = CreateTempDirFilename ("order.pcap");
+  uint32_t times[] = { 100, 50, 300, 200 };
+  PcapFile f;
+  f.Open (filename, std::ios::out);
+  f.Init (1, 64, 0, false);
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      uint8_t data[14];
+      memset (data, 0, sizeof (data));
+      data[0] = 0xff;
+      data[12] = 0x08;
+      f.Write (100, times[i], data, sizeof (data));
+    }
+  f.Close ();
+
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<PcapReplayNetDevice> device = CreateObject<PcapReplayNetDevice> ();
+  device->SetAttribute ("FileName", StringValue (filename));
+  device->SetAttribute ("StartTime", TimeValue (Seconds (1.0)));
+  device->SetAddress (Mac48Address ("00:00:00:00:00:01"));
+  node->AddDevice (device);
+  node->RegisterProtocolHandler (MakeCallback (&PcapReplayOrderTestCase::Receive, this),
+                                 0x0800, device, true);
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_times.size (), 4, "Frames not received");
+  NS_TEST_EXPECT_MSG_EQ (m_times[0], Seconds (1.0), "Wrong time of frame 0");
+  NS_TEST_EXPECT_MSG_EQ (m_times[1], Seconds (1.0), "Wrong time of frame 1");
+  NS_TEST_EXPECT_MSG_EQ (m_times[2], Seconds (1.0) + MicroSeconds (200), "Wrong time of frame 2");
+  NS_TEST_EXPECT_MSG_EQ (m_times[3], Seconds (1.0) + MicroSeconds (200), "Wrong time of frame 3");
+  remove (filename.c_str ());
+}
+
+class PcapReplayDeliveryTestCase : public TestCase
+{
+public:
+  PcapReplayDeliveryTestCase ();
+private:
+  virtual void DoRun (void);
+  void Replay (std::string filename);
+  void Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol,
+                const Address &from, const Address &to, NetDevice::PacketType packetType);
+  void PromiscReceive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol,
+                       const Address &from, const Address &to, NetDevice::PacketType packetType);
+
+  std::vector<uint16_t> m_protocols;
+  std::vector<NetDevice::PacketType> m_promiscTypes;
+};
+
+PcapReplayDeliveryTestCase::PcapReplayDeliveryTestCase ()
+  : TestCase ("Check the handlers and the protocols of the frames replayed by PcapReplayNetDevice")
+{
+}
+
+void
+PcapReplayDeliveryTestCase::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol,
+                                     const Address &from, const Address &to, NetDevice::PacketType packetType)
+{
+  m_protocols.push_back (protocol);
+}
+
+void
+PcapReplayDeliveryTestCase::PromiscReceive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol,
+                                            const Address &from, const Address &to, NetDevice::PacketType packetType)
+{
+  m_promiscTypes.push_back (packetType);
+}
+
+void
+PcapReplayDeliveryTestCase::Replay (std::string filename)
+{
+  m_protocols.clear ();
+  m_promiscTypes.clear ();
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<PcapReplayNetDevice> device = CreateObject<PcapReplayNetDevice> ();
+  device->SetAttribute ("FileName", StringValue (filename));
+  device->SetAddress (Mac48Address ("00:00:00:00:00:01"));
+  node->AddDevice (device);
+  node->RegisterProtocolHandler (MakeCallback (&PcapReplayDeliveryTestCase::Receive, this),
+                                 0, device, false);
+  node->RegisterProtocolHandler (MakeCallback (&PcapReplayDeliveryTestCase::PromiscReceive, this),
+                                 0, device, true);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+PcapReplayDeliveryTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("delivery.pcap");
+
+  // Ethernet frames to the device, to all and to another host
+  PcapFile f;
+  f.Open (filename, std::ios::out);
+  f.Init (1, 65535, 0);
+  const uint8_t destinations[3][6] = { { 0, 0, 0, 0, 0, 1 }, { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff }, { 0, 0, 0, 0, 0, 2 } };
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      uint8_t data[20];
+      memset (data, 0, sizeof (data));
+      memcpy (data, destinations[i], 6);
+      data[12] = 0x08;
+      f.Write (0, i, data, sizeof (data));
+    }
+  f.Close ();
+  Replay (filename);
+  NS_TEST_EXPECT_MSG_EQ (m_protocols.size (), 2, "Frame to another host received by a non-promiscuous handler");
+  NS_TEST_ASSERT_MSG_EQ (m_promiscTypes.size (), 3, "Frames not received by the promiscuous handler");
+  NS_TEST_EXPECT_MSG_EQ (m_promiscTypes[0], NetDevice::PACKET_HOST, "Wrong type of the frame to the device");
+  NS_TEST_EXPECT_MSG_EQ (m_promiscTypes[1], NetDevice::PACKET_BROADCAST, "Wrong type of the broadcast frame");
+  NS_TEST_EXPECT_MSG_EQ (m_promiscTypes[2], NetDevice::PACKET_OTHERHOST, "Wrong type of the frame to another host");
+
+  // PPP frames of IPv4, IPv6 and LCP
+  f.Open (filename, std::ios::out);
+  f.Init (9, 65535, 0);
+  const uint16_t protocols[3] = { 0x0021, 0x0057, 0xc021 };
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      uint8_t data[24];
+      memset (data, 0, sizeof (data));
+      data[0] = 0xff;
+      data[1] = 0x03;
+      data[2] = protocols[i] >> 8;
+      data[3] = protocols[i] & 0xff;
+      f.Write (0, i, data, sizeof (data));
+    }
+  f.Close ();
+  Replay (filename);
+  NS_TEST_ASSERT_MSG_EQ (m_protocols.size (), 2, "LCP frame not dropped");
+  NS_TEST_EXPECT_MSG_EQ (m_protocols[0], 0x0800, "Wrong protocol of the IPv4 frame");
+  NS_TEST_EXPECT_MSG_EQ (m_protocols[1], 0x86dd, "Wrong protocol of the IPv6 frame");
+  remove (filename.c_str ());
+}
+
+class PcapReplayTestSuite : public TestSuite
+{
+public:
+  PcapReplayTestSuite ();
+};
+
+PcapReplayTestSuite::PcapReplayTestSuite ()
+  : TestSuite ("pcap-replay", UNIT)
+{
+  AddTestCase (new MappedPcapFileTestCase (false));
+  AddTestCase (new MappedPcapFileTestCase (true));
+  AddTestCase (new MappedPcapFileIndexTestCase);
+  AddTestCase (new PcapReplayNetDeviceTestCase);
+  AddTestCase (new PcapReplayOrderTestCase);
+  AddTestCase (new PcapReplayDeliveryTestCase);
+}
+
+static PcapReplayTestSuite g_pcapReplayTestSuite;
@@ -0,0 +1,185 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/size-class-allocator.h"
+#include "ns3/buffer.h"
+#include "ns3/test.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include "ns3/callback.h"
+#endif /* HAVE_PTHREAD_H */
+#include <vector>
+
+namespace ns3 {
+
+class SizeClassAllocatorClassTestCase : public TestCase
+{
+public:
+  SizeClassAllocatorClassTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+SizeClassAllocatorClassTestCase::SizeClassAllocatorClassTestCase ()
+  : TestCase ("Check the size classes and the reuse of the freed blocks")
+{
+}
+
+void
+SizeClassAllocatorClassTestCase::DoRun (void)
+{
+  NS_TEST_EXPECT_MSG_EQ (SizeClassAllocator::GetClassSize (1), 64, "smallest class");
+  NS_TEST_EXPECT_MSG_EQ (SizeClassAllocator::GetClassSize (64), 64, "smallest class");
+  NS_TEST_EXPECT_MSG_EQ (SizeClassAllocator::GetClassSize (65), 80, "second class");
+  NS_TEST_EXPECT_MSG_EQ (SizeClassAllocator::GetClassSize (129), 160, "first class above 128");
+  NS_TEST_EXPECT_MSG_EQ (SizeClassAllocator::GetClassSize (1500), 1536, "ethernet frame");
+  NS_TEST_EXPECT_MSG_EQ (SizeClassAllocator::GetClassSize (9000), 10240, "jumbo frame");
+  NS_TEST_EXPECT_MSG_EQ (SizeClassAllocator::GetClassSize (65536), 65536, "largest class");
+  NS_TEST_EXPECT_MSG_EQ (SizeClassAllocator::GetClassSize (65537), 65537, "no class");
+
+  // A freed block is handed out again for any size of its class
+  uint32_t size = 9000;
+  uint8_t *jumbo = SizeClassAllocator::Allocate (size);
+  NS_TEST_EXPECT_MSG_EQ (size, 10240, "size rounded up to the class size");
+  uint32_t small = 80;
+  uint8_t *ack = SizeClassAllocator::Allocate (small);
+  SizeClassAllocator::Deallocate (jumbo, size);
+  SizeClassAllocator::Deallocate (ack, small);
+  SizeClassAllocator::Stats before = SizeClassAllocator::GetStats ();
+  size = 9100;
+  NS_TEST_EXPECT_MSG_EQ (SizeClassAllocator::Allocate (size), jumbo, "jumbo block reused");
+  small = 70;
+  NS_TEST_EXPECT_MSG_EQ (SizeClassAllocator::Allocate (small), ack, "small block reused");
+  SizeClassAllocator::Stats after = SizeClassAllocator::GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (after.hits - before.hits, 2, "two cache hits");
+  NS_TEST_EXPECT_MSG_EQ (after.misses - before.misses, 0, "no cache miss");
+  NS_TEST_EXPECT_MSG_EQ (before.cachedBytes - after.cachedBytes, 10240 + 80, "cached bytes");
+  SizeClassAllocator::Deallocate (jumbo, size);
+  SizeClassAllocator::Deallocate (ack, small);
+
+  // Buffers use the whole block
+  Buffer buffer;
+  buffer.AddAtStart (9000);
+  buffer.Begin ().WriteU8 (0x55, 9000);
+  NS_TEST_EXPECT_MSG_EQ (buffer.GetSize (), 9000, "buffer size");
+  NS_TEST_EXPECT_MSG_EQ (buffer.PeekData ()[8999], 0x55, "buffer content");
+}
+
+class SizeClassAllocatorCapTestCase : public TestCase
+{
+public:
+  SizeClassAllocatorCapTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+SizeClassAllocatorCapTestCase::SizeClassAllocatorCapTestCase ()
+  : TestCase ("Check that a cache holds at most CACHE_BYTES bytes of a class")
+{
+}
+
+void
+SizeClassAllocatorCapTestCase::DoRun (void)
+{
+  uint32_t n = SizeClassAllocator::CACHE_BYTES / SizeClassAllocator::MAX_SIZE + 2;
+  std::vector<uint8_t *> blocks;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      uint32_t size = SizeClassAllocator::MAX_SIZE;
+      blocks.push_back (SizeClassAllocator::Allocate (size));
+    }
+  SizeClassAllocator::Stats before = SizeClassAllocator::GetStats ();
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      SizeClassAllocator::Deallocate (blocks[i], SizeClassAllocator::MAX_SIZE);
+    }
+  SizeClassAllocator::Stats after = SizeClassAllocator::GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (after.cachedBytes - before.cachedBytes, SizeClassAllocator::CACHE_BYTES,
+                         "the cache is full");
+  NS_TEST_EXPECT_MSG_EQ (after.releasedBytes - before.releasedBytes, 2 * SizeClassAllocator::MAX_SIZE,
+                         "the blocks beyond the cap are released");
+}
+
+#ifdef HAVE_PTHREAD_H
+class SizeClassAllocatorThreadTestCase : public TestCase
+{
+public:
+  SizeClassAllocatorThreadTestCase ();
+private:
+  virtual void DoRun (void);
+  static void AllocateAndFree (uint32_t n);
+};
+
+SizeClassAllocatorThreadTestCase::SizeClassAllocatorThreadTestCase ()
+  : TestCase ("Check that the cache of an exited thread is released")
+{
+}
+
+void
+SizeClassAllocatorThreadTestCase::AllocateAndFree (uint32_t n)
+{
+  std::vector<uint8_t *> blocks;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      uint32_t size = 1500;
+      blocks.push_back (SizeClassAllocator::Allocate (size));
+    }
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      SizeClassAllocator::Deallocate (blocks[i], 1536);
+    }
+}
+
+void
+SizeClassAllocatorThreadTestCase::DoRun (void)
+{
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      SizeClassAllocator::Stats before = SizeClassAllocator::GetStats ();
+      Ptr<SystemThread> thread = Create<SystemThread> (MakeBoundCallback (&AllocateAndFree, 100));
+      thread->Start ();
+      thread->Join ();
+      SizeClassAllocator::Stats after = SizeClassAllocator::GetStats ();
+      // A new thread starts with an empty cache, the one of the
+      // previous thread after the first iteration
+      NS_TEST_EXPECT_MSG_EQ (after.misses - before.misses, 100, "thread " << i << " allocated from the system");
+      NS_TEST_EXPECT_MSG_EQ (after.cachedBytes, before.cachedBytes, "thread " << i << " left blocks in its cache");
+      NS_TEST_EXPECT_MSG_EQ (after.releasedBytes - before.releasedBytes, 100 * 1536,
+                             "thread " << i << " did not release its blocks");
+    }
+}
+#endif /* HAVE_PTHREAD_H */
+
+class SizeClassAllocatorTestSuite : public TestSuite
+{
+public:
+  SizeClassAllocatorTestSuite ();
+};
+
+SizeClassAllocatorTestSuite::SizeClassAllocatorTestSuite ()
+  : TestSuite ("size-class-allocator", UNIT)
+{
+  AddTestCase (new SizeClassAllocatorClassTestCase);
+  AddTestCase (new SizeClassAllocatorCapTestCase);
+#ifdef HAVE_PTHREAD_H
+  AddTestCase (new SizeClassAllocatorThreadTestCase);
+#endif /* HAVE_PTHREAD_H */
+}
+
+static SizeClassAllocatorTestSuite g_sizeClassAllocatorTestSuite;
+
+} // namespace ns3
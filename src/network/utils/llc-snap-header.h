@@ -55,6 +55,12 @@ private:
   uint16_t m_etherType;
 };
 
+template <>
+struct FixedSerializedSize<LlcSnapHeader>
+{
+  static const uint32_t value = LLC_SNAP_HEADER_LENGTH;
+};
+
 } // namespace ns3
 
 #endif /* LLC_SNAP_HEADER_H */
@@ -0,0 +1,319 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include "ns3/core-config.h"
+#include "mapped-pcap-file.h"
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif /* HAVE_SYS_MMAN_H */
+
+NS_LOG_COMPONENT_DEFINE ("MappedPcapFile");
+
+namespace {
+
+const uint32_t MAGIC = 0xa1b2c3d4;
+const uint32_t SWAPPED_MAGIC = 0xd4c3b2a1;
+// the nanosecond magic of PcapFile, and the one of libpcap
+const uint32_t NS_MAGIC = 0xa1b23cd4;
+const uint32_t NS_SWAPPED_MAGIC = 0xd43cb2a1;
+const uint32_t LIBPCAP_NS_MAGIC = 0xa1b23c4d;
+const uint32_t LIBPCAP_NS_SWAPPED_MAGIC = 0x4d3cb2a1;
+
+const uint32_t FILE_HEADER_SIZE = 24;
+const uint32_t RECORD_HEADER_SIZE = 16;
+
+// one record out of INDEX_STEP is indexed
+const uint32_t INDEX_STEP = 256;
+
+} // anonymous namespace
+
+namespace ns3 {
+
+MappedPcapFile::MappedPcapFile ()
+  : m_data (0),
+    m_size (0),
+    m_mapped (false),
+    m_swapMode (false),
+    m_nanoseconds (false),
+    m_dataLinkType (0),
+    m_snapLen (0),
+    m_complete (false),
+    m_nRecords (0),
+    m_cursor (0),
+    m_cursorOffset (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+MappedPcapFile::~MappedPcapFile ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+uint32_t
+MappedPcapFile::ReadU32 (uint64_t offset) const
+{
+  uint32_t value;
+  memcpy (&value, m_data + offset, 4);
+  if (m_swapMode)
+    {
+      value = ((value >> 24) & 0x000000ff) | ((value >> 8) & 0x0000ff00)
+        | ((value << 8) & 0x00ff0000) | ((value << 24) & 0xff000000);
+    }
+  return value;
+}
+
+bool
+MappedPcapFile::Open (std::string const &filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  Close ();
+#ifdef HAVE_SYS_MMAN_H
+  int fd = open (filename.c_str (), O_RDONLY);
+  if (fd < 0)
+    {
+      NS_LOG_LOGIC ("cannot open " << filename);
+      return false;
+    }
+  struct stat st;
+  if (fstat (fd, &st) == 0 && st.st_size > 0)
+    {
+      void *data = mmap (0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+      if (data != MAP_FAILED)
+        {
+          // records are read in order, mostly
+          madvise (data, st.st_size, MADV_SEQUENTIAL);
+          m_data = static_cast<uint8_t const *> (data);
+          m_size = st.st_size;
+          m_mapped = true;
+        }
+    }
+  close (fd);
+#endif /* HAVE_SYS_MMAN_H */
+  if (!m_mapped)
+    {
+      std::ifstream file (filename.c_str (), std::ios::in | std::ios::binary);
+      if (!file.is_open ())
+        {
+          NS_LOG_LOGIC ("cannot open " << filename);
+          return false;
+        }
+      file.seekg (0, std::ios::end);
+      m_copy.resize (file.tellg ());
+      file.seekg (0, std::ios::beg);
+      if (!m_copy.empty ())
+        {
+          file.read ((char *)&m_copy[0], m_copy.size ());
+          m_data = &m_copy[0];
+        }
+      m_size = m_copy.size ();
+    }
+
+  if (m_size < FILE_HEADER_SIZE)
+    {
+      NS_LOG_LOGIC ("no pcap file header in " << filename);
+      Close ();
+      return false;
+    }
+  uint32_t magic = ReadU32 (0);
+  switch (magic)
+    {
+    case MAGIC:
+      break;
+    case SWAPPED_MAGIC:
+      m_swapMode = true;
+      break;
+    case NS_MAGIC:
+    case LIBPCAP_NS_MAGIC:
+      m_nanoseconds = true;
+      break;
+    case NS_SWAPPED_MAGIC:
+    case LIBPCAP_NS_SWAPPED_MAGIC:
+      m_swapMode = true;
+      m_nanoseconds = true;
+      break;
+    default:
+      NS_LOG_LOGIC ("bad magic number in " << filename);
+      Close ();
+      return false;
+    }
+  m_snapLen = ReadU32 (16);
+  m_dataLinkType = ReadU32 (20);
+
+  m_offsets.push_back (FILE_HEADER_SIZE);
+  m_cursor = 0;
+  m_cursorOffset = FILE_HEADER_SIZE;
+  if (!IsComplete (FILE_HEADER_SIZE))
+    {
+      NS_LOG_LOGIC ("no record in " << filename);
+      m_complete = true;
+    }
+  return true;
+}
+
+bool
+MappedPcapFile::IsComplete (uint64_t offset) const
+{
+  return offset + RECORD_HEADER_SIZE <= m_size
+         && offset + RECORD_HEADER_SIZE + ReadU32 (offset + 8) <= m_size;
+}
+
+bool
+MappedPcapFile::Seek (uint32_t index) const
+{
+  if (m_complete && index >= m_nRecords)
+    {
+      return false;
+    }
+  // from the last record found, or from the nearest record indexed
+  uint32_t current;
+  uint64_t offset;
+  uint32_t step = std::min<uint32_t> (index / INDEX_STEP, m_offsets.size () - 1);
+  if (m_cursor <= index && m_cursor >= step * INDEX_STEP)
+    {
+      current = m_cursor;
+      offset = m_cursorOffset;
+    }
+  else
+    {
+      current = step * INDEX_STEP;
+      offset = m_offsets[step];
+    }
+  while (current < index)
+    {
+      uint64_t next = offset + RECORD_HEADER_SIZE + ReadU32 (offset + 8);
+      if (!IsComplete (next))
+        {
+          NS_LOG_LOGIC ("end of file after " << current + 1 << " records");
+          m_complete = true;
+          m_nRecords = current + 1;
+          return false;
+        }
+      offset = next;
+      current++;
+      if (current % INDEX_STEP == 0 && current / INDEX_STEP == m_offsets.size ())
+        {
+          m_offsets.push_back (offset);
+        }
+    }
+  m_cursor = current;
+  m_cursorOffset = offset;
+  return true;
+}
+
+void
+MappedPcapFile::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+#ifdef HAVE_SYS_MMAN_H
+  if (m_mapped)
+    {
+      munmap (const_cast<uint8_t *> (m_data), m_size);
+    }
+#endif /* HAVE_SYS_MMAN_H */
+  m_data = 0;
+  m_size = 0;
+  m_mapped = false;
+  std::vector<uint8_t> ().swap (m_copy);
+  m_swapMode = false;
+  m_nanoseconds = false;
+  m_dataLinkType = 0;
+  m_snapLen = 0;
+  std::vector<uint64_t> ().swap (m_offsets);
+  m_complete = false;
+  m_nRecords = 0;
+  m_cursor = 0;
+  m_cursorOffset = 0;
+}
+
+bool
+MappedPcapFile::IsOpen (void) const
+{
+  return m_data != 0;
+}
+
+uint32_t
+MappedPcapFile::GetNRecords (void) const
+{
+  if (!IsOpen ())
+    {
+      return 0;
+    }
+  while (!m_complete)
+    {
+      Seek (m_cursor + INDEX_STEP);
+    }
+  return m_nRecords;
+}
+
+bool
+MappedPcapFile::HasRecord (uint32_t index) const
+{
+  return IsOpen () && Seek (index);
+}
+
+struct MappedPcapFile::Record
+MappedPcapFile::GetRecord (uint32_t index) const
+{
+  NS_ABORT_MSG_UNLESS (HasRecord (index), "No record " << index << " in the pcap file");
+  uint64_t offset = m_cursorOffset;
+  struct Record record;
+  uint64_t sec = ReadU32 (offset);
+  uint64_t subsec = ReadU32 (offset + 4);
+  record.time = sec * 1000000000 + (m_nanoseconds ? subsec : subsec * 1000);
+  record.inclLen = ReadU32 (offset + 8);
+  record.origLen = ReadU32 (offset + 12);
+  record.data = m_data + offset + RECORD_HEADER_SIZE;
+  return record;
+}
+
+Ptr<Packet>
+MappedPcapFile::CreatePacket (uint32_t index) const
+{
+  struct Record record = GetRecord (index);
+  return Create<Packet> (record.data, record.inclLen);
+}
+
+uint32_t
+MappedPcapFile::GetDataLinkType (void) const
+{
+  return m_dataLinkType;
+}
+
+uint32_t
+MappedPcapFile::GetSnapLen (void) const
+{
+  return m_snapLen;
+}
+
+bool
+MappedPcapFile::GetSwapMode (void) const
+{
+  return m_swapMode;
+}
+
+} // namespace ns3
@@ -0,0 +1,133 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef MAPPED_PCAP_FILE_H
+#define MAPPED_PCAP_FILE_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+class Packet;
+
+/**
+ * \brief A read-only pcap file, with random access to its records
+ *
+ * The file is mapped in memory (or, where mmap is not available, read
+ * in memory), and its records are read without copying their bytes.
+ * The records are indexed as they are reached: the offset of every
+ * INDEX_STEP-th record is kept, so that a record is found from the
+ * nearest one before it, and the records read in order are found from
+ * the last one read.  Both byte orders, and the nanosecond variant of
+ * the format, are supported.
+ */
+class MappedPcapFile
+{
+public:
+  /**
+   * A record of the file.  Its data point into the mapped file, and
+   * are valid until the file is closed.
+   */
+  struct Record
+  {
+    uint64_t time;        //!< the timestamp, in nanoseconds
+    uint32_t inclLen;     //!< the number of bytes in the file
+    uint32_t origLen;     //!< the length of the captured frame
+    uint8_t const *data;
+  };
+
+  MappedPcapFile ();
+  ~MappedPcapFile ();
+
+  /**
+   * Map a pcap file and check its header.  A truncated last record is
+   * ignored.
+   *
+   * \param filename the name of the file
+   * \returns false if the file could not be mapped or is not a pcap
+   *          file, true otherwise
+   */
+  bool Open (std::string const &filename);
+  void Close (void);
+  bool IsOpen (void) const;
+
+  /**
+   * \returns the number of records of the file.  The first call goes
+   * through the headers of all the records.
+   */
+  uint32_t GetNRecords (void) const;
+  /**
+   * \param index the index of a record
+   * \returns true if the file holds a record of that index.  Only the
+   * records up to it are gone through.
+   */
+  bool HasRecord (uint32_t index) const;
+  /**
+   * \param index the index of a record, for which HasRecord is true
+   * \returns the record
+   */
+  struct Record GetRecord (uint32_t index) const;
+  /**
+   * \param index the index of a record, for which HasRecord is true
+   * \returns a packet holding a copy of the bytes of the record
+   */
+  Ptr<Packet> CreatePacket (uint32_t index) const;
+
+  uint32_t GetDataLinkType (void) const;
+  uint32_t GetSnapLen (void) const;
+  bool GetSwapMode (void) const;
+
+private:
+  MappedPcapFile (const MappedPcapFile &o);
+  MappedPcapFile &operator = (const MappedPcapFile &o);
+
+  uint32_t ReadU32 (uint64_t offset) const;
+  /**
+   * \param offset the offset of a record
+   * \returns true if the record, header and data, is in the file
+   */
+  bool IsComplete (uint64_t offset) const;
+  /**
+   * Find the offset of a record, indexing the records on the way.
+   *
+   * \param index the index of a record
+   * \returns false if the file ends before that record
+   */
+  bool Seek (uint32_t index) const;
+
+  uint8_t const *m_data;
+  uint64_t m_size;
+  bool m_mapped;
+  std::vector<uint8_t> m_copy;
+  bool m_swapMode;
+  bool m_nanoseconds;
+  uint32_t m_dataLinkType;
+  uint32_t m_snapLen;
+  // offsets of the records 0, INDEX_STEP, 2 * INDEX_STEP... reached
+  mutable std::vector<uint64_t> m_offsets;
+  // the number of records, once the end of the file is reached
+  mutable bool m_complete;
+  mutable uint32_t m_nRecords;
+  // the last record found
+  mutable uint32_t m_cursor;
+  mutable uint64_t m_cursorOffset;
+};
+
+} // namespace ns3
+
+#endif /* MAPPED_PCAP_FILE_H */
@@ -72,7 +72,7 @@ class OutputStreamWrapper : public SimpleRefCount<OutputStreamWrapper>
 public:
   OutputStreamWrapper (std::string filename, std::ios::openmode filemode);
   OutputStreamWrapper (std::ostream* os);
-  ~OutputStreamWrapper ();
+  virtual ~OutputStreamWrapper ();
 
   /**
    * Return a pointer to an ostream previously set in the wrapper.
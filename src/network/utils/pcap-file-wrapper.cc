@@ -18,14 +18,196 @@
 
 #include "ns3/log.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/simulator.h"
 #include "ns3/buffer.h"
 #include "ns3/header.h"
+#include "ns3/core-config.h"
 #include "pcap-file-wrapper.h"
+#include <list>
+#include <algorithm>
+
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#include "ns3/system-condition.h"
+#endif /* HAVE_PTHREAD_H */
 
 NS_LOG_COMPONENT_DEFINE ("PcapFileWrapper");
 
 namespace ns3 {
 
+#ifdef HAVE_PTHREAD_H
+/**
+ * The thread which writes the batches of records of all the asynchronous
+ * pcap files, in the order they were submitted.  It runs while at least
+ * one asynchronous file is open.
+ */
+class PcapWriterThread
+{
+public:
+  static PcapWriterThread *Get (void);
+  void Attach (void);
+  void Detach (void);
+  /**
+   * Queue a batch of records for file.  queued counts the bytes of the file
+   * waiting to be written; it is only accessed with the lock held.
+   *
+   * \returns false if the batch was dropped
+   */
+  bool Submit (PcapFile *file, uint32_t *queued, std::vector<uint8_t> &batch,
+               uint32_t limit, bool block);
+  /**
+   * Wait until *queued drops to zero.
+   */
+  void Wait (uint32_t *queued);
+
+private:
+  struct Batch
+  {
+    PcapFile *file;
+    uint32_t *queued;
+    std::vector<uint8_t> data;
+  };
+  PcapWriterThread ();
+  void Run (void);
+  // wait until a condition is signaled; the lock is released meanwhile.
+  // The condition is always set with the lock held, so no signal is
+  // missed; the timeout is only a safety net.
+  void WaitFor (SystemCondition &condition, uint64_t ns);
+
+  SystemMutex m_mutex;
+  SystemCondition m_work;
+  SystemCondition m_written;
+  std::list<Batch> m_batches;
+  uint32_t m_files;
+  bool m_stop;
+  Ptr<SystemThread> m_thread;
+};
+
+PcapWriterThread::PcapWriterThread ()
+  : m_files (0),
+    m_stop (false)
+{
+}
+
+PcapWriterThread *
+PcapWriterThread::Get (void)
+{
+  // Never deleted: files left open at exit may still use it
+  static PcapWriterThread *writer = new PcapWriterThread ();
+  return writer;
+}
+
+void
+PcapWriterThread::Attach (void)
+{
+  if (m_files++ == 0)
+    {
+      NS_LOG_LOGIC ("start the pcap writer thread");
+      m_stop = false;
+      m_thread = Create<SystemThread> (MakeCallback (&PcapWriterThread::Run, this));
+      m_thread->Start ();
+    }
+}
+
+void
+PcapWriterThread::Detach (void)
+{
+  NS_ASSERT (m_files > 0);
+  if (--m_files == 0)
+    {
+      NS_LOG_LOGIC ("stop the pcap writer thread");
+      m_mutex.Lock ();
+      m_stop = true;
+      m_work.SetCondition (true);
+      m_work.Signal ();
+      m_mutex.Unlock ();
+      m_thread->Join ();
+      m_thread = 0;
+    }
+}
+
+void
+PcapWriterThread::WaitFor (SystemCondition &condition, uint64_t ns)
+{
+  condition.SetCondition (false);
+  m_mutex.Unlock ();
+  condition.TimedWait (ns);
+  m_mutex.Lock ();
+}
+
+bool
+PcapWriterThread::Submit (PcapFile *file, uint32_t *queued, std::vector<uint8_t> &batch,
+                          uint32_t limit, bool block)
+{
+  uint32_t size = batch.size ();
+  CriticalSection cs (m_mutex);
+  // A batch larger than the limit is accepted once the file caught up
+  while (*queued != 0 && *queued + size > limit)
+    {
+      if (!block)
+        {
+          return false;
+        }
+      WaitFor (m_written, 1000000);
+    }
+  *queued += size;
+  m_batches.push_back (Batch ());
+  m_batches.back ().file = file;
+  m_batches.back ().queued = queued;
+  m_batches.back ().data.swap (batch);
+  m_work.SetCondition (true);
+  m_work.Signal ();
+  return true;
+}
+
+void
+PcapWriterThread::Wait (uint32_t *queued)
+{
+  CriticalSection cs (m_mutex);
+  while (*queued != 0)
+    {
+      WaitFor (m_written, 1000000);
+    }
+}
+
+void
+PcapWriterThread::Run (void)
+{
+  std::vector<uint8_t> data;
+  m_mutex.Lock ();
+  while (true)
+    {
+      if (m_batches.empty ())
+        {
+          if (m_stop)
+            {
+              break;
+            }
+          WaitFor (m_work, 10000000);
+          continue;
+        }
+      Batch &batch = m_batches.front ();
+      PcapFile *file = batch.file;
+      uint32_t *queued = batch.queued;
+      data.swap (batch.data);
+      m_batches.pop_front ();
+      m_mutex.Unlock ();
+
+      file->WriteRecords (&data[0], data.size ());
+
+      m_mutex.Lock ();
+      *queued -= data.size ();
+      data.clear ();
+      m_written.SetCondition (true);
+      m_written.Broadcast ();
+    }
+  m_mutex.Unlock ();
+}
+#endif /* HAVE_PTHREAD_H */
+
 NS_OBJECT_ENSURE_REGISTERED (PcapFileWrapper);
 
 TypeId 
@@ -39,12 +221,37 @@ PcapFileWrapper::GetTypeId (void)
                    UintegerValue (PcapFile::SNAPLEN_DEFAULT),
                    MakeUintegerAccessor (&PcapFileWrapper::m_snapLen),
                    MakeUintegerChecker<uint32_t> (0, PcapFile::SNAPLEN_DEFAULT))
+    .AddAttribute ("Asynchronous",
+                   "Write the records from a background thread",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PcapFileWrapper::m_asynchronous),
+                   MakeBooleanChecker ())
+    .AddAttribute ("BatchSize",
+                   "Number of bytes of records the background thread writes at once",
+                   UintegerValue (64 * 1024),
+                   MakeUintegerAccessor (&PcapFileWrapper::m_batchSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("BufferSize",
+                   "Maximum number of bytes of records waiting for the background thread",
+                   UintegerValue (4 * 1024 * 1024),
+                   MakeUintegerAccessor (&PcapFileWrapper::m_bufferSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("OverflowPolicy",
+                   "What to do with records which do not fit in BufferSize",
+                   EnumValue (BLOCK),
+                   MakeEnumAccessor (&PcapFileWrapper::m_overflowPolicy),
+                   MakeEnumChecker (BLOCK, "Block",
+                                    DROP, "Drop"))
   ;
   return tid;
 }
 
 
 PcapFileWrapper::PcapFileWrapper ()
+  : m_started (false),
+    m_queued (0),
+    m_batchRecords (0),
+    m_dropped (0)
 {
 }
 
@@ -73,12 +280,53 @@ PcapFileWrapper::Clear (void)
 void
 PcapFileWrapper::Close (void)
 {
+  StopWriter ();
   m_file.Close ();
 }
 
+void
+PcapFileWrapper::StopWriter (void)
+{
+#ifdef HAVE_PTHREAD_H
+  if (m_started)
+    {
+      Flush ();
+      m_started = false;
+      PcapWriterThread::Get ()->Detach ();
+    }
+#endif /* HAVE_PTHREAD_H */
+}
+
+void
+PcapFileWrapper::Flush (void)
+{
+#ifdef HAVE_PTHREAD_H
+  if (m_started)
+    {
+      NS_LOG_FUNCTION (this);
+      SubmitBatch (true);
+      PcapWriterThread::Get ()->Wait (&m_queued);
+    }
+#endif /* HAVE_PTHREAD_H */
+}
+
+uint32_t
+PcapFileWrapper::GetDroppedRecords (void) const
+{
+  return m_dropped;
+}
+
 void
 PcapFileWrapper::Open (std::string const &filename, std::ios::openmode mode)
 {
+  // The writer thread may still be writing the previous file to the
+  // stream: write its last records and close it before reusing the
+  // stream.  Init starts the writer again for the new file.
+  if (m_started)
+    {
+      StopWriter ();
+      m_file.Close ();
+    }
   m_file.Open (filename, mode);
 }
 
@@ -98,6 +346,67 @@ PcapFileWrapper::Init (uint32_t dataLinkType, uint32_t snapLen, int32_t tzCorrec
     {
       m_file.Init (dataLinkType, m_snapLen, tzCorrection);
     } 
+
+  if (m_asynchronous && !m_started && !m_file.Fail ())
+    {
+#ifdef HAVE_PTHREAD_H
+      m_batch.reserve (m_batchSize + PcapFile::RECORD_HEADER_SIZE + PcapFile::SNAPLEN_DEFAULT);
+      m_started = true;
+      PcapWriterThread::Get ()->Attach ();
+      // The file object may outlive the simulation
+      Simulator::ScheduleDestroy (&PcapFileWrapper::Flush, Ptr<PcapFileWrapper> (this));
+#else
+      NS_LOG_WARN ("No threads: pcap records are written synchronously");
+#endif /* HAVE_PTHREAD_H */
+    }
+}
+
+uint8_t *
+PcapFileWrapper::AddRecord (Time t, uint32_t totalLen, uint32_t &inclLen)
+{
+  uint64_t current = t.GetMicroSeconds ();
+  uint64_t s = current / 1000000;
+  uint64_t us = current % 1000000;
+
+  uint32_t start = m_batch.size ();
+  uint8_t header[PcapFile::RECORD_HEADER_SIZE];
+  inclLen = m_file.FormatRecordHeader (s, us, totalLen, header);
+  m_batch.resize (start + PcapFile::RECORD_HEADER_SIZE + inclLen);
+  memcpy (&m_batch[start], header, PcapFile::RECORD_HEADER_SIZE);
+  return &m_batch[start + PcapFile::RECORD_HEADER_SIZE];
+}
+
+void
+PcapFileWrapper::RecordAdded (void)
+{
+  m_batchRecords++;
+  if (m_batch.size () >= m_batchSize)
+    {
+      SubmitBatch (m_overflowPolicy == BLOCK);
+    }
+}
+
+void
+PcapFileWrapper::SubmitBatch (bool block)
+{
+#ifdef HAVE_PTHREAD_H
+  if (m_batch.empty ())
+    {
+      return;
+    }
+  std::vector<uint8_t> batch;
+  batch.reserve (m_batch.capacity ());
+  batch.swap (m_batch);
+  if (!PcapWriterThread::Get ()->Submit (&m_file, &m_queued, batch, m_bufferSize, block))
+    {
+      NS_LOG_WARN ("pcap buffer full, dropping " << m_batchRecords << " records");
+      m_dropped += m_batchRecords;
+      // reuse the memory of the dropped batch
+      batch.clear ();
+      batch.swap (m_batch);
+    }
+  m_batchRecords = 0;
+#endif /* HAVE_PTHREAD_H */
 }
 
 void
@@ -107,6 +416,14 @@ PcapFileWrapper::Write (Time t, Ptr<const Packet> p)
   uint64_t s = current / 1000000;
   uint64_t us = current % 1000000;
 
+  if (m_started)
+    {
+      uint32_t inclLen;
+      uint8_t *data = AddRecord (t, p->GetSize (), inclLen);
+      p->CopyData (data, inclLen);
+      RecordAdded ();
+      return;
+    }
   m_file.Write (s, us, p);
 }
 
@@ -117,6 +434,20 @@ PcapFileWrapper::Write (Time t, Header &header, Ptr<const Packet> p)
   uint64_t s = current / 1000000;
   uint64_t us = current % 1000000;
 
+  if (m_started)
+    {
+      uint32_t headerSize = header.GetSerializedSize ();
+      uint32_t inclLen;
+      uint8_t *data = AddRecord (t, headerSize + p->GetSize (), inclLen);
+      Buffer headerBuffer;
+      headerBuffer.AddAtStart (headerSize);
+      header.Serialize (headerBuffer.Begin ());
+      uint32_t toCopy = std::min (headerSize, inclLen);
+      headerBuffer.CopyData (data, toCopy);
+      p->CopyData (data + toCopy, inclLen - toCopy);
+      RecordAdded ();
+      return;
+    }
   m_file.Write (s, us, header, p);
 }
 
@@ -127,6 +458,14 @@ PcapFileWrapper::Write (Time t, uint8_t const *buffer, uint32_t length)
   uint64_t s = current / 1000000;
   uint64_t us = current % 1000000;
 
+  if (m_started)
+    {
+      uint32_t inclLen;
+      uint8_t *data = AddRecord (t, length, inclLen);
+      memcpy (data, buffer, inclLen);
+      RecordAdded ();
+      return;
+    }
   m_file.Write (s, us, buffer, length);
 }
 
@@ -22,6 +22,7 @@
 #include <string.h>
 #include <limits>
 #include <fstream>
+#include <vector>
 #include "ns3/ptr.h"
 #include "ns3/packet.h"
 #include "ns3/object.h"
@@ -35,12 +36,26 @@ namespace ns3 {
  * ns-3 interface to the low-level public methods of PcapFile.  Users are
  * encouraged to use this object instead of class ns3::PcapFile in ns-3
  * public APIs.
+ *
+ * When the Asynchronous attribute is set, the records are copied into a
+ * memory buffer and a background thread, shared by all files, writes them
+ * in batches of BatchSize bytes.  At most BufferSize bytes of a file wait
+ * for the background thread: beyond that, the OverflowPolicy attribute
+ * tells whether the simulation waits for the file to catch up or the
+ * records are dropped.  The records still in memory are written when the
+ * simulator is destroyed, on Flush and on Close.
  */
 class PcapFileWrapper : public Object
 {
 public:
   static TypeId GetTypeId (void);
 
+  enum OverflowPolicy
+  {
+    BLOCK,      /**< Wait for the background thread to write earlier records */
+    DROP        /**< Drop the records which do not fit in memory */
+  };
+
   PcapFileWrapper ();
   ~PcapFileWrapper ();
 
@@ -66,6 +81,9 @@ public:
    * selected as a binary file (fstream::binary is automatically ored with the mode
    * field).
    *
+   * If records are still being written asynchronously to a previous file,
+   * they are written and that file is closed first.
+   *
    * \param filename String containing the name of the file.
    *
    * \param mode String containing the access mode for the file.
@@ -78,6 +96,18 @@ public:
    */
   void Close (void);
 
+  /**
+   * Wait until the records kept in memory in asynchronous mode are
+   * written to the file.
+   */
+  void Flush (void);
+
+  /**
+   * \returns the number of records dropped in asynchronous mode because
+   * the buffer was full
+   */
+  uint32_t GetDroppedRecords (void) const;
+
   /**
    * Initialize the pcap file associated with this wrapper.  This file must have
    * been previously opened with write permissions.
@@ -195,8 +225,30 @@ public:
   uint32_t GetDataLinkType (void);
 
 private:
+  /**
+   * \returns where to copy the inclLen bytes of a new record in the batch
+   */
+  uint8_t *AddRecord (Time t, uint32_t totalLen, uint32_t &inclLen);
+  void RecordAdded (void);
+  void SubmitBatch (bool block);
+  /**
+   * Write the pending records and detach from the writer thread
+   */
+  void StopWriter (void);
+
   PcapFile m_file;
   uint32_t m_snapLen;
+  bool m_asynchronous;
+  uint32_t m_batchSize;
+  uint32_t m_bufferSize;
+  enum OverflowPolicy m_overflowPolicy;
+  // true while the background thread may write to m_file
+  bool m_started;
+  std::vector<uint8_t> m_batch;
+  // bytes submitted to the background thread and not written yet
+  uint32_t m_queued;
+  uint32_t m_batchRecords;
+  uint32_t m_dropped;
 };
 
 } // namespace ns3
@@ -345,10 +345,8 @@ PcapFile::Init (uint32_t dataLinkType, uint32_t snapLen, int32_t timeZoneCorrect
 }
 
 uint32_t
-PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
+PcapFile::FormatRecordHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen, uint8_t *buffer)
 {
-  NS_ASSERT (m_file.good ());
-
   uint32_t inclLen = totalLen > m_fileHeader.m_snapLen ? m_fileHeader.m_snapLen : totalLen;
 
   PcapRecordHeader header;
@@ -363,16 +361,34 @@ PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
     }
 
   //
-  // Watch out for memory alignment differences between machines, so write
+  // Watch out for memory alignment differences between machines, so copy
   // them all individually.
   //
-  m_file.write ((const char *)&header.m_tsSec, sizeof(header.m_tsSec));
-  m_file.write ((const char *)&header.m_tsUsec, sizeof(header.m_tsUsec));
-  m_file.write ((const char *)&header.m_inclLen, sizeof(header.m_inclLen));
-  m_file.write ((const char *)&header.m_origLen, sizeof(header.m_origLen));
+  memcpy (buffer, &header.m_tsSec, sizeof(header.m_tsSec));
+  memcpy (buffer + 4, &header.m_tsUsec, sizeof(header.m_tsUsec));
+  memcpy (buffer + 8, &header.m_inclLen, sizeof(header.m_inclLen));
+  memcpy (buffer + 12, &header.m_origLen, sizeof(header.m_origLen));
+  return inclLen;
+}
+
+uint32_t
+PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
+{
+  NS_ASSERT (m_file.good ());
+
+  uint8_t header[RECORD_HEADER_SIZE];
+  uint32_t inclLen = FormatRecordHeader (tsSec, tsUsec, totalLen, header);
+  m_file.write ((const char *)header, RECORD_HEADER_SIZE);
   return inclLen;
 }
 
+void
+PcapFile::WriteRecords (uint8_t const *data, uint32_t length)
+{
+  m_file.write ((const char *)data, length);
+  m_file.flush ();
+}
+
 void
 PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, uint8_t const * const data, uint32_t totalLen)
 {
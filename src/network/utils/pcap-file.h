@@ -42,6 +42,7 @@ class PcapFile
 public:
   static const int32_t  ZONE_DEFAULT    = 0;           /**< Time zone offset for current location */
   static const uint32_t SNAPLEN_DEFAULT = 65535;       /**< Default value for maximum octets to save per packet */
+  static const uint32_t RECORD_HEADER_SIZE = 16;       /**< Size of the header of each packet record */
 
 public:
   PcapFile ();
@@ -147,6 +148,25 @@ public:
    */
   void Write (uint32_t tsSec, uint32_t tsUsec, Header &header, Ptr<const Packet> p);
 
+  /**
+   * \brief Build the record header which Write would write for a packet
+   *
+   * \param tsSec       Packet timestamp, seconds
+   * \param tsUsec      Packet timestamp, microseconds
+   * \param totalLen    Total packet length
+   * \param buffer      Where to store the RECORD_HEADER_SIZE bytes of the header
+   *
+   * \returns the number of packet bytes to store after the header, which
+   * the snapshot length may make smaller than totalLen
+   */
+  uint32_t FormatRecordHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen, uint8_t *buffer);
+  /**
+   * \brief Write records built with FormatRecordHeader, in one go
+   *
+   * \param data        The records
+   * \param length      Number of bytes to write
+   */
+  void WriteRecords (uint8_t const *data, uint32_t length);
 
   /**
    * \brief Read next packet from file
@@ -0,0 +1,426 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "pcap-replay-net-device.h"
+#include "ns3/node.h"
+#include "ns3/channel.h"
+#include "ns3/packet.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/trace-source-accessor.h"
+
+NS_LOG_COMPONENT_DEFINE ("PcapReplayNetDevice");
+
+namespace {
+
+// the data link types of the captures which can be replayed
+const uint32_t DLT_EN10MB = 1;
+const uint32_t DLT_PPP = 9;
+const uint32_t DLT_RAW = 101;
+const uint32_t LINKTYPE_IPV4 = 228;
+const uint32_t LINKTYPE_IPV6 = 229;
+
+const uint16_t IPV4_PROTOCOL = 0x0800;
+const uint16_t IPV6_PROTOCOL = 0x86dd;
+const uint16_t VLAN_PROTOCOL = 0x8100;
+
+// the protocols of PPP which carry IP
+const uint16_t PPP_IPV4 = 0x0021;
+const uint16_t PPP_IPV6 = 0x0057;
+
+uint16_t
+ReadNtohU16 (uint8_t const *data)
+{
+  return (data[0] << 8) | data[1];
+}
+
+uint16_t
+GetIpProtocol (uint8_t const *data, uint32_t size)
+{
+  if (size > 0 && (data[0] >> 4) == 6)
+    {
+      return IPV6_PROTOCOL;
+    }
+  return IPV4_PROTOCOL;
+}
+
+} // anonymous namespace
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (PcapReplayNetDevice);
+
+TypeId
+PcapReplayNetDevice::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PcapReplayNetDevice")
+    .SetParent<NetDevice> ()
+    .AddConstructor<PcapReplayNetDevice> ()
+    .AddAttribute ("FileName",
+                   "The pcap file whose frames are received",
+                   StringValue (""),
+                   MakeStringAccessor (&PcapReplayNetDevice::m_fileName),
+                   MakeStringChecker ())
+    .AddAttribute ("StartTime",
+                   "The time at which the first frame of the file is received",
+                   TimeValue (Seconds (0.0)),
+                   MakeTimeAccessor (&PcapReplayNetDevice::m_startTime),
+                   MakeTimeChecker ())
+    .AddAttribute ("Speedup",
+                   "The factor by which the intervals between the frames are divided",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&PcapReplayNetDevice::m_speedup),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("Granularity",
+                   "The frames due no later than this after a replay event are received by it",
+                   TimeValue (Seconds (0.0)),
+                   MakeTimeAccessor (&PcapReplayNetDevice::m_granularity),
+                   MakeTimeChecker ())
+    .AddAttribute ("Mtu", "The MAC-level Maximum Transmission Unit",
+                   UintegerValue (1500),
+                   MakeUintegerAccessor (&PcapReplayNetDevice::SetMtu,
+                                         &PcapReplayNetDevice::GetMtu),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddTraceSource ("MacRx",
+                     "A frame of the file has been received by this device",
+                     MakeTraceSourceAccessor (&PcapReplayNetDevice::m_macRxTrace))
+    .AddTraceSource ("MacTxDrop",
+                     "A packet sent through this device has been dropped",
+                     MakeTraceSourceAccessor (&PcapReplayNetDevice::m_macTxDropTrace))
+  ;
+  return tid;
+}
+
+PcapReplayNetDevice::PcapReplayNetDevice ()
+  : m_firstTimestamp (0),
+    m_next (0),
+    m_node (0),
+    m_mtu (1500),
+    m_ifIndex (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+PcapReplayNetDevice::~PcapReplayNetDevice ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+PcapReplayNetDevice::GetNReplayed (void) const
+{
+  return m_next;
+}
+
+void
+PcapReplayNetDevice::DoStart (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_fileName.empty ())
+    {
+      NS_ABORT_MSG_UNLESS (m_file.Open (m_fileName),
+                           "PcapReplayNetDevice::DoStart(): Unable to read pcap file " << m_fileName);
+      uint32_t dataLinkType = m_file.GetDataLinkType ();
+      NS_ABORT_MSG_UNLESS (dataLinkType == DLT_EN10MB || dataLinkType == DLT_PPP || dataLinkType == DLT_RAW
+                           || dataLinkType == LINKTYPE_IPV4 || dataLinkType == LINKTYPE_IPV6,
+                           "PcapReplayNetDevice::DoStart(): Unsupported data link type " << dataLinkType);
+      NS_ABORT_MSG_UNLESS (m_speedup > 0, "PcapReplayNetDevice::DoStart(): Speedup must be positive");
+      m_next = 0;
+      if (m_file.HasRecord (0))
+        {
+          m_firstTimestamp = m_file.GetRecord (0).time;
+          Time delay = m_startTime - Simulator::Now ();
+          m_event = Simulator::Schedule (delay.IsStrictlyPositive () ? delay : Seconds (0.0),
+                                         &PcapReplayNetDevice::ReplayBatch, this);
+        }
+    }
+  NetDevice::DoStart ();
+}
+
+Time
+PcapReplayNetDevice::GetReplayTime (uint32_t index) const
+{
+  uint64_t time = m_file.GetRecord (index).time;
+  if (time < m_firstTimestamp)
+    {
+      // A capture merged from several interfaces may be out of order
+      NS_LOG_WARN ("Frame " << index << " timestamped before the first one, replayed at the start");
+      return m_startTime;
+    }
+  uint64_t offset = time - m_firstTimestamp;
+  if (m_speedup != 1.0)
+    {
+      offset = static_cast<uint64_t> (offset / m_speedup);
+    }
+  return m_startTime + NanoSeconds (offset);
+}
+
+void
+PcapReplayNetDevice::ReplayBatch (void)
+{
+  NS_LOG_FUNCTION (this);
+  Time end = Simulator::Now () + m_granularity;
+  while (m_file.HasRecord (m_next) && GetReplayTime (m_next) <= end)
+    {
+      Replay (m_next);
+      m_next++;
+    }
+  if (m_file.HasRecord (m_next))
+    {
+      Time delay = GetReplayTime (m_next) - Simulator::Now ();
+      m_event = Simulator::Schedule (delay, &PcapReplayNetDevice::ReplayBatch, this);
+    }
+  else
+    {
+      m_file.Close ();
+    }
+}
+
+void
+PcapReplayNetDevice::Replay (uint32_t index)
+{
+  NS_LOG_FUNCTION (this << index);
+  struct MappedPcapFile::Record record = m_file.GetRecord (index);
+  uint8_t const *data = record.data;
+  uint32_t size = record.inclLen;
+  uint16_t protocol;
+  Mac48Address to = m_address;
+  Mac48Address from;
+  switch (m_file.GetDataLinkType ())
+    {
+    case DLT_EN10MB:
+      if (size < 14)
+        {
+          return;
+        }
+      to.CopyFrom (data);
+      from.CopyFrom (data + 6);
+      protocol = ReadNtohU16 (data + 12);
+      data += 14;
+      size -= 14;
+      if (protocol == VLAN_PROTOCOL && size >= 4)
+        {
+          protocol = ReadNtohU16 (data + 2);
+          data += 4;
+          size -= 4;
+        }
+      else if (protocol < 0x600 && size >= 8)
+        {
+          // LLC/SNAP
+          protocol = ReadNtohU16 (data + 6);
+          data += 8;
+          size -= 8;
+        }
+      break;
+    case DLT_PPP:
+      if (size >= 2 && data[0] == 0xff && data[1] == 0x03)
+        {
+          data += 2;
+          size -= 2;
+        }
+      if (size < 2)
+        {
+          return;
+        }
+      switch (ReadNtohU16 (data))
+        {
+        case PPP_IPV4:
+          protocol = IPV4_PROTOCOL;
+          break;
+        case PPP_IPV6:
+          protocol = IPV6_PROTOCOL;
+          break;
+        default:
+          // LCP, IPCP and the other control protocols of the link
+          NS_LOG_LOGIC ("Dropping frame " << index << " of PPP protocol 0x" << std::hex << ReadNtohU16 (data) << std::dec);
+          return;
+        }
+      data += 2;
+      size -= 2;
+      break;
+    default:
+      protocol = GetIpProtocol (data, size);
+      break;
+    }
+
+  Ptr<Packet> packet = Create<Packet> (data, size);
+  NetDevice::PacketType packetType;
+  if (to == m_address)
+    {
+      packetType = NetDevice::PACKET_HOST;
+    }
+  else if (to.IsBroadcast ())
+    {
+      packetType = NetDevice::PACKET_BROADCAST;
+    }
+  else if (to.IsGroup ())
+    {
+      packetType = NetDevice::PACKET_MULTICAST;
+    }
+  else
+    {
+      packetType = NetDevice::PACKET_OTHERHOST;
+    }
+  m_macRxTrace (packet);
+  if (!m_promiscCallback.IsNull ())
+    {
+      m_promiscCallback (this, packet, protocol, from, to, packetType);
+    }
+  // the frames to other hosts are only for the promiscuous sniffers
+  if (packetType != NetDevice::PACKET_OTHERHOST && !m_rxCallback.IsNull ())
+    {
+      m_rxCallback (this, packet, protocol, from);
+    }
+}
+
+void
+PcapReplayNetDevice::SetIfIndex (const uint32_t index)
+{
+  m_ifIndex = index;
+}
+uint32_t
+PcapReplayNetDevice::GetIfIndex (void) const
+{
+  return m_ifIndex;
+}
+Ptr<Channel>
+PcapReplayNetDevice::GetChannel (void) const
+{
+  return 0;
+}
+void
+PcapReplayNetDevice::SetAddress (Address address)
+{
+  m_address = Mac48Address::ConvertFrom (address);
+}
+Address
+PcapReplayNetDevice::GetAddress (void) const
+{
+  return m_address;
+}
+bool
+PcapReplayNetDevice::SetMtu (const uint16_t mtu)
+{
+  m_mtu = mtu;
+  return true;
+}
+uint16_t
+PcapReplayNetDevice::GetMtu (void) const
+{
+  return m_mtu;
+}
+bool
+PcapReplayNetDevice::IsLinkUp (void) const
+{
+  return true;
+}
+void
+PcapReplayNetDevice::AddLinkChangeCallback (Callback<void> callback)
+{}
+bool
+PcapReplayNetDevice::IsBroadcast (void) const
+{
+  return true;
+}
+Address
+PcapReplayNetDevice::GetBroadcast (void) const
+{
+  return Mac48Address ("ff:ff:ff:ff:ff:ff");
+}
+bool
+PcapReplayNetDevice::IsMulticast (void) const
+{
+  return true;
+}
+Address
+PcapReplayNetDevice::GetMulticast (Ipv4Address multicastGroup) const
+{
+  return Mac48Address::GetMulticast (multicastGroup);
+}
+Address
+PcapReplayNetDevice::GetMulticast (Ipv6Address addr) const
+{
+  return Mac48Address::GetMulticast (addr);
+}
+bool
+PcapReplayNetDevice::IsPointToPoint (void) const
+{
+  return false;
+}
+bool
+PcapReplayNetDevice::IsBridge (void) const
+{
+  return false;
+}
+bool
+PcapReplayNetDevice::Send (Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber)
+{
+  NS_LOG_FUNCTION (this << packet << dest << protocolNumber);
+  m_macTxDropTrace (packet);
+  return true;
+}
+bool
+PcapReplayNetDevice::SendFrom (Ptr<Packet> packet, const Address& source, const Address& dest, uint16_t protocolNumber)
+{
+  NS_LOG_FUNCTION (this << packet << source << dest << protocolNumber);
+  m_macTxDropTrace (packet);
+  return true;
+}
+Ptr<Node>
+PcapReplayNetDevice::GetNode (void) const
+{
+  return m_node;
+}
+void
+PcapReplayNetDevice::SetNode (Ptr<Node> node)
+{
+  m_node = node;
+}
+bool
+PcapReplayNetDevice::NeedsArp (void) const
+{
+  return false;
+}
+void
+PcapReplayNetDevice::SetReceiveCallback (NetDevice::ReceiveCallback cb)
+{
+  m_rxCallback = cb;
+}
+void
+PcapReplayNetDevice::SetPromiscReceiveCallback (PromiscReceiveCallback cb)
+{
+  m_promiscCallback = cb;
+}
+bool
+PcapReplayNetDevice::SupportsSendFrom (void) const
+{
+  return true;
+}
+
+void
+PcapReplayNetDevice::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_event.Cancel ();
+  m_file.Close ();
+  m_node = 0;
+  NetDevice::DoDispose ();
+}
+
+} // namespace ns3
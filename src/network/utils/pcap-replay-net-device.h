@@ -0,0 +1,123 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef PCAP_REPLAY_NET_DEVICE_H
+#define PCAP_REPLAY_NET_DEVICE_H
+
+#include <stdint.h>
+#include <string>
+#include "ns3/net-device.h"
+#include "ns3/traced-callback.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "mac48-address.h"
+#include "mapped-pcap-file.h"
+
+namespace ns3 {
+
+class Node;
+
+/**
+ * \ingroup netdevice
+ *
+ * \brief A net device which receives the frames of a pcap file
+ *
+ * The frames of FileName are passed up to the node of the device as if
+ * they had been received by it, at StartTime plus their offset from the
+ * first frame of the file divided by Speedup.  As with the other devices,
+ * the frames to other hosts only go to the promiscuous protocol handlers.
+ * Ethernet (with LLC/SNAP or a VLAN tag), PPP and raw IP captures are
+ * supported; the PPP frames other than IPv4 and IPv6 (LCP, IPCP...) are
+ * dropped.  Packets sent through the device are dropped.
+ *
+ * The file is mapped in memory by MappedPcapFile, and a single event is
+ * pending at any time: each event receives all the frames due no later
+ * than Granularity after it, then schedules the next one, so that the
+ * captures of any size take a constant amount of scheduler memory.  A
+ * non-zero Granularity trades the accuracy of the timestamps for fewer
+ * events.  The frames are replayed in the order of the file; a frame
+ * timestamped before the first one is replayed at StartTime, and a frame
+ * timestamped before the previous one as soon as it is reached.
+ */
+class PcapReplayNetDevice : public NetDevice
+{
+public:
+  static TypeId GetTypeId (void);
+  PcapReplayNetDevice ();
+  virtual ~PcapReplayNetDevice ();
+
+  /**
+   * \returns the number of frames received from the file so far
+   */
+  uint32_t GetNReplayed (void) const;
+
+  // inherited from NetDevice base class.
+  virtual void SetIfIndex (const uint32_t index);
+  virtual uint32_t GetIfIndex (void) const;
+  virtual Ptr<Channel> GetChannel (void) const;
+  virtual void SetAddress (Address address);
+  virtual Address GetAddress (void) const;
+  virtual bool SetMtu (const uint16_t mtu);
+  virtual uint16_t GetMtu (void) const;
+  virtual bool IsLinkUp (void) const;
+  virtual void AddLinkChangeCallback (Callback<void> callback);
+  virtual bool IsBroadcast (void) const;
+  virtual Address GetBroadcast (void) const;
+  virtual bool IsMulticast (void) const;
+  virtual Address GetMulticast (Ipv4Address multicastGroup) const;
+  virtual Address GetMulticast (Ipv6Address addr) const;
+  virtual bool IsPointToPoint (void) const;
+  virtual bool IsBridge (void) const;
+  virtual bool Send (Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber);
+  virtual bool SendFrom (Ptr<Packet> packet, const Address& source, const Address& dest, uint16_t protocolNumber);
+  virtual Ptr<Node> GetNode (void) const;
+  virtual void SetNode (Ptr<Node> node);
+  virtual bool NeedsArp (void) const;
+  virtual void SetReceiveCallback (NetDevice::ReceiveCallback cb);
+  virtual void SetPromiscReceiveCallback (PromiscReceiveCallback cb);
+  virtual bool SupportsSendFrom (void) const;
+
+protected:
+  virtual void DoStart (void);
+  virtual void DoDispose (void);
+
+private:
+  Time GetReplayTime (uint32_t index) const;
+  void ReplayBatch (void);
+  void Replay (uint32_t index);
+
+  std::string m_fileName;
+  Time m_startTime;
+  double m_speedup;
+  Time m_granularity;
+  MappedPcapFile m_file;
+  uint64_t m_firstTimestamp;
+  uint32_t m_next;
+  EventId m_event;
+
+  NetDevice::ReceiveCallback m_rxCallback;
+  NetDevice::PromiscReceiveCallback m_promiscCallback;
+  Ptr<Node> m_node;
+  uint16_t m_mtu;
+  uint32_t m_ifIndex;
+  Mac48Address m_address;
+
+  TracedCallback<Ptr<const Packet> > m_macRxTrace;
+  TracedCallback<Ptr<const Packet> > m_macTxDropTrace;
+};
+
+} // namespace ns3
+
+#endif /* PCAP_REPLAY_NET_DEVICE_H */
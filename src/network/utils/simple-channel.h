@@ -21,6 +21,7 @@
 #define SIMPLE_CHANNEL_H
 
 #include "ns3/channel.h"
+#include "ns3/nstime.h"
 #include "mac48-address.h"
 #include <vector>
 
@@ -49,6 +50,7 @@ public:
   virtual Ptr<NetDevice> GetDevice (uint32_t i) const;
 
 private:
+  Time m_delay;
   std::vector<Ptr<SimpleNetDevice> > m_devices;
 };
 
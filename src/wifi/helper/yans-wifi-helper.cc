@@ -467,6 +467,14 @@ YansWifiPhyHelper::EnableAsciiInternal (
       return;
     }
 
+  //
+  // The wifi phy trace sinks only write text.
+  //
+  if (AsciiTraceHelper::IsBinaryStream (stream))
+    {
+      NS_FATAL_ERROR ("YansWifiPhyHelper::EnableAsciiInternal(): binary trace streams are not supported");
+    }
+
   //
   // Our trace sinks are going to use packet printing, so we have to make sure
   // that is turned on.
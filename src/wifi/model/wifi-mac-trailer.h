@@ -51,6 +51,12 @@ public:
   virtual uint32_t Deserialize (Buffer::Iterator start);
 };
 
+template <>
+struct FixedSerializedSize<WifiMacTrailer>
+{
+  static const uint32_t value = WIFI_MAC_FCS_LENGTH;
+};
+
 } // namespace ns3
 
 #endif /* WIFI_MAC_TRAILER_H */
@@ -58,17 +58,17 @@ void WimaxHelper::EnableAsciiForConnection (Ptr<OutputStreamWrapper> os,
   std::ostringstream oss;
   oss << "/NodeList/" << nodeid << "/DeviceList/" << deviceid << "/$ns3::" << netdevice << "/" << connection
       << "/TxQueue/Enqueue";
-  Config::Connect (oss.str (), MakeBoundCallback (&AsciiTraceHelper::DefaultEnqueueSinkWithContext, os));
+  Config::Connect (oss.str (), AsciiTraceHelper::MakeDefaultSinkWithContext ('+', os));
 
   oss.str ("");
   oss << "/NodeList/" << nodeid << "/DeviceList/" << deviceid << "/$ns3::" << netdevice << "/" << connection
       << "/TxQueue/Dequeue";
-  Config::Connect (oss.str (), MakeBoundCallback (&AsciiTraceHelper::DefaultDequeueSinkWithContext, os));
+  Config::Connect (oss.str (), AsciiTraceHelper::MakeDefaultSinkWithContext ('-', os));
 
   oss.str ("");
   oss << "/NodeList/" << nodeid << "/DeviceList/" << deviceid << "/$ns3::" << netdevice << "/" << connection
       << "/TxQueue/Drop";
-  Config::Connect (oss.str (), MakeBoundCallback (&AsciiTraceHelper::DefaultDropSinkWithContext, os));
+  Config::Connect (oss.str (), AsciiTraceHelper::MakeDefaultSinkWithContext ('d', os));
 }
 
 Ptr<WimaxPhy> WimaxHelper::CreatePhy (PhyType phyType)
@@ -460,6 +460,14 @@ WimaxHelper::EnableAsciiInternal (Ptr<OutputStreamWrapper> stream,
       return;
     }
 
+  //
+  // The wimax trace sinks only write text.
+  //
+  if (AsciiTraceHelper::IsBinaryStream (stream))
+    {
+      NS_FATAL_ERROR ("WimaxHelper::EnableAsciiInternal(): binary trace streams are not supported");
+    }
+
   //
   // Our default trace sinks are going to use packet printing, so we have to
   // make sure that is turned on.
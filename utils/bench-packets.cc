@@ -20,10 +20,14 @@
 #include "ns3/system-wall-clock-ms.h"
 #include "ns3/packet.h"
 #include "ns3/packet-metadata.h"
+#include "ns3/size-class-allocator.h"
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include <stdlib.h> // for exit ()
+#include <sys/resource.h> // for getrusage ()
 
 using namespace ns3;
 
@@ -115,6 +119,14 @@ BenchHeader<N>::Deserialize (Buffer::Iterator start)
   return N;
 }
 
+namespace ns3 {
+template <int N>
+struct FixedSerializedSize<BenchHeader<N> >
+{
+  static const uint32_t value = N;
+};
+} // namespace ns3
+
 template <int N>
 class BenchTag : public Tag
 {
@@ -241,18 +253,127 @@ benchC (uint32_t n)
   }
 }
 
+// mixed MTU traffic: jumbo frames and their acks
+static void
+benchE (uint32_t n)
+{
+  BenchHeader<20> ipv4;
+  BenchHeader<20> tcp;
+  std::vector<Ptr<Packet> > inFlight;
+
+  for (uint32_t i = 0; i < n; i++) {
+    Ptr<Packet> p = Create<Packet> (i % 2 ? 40 : 8960);
+    p->AddHeader (tcp);
+    p->AddHeader (ipv4);
+    inFlight.push_back (p);
+    if (inFlight.size () == 32)
+      {
+        inFlight.clear ();
+      }
+  }
+}
+
+// bulk transfer: segments cut across application writes, then
+// fragmented and reassembled
+static void
+benchF (uint32_t n)
+{
+  BenchHeader<20> ipv4;
+  BenchHeader<20> tcp;
+  Ptr<Packet> first = Create<Packet> (8000);
+  Ptr<Packet> second = Create<Packet> (8000);
+
+  for (uint32_t i = 0; i < n; i++) {
+    Ptr<Packet> p = first->CreateFragment (4000, 4000);
+    p->AddAtEnd (second->CreateFragment (0, 4960));
+    p->AddHeader (tcp);
+    Ptr<Packet> reassembled = p->CreateFragment (0, 1480);
+    for (uint32_t offset = 1480; offset < p->GetSize (); offset += 1480)
+      {
+        Ptr<Packet> fragment = p->CreateFragment (offset, std::min (p->GetSize () - offset, 1480U));
+        fragment->AddHeader (ipv4);
+        fragment->RemoveHeader (ipv4);
+        reassembled->AddAtEnd (fragment);
+      }
+  }
+}
+
+// per-packet tags of the wifi and lte stacks: added once, peeked
+// and copied at every layer
+static void
+benchG (uint32_t n)
+{
+  BenchHeader<20> ipv4;
+  BenchTag<4> qos;
+  BenchTag<8> flow;
+
+  for (uint32_t i = 0; i < n; i++) {
+    Ptr<Packet> p = Create<Packet> (1000);
+    p->AddPacketTag (flow);
+    p->AddHeader (ipv4);
+    p->AddPacketTag (qos);
+    for (uint32_t layer = 0; layer < 3; layer++)
+      {
+        p = p->Copy ();
+        p->PeekPacketTag (flow);
+        p->PeekPacketTag (qos);
+      }
+    p->RemovePacketTag (qos);
+    p->RemoveHeader (ipv4);
+  }
+}
+
+// bulk transfer of packets with byte tags, such as the flow monitor
+// tags, fragmented and reassembled
+static void
+benchH (uint32_t n)
+{
+  BenchHeader<20> ipv4;
+  BenchHeader<20> tcp;
+  BenchTag<12> probe;
+  Ptr<Packet> first = Create<Packet> (8000);
+  first->AddByteTag (probe);
+  Ptr<Packet> second = Create<Packet> (8000);
+  second->AddByteTag (probe);
+
+  for (uint32_t i = 0; i < n; i++) {
+    Ptr<Packet> p = first->CreateFragment (4000, 4000);
+    p->AddAtEnd (second->CreateFragment (0, 4960));
+    p->AddHeader (tcp);
+    p->AddByteTag (probe);
+    Ptr<Packet> reassembled = p->CreateFragment (0, 1480);
+    for (uint32_t offset = 1480; offset < p->GetSize (); offset += 1480)
+      {
+        Ptr<Packet> fragment = p->CreateFragment (offset, std::min (p->GetSize () - offset, 1480U));
+        fragment->AddHeader (ipv4);
+        fragment->RemoveHeader (ipv4);
+        reassembled->AddAtEnd (fragment);
+      }
+  }
+}
 
 static void
 runBench (void (*bench) (uint32_t), uint32_t n, char const *name)
 {
   SystemWallClockMs time;
+  SizeClassAllocator::Stats before = SizeClassAllocator::GetStats ();
+  Packet::PoolStats poolBefore = Packet::GetPoolStats ();
   time.Start ();
   (*bench) (n);
   uint64_t deltaMs = time.End ();
+  SizeClassAllocator::Stats after = SizeClassAllocator::GetStats ();
+  Packet::PoolStats poolAfter = Packet::GetPoolStats ();
   double ps = n;
   ps *= 1000;
   ps /= deltaMs;
-  std::cout << name<<"=" << ps << " packets/s" << std::endl;
+  std::cout << name<<"=" << ps << " packets/s"
+            << " (buffer hits=" << after.hits - before.hits
+            << ", misses=" << after.misses - before.misses
+            << ", allocations/packet="
+            << (double)(after.hits + after.misses - before.hits - before.misses) / n
+            << ", packet pool hits=" << poolAfter.hits - poolBefore.hits
+            << ", misses=" << poolAfter.misses - poolBefore.misses
+            << ")" << std::endl;
 }
 
 int main (int argc, char *argv[])
@@ -266,10 +387,23 @@ int main (int argc, char *argv[])
           iss.str (nAscii);
           iss >> n;
         }
+      if (strncmp ("--packet-pool", argv[0], strlen ("--packet-pool")) == 0)
+        {
+          Packet::EnablePool ();
+        }
       if (strncmp ("--enable-printing", argv[0], strlen ("--enable-printing")) == 0)
         {
           Packet::EnablePrinting ();
         }
+      if (strncmp ("--sample-printing=", argv[0], strlen ("--sample-printing=")) == 0)
+        {
+          char const *periodAscii = argv[0] + strlen ("--sample-printing=");
+          std::istringstream iss;
+          iss.str (periodAscii);
+          uint32_t period = 1;
+          iss >> period;
+          Packet::EnableSampledPrinting (period);
+        }
       argc--;
       argv++;
   }
@@ -285,6 +419,14 @@ int main (int argc, char *argv[])
   runBench (&benchB, n, "b");
   runBench (&benchC, n, "c");
   runBench (&benchD, n, "d");
+  runBench (&benchE, n, "e");
+  runBench (&benchF, n, "f");
+  runBench (&benchG, n, "g");
+  runBench (&benchH, n, "h");
+
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  std::cout << "max RSS=" << usage.ru_maxrss << " kB" << std::endl;
 
   return 0;
 }
@@ -0,0 +1,201 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Measure the lookups of the static routing tables.  The routes are
+// looked up first without an output device, through the trie, then
+// with one, which scans the whole table as it used to be done.
+
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/random-variable.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv6.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv6-route.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv6-static-routing.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/ipv6-static-routing-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string.h>
+#include <stdlib.h> // for exit ()
+
+using namespace ns3;
+
+static void
+report (char const *name, uint32_t n, uint32_t found, uint64_t deltaMs)
+{
+  double ls = n;
+  ls *= 1000;
+  ls /= deltaMs ? deltaMs : 1;
+  std::cout << name << "=" << ls << " lookups/s (" << found << " routes found)" << std::endl;
+}
+
+static Ipv4Address
+randomIpv4 (UniformVariable &random)
+{
+  return Ipv4Address ((random.GetInteger (0, 0xffff) << 16) | random.GetInteger (0, 0xffff));
+}
+
+static void
+benchIpv4 (Ptr<Ipv4> ipv4, uint32_t interface, uint32_t nRoutes, uint32_t n)
+{
+  UniformVariable random;
+  Ptr<Ipv4StaticRouting> routing = Ipv4StaticRoutingHelper ().GetStaticRouting (ipv4);
+  for (uint32_t i = 0; i < nRoutes; i++)
+    {
+      uint32_t length = random.GetInteger (8, 32);
+      Ipv4Mask mask (length == 32 ? 0xffffffff : ~(0xffffffff >> length));
+      Ipv4Address network = randomIpv4 (random).CombineMask (mask);
+      routing->AddNetworkRouteTo (network, mask, "10.0.0.2", interface, random.GetInteger (0, 3));
+    }
+  routing->SetDefaultRoute ("10.0.0.3", interface);
+
+  std::vector<Ipv4Header> headers (1024);
+  for (uint32_t i = 0; i < headers.size (); i++)
+    {
+      Ipv4Address destination = randomIpv4 (random);
+      // the route to the loopback interface is not scanned with a device
+      while (Ipv4Mask ("255.0.0.0").IsMatch (destination, "127.0.0.0"))
+        {
+          destination = randomIpv4 (random);
+        }
+      headers[i].SetDestination (destination);
+    }
+  Ptr<NetDevice> devices[2] = { 0, ipv4->GetNetDevice (interface) };
+  char const *names[2] = { "ipv4-trie", "ipv4-scan" };
+  for (uint32_t k = 0; k < 2; k++)
+    {
+      uint32_t found = 0;
+      SystemWallClockMs time;
+      time.Start ();
+      for (uint32_t i = 0; i < n; i++)
+        {
+          Socket::SocketErrno sockerr;
+          Ptr<Ipv4Route> route = routing->RouteOutput (0, headers[i % headers.size ()], devices[k], sockerr);
+          if (route->GetGateway () != Ipv4Address ("10.0.0.3"))
+            {
+              found++;
+            }
+        }
+      report (names[k], n, found, time.End ());
+    }
+}
+
+static void
+benchIpv6 (Ptr<Ipv6> ipv6, uint32_t interface, uint32_t nRoutes, uint32_t n)
+{
+  UniformVariable random;
+  Ptr<Ipv6StaticRouting> routing = Ipv6StaticRoutingHelper ().GetStaticRouting (ipv6);
+  for (uint32_t i = 0; i < nRoutes; i++)
+    {
+      uint8_t bytes[16];
+      uint32_t length = random.GetInteger (16, 64);
+      for (uint32_t j = 0; j < 16; j++)
+        {
+          bytes[j] = j < 2 ? (j == 0 ? 0x20 : 0x01) : random.GetInteger (0, 255);
+        }
+      routing->AddNetworkRouteTo (Ipv6Address (bytes), Ipv6Prefix (length), "2001::2", interface, random.GetInteger (0, 3));
+    }
+  routing->SetDefaultRoute ("2001::3", interface);
+
+  std::vector<Ipv6Header> headers (1024);
+  for (uint32_t i = 0; i < headers.size (); i++)
+    {
+      uint8_t bytes[16];
+      for (uint32_t j = 0; j < 16; j++)
+        {
+          bytes[j] = j < 2 ? (j == 0 ? 0x20 : 0x01) : random.GetInteger (0, 255);
+        }
+      headers[i].SetDestinationAddress (Ipv6Address (bytes));
+    }
+  Ptr<NetDevice> devices[2] = { 0, ipv6->GetNetDevice (interface) };
+  char const *names[2] = { "ipv6-trie", "ipv6-scan" };
+  for (uint32_t k = 0; k < 2; k++)
+    {
+      uint32_t found = 0;
+      SystemWallClockMs time;
+      time.Start ();
+      for (uint32_t i = 0; i < n; i++)
+        {
+          Socket::SocketErrno sockerr;
+          Ptr<Ipv6Route> route = routing->RouteOutput (0, headers[i % headers.size ()], devices[k], sockerr);
+          if (route->GetGateway () != Ipv6Address ("2001::3"))
+            {
+              found++;
+            }
+        }
+      report (names[k], n, found, time.End ());
+    }
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  uint32_t nRoutes = 1000;
+  while (argc > 0) {
+      if (strncmp ("--n=", argv[0],strlen ("--n=")) == 0)
+        {
+          char const *nAscii = argv[0] + strlen ("--n=");
+          std::istringstream iss;
+          iss.str (nAscii);
+          iss >> n;
+        }
+      if (strncmp ("--routes=", argv[0], strlen ("--routes=")) == 0)
+        {
+          char const *routesAscii = argv[0] + strlen ("--routes=");
+          std::istringstream iss;
+          iss.str (routesAscii);
+          iss >> nRoutes;
+        }
+      argc--;
+      argv++;
+  }
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of lookups must be specified " <<
+        "by command-line argument --n=(number of lookups)" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-routing with n=" << n << ", routes=" << nRoutes << std::endl;
+
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (node);
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  device->SetAddress (Mac48Address::Allocate ());
+  node->AddDevice (device);
+
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  uint32_t interface = ipv4->AddInterface (device);
+  ipv4->AddAddress (interface, Ipv4InterfaceAddress ("10.0.0.1", "255.255.255.0"));
+  ipv4->SetUp (interface);
+  benchIpv4 (ipv4, interface, nRoutes, n);
+
+  Ptr<Ipv6> ipv6 = node->GetObject<Ipv6> ();
+  interface = ipv6->AddInterface (device);
+  ipv6->AddAddress (interface, Ipv6InterfaceAddress ("2001::1", Ipv6Prefix (64)));
+  ipv6->SetUp (interface);
+  benchIpv6 (ipv6, interface, nRoutes, n);
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -18,55 +18,176 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 
+// Hold model benchmark of the event schedulers.  The event list is
+// filled with --sizes events, then every event which expires schedules
+// a new one, keeping the size of the event list constant, until --total
+// events have run.  Inter-event times are drawn from an exponential, a
+// bimodal or a triangular distribution or replayed from a trace file
+// (one delay in seconds per line):
+//
+//   ./waf --run "bench-simulator --schedulers=map,heap,calendar
+//                --distributions=exponential,bimodal --sizes=1e3,1e5,1e7 --csv=1"
+//   ./waf --run "bench-simulator delays.txt --schedulers=heap"
+//
+// --cancel sets aside a fraction of the event list for timers: each
+// hold event then cancels and reschedules a random timer with the same
+// probability, the way protocols restart their retransmission timers.
+// --contexts spreads the hold events over as many contexts with
+// Simulator::ScheduleWithContext and --threads adds as many threads
+// which schedule events with a context while the simulation runs.
+//
+// Each event costs about 100 bytes, so a 1e8 event list needs about
+// 10GB of memory.
+
 #include "ns3/core-module.h"
+#include "ns3/core-config.h"
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <vector>
-#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
 
 using namespace ns3;
 
 
 bool g_debug = false;
 
-class Bench 
+struct BenchResult
+{
+  double init;
+  double simu;
+  uint64_t events;
+  uint64_t cancelled;
+};
+
+class Bench
 {
 public:
   Bench ();
   void ReadDistribution (std::istream &istream);
+  /**
+   * \param name exponential, bimodal or triangular
+   * \param mean the mean inter-event time in nanoseconds
+   */
+  void GenerateDistribution (std::string name, double mean);
   void SetTotal (uint32_t total);
-  void RunBench (void);
+  void SetPopulation (uint32_t population);
+  void SetCancel (double fraction, bool remove);
+  void SetContexts (uint32_t contexts);
+  void SetThreads (uint32_t threads, uint32_t events);
+  BenchResult RunBench (void);
+  uint64_t GetDelay (uint32_t index) const;
+  void Produced (void);
 private:
+  uint64_t NextDelay (void);
+  uint32_t NextRandom (void);
+  void ScheduleHold (void);
   void Cb (void);
+  void Timer (uint32_t index);
   std::vector<uint64_t> m_distribution;
-  std::vector<uint64_t>::const_iterator m_current;
+  uint32_t m_current;
   uint32_t m_n;
   uint32_t m_total;
+  uint32_t m_population;
+  uint32_t m_cancelThreshold;
+  bool m_remove;
+  uint32_t m_contexts;
+  uint32_t m_threads;
+  uint32_t m_threadEvents;
+  uint32_t m_random;
+  uint64_t m_events;
+  uint64_t m_cancelled;
+  std::vector<EventId> m_timers;
+};
+
+#ifdef HAVE_PTHREAD_H
+// Schedules events with a context from outside of the simulation thread
+class Producer
+{
+public:
+  Producer (Bench *bench, uint32_t context, uint32_t offset, uint32_t n)
+    : m_bench (bench),
+      m_context (context),
+      m_offset (offset),
+      m_n (n)
+  {}
+  void Run (void)
+  {
+    for (uint32_t i = 0; i < m_n; i++)
+      {
+        Simulator::ScheduleWithContext (m_context, NanoSeconds (m_bench->GetDelay (m_offset + i)),
+                                        &Bench::Produced, m_bench);
+      }
+  }
+private:
+  Bench *m_bench;
+  uint32_t m_context;
+  uint32_t m_offset;
+  uint32_t m_n;
 };
+#endif /* HAVE_PTHREAD_H */
 
 Bench::Bench ()
-  : m_n (0),
-    m_total (0)
+  : m_current (0),
+    m_n (0),
+    m_total (0),
+    m_population (1),
+    m_cancelThreshold (0),
+    m_remove (false),
+    m_contexts (0),
+    m_threads (0),
+    m_threadEvents (0),
+    m_random (2463534242U),
+    m_events (0),
+    m_cancelled (0)
 {}
 
-void 
+void
 Bench::SetTotal (uint32_t total)
 {
   m_total = total;
 }
 
+void
+Bench::SetPopulation (uint32_t population)
+{
+  m_population = population;
+}
+
+void
+Bench::SetCancel (double fraction, bool remove)
+{
+  m_cancelThreshold = static_cast<uint32_t> (fraction * 4294967295.0);
+  m_timers.resize (static_cast<uint32_t> (fraction * m_population));
+  m_remove = remove;
+}
+
+void
+Bench::SetContexts (uint32_t contexts)
+{
+  m_contexts = contexts;
+}
+
+void
+Bench::SetThreads (uint32_t threads, uint32_t events)
+{
+  m_threads = threads;
+  m_threadEvents = events;
+}
+
 void
 Bench::ReadDistribution (std::istream &input)
 {
   double data;
-  while (!input.eof ()) 
+  while (!input.eof ())
     {
-      if (input >> data) 
+      if (input >> data)
         {
           uint64_t ns = (uint64_t) (data * 1000000000);
           m_distribution.push_back (ns);
-        } 
-      else 
+        }
+      else
         {
           input.clear ();
           std::string line;
@@ -76,134 +197,349 @@ Bench::ReadDistribution (std::istream &input)
 }
 
 void
-Bench::RunBench (void) 
+Bench::GenerateDistribution (std::string name, double mean)
+{
+  // Draw the delays up front, to leave the random variables out of the
+  // measurements
+  const uint32_t n = 1 << 20;
+  m_distribution.clear ();
+  m_distribution.reserve (n);
+  if (name == "exponential")
+    {
+      ExponentialVariable exponential (mean);
+      for (uint32_t i = 0; i < n; i++)
+        {
+          m_distribution.push_back ((uint64_t) exponential.GetValue ());
+        }
+    }
+  else if (name == "bimodal")
+    {
+      // 90% of short delays with a mean of mean/10 and 10% of long
+      // delays with a mean of 9.1 * mean
+      UniformVariable mode;
+      UniformVariable shortDelay (0, 0.2 * mean);
+      UniformVariable longDelay (0, 18.2 * mean);
+      for (uint32_t i = 0; i < n; i++)
+        {
+          double delay = mode.GetValue () < 0.9 ? shortDelay.GetValue () : longDelay.GetValue ();
+          m_distribution.push_back ((uint64_t) delay);
+        }
+    }
+  else if (name == "triangular")
+    {
+      TriangularVariable triangular (0, 2 * mean, mean);
+      for (uint32_t i = 0; i < n; i++)
+        {
+          m_distribution.push_back ((uint64_t) triangular.GetValue ());
+        }
+    }
+  else
+    {
+      NS_FATAL_ERROR ("Unknown distribution " << name);
+    }
+}
+
+uint64_t
+Bench::GetDelay (uint32_t index) const
+{
+  return m_distribution[index % m_distribution.size ()];
+}
+
+uint64_t
+Bench::NextDelay (void)
+{
+  if (m_current == m_distribution.size ())
+    {
+      m_current = 0;
+    }
+  return m_distribution[m_current++];
+}
+
+uint32_t
+Bench::NextRandom (void)
+{
+  // xorshift: cheap enough not to show in the measurements
+  m_random ^= m_random << 13;
+  m_random ^= m_random >> 17;
+  m_random ^= m_random << 5;
+  return m_random;
+}
+
+void
+Bench::ScheduleHold (void)
+{
+  if (m_contexts == 0)
+    {
+      Simulator::Schedule (NanoSeconds (NextDelay ()), &Bench::Cb, this);
+    }
+  else
+    {
+      Simulator::ScheduleWithContext (NextRandom () % m_contexts, NanoSeconds (NextDelay ()),
+                                      &Bench::Cb, this);
+    }
+}
+
+BenchResult
+Bench::RunBench (void)
 {
+  NS_ABORT_MSG_IF (m_distribution.empty (), "Empty distribution");
+  NS_ABORT_MSG_IF (m_timers.size () >= m_population, "No room left for hold events");
+  BenchResult result;
   SystemWallClockMs time;
-  double init, simu;
+  m_current = 0;
+  m_n = 0;
+  m_events = 0;
+  m_cancelled = 0;
+
   time.Start ();
-  for (std::vector<uint64_t>::const_iterator i = m_distribution.begin ();
-       i != m_distribution.end (); i++) 
+  for (uint32_t i = 0; i < m_timers.size (); i++)
     {
-      Simulator::Schedule (NanoSeconds (*i), &Bench::Cb, this);
+      m_timers[i] = Simulator::Schedule (NanoSeconds (NextDelay ()), &Bench::Timer, this, i);
     }
-  init = time.End ();
-  init /= 1000;
-
-  m_current = m_distribution.begin ();
+  for (uint32_t i = m_timers.size (); i < m_population; i++)
+    {
+      ScheduleHold ();
+    }
+  result.init = time.End ();
+  result.init /= 1000;
 
   time.Start ();
+#ifdef HAVE_PTHREAD_H
+  std::vector<Producer *> producers;
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 0; i < m_threads; i++)
+    {
+      producers.push_back (new Producer (this, m_contexts + i, i * m_threadEvents, m_threadEvents));
+      threads.push_back (Create<SystemThread> (MakeCallback (&Producer::Run, producers[i])));
+      threads[i]->Start ();
+    }
+#else
+  NS_ABORT_MSG_IF (m_threads != 0, "Threads are not supported on this platform");
+#endif /* HAVE_PTHREAD_H */
   Simulator::Run ();
-  simu = time.End ();
-  simu /= 1000;
-
-  std::cout <<
-      "init n=" << m_distribution.size () << ", time=" << init << "s" << std::endl <<
-      "simu n=" << m_n << ", time=" <<simu << "s" << std::endl <<
-      "init " << ((double)m_distribution.size ()) / init << " insert/s, avg insert=" <<
-      init / ((double)m_distribution.size ())<< "s" << std::endl <<
-      "simu " << ((double)m_n) / simu<< " hold/s, avg hold=" << 
-      simu / ((double)m_n) << "s" << std::endl
-      ;
+#ifdef HAVE_PTHREAD_H
+  for (uint32_t i = 0; i < m_threads; i++)
+    {
+      threads[i]->Join ();
+      delete producers[i];
+    }
+  if (m_threads != 0)
+    {
+      // Events scheduled by the producers after the event list emptied
+      Simulator::Run ();
+    }
+#endif /* HAVE_PTHREAD_H */
+  result.simu = time.End ();
+  result.simu /= 1000;
+  result.events = m_events;
+  result.cancelled = m_cancelled;
+  return result;
 }
 
 void
 Bench::Cb (void)
 {
-  if (m_n > m_total) 
+  m_events++;
+  if (m_n > m_total)
     {
       return;
     }
-  if (m_current == m_distribution.end ()) 
+  if (g_debug)
     {
-      m_current = m_distribution.begin ();
+      std::cerr << "event at " << Simulator::Now ().GetSeconds () << "s" << std::endl;
     }
-  if (g_debug) 
+  ScheduleHold ();
+  if (!m_timers.empty () && NextRandom () < m_cancelThreshold)
     {
-      std::cerr << "event at " << Simulator::Now ().GetSeconds () << "s" << std::endl;
+      uint32_t index = NextRandom () % m_timers.size ();
+      if (m_remove)
+        {
+          Simulator::Remove (m_timers[index]);
+        }
+      else
+        {
+          m_timers[index].Cancel ();
+        }
+      m_timers[index] = Simulator::Schedule (NanoSeconds (NextDelay ()), &Bench::Timer, this, index);
+      m_cancelled++;
     }
-  Simulator::Schedule (NanoSeconds (*m_current), &Bench::Cb, this);
-  m_current++;
   m_n++;
 }
 
 void
-PrintHelp (void)
+Bench::Timer (uint32_t index)
 {
-  std::cout << "bench-simulator filename [options]"<<std::endl;
-  std::cout << "  filename: a string which identifies the input distribution. \"-\" represents stdin." << std::endl;
-  std::cout << "  Options:"<<std::endl;
-  std::cout << "      --list: use std::list scheduler"<<std::endl;
-  std::cout << "      --map: use std::map cheduler"<<std::endl;
-  std::cout << "      --heap: use Binary Heap scheduler"<<std::endl;
-  std::cout << "      --debug: enable some debugging"<<std::endl;
+  m_events++;
+  if (m_n > m_total)
+    {
+      return;
+    }
+  m_timers[index] = Simulator::Schedule (NanoSeconds (NextDelay ()), &Bench::Timer, this, index);
+}
+
+void
+Bench::Produced (void)
+{
+  m_events++;
+}
+
+static std::vector<std::string>
+Split (std::string list)
+{
+  std::vector<std::string> items;
+  std::istringstream iss (list);
+  std::string item;
+  while (std::getline (iss, item, ','))
+    {
+      if (!item.empty ())
+        {
+          items.push_back (item);
+        }
+    }
+  return items;
+}
+
+// Wall clock times have a millisecond resolution: no rate below that
+static std::string
+Rate (uint64_t n, double seconds)
+{
+  std::ostringstream oss;
+  if (seconds > 0)
+    {
+      oss << n / seconds;
+    }
+  return oss.str ();
+}
+
+static std::string
+GetSchedulerTypeName (std::string name)
+{
+  if (name.find ("::") != std::string::npos)
+    {
+      return name;
+    }
+  // "heap" stands for ns3::HeapScheduler
+  name[0] = toupper (name[0]);
+  return "ns3::" + name + "Scheduler";
 }
 
 int main (int argc, char *argv[])
 {
-  char const *filename = argv[1];
-  std::istream *input;
+  std::string trace = "";
+  std::string schedulers = "map,heap,calendar";
+  std::string distributions = "exponential,bimodal,triangular";
+  std::string sizes = "1e3,1e4,1e5";
+  uint32_t total = 1000000;
   uint32_t n = 1;
-  uint32_t total = 20000;
-  if (argc == 1)
+  double mean = 100;
+  double cancel = 0;
+  bool remove = false;
+  uint32_t contexts = 0;
+  uint32_t threads = 0;
+  uint32_t threadEvents = 100000;
+  bool csv = false;
+
+  // The trace file used to be the first, mandatory, argument
+  if (argc > 1 && argv[1][0] != '-')
     {
-      PrintHelp ();
-      return 0;
+      trace = argv[1];
+      distributions = "trace";
     }
-  argc-=2;
-  argv+= 2;
-  if (strcmp (filename, "-") == 0) 
-    {
-      input = &std::cin;
-    } 
-  else 
+
+  CommandLine cmd;
+  cmd.AddValue ("schedulers", "Comma separated list of schedulers: list, map, heap, calendar "
+                "or an ns3::Scheduler subclass", schedulers);
+  cmd.AddValue ("distributions", "Comma separated list of inter-event time distributions: "
+                "exponential, bimodal, triangular, trace", distributions);
+  cmd.AddValue ("trace", "File of inter-event times in seconds (\"-\" for stdin) "
+                "for the trace distribution", trace);
+  cmd.AddValue ("sizes", "Comma separated list of event list sizes", sizes);
+  cmd.AddValue ("total", "Number of hold events per run", total);
+  cmd.AddValue ("n", "Number of runs of each combination", n);
+  cmd.AddValue ("mean", "Mean inter-event time in microseconds", mean);
+  cmd.AddValue ("cancel", "Fraction of the event list made of timers, and probability "
+                "for each hold event to cancel and reschedule one of them", cancel);
+  cmd.AddValue ("remove", "Use Simulator::Remove instead of EventId::Cancel", remove);
+  cmd.AddValue ("contexts", "Spread the hold events over this many contexts", contexts);
+  cmd.AddValue ("threads", "Number of threads which schedule events with a context", threads);
+  cmd.AddValue ("threadEvents", "Number of events scheduled by each thread", threadEvents);
+  cmd.AddValue ("csv", "Print comma separated values", csv);
+  cmd.AddValue ("debug", "Enable some debugging", g_debug);
+  cmd.Parse (argc, argv);
+
+  std::vector<std::string> schedulerList = Split (schedulers);
+  std::vector<std::string> distributionList = Split (distributions);
+  std::vector<std::string> sizeList = Split (sizes);
+
+  if (csv)
     {
-      input = new std::ifstream (filename);
+      std::cout << "scheduler,distribution,size,total,cancel,remove,contexts,threads,run,"
+                << "init_s,simu_s,events,cancelled,insert_per_s,events_per_s,ns_per_event"
+                << std::endl;
     }
-  while (argc > 0) 
+  for (std::vector<std::string>::const_iterator d = distributionList.begin ();
+       d != distributionList.end (); d++)
     {
-      ObjectFactory factory;
-      if (strcmp ("--list", argv[0]) == 0) 
+      for (std::vector<std::string>::const_iterator s = sizeList.begin (); s != sizeList.end (); s++)
         {
-          factory.SetTypeId ("ns3::ListScheduler");
-          Simulator::SetScheduler (factory);
-        } 
-      else if (strcmp ("--heap", argv[0]) == 0) 
-        {
-          factory.SetTypeId ("ns3::HeapScheduler");
-          Simulator::SetScheduler (factory);
-        } 
-      else if (strcmp ("--map", argv[0]) == 0) 
-        {
-          factory.SetTypeId ("ns3::HeapScheduler");
-          Simulator::SetScheduler (factory);
-        } 
-      else if (strcmp ("--calendar", argv[0]) == 0)
-        {
-          factory.SetTypeId ("ns3::CalendarScheduler");
-          Simulator::SetScheduler (factory);
-        }
-      else if (strcmp ("--debug", argv[0]) == 0) 
-        {
-          g_debug = true;
-        } 
-      else if (strncmp ("--total=", argv[0], strlen("--total=")) == 0) 
-        {
-          total = atoi (argv[0]+strlen ("--total="));
-        } 
-      else if (strncmp ("--n=", argv[0], strlen("--n=")) == 0) 
-        {
-          n = atoi (argv[0]+strlen ("--n="));
-        } 
+          uint32_t size = (uint32_t) strtod (s->c_str (), 0);
+          for (std::vector<std::string>::const_iterator sched = schedulerList.begin ();
+               sched != schedulerList.end (); sched++)
+            {
+              for (uint32_t run = 0; run < n; run++)
+                {
+                  Bench *bench = new Bench ();
+                  if (*d == "trace")
+                    {
+                      NS_ABORT_MSG_IF (trace == "", "The trace distribution needs --trace");
+                      if (trace == "-")
+                        {
+                          bench->ReadDistribution (std::cin);
+                        }
+                      else
+                        {
+                          std::ifstream input (trace.c_str ());
+                          NS_ABORT_MSG_UNLESS (input.good (), "Could not open " << trace);
+                          bench->ReadDistribution (input);
+                        }
+                    }
+                  else
+                    {
+                      bench->GenerateDistribution (*d, mean * 1000);
+                    }
+                  bench->SetTotal (total);
+                  bench->SetPopulation (size);
+                  bench->SetCancel (cancel, remove);
+                  bench->SetContexts (contexts);
+                  bench->SetThreads (threads, threadEvents);
 
-      argc--;
-      argv++;
-  }
-  Bench *bench = new Bench ();
-  bench->ReadDistribution (*input);
-  bench->SetTotal (total);
-  for (uint32_t i = 0; i < n; i++)
-    {
-      bench->RunBench ();
+                  ObjectFactory factory;
+                  factory.SetTypeId (GetSchedulerTypeName (*sched));
+                  Simulator::SetScheduler (factory);
+                  BenchResult r = bench->RunBench ();
+                  Simulator::Destroy ();
+                  delete bench;
+
+                  if (csv)
+                    {
+                      std::cout << *sched << "," << *d << "," << size << "," << total << ","
+                                << cancel << "," << remove << "," << contexts << "," << threads << ","
+                                << run << "," << r.init << "," << r.simu << ","
+                                << r.events << "," << r.cancelled << ","
+                                << Rate (size, r.init) << "," << Rate (r.events, r.simu) << ","
+                                << r.simu * 1e9 / r.events << std::endl;
+                    }
+                  else
+                    {
+                      std::cout << *sched << " " << *d << " size=" << size
+                                << " insert=" << r.init * 1e9 / size << "ns"
+                                << " event=" << r.simu * 1e9 / r.events << "ns"
+                                << " (" << r.events << " events, " << r.cancelled << " cancelled)"
+                                << std::endl;
+                    }
+                }
+            }
+        }
     }
 
   return 0;
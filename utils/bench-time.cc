@@ -0,0 +1,170 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Compares the integer Time fast paths with the int64x64_t arithmetic
+// they replace: scaling a Time by an integer, building a Time from a
+// whole double and, per event, computing a transmission delay the way a
+// channel does before scheduling the reception.
+
+#include "ns3/core-module.h"
+#include <iostream>
+
+using namespace ns3;
+
+static int64_t g_sink = 0;
+
+static void
+Report (std::string name, uint32_t n, double integerMs, double int64x64Ms)
+{
+  std::cout << name << " n=" << n
+            << " integer=" << integerMs * 1e6 / n << "ns/op"
+            << " int64x64=" << int64x64Ms * 1e6 / n << "ns/op"
+            << " speedup=" << int64x64Ms / integerMs << std::endl;
+}
+
+static void
+BenchScale (uint32_t n)
+{
+  SystemWallClockMs clock;
+  Time bitTime = NanoSeconds (80);
+
+  clock.Start ();
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      Time t = bitTime * (i & 0xfff);
+      g_sink += t.GetTimeStep ();
+    }
+  double integerMs = clock.End ();
+
+  clock.Start ();
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      Time t = Time (int64x64_t (bitTime) * int64x64_t (i & 0xfff));
+      g_sink += t.GetTimeStep ();
+    }
+  double int64x64Ms = clock.End ();
+
+  Report ("scale", n, integerMs, int64x64Ms);
+}
+
+static void
+BenchFromDouble (uint32_t n)
+{
+  SystemWallClockMs clock;
+
+  clock.Start ();
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      Time t = MilliSeconds (static_cast<double> (i & 0xfff));
+      g_sink += t.GetTimeStep ();
+    }
+  double integerMs = clock.End ();
+
+  clock.Start ();
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      Time t = Time::From (int64x64_t (static_cast<double> (i & 0xfff)), Time::MS);
+      g_sink += t.GetTimeStep ();
+    }
+  double int64x64Ms = clock.End ();
+
+  Report ("from-double", n, integerMs, int64x64Ms);
+}
+
+class EventBench
+{
+public:
+  EventBench (uint32_t total, bool integer);
+  double Run (void);
+private:
+  void Receive (uint32_t size);
+  Time m_bitTime;
+  uint32_t m_n;
+  uint32_t m_total;
+  bool m_integer;
+};
+
+EventBench::EventBench (uint32_t total, bool integer)
+  : m_bitTime (NanoSeconds (80)),
+    m_n (0),
+    m_total (total),
+    m_integer (integer)
+{
+}
+
+void
+EventBench::Receive (uint32_t size)
+{
+  if (++m_n >= m_total)
+    {
+      return;
+    }
+  uint32_t next = 64 + (m_n * 37) % 1437;
+  Time delay;
+  if (m_integer)
+    {
+      delay = m_bitTime * (next * 8);
+    }
+  else
+    {
+      delay = Time (int64x64_t (m_bitTime) * int64x64_t (next * 8));
+    }
+  Simulator::Schedule (delay, &EventBench::Receive, this, next);
+}
+
+double
+EventBench::Run (void)
+{
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::ScheduleNow (&EventBench::Receive, this, 64);
+  Simulator::Run ();
+  double ms = clock.End ();
+  Simulator::Destroy ();
+  return ms;
+}
+
+static void
+BenchEvents (uint32_t n)
+{
+  EventBench integer (n, true);
+  double integerMs = integer.Run ();
+  EventBench int64x64 (n, false);
+  double int64x64Ms = int64x64.Run ();
+  Report ("event", n, integerMs, int64x64Ms);
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 10000000;
+  uint32_t events = 1000000;
+
+  CommandLine cmd;
+  cmd.AddValue ("n", "Number of arithmetic operations to time", n);
+  cmd.AddValue ("events", "Number of simulation events to time", events);
+  cmd.Parse (argc, argv);
+
+  BenchScale (n);
+  BenchFromDouble (n);
+  BenchEvents (events);
+
+  // Keep the loops from being optimized away
+  if (g_sink == 42)
+    {
+      std::cout << std::endl;
+    }
+  return 0;
+}
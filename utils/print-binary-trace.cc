@@ -0,0 +1,76 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Print the records of a binary trace (see
+// AsciiTraceHelper::CreateBinaryFileStream) as lines of text:
+//
+//   <event> <seconds> /NodeList/<node>/DeviceList/<device> uid=<uid> size=<size> [header=<hex>]
+
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+#include "ns3/binary-trace.h"
+#include "ns3/command-line.h"
+
+using namespace ns3;
+
+static void
+PrintId (std::ostream &os, const char *list, uint32_t id)
+{
+  os << list;
+  if (id == BinaryTraceRecord::NO_ID)
+    {
+      os << "*";
+    }
+  else
+    {
+      os << id;
+    }
+}
+
+int main (int argc, char *argv[])
+{
+  std::string filename;
+  CommandLine cmd;
+  cmd.AddValue ("file", "the binary trace to print", filename);
+  cmd.Parse (argc, argv);
+
+  BinaryTraceReader reader;
+  if (!reader.Open (filename))
+    {
+      std::cerr << "Could not read a binary trace from \"" << filename << "\"" << std::endl;
+      exit (1);
+    }
+  BinaryTraceRecord record;
+  while (reader.Read (record))
+    {
+      std::cout << record.event << " " << record.time / 1e9 << " ";
+      PrintId (std::cout, "/NodeList/", record.node);
+      PrintId (std::cout, "/DeviceList/", record.device);
+      std::cout << " uid=" << record.uid << " size=" << record.size;
+      if (!record.header.empty ())
+        {
+          std::cout << " header=" << std::hex << std::setfill ('0');
+          for (uint32_t i = 0; i < record.header.size (); i++)
+            {
+              std::cout << std::setw (2) << (uint32_t)record.header[i];
+            }
+          std::cout << std::dec << std::setfill (' ');
+        }
+      std::cout << std::endl;
+    }
+  return 0;
+}